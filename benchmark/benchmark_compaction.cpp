@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "../include/block/block_cache.h"
+#include "../include/iterator/merge_iterator.h"
+#include "../include/iterator/scan.h"
+#include "../include/lsm/two_merge_iterator.h"
+#include "../include/sst/concact_iterator.h"
+#include "../include/sst/sst.h"
+#include "../include/sst/sst_iterator.h"
+#include "../include/sst/sst_scan.h"
+
+using namespace ::tiny_lsm;
+
+// 测试 L0 -> L1 compaction 的吞吐量, 对比两种输入路径:
+// 虚函数迭代器: SstIterator/ConcactIterator -> MergeIterator -> TwoMergeIterator, 每层拷贝一次键值对
+// 模板扫描: SstScan/LevelScan -> MergeScan -> TwoMergeScan -> NewestScan, 编译期组合
+// 两条路径都把输出写入新的 sst, 吞吐量按输入 sst 的总大小计算
+const std::string kBenchDir = "benchmark_compaction_dir";
+const size_t kKeySpace = 400000;
+const size_t kNumL0 = 4;
+const size_t kL0Keys = 100000;
+const size_t kNumL1 = 4;
+const size_t kValueSize = 64;
+const size_t kBlockSize = 4096;
+const size_t kTargetSstSize = 16 << 20;
+const int kRounds = 3;
+
+std::string make_key(uint64_t i) {
+  auto str = std::to_string(i);
+  return "key" + std::string(10 - str.length(), '0') + str;
+}
+
+std::shared_ptr<SST> build_sst(size_t sst_id, const std::vector<std::pair<std::string, std::string>> &kvs,
+                               uint64_t tranc_id, std::shared_ptr<BlockCache> block_cache) {
+  SSTBuilder builder(kBlockSize, true);
+  for (auto &[key, value] : kvs) {
+    builder.add(key, value, tranc_id);
+  }
+  return builder.build(sst_id, kBenchDir + "/input_" + std::to_string(sst_id), block_cache);
+}
+
+// 把输出写入新的 sst, 返回写入的元素个数
+template <typename Add>
+size_t write_output(size_t &out_id, std::shared_ptr<BlockCache> block_cache, Add &&add_all) {
+  size_t entries = 0;
+  SSTBuilder builder(kBlockSize, true);
+  auto finish = [&]() {
+    auto path = kBenchDir + "/output_" + std::to_string(out_id);
+    builder.build(out_id++, path, block_cache)->del_sst();
+    builder = SSTBuilder(kBlockSize, true);
+  };
+  add_all([&](const std::string &key, const std::string &value, uint64_t tranc_id) {
+    builder.add(key, value, tranc_id);
+    ++entries;
+    if (builder.estimated_size() >= kTargetSstSize) {
+      finish();
+    }
+  });
+  finish();
+  return entries;
+}
+
+int main() {
+  std::filesystem::remove_all(kBenchDir);
+  std::filesystem::create_directory(kBenchDir);
+  auto block_cache = std::make_shared<BlockCache>(1 << 12, 8);
+
+  std::mt19937_64 rng(42);
+  std::string value(kValueSize, 'v');
+  size_t sst_id = 0;
+  size_t input_bytes = 0;
+
+  // L1: 覆盖整个 key 空间, 按 key 切分为互不重叠的 sst
+  std::vector<std::shared_ptr<SST>> l1;
+  for (size_t i = 0; i < kNumL1; ++i) {
+    std::vector<std::pair<std::string, std::string>> kvs;
+    for (size_t k = i * kKeySpace / kNumL1; k < (i + 1) * kKeySpace / kNumL1; ++k) {
+      kvs.emplace_back(make_key(k), value);
+    }
+    l1.push_back(build_sst(sst_id++, kvs, 1, block_cache));
+  }
+  // L0: 相互重叠的随机 key, 新的 sst 在前
+  std::vector<std::shared_ptr<SST>> l0;
+  for (size_t i = 0; i < kNumL0; ++i) {
+    std::vector<uint64_t> picked(kL0Keys);
+    for (auto &k : picked) {
+      k = rng() % kKeySpace;
+    }
+    std::sort(picked.begin(), picked.end());
+    picked.erase(std::unique(picked.begin(), picked.end()), picked.end());
+    std::vector<std::pair<std::string, std::string>> kvs;
+    for (auto k : picked) {
+      kvs.emplace_back(make_key(k), value);
+    }
+    l0.insert(l0.begin(), build_sst(sst_id++, kvs, 2 + i, block_cache));
+  }
+  for (auto &sst : l0) {
+    input_bytes += sst->sst_size();
+  }
+  for (auto &sst : l1) {
+    input_bytes += sst->sst_size();
+  }
+
+  size_t out_id = 0;
+  auto virtual_path = [&]() {
+    return write_output(out_id, block_cache, [&](auto &&add) {
+      std::vector<std::shared_ptr<BaseIterator>> children;
+      for (auto &sst : l0) {
+        children.push_back(std::make_shared<SstIterator>(sst, 0));
+      }
+      auto l0_iter = std::make_shared<MergeIterator>(std::move(children), 0);
+      auto l1_iter = std::make_shared<ConcactIterator>(l1, 0);
+      TwoMergeIterator iter(l0_iter, l1_iter, 0);
+      // 同一个 key 只保留第一个版本
+      std::string last_key;
+      for (; iter.is_valid(); ++iter) {
+        auto kv = *iter;
+        if (kv.first == last_key) {
+          continue;
+        }
+        add(kv.first, kv.second, iter.get_tranc_id());
+        last_key = kv.first;
+      }
+    });
+  };
+  auto scan_path = [&]() {
+    return write_output(out_id, block_cache, [&](auto &&add) {
+      std::vector<SstScan> l0_scans;
+      for (auto &sst : l0) {
+        l0_scans.emplace_back(sst, 0);
+      }
+      NewestScan scan(TwoMergeScan(MergeScan<SstScan>(std::move(l0_scans)), LevelScan(l1, 0)), false);
+      for (; scan.valid(); scan.next()) {
+        add(scan.key(), scan.value(), scan.tranc_id());
+      }
+    });
+  };
+
+  auto measure = [&](auto &&run, size_t &entries) {
+    auto start = std::chrono::steady_clock::now();
+    entries = run();
+    auto end = std::chrono::steady_clock::now();
+    return input_bytes / 1048576.0 / std::chrono::duration<double>(end - start).count();
+  };
+
+  // 交替运行, 各取最好的一次, 减少 page cache 和 block cache 预热的影响
+  double best_virtual = 0;
+  double best_scan = 0;
+  size_t virtual_entries = 0;
+  size_t scan_entries = 0;
+  for (int round = 0; round < kRounds; ++round) {
+    best_virtual = std::max(best_virtual, measure(virtual_path, virtual_entries));
+    best_scan = std::max(best_scan, measure(scan_path, scan_entries));
+  }
+  std::filesystem::remove_all(kBenchDir);
+
+  std::cout << "L0 -> L1 compaction (" << kNumL0 << " L0 SSTs + " << kNumL1 << " L1 SSTs, " << input_bytes / 1048576
+            << " MB input)" << std::endl;
+  std::cout << "  virtual iterators: " << best_virtual << " MB/s, " << virtual_entries << " entries" << std::endl;
+  std::cout << "  templated scans:   " << best_scan << " MB/s, " << scan_entries << " entries" << std::endl;
+  return 0;
+}
@@ -0,0 +1,84 @@
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "../include/block/block_cache.h"
+#include "../include/consts.h"
+#include "../include/sst/sst.h"
+
+using namespace ::tiny_lsm;
+
+// 测试 SST 点查定位 block 的延迟, 对比二分查找索引和使用 LearnedIndex
+// key 模拟有序集合中按分数排列的 key: 前缀 + 补齐的分数
+const std::string kBenchDir = "benchmark_sst_index_dir";
+const size_t kNumKeys = 500000;
+const size_t kBlockSize = 4096;
+const size_t kNumLookups = 2000000;
+const size_t kErrorBound = 8;
+
+std::string make_key(uint64_t score) {
+  auto str = std::to_string(score);
+  return "zset_rank_" + std::string(REDIS_SORTED_SET_SCORE_LEN - str.length(), '0') + str;
+}
+
+double bench_find_block_idx(size_t error_bound, const std::vector<std::string> &keys,
+                            const std::vector<std::string> &queries) {
+  auto block_cache = std::make_shared<BlockCache>(1 << 16, 8);
+  SSTBuilder builder(kBlockSize, true);
+  builder.set_learned_index_error(error_bound);
+  for (auto &key : keys) {
+    builder.add(key, "value", 0);
+  }
+  auto sst = builder.build(error_bound, kBenchDir + "/" + std::to_string(error_bound) + ".sst", block_cache);
+
+  // 预热: 把所有索引分区读入 block cache
+  size_t checksum = 0;
+  for (auto &query : queries) {
+    checksum += sst->find_block_idx(query);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (auto &query : queries) {
+    checksum += sst->find_block_idx(query);
+  }
+  auto end = std::chrono::steady_clock::now();
+  if (checksum == 0) {
+    std::cout << "unexpected checksum" << std::endl;
+  }
+
+  std::cout << "  " << sst->num_blocks() << " blocks, " << sst->sst_size() << " bytes" << std::endl;
+  double ns = std::chrono::duration<double, std::nano>(end - start).count();
+  return ns / queries.size();
+}
+
+int main() {
+  std::filesystem::remove_all(kBenchDir);
+  std::filesystem::create_directory(kBenchDir);
+
+  // 分数单调递增, 间隔随机
+  std::mt19937_64 rng(42);
+  std::uniform_int_distribution<uint64_t> gap(1, 1000);
+  std::vector<std::string> keys;
+  uint64_t score = 0;
+  for (size_t i = 0; i < kNumKeys; i++) {
+    score += gap(rng);
+    keys.push_back(make_key(score));
+  }
+  std::vector<std::string> queries;
+  std::uniform_int_distribution<size_t> pick(0, kNumKeys - 1);
+  for (size_t i = 0; i < kNumLookups; i++) {
+    queries.push_back(keys[pick(rng)]);
+  }
+
+  double binary_search = bench_find_block_idx(0, keys, queries);
+  double learned = bench_find_block_idx(kErrorBound, keys, queries);
+  std::filesystem::remove_all(kBenchDir);
+
+  std::cout << "SST find_block_idx (" << kNumKeys << " keys, " << kBlockSize << "B block)" << std::endl;
+  std::cout << "  binary search: " << binary_search << " ns/lookup" << std::endl;
+  std::cout << "  learned index: " << learned << " ns/lookup" << std::endl;
+  return 0;
+}
@@ -0,0 +1,61 @@
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/wal/record.h"
+#include "../include/wal/wal.h"
+
+using namespace ::tiny_lsm;
+
+// 测试 WAL 在 Always 模式下的追加提交性能, 对比是否回收日志文件
+// 日志文件较小, 测试期间会多次切换文件, 清理线程持续回收已完成的文件
+const std::string kBenchDir = "benchmark_wal_dir";
+const size_t kFileSizeLimit = 1 << 20;  // 1MB
+const uint64_t kWarmupTrancs = 20000;
+const uint64_t kBenchTrancs = 20000;
+const size_t kValueSize = 256;
+
+std::vector<Record> make_tranc(uint64_t tranc_id, const std::string &value) {
+  return {Record::createRecord(tranc_id), Record::putRecord(tranc_id, "key" + std::to_string(tranc_id), value),
+          Record::commitRecord(tranc_id)};
+}
+
+double bench_wal_commit(size_t recycle_num) {
+  std::filesystem::remove_all(kBenchDir);
+  std::string value(kValueSize, 'v');
+  WAL wal(kBenchDir, 128, 0, 1, kFileSizeLimit, WalSyncMode::Always, 1000, recycle_num);
+
+  // 预热: 写满若干个文件并等待清理线程处理, 开启回收时会留下可复用的文件
+  uint64_t tranc_id = 0;
+  while (tranc_id < kWarmupTrancs) {
+    wal.log_async(make_tranc(++tranc_id, value)).get();
+  }
+  wal.set_max_finished_tranc_id(tranc_id);
+  std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < kBenchTrancs; i++) {
+    wal.log_async(make_tranc(++tranc_id, value)).get();
+    // 模拟刷盘进度, 使已经写满的文件可以被清理
+    if (i % 1000 == 0) {
+      wal.set_max_finished_tranc_id(tranc_id);
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+  return kBenchTrancs / seconds;
+}
+
+int main() {
+  double without_recycle = bench_wal_commit(0);
+  double with_recycle = bench_wal_commit(4);
+  std::filesystem::remove_all(kBenchDir);
+
+  std::cout << "WAL commit (always, " << kValueSize << "B value, " << (kFileSizeLimit >> 20) << "MB file)" << std::endl;
+  std::cout << "  without recycling: " << static_cast<uint64_t>(without_recycle) << " commits/sec" << std::endl;
+  std::cout << "  with recycling:    " << static_cast<uint64_t>(with_recycle) << " commits/sec" << std::endl;
+  return 0;
+}
@@ -18,6 +18,13 @@ Refer to https://skyzh.github.io/mini-lsm/week1-03-block.html for memory layout
 |Entry#1|Entry#2|...|Entry#N|Offset#1|Offset#2|...|Offset#N|num_of_elements(2B)|
 --------------------------------------------------------------------------------
 
+启用 hash 索引时, num_of_elements 的最高位置 1, 之前插入 hash 索引:
+--------------------------------------------------------------------------------
+| Data Section | Offset Section | Bucket#1|...|Bucket#M | num_buckets(2B) | Extra |
+--------------------------------------------------------------------------------
+每个桶(2B)记录 hash 到该桶的 key 的第一个元素下标,
+没有 key 时为 HASH_BUCKET_EMPTY, 多个不同的 key 时为 HASH_BUCKET_COLLISION
+
 ---------------------------------------------------------------------
 |                           Entry #1 |                          ... |
 --------------------------------------------------------------|-----|
@@ -33,9 +40,37 @@ class Block : public std::enable_shared_from_this<Block> {
   friend BlockIterator;
 
 private:
+  static constexpr uint16_t HASH_INDEX_FLAG = 0x8000;
+  static constexpr uint16_t HASH_BUCKET_EMPTY = 0xFFFF;
+  static constexpr uint16_t HASH_BUCKET_COLLISION = 0xFFFE;
+
   std::vector<uint8_t> data;
   std::vector<uint16_t> offsets;
   size_t capacity;
+  // hash 索引中 key 数量与桶数量之比, 为 0 时不构建 hash 索引
+  double hash_util_ratio_ = 0;
+  // 构建时每个不同的 key 的 hash 值和第一个元素下标
+  std::vector<std::pair<uint32_t, uint16_t>> hash_entries_;
+  // 解码得到的 hash 索引, 为空时只使用二分查找
+  std::vector<uint16_t> hash_buckets_;
+  // 零拷贝解码时 data 为空, Data Section 直接引用外部的只读内存(如 mmap)
+  std::shared_ptr<const uint8_t> data_view_;
+  size_t data_view_size_ = 0;
+
+  // Data Section 的起始地址与长度, 兼容拷贝与零拷贝两种形式
+  const uint8_t *data_ptr() const;
+  size_t data_size() const;
+
+  // 校验 hash 并解析 Offset Section 和 hash 索引, 返回 Data Section 的长度
+  static size_t decode_offsets(const uint8_t *encoded, size_t size,
+                               bool with_hash, std::vector<uint16_t> &offsets,
+                               std::vector<uint16_t> &hash_buckets);
+
+  static uint32_t hash_key(const std::string &key);
+  // key 数量为 num_keys 时 hash 索引的桶数量
+  size_t num_hash_buckets(size_t num_keys) const;
+  // 编码后 hash 索引的字节数, 不启用时为 0
+  size_t hash_index_size(size_t num_keys) const;
 
   struct Entry {
     std::string key;
@@ -55,18 +90,25 @@ private:
 
 public:
   Block() = default;
-  Block(size_t capacity);
+  Block(size_t capacity, double hash_util_ratio = 0);
   // ! 这里的编码函数不包括 hash (已补充hash)
   std::vector<uint8_t> encode(bool with_hash = false);
   // ! 这里的解码函数可指定切片是否包括 hash
   static std::shared_ptr<Block> decode(const std::vector<uint8_t> &encoded,
                                        bool with_hash = false);
+  // 零拷贝解码, 返回的 Block 与 encoded 共享生命周期且只读
+  static std::shared_ptr<Block>
+  decode_view(std::shared_ptr<const uint8_t> encoded, size_t size,
+              bool with_hash = false);
   std::string get_first_key();
   size_t get_offset_at(size_t idx) const;
   bool add_entry(const std::string &key, const std::string &value,
                  uint64_t tranc_id, bool force_write);
   std::optional<std::string> get_value_binary(const std::string &key,
                                               uint64_t tranc_id);
+  // 与 get_value_binary 相同, 但同时返回该记录的事务 id
+  std::optional<std::pair<std::string, uint64_t>>
+  get_value_tranc_binary(const std::string &key, uint64_t tranc_id);
 
   // 元素个数
   size_t size() const;
@@ -75,6 +117,14 @@ public:
   bool is_empty() const;
   std::optional<size_t> get_idx_binary(const std::string &key,
                                        uint64_t tranc_id);
+  // [lo, hi) 中第一个 key 不小于目标 key 的元素下标, 都小于目标 key 时返回 hi
+  // 不考虑事务可见性, 用于 key 不重复的索引分区
+  size_t lower_bound(const std::string &key, size_t lo = 0, size_t hi = SIZE_MAX) const;
+  // 按下标读取元素的 key 和事务 id
+  std::string get_key_at_idx(size_t idx) const;
+  uint64_t get_tranc_id_at_idx(size_t idx) const;
+  // 按下标读取整个元素到调用者提供的缓冲区中, 顺序扫描时可以复用内存
+  void read_entry_at_idx(size_t idx, std::string &key, std::string &value, uint64_t &tranc_id) const;
 
   // 按照谓词返回迭代器, 左闭右开
   std::optional<
@@ -14,7 +14,7 @@ class Block;
 class BlockIterator {
 public:
   // 标准迭代器类型定义
-  using iterator_category = std::forward_iterator_tag;
+  using iterator_category = std::bidirectional_iterator_tag;
   using value_type = std::pair<std::string, std::string>;
   using difference_type = std::ptrdiff_t;
   using pointer = const value_type *;
@@ -32,6 +32,15 @@ public:
   pointer operator->() const;
   BlockIterator &operator++();
   BlockIterator operator++(int) = delete;
+  // 移动到上一个 key 的可见版本, 已经是第一个 key 时变为 end
+  BlockIterator &operator--();
+  BlockIterator operator--(int) = delete;
+  // 定位到第一个不小于 key 的可见 key
+  void seek(const std::string &key);
+  // 定位到最后一个不大于 key 的可见 key
+  void seek_for_prev(const std::string &key);
+  // 定位到最后一个可见 key
+  void seek_to_last();
   bool operator==(const BlockIterator &other) const;
   bool operator!=(const BlockIterator &other) const;
   value_type operator*() const;
@@ -41,6 +50,8 @@ private:
   void update_current() const;
   // 跳过当前不可见事务的id (如果开启了事务功能)
   void skip_by_tranc_id();
+  // 定位到 [0, end) 中最后一个有可见版本的 key, end 必须位于两个 key 之间
+  void seek_prev_before(size_t end);
 
 private:
   std::shared_ptr<Block> block;                   // 指向所属的 Block
@@ -16,12 +16,28 @@ private:
   long long lsm_tol_mem_size_limit_;
   long long lsm_per_mem_size_limit_;
   int lsm_block_size_;
+  double lsm_block_hash_util_ratio_;
+  int lsm_sst_learned_index_error_;
   int lsm_sst_level_ratio_;
 
   // --- LSM Cache ---
   int lsm_block_cache_capacity_;
   int lsm_block_cache_k_;
 
+  // --- LSM IO ---
+  std::string lsm_sst_io_mode_;
+  int lsm_max_open_files_;
+  int lsm_sst_readahead_max_blocks_;
+  int lsm_compaction_readahead_blocks_;
+
+  // --- LSM WAL ---
+  int lsm_wal_buffer_size_;
+  long long lsm_wal_file_size_limit_;
+  int lsm_wal_clean_interval_;
+  std::string lsm_wal_sync_mode_;
+  int lsm_wal_sync_interval_ms_;
+  int lsm_wal_recycle_num_;
+
   // --- Redis Headers/Separators ---
   std::string redis_expire_header_;
   std::string redis_hash_value_preffix_;
@@ -57,11 +73,25 @@ public:
   long long getLsmTolMemSizeLimit() const;
   long long getLsmPerMemSizeLimit() const;
   int getLsmBlockSize() const;
+  double getLsmBlockHashUtilRatio() const;
+  int getLsmSstLearnedIndexError() const;
   int getLsmSstLevelRatio() const;
 
   int getLsmBlockCacheCapacity() const;
   int getLsmBlockCacheK() const;
 
+  const std::string &getLsmSstIoMode() const;
+  int getLsmMaxOpenFiles() const;
+  int getLsmSstReadaheadMaxBlocks() const;
+  int getLsmCompactionReadaheadBlocks() const;
+
+  int getLsmWalBufferSize() const;
+  long long getLsmWalFileSizeLimit() const;
+  int getLsmWalCleanInterval() const;
+  const std::string &getLsmWalSyncMode() const;
+  int getLsmWalSyncIntervalMs() const;
+  int getLsmWalRecycleNum() const;
+
   const std::string &getRedisExpireHeader() const;
   const std::string &getRedisHashValuePreffix() const;
   const std::string &getRedisFieldPrefix() const;
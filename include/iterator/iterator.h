@@ -17,6 +17,7 @@ enum class IteratorType {
   TwoMergeIterator,
   ConcactIterator,
   LevelIterator,
+  MergeIterator,
   Undefined,
 };
 
@@ -34,6 +35,14 @@ public:
   virtual uint64_t get_tranc_id() const = 0;
   virtual bool is_end() const = 0;
   virtual bool is_valid() const = 0;
+
+  // 双向迭代, 默认不支持, 由具体的迭代器按需实现
+  // 移动到上一个 key, 已经是第一个 key 时变为无效
+  virtual BaseIterator &operator--();
+  // 定位到第一个不小于 key 的位置
+  virtual void seek(const std::string &key);
+  // 定位到最后一个不大于 key 的位置
+  virtual void seek_for_prev(const std::string &key);
 };
 
 class SstIterator;
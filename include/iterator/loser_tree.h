@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace tiny_lsm {
+
+/**
+ * 多路归并使用的败者树
+ * 叶子是 k 个数据源的下标, 内部节点记录比赛中的失败者, tree_[0] 记录冠军.
+ * 冠军前进后只需沿着它到根的路径重新比赛, 每次比较 log2(k) 次,
+ * 不需要像二叉堆一样重新插入元素.
+ * 败者树只保存下标, 比较函数在每次比赛时传入, 因此可以随所属的迭代器拷贝.
+ * less(a, b) 判断数据源 a 的当前元素是否应该排在数据源 b 之前,
+ * 必须是严格全序: 已经耗尽的数据源排在最后, 元素相同时按下标排序
+ */
+class LoserTree {
+public:
+  // 重新为 k 个数据源构建败者树
+  template <typename Less> void build(size_t k, const Less &less) {
+    k_ = k;
+    tree_.assign(k_ == 0 ? 1 : k_, 0);
+    if (k_ > 0) {
+      tree_[0] = play(1, less);
+    }
+  }
+
+  // 当前排在最前面的数据源
+  size_t winner() const { return tree_.empty() ? 0 : tree_[0]; }
+
+  // 冠军的当前元素变化(前进或者耗尽)后重新比赛
+  template <typename Less> void replay(const Less &less) {
+    size_t cur = tree_[0];
+    for (size_t node = (cur + k_) / 2; node > 0; node /= 2) {
+      if (less(tree_[node], cur)) {
+        std::swap(tree_[node], cur);
+      }
+    }
+    tree_[0] = cur;
+  }
+
+  size_t size() const { return k_; }
+
+private:
+  // 节点编号从 1 开始, 节点 n 的子节点为 2n 和 2n + 1,
+  // 编号不小于 k 的节点是叶子, 对应数据源 n - k
+  template <typename Less> size_t play(size_t node, const Less &less) {
+    if (node >= k_) {
+      return node - k_;
+    }
+    size_t left = play(node * 2, less);
+    size_t right = play(node * 2 + 1, less);
+    if (less(right, left)) {
+      tree_[node] = left;
+      return right;
+    }
+    tree_[node] = right;
+    return left;
+  }
+
+  size_t k_ = 0;
+  std::vector<size_t> tree_;
+};
+} // namespace tiny_lsm
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "iterator.h"
+#include "loser_tree.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace tiny_lsm {
+
+// *************************** MergeIterator ***************************
+/**
+ * 按需拉取的多路归并迭代器, 每个子迭代器只保留当前位置
+ * 子迭代器按从新到旧排列, 按 key 升序输出所有子迭代器的元素,
+ * key 相同时新的子迭代器的元素在前. 不去重也不跳过删除标记,
+ * 由上层决定如何处理同一个 key 的多个版本
+ * 反向迭代时按 key 降序输出, key 相同时仍然是新的子迭代器在前;
+ * 切换方向时以 key 为单位移动: 越过当前 key 的所有元素
+ */
+class MergeIterator : public BaseIterator {
+public:
+  MergeIterator();
+  MergeIterator(std::vector<std::shared_ptr<BaseIterator>> children,
+                uint64_t max_tranc_id);
+  MergeIterator(const MergeIterator &) = delete;
+  MergeIterator &operator=(const MergeIterator &) = delete;
+
+  // 当前元素的 key, 不拷贝
+  const std::string &key() const;
+  // 当前元素所在的子迭代器的下标
+  size_t source_idx() const;
+
+  pointer operator->() const;
+  virtual value_type operator*() const override;
+  BaseIterator &operator++() override;
+  BaseIterator &operator--() override;
+  void seek(const std::string &key) override;
+  void seek_for_prev(const std::string &key) override;
+  virtual bool operator==(const BaseIterator &other) const override;
+  virtual bool operator!=(const BaseIterator &other) const override;
+
+  virtual IteratorType get_type() const override;
+  virtual uint64_t get_tranc_id() const override;
+  virtual bool is_end() const override;
+  virtual bool is_valid() const override;
+
+private:
+  // 比较两个子迭代器的当前元素
+  bool source_less(size_t a, size_t b) const;
+
+  // 缓存子迭代器当前的 key, 比较时不需要每次解引用
+  void load_key(size_t idx);
+  void rebuild_tree();
+
+  std::vector<std::shared_ptr<BaseIterator>> children_;
+  std::vector<std::string> keys_;
+  std::vector<bool> valid_;
+  LoserTree tree_;
+  bool forward_ = true; // 当前的迭代方向
+  mutable std::optional<value_type> current_;
+  uint64_t max_tranc_id_ = 0;
+};
+} // namespace tiny_lsm
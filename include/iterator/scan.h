@@ -0,0 +1,159 @@
+#pragma once
+
+#include "loser_tree.h"
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tiny_lsm {
+
+// *************************** Scan ***************************
+/**
+ * flush 和 compaction 使用的只读顺序扫描
+ * 与 BaseIterator 不同, 扫描只能前进, 由具体类型在编译期组合而不是通过虚函数,
+ * key 和 value 以引用返回, 每经过一层不需要拷贝一次 std::pair; 整条扫描链的
+ * 内层循环可以被完全内联. 输出按 key 升序, 同一个 key 的多个版本按事务 id 从大到小
+ */
+template <typename T>
+concept Scan = requires(T &scan, const T &cscan) {
+  { cscan.valid() } -> std::convertible_to<bool>;
+  { cscan.key() } -> std::convertible_to<const std::string &>;
+  { cscan.value() } -> std::convertible_to<const std::string &>;
+  { cscan.tranc_id() } -> std::convertible_to<uint64_t>;
+  scan.next();
+};
+
+// 合并两个扫描, a 的数据比 b 新, key 相同时先输出 a 的所有版本
+template <Scan A, Scan B> class TwoMergeScan {
+public:
+  TwoMergeScan(A a, B b) : a_(std::move(a)), b_(std::move(b)) { choose(); }
+
+  bool valid() const { return a_.valid() || b_.valid(); }
+  const std::string &key() const { return use_a_ ? a_.key() : b_.key(); }
+  const std::string &value() const { return use_a_ ? a_.value() : b_.value(); }
+  uint64_t tranc_id() const { return use_a_ ? a_.tranc_id() : b_.tranc_id(); }
+
+  void next() {
+    if (use_a_) {
+      a_.next();
+    } else {
+      b_.next();
+    }
+    choose();
+  }
+
+private:
+  void choose() {
+    use_a_ = a_.valid() && (!b_.valid() || a_.key() <= b_.key());
+  }
+
+  A a_;
+  B b_;
+  bool use_a_ = false;
+};
+
+// 用败者树合并多个同类型的扫描, 按从新到旧排列, key 相同时新的扫描在前
+template <Scan S> class MergeScan {
+public:
+  explicit MergeScan(std::vector<S> sources) : sources_(std::move(sources)) {
+    tree_.build(sources_.size(),
+                [this](size_t a, size_t b) { return source_less(a, b); });
+  }
+
+  bool valid() const {
+    return !sources_.empty() && sources_[tree_.winner()].valid();
+  }
+  const std::string &key() const { return sources_[tree_.winner()].key(); }
+  const std::string &value() const {
+    return sources_[tree_.winner()].value();
+  }
+  uint64_t tranc_id() const { return sources_[tree_.winner()].tranc_id(); }
+
+  void next() {
+    sources_[tree_.winner()].next();
+    tree_.replay([this](size_t a, size_t b) { return source_less(a, b); });
+  }
+
+private:
+  bool source_less(size_t a, size_t b) const {
+    bool a_valid = sources_[a].valid();
+    bool b_valid = sources_[b].valid();
+    if (a_valid != b_valid) {
+      return a_valid;
+    }
+    if (!a_valid) {
+      return a < b;
+    }
+    int cmp = sources_[a].key().compare(sources_[b].key());
+    if (cmp != 0) {
+      return cmp < 0;
+    }
+    return a < b;
+  }
+
+  std::vector<S> sources_;
+  LoserTree tree_;
+};
+
+// 每个 key 只输出最新的版本, 以及未释放的快照仍然能看到的旧版本
+// snapshots 为快照的事务 id, 从小到大排列; 快照把事务 id 分成若干段,
+// 同一段中的版本对相同的快照可见, 每段只需要保留最新的一个
+// drop_deleted 为 true 时丢弃最早一段中的删除标记, 只能用于下面没有更旧数据的层
+template <Scan S> class NewestScan {
+public:
+  NewestScan(S source, bool drop_deleted, std::vector<uint64_t> snapshots = {})
+      : source_(std::move(source)), drop_deleted_(drop_deleted),
+        snapshots_(std::move(snapshots)) {
+    settle();
+  }
+
+  bool valid() const { return source_.valid(); }
+  const std::string &key() const { return source_.key(); }
+  const std::string &value() const { return source_.value(); }
+  uint64_t tranc_id() const { return source_.tranc_id(); }
+
+  void next() {
+    source_.next();
+    settle();
+  }
+
+private:
+  // 版本所在的段: 第一个不小于 tranc_id 的快照的下标
+  size_t stripe(uint64_t tranc_id) const {
+    return std::lower_bound(snapshots_.begin(), snapshots_.end(), tranc_id) -
+           snapshots_.begin();
+  }
+
+  // 跳过被同一段中更新的版本遮盖的版本, 停在下一个需要输出的版本上
+  void settle() {
+    for (; source_.valid(); source_.next()) {
+      bool same_key = has_last_ && source_.key() == last_key_;
+      size_t cur_stripe = stripe(source_.tranc_id());
+      if (same_key && cur_stripe == last_stripe_) {
+        continue;
+      }
+      if (!same_key) {
+        last_key_ = source_.key();
+        has_last_ = true;
+      }
+      last_stripe_ = cur_stripe;
+      // 最早一段中的删除标记对所有快照可见, 同一段中更旧的版本也随之跳过
+      if (drop_deleted_ && cur_stripe == 0 && source_.value().empty()) {
+        continue;
+      }
+      return;
+    }
+  }
+
+  S source_;
+  bool drop_deleted_;
+  std::vector<uint64_t> snapshots_;
+  std::string last_key_; // 复用内存, 不必每个 key 分配一次
+  bool has_last_ = false;
+  size_t last_stripe_ = 0;
+};
+} // namespace tiny_lsm
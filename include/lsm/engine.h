@@ -1,15 +1,26 @@
 #pragma once
 
+#include "../iterator/scan.h"
 #include "../memtable/memtable.h"
 #include "../sst/sst.h"
+#include "../sst/table_cache.h"
 #include "compact.h"
+#include "file_indexer.h"
+#include "manifest.h"
+#include "snapshot.h"
 #include "transaction.h"
 #include "two_merge_iterator.h"
+#include "version.h"
+#include <atomic>
 #include <cstddef>
 #include <deque>
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
 #include <unordered_map>
 #include <vector>
 
@@ -21,10 +32,13 @@ class LSMEngine : public std::enable_shared_from_this<LSMEngine> {
 public:
   std::string data_dir;
   MemTable memtable;
+  // flush 和 compact 修改的 sst 组成, 由 ssts_mtx 的写锁保护;
+  // 读操作不访问它们, 而是使用 current_version() 发布的快照
   std::map<size_t, std::deque<size_t>> level_sst_ids;
   std::unordered_map<size_t, std::shared_ptr<SST>> ssts;
   std::shared_mutex ssts_mtx;
   std::shared_ptr<BlockCache> block_cache;
+  std::shared_ptr<TableCache> table_cache;
   size_t next_sst_id = 0;
   size_t cur_max_level = 0;
 
@@ -41,6 +55,11 @@ public:
   std::optional<std::pair<std::string, uint64_t>>
   sst_get_(const std::string &key, uint64_t tranc_id);
 
+  // 查询 key 对事务可见的最新版本, 删除标记同样返回(value 为空),
+  // 事务提交时据此检测冲突
+  std::optional<std::pair<std::string, uint64_t>>
+  get_version(const std::string &key, uint64_t tranc_id);
+
   // 如果触发了刷盘, 返回当前刷入sst的最大事务id
   uint64_t put(const std::string &key, const std::string &value,
                uint64_t tranc_id);
@@ -52,21 +71,53 @@ public:
   uint64_t remove(const std::string &key, uint64_t tranc_id);
   uint64_t remove_batch(const std::vector<std::string> &keys,
                         uint64_t tranc_id);
+  // batch 中的所有操作使用同一个事务 id, 在一次加锁中写入 memtable
+  uint64_t write(const WriteBatch &batch, uint64_t tranc_id);
   void clear();
+  // 返回刷入sst的最大事务id; 记录到 MANIFEST 失败时抛出 std::runtime_error,
+  // 此时数据留在 memtable 中. 写入触发的刷盘同样会把异常抛给调用者
   uint64_t flush();
 
+  // 批量加载按 key 严格递增的 (key, value, tranc_id), 用于 WAL 重放
+  // 如果触发了刷盘, 返回刷入sst的最大事务id
+  uint64_t
+  load_sorted(const std::vector<std::tuple<std::string, std::string, uint64_t>>
+                  &entries);
+
   std::string get_sst_path(size_t sst_id, size_t target_level);
 
+  // 满足 predicate(key) == 0 的 key 组成的区间, 没有可见的 key 时返回空;
+  // 在每个数据源中二分查找区间的首尾, 再用范围迭代器合并
   std::optional<std::pair<TwoMergeIterator, TwoMergeIterator>>
   lsm_iters_monotony_predicate(
       uint64_t tranc_id, std::function<int(const std::string &)> predicate);
 
   Level_Iterator begin(uint64_t tranc_id);
   Level_Iterator end();
+  // [lower, upper) 范围内的迭代器, 结束时与 end() 相等
+  Level_Iterator range(uint64_t tranc_id, const std::string &lower,
+                       const std::string &upper);
 
   static size_t get_sst_size(size_t level);
 
+  // 当前发布的 sst 组成, 持有返回值期间其中的 sst 文件不会被删除
+  std::shared_ptr<const Version> current_version() const;
+
+  // 创建只能看到事务 id 不大于 tranc_id 的版本的快照,
+  // 释放之前 compact 会保留它能看到的版本
+  Snapshot create_snapshot(uint64_t tranc_id);
+
 private:
+  // memtable 超出总大小限制时刷盘
+  uint64_t flush_if_needed_();
+
+  // 在 sst 中查询最新的可见版本, 包括删除标记
+  std::optional<std::pair<std::string, uint64_t>>
+  sst_get_version_(const std::string &key, uint64_t tranc_id);
+
+  // sst 组成变化后发布新的 Version, 调用者需持有 ssts_mtx 的写锁
+  void install_version_();
+
   void full_compact(size_t src_level);
   std::vector<std::shared_ptr<SST>>
   full_l0_l1_compact(std::vector<size_t> &l0_ids, std::vector<size_t> &l1_ids);
@@ -75,9 +126,26 @@ private:
   full_common_compact(std::vector<size_t> &lx_ids, std::vector<size_t> &ly_ids,
                       size_t level_y);
 
-  std::vector<std::shared_ptr<SST>> gen_sst_from_iter(BaseIterator &iter,
+  // 把按 key 有序的扫描依次写入 target_level 的 sst, 每个 sst 达到
+  // target_sst_size 后切分; 扫描的类型在编译期确定, 写入循环中没有虚函数调用
+  template <Scan S>
+  std::vector<std::shared_ptr<SST>> gen_sst_from_iter(S &scan,
                                                       size_t target_sst_size,
                                                       size_t target_level);
+  // level 之下没有更旧的数据, compact 到这一层时可以丢弃删除标记
+  bool is_bottom_level_(size_t level) const;
+
+  // 没有 MANIFEST 时扫描 data_dir 下的 sst 文件, 返回它们的元数据
+  std::vector<SstFileMeta> scan_sst_files_();
+  // 后台并行加载 sst 的元数据和布隆过滤器, 从低层开始, 最多加载到表缓存的容量
+  void preload_ssts_();
+  SstFileMeta sst_file_meta_(const std::shared_ptr<SST> &sst, size_t level);
+
+  Manifest manifest_;
+  std::atomic<std::shared_ptr<const Version>> version_;
+  SnapshotList snapshots_;
+  std::vector<std::thread> sst_loaders_;
+  std::atomic<bool> stop_loading_{false};
 };
 
 class LSM {
@@ -85,28 +153,69 @@ private:
   std::shared_ptr<LSMEngine> engine;
   std::shared_ptr<TranManager> tran_manager_;
 
+  std::vector<std::pair<std::string, std::optional<std::string>>>
+  get_batch_(const std::vector<std::string> &keys, uint64_t tranc_id);
+  // 持有 keys 所在的提交分片写入 WAL(records 为空时跳过) 和 memtable,
+  // 无论写入是否抛出异常都会标记事务 id 已结束
+  void commit_write_(uint64_t tranc_id,
+                     const std::vector<std::string_view> &keys,
+                     const std::vector<Record> &records, WalSyncMode sync_mode,
+                     const std::function<uint64_t()> &apply);
+
 public:
   LSM(std::string path);
   ~LSM();
 
+  // 读取最新的数据, 不分配事务 id; 第二个参数只为兼容旧的调用而保留, 没有作用
   std::optional<std::string> get(const std::string &key,
                                  bool tranc_off = false);
   std::vector<std::pair<std::string, std::optional<std::string>>>
   get_batch(const std::vector<std::string> &keys);
 
-  void put(const std::string &key, const std::string &value,
-           bool tranc_off = false);
-  void put_batch(const std::vector<std::pair<std::string, std::string>> &kvs);
+  // 创建快照: 使用已结束事务的水位(不大于它的事务都已经提交或回滚),
+  // 不会分配新的事务 id. 水位之前提交的写入对快照可见, 还在进行中的事务
+  // 和之后的写入不可见; 快照析构时自动释放
+  Snapshot get_snapshot();
 
-  void remove(const std::string &key);
-  void remove_batch(const std::vector<std::string> &keys);
+  // 在快照上读取
+  std::optional<std::string> get(const std::string &key,
+                                 const Snapshot &snapshot);
+  std::vector<std::pair<std::string, std::optional<std::string>>>
+  get_batch(const std::vector<std::string> &keys, const Snapshot &snapshot);
+
+  // 写入会先记录到 WAL, tranc_off 为 true 时跳过 WAL;
+  // sync_mode 覆盖本次写入的持久化策略
+  void put(const std::string &key, const std::string &value,
+           bool tranc_off = false,
+           WalSyncMode sync_mode = WalSyncMode::Default);
+  void put_batch(const std::vector<std::pair<std::string, std::string>> &kvs,
+                 WalSyncMode sync_mode = WalSyncMode::Default);
+
+  void remove(const std::string &key,
+              WalSyncMode sync_mode = WalSyncMode::Default);
+  void remove_batch(const std::vector<std::string> &keys,
+                    WalSyncMode sync_mode = WalSyncMode::Default);
+  // 原子地写入 batch: 分配一个事务 id, 写入一次 WAL, 一次加锁写入 memtable
+  void write(const WriteBatch &batch,
+             WalSyncMode sync_mode = WalSyncMode::Default);
 
   using LSMIterator = Level_Iterator;
   LSMIterator begin(uint64_t tranc_id);
   LSMIterator end();
+  // 按 key 范围 [lower, upper) 迭代, 只打开与范围相交的 sst 和 block
+  LSMIterator range(uint64_t tranc_id, const std::string &lower,
+                    const std::string &upper);
   std::optional<std::pair<TwoMergeIterator, TwoMergeIterator>>
   lsm_iters_monotony_predicate(
       uint64_t tranc_id, std::function<int(const std::string &)> predicate);
+  // 在快照上迭代
+  LSMIterator begin(const Snapshot &snapshot);
+  LSMIterator range(const Snapshot &snapshot, const std::string &lower,
+                    const std::string &upper);
+  std::optional<std::pair<TwoMergeIterator, TwoMergeIterator>>
+  lsm_iters_monotony_predicate(
+      const Snapshot &snapshot,
+      std::function<int(const std::string &)> predicate);
   void clear();
   void flush();
   void flush_all();
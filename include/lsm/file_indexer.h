@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../sst/sst.h"
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tiny_lsm {
+
+/**
+ * 有序层(L1 及以上)的点查索引, 参考 RocksDB 的 FileIndexer
+ * 同一层的 sst 之间 key 不重叠, 按 key 排列. 对于第 L 层的第 i 个 sst,
+ * 预先计算下一层中第一个 last_key >= 它的 last_key 的位置 next_lb[i].
+ * 在第 L 层二分得到位置 p 后, 有 last_key[p - 1] < key <= last_key[p],
+ * 因此 key 在下一层的位置位于 [next_lb[p - 1], next_lb[p]] 之间,
+ * 逐层缩小二分的范围.
+ * 另外每层记录上一次命中的 sst, 顺序访问时直接命中或者命中下一个 sst.
+ * 各层的 sst 变化后需要重新构建
+ */
+class FileIndexer {
+public:
+  FileIndexer() = default;
+
+  // 根据各层的 sst 构建, L0 的 sst 之间 key 可能重叠, 不参与索引
+  void build(const std::map<size_t, std::deque<size_t>> &level_sst_ids,
+             const std::unordered_map<size_t, std::shared_ptr<SST>> &ssts);
+
+  // 按层从上到下追加 key 范围覆盖 key 的 sst, 每层最多一个
+  void find(const std::string &key,
+            std::vector<std::shared_ptr<SST>> &res) const;
+
+private:
+  struct FileEntry {
+    std::string first_key;
+    std::string last_key;
+    std::shared_ptr<SST> sst;
+    size_t next_lb; // 下一层中第一个 last_key >= 当前 last_key 的位置
+  };
+
+  struct LevelFiles {
+    std::vector<FileEntry> files;
+    mutable std::atomic<size_t> last_hit{0}; // 上一次命中的位置
+  };
+
+  // 在 [lo, hi) 中二分查找第一个 last_key >= key 的位置
+  static size_t lower_bound(const LevelFiles &level, const std::string &key,
+                            size_t lo, size_t hi);
+
+  // 先检查上一次命中的 sst 及其下一个, 未命中时在 [lo, hi) 中二分
+  static size_t search(const LevelFiles &level, const std::string &key,
+                       size_t lo, size_t hi);
+
+  // 元素包含原子变量, 不能移动, 使用 deque 存储
+  std::deque<LevelFiles> levels_;
+};
+} // namespace tiny_lsm
@@ -1,8 +1,10 @@
 #pragma once
 #include "../iterator/iterator.h"
+#include "../iterator/merge_iterator.h"
+#include "version.h"
 #include <memory>
 #include <optional>
-#include <shared_mutex>
+#include <string>
 
 namespace tiny_lsm {
 class LSMEngine;
@@ -11,8 +13,14 @@ class Level_Iterator : public BaseIterator {
 public:
   Level_Iterator() = default;
   Level_Iterator(std::shared_ptr<LSMEngine> engine_, uint64_t max_tranc_id);
+  // 只输出 [lower, upper) 中的 key, key 范围与之不相交的 sst 不会被打开
+  Level_Iterator(std::shared_ptr<LSMEngine> engine_, uint64_t max_tranc_id,
+                 const std::string &lower, const std::string &upper);
 
   virtual BaseIterator &operator++() override;
+  virtual BaseIterator &operator--() override;
+  void seek(const std::string &key) override;
+  void seek_for_prev(const std::string &key) override;
   virtual bool operator==(const BaseIterator &other) const override;
   virtual bool operator!=(const BaseIterator &other) const override;
   virtual value_type operator*() const override;
@@ -25,15 +33,19 @@ public:
 
 private:
   std::shared_ptr<LSMEngine> engine_;
-  std::vector<std::shared_ptr<BaseIterator>> iter_vec;
-  size_t cur_idx_;
-  uint64_t max_tranc_id_;
-  mutable std::optional<value_type> cached_value; // 缓存当前值
-  std::shared_lock<std::shared_mutex> rlock_;
+  // 按需归并 memtable、L0 的各个 sst 以及其他各层的迭代器
+  std::shared_ptr<MergeIterator> merge_;
+  bool forward_ = true; // 当前的迭代方向
+  uint64_t max_tranc_id_ = 0;
+  // 范围迭代的边界, 为空表示不限制
+  std::optional<std::string> lower_;
+  std::optional<std::string> upper_;
+  mutable std::optional<value_type> cached_value; // 缓存当前值, 为空表示结束
+  // 创建时的 sst 组成, 迭代期间 compact 可以安装新的 Version, 旧的 sst 文件在迭代器释放后才删除
+  std::shared_ptr<const Version> version_;
 
 private:
-  void update_current() const;
-  std::pair<size_t, std::string> get_min_key_idx() const;
-  void skip_key(const std::string &key);
+  // 沿当前方向取出下一个未被删除的 key 的最新版本, 并跳过它的其他版本
+  void settle();
 };
 } // namespace tiny_lsm
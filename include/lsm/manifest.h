@@ -0,0 +1,65 @@
+#pragma once
+
+#include "../utils/files.h"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace tiny_lsm {
+
+// MANIFEST 中记录的一个 sst 的元数据, 启动时不需要读取 sst 文件
+struct SstFileMeta {
+  size_t sst_id;
+  size_t level;
+  size_t file_size;
+  std::string first_key;
+  std::string last_key;
+  uint64_t min_tranc_id;
+  uint64_t max_tranc_id;
+};
+
+/**
+ * MANIFEST 记录各层 sst 的组成, 是一个只追加的变更日志,
+ * 每次变更(flush 或 compact)写入一帧:
+ * -------------------------------------------
+ * | payload_len(32) | crc32c(32) | payload |
+ * -------------------------------------------
+ * payload 由若干操作组成, 每个操作以 1 字节的类型开头:
+ *   - 新增: | 0 | sst_id(64) | level(32) | file_size(64) | min_tranc_id(64) |
+ *           | max_tranc_id(64) | first_key_len(16) | first_key |
+ *           | last_key_len(16) | last_key |
+ *   - 删除: | 1 | sst_id(64) |
+ * 启动时按顺序重放所有的帧得到当前的 sst 列表, 遇到不完整的帧时停止,
+ * 然后把当前列表写成只有一帧的新 MANIFEST, 避免文件无限增长
+ */
+class Manifest {
+public:
+  Manifest() = default;
+
+  // 读取 data_dir 下的 MANIFEST, 文件不存在时返回 std::nullopt
+  static std::optional<std::vector<SstFileMeta>>
+  load(const std::string &data_dir);
+
+  // 用完整的 sst 列表重写 MANIFEST, 先写入临时文件再重命名,
+  // 之后的变更追加到新文件中
+  void reset(const std::string &data_dir, const std::vector<SstFileMeta> &ssts);
+
+  // 追加一次变更并刷盘, 失败后之后的变更也都会失败
+  bool log_edit(const std::vector<SstFileMeta> &added,
+                const std::vector<size_t> &deleted);
+
+  static std::string get_manifest_path(const std::string &data_dir);
+
+private:
+  static void encode_edit(const std::vector<SstFileMeta> &added,
+                          const std::vector<size_t> &deleted,
+                          std::vector<uint8_t> &buf);
+
+  std::mutex mtx_;
+  FileObj file_;
+  bool opened_ = false;
+};
+} // namespace tiny_lsm
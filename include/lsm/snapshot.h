@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace tiny_lsm {
+
+// 所有未释放快照的事务 id, 由 SnapshotList 和它创建的快照共同持有,
+// 快照比 SnapshotList 存活得更久时释放也是安全的
+struct SnapshotRegistry {
+  std::mutex mtx;
+  std::multiset<uint64_t> tranc_ids;
+};
+
+// 读操作的一致性视图, 只能看到事务 id 不大于 get_tranc_id() 的版本
+// 由 SnapshotList 创建, 只能移动不能复制; 析构或调用 release 时释放,
+// 释放前 compact 会保留它能看到的版本
+class Snapshot {
+  friend class SnapshotList;
+
+public:
+  Snapshot() = default;
+  ~Snapshot();
+
+  Snapshot(const Snapshot &) = delete;
+  Snapshot &operator=(const Snapshot &) = delete;
+  Snapshot(Snapshot &&other) noexcept;
+  Snapshot &operator=(Snapshot &&other) noexcept;
+
+  uint64_t get_tranc_id() const { return tranc_id_; }
+  // 提前释放, 重复释放没有影响
+  void release();
+
+private:
+  Snapshot(std::shared_ptr<SnapshotRegistry> registry, uint64_t tranc_id);
+
+  // 已经释放或被移走时为空
+  std::shared_ptr<SnapshotRegistry> registry_;
+  uint64_t tranc_id_ = 0;
+};
+
+/**
+ * 记录所有未释放的快照
+ * compact 合并同一个 key 的多个版本时, 相邻两个快照之间只需要保留最新的一个版本,
+ * 没有快照时每个 key 只保留最新的版本
+ */
+class SnapshotList {
+public:
+  SnapshotList();
+
+  Snapshot create(uint64_t tranc_id);
+
+  // 所有未释放快照的事务 id, 从小到大排列, 可能重复
+  std::vector<uint64_t> tranc_ids() const;
+  size_t size() const;
+
+private:
+  std::shared_ptr<SnapshotRegistry> registry_;
+};
+} // namespace tiny_lsm
@@ -1,13 +1,17 @@
 #pragma once
 
 #include "../utils/files.h"
+#include "snapshot.h"
 #include "../wal/wal.h"
+#include <array>
 #include <atomic>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <set>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -32,12 +36,15 @@ public:
   TranContext(uint64_t tranc_id, std::shared_ptr<LSMEngine> engine,
               std::shared_ptr<TranManager> tranManager,
               const enum IsolationLevel &isolation_level);
+  ~TranContext();
   void put(const std::string &key, const std::string &value);
   void remove(const std::string &key);
   std::optional<std::string> get(const std::string &key);
 
   // ! test_fail = true 是测试中手动触发的崩溃
-  bool commit(bool test_fail = false);
+  // sync_mode 覆盖本次提交的 WAL 持久化策略, Default 表示使用配置
+  bool commit(bool test_fail = false,
+              WalSyncMode sync_mode = WalSyncMode::Default);
   bool abort();
   enum IsolationLevel get_isolation_level();
 
@@ -45,7 +52,8 @@ public:
   std::shared_ptr<LSMEngine> engine_;
   std::shared_ptr<TranManager> tranManager_;
   uint64_t tranc_id_;
-  std::vector<Record> operations;
+  // 按顺序记录事务的所有写操作, 提交时作为一个整体写入 WAL 和 memtable
+  WriteBatch write_batch_;
   std::unordered_map<std::string, std::string> temp_map_;
   bool isCommited = false;
   bool isAborted = false;
@@ -58,9 +66,20 @@ private:
   std::unordered_map<std::string,
                      std::optional<std::pair<std::string, uint64_t>>>
       rollback_map_;
+  // 事务结束(提交或回滚)时释放快照, 并标记事务 id 已结束
+  void finish_();
+
+  // 可重复读及以上的事务开始时已结束事务的水位上的视图, 事务的读取都在这个视图上,
+  // 提交时比它新的版本都是并发事务的写入; 结束前 compact 保留其中的版本
+  std::optional<Snapshot> snapshot_;
+  // 可串行化事务的读集合: 读取过的 key 及当时看到的版本的事务 id, 0 表示不存在
+  // 提交时校验这些 key 的最新版本没有变化(乐观并发控制)
+  std::unordered_map<std::string, uint64_t> read_set_;
 };
 
 class TranManager : public std::enable_shared_from_this<TranManager> {
+  friend class TranContext;
+
 public:
   TranManager(std::string data_dir);
   ~TranManager();
@@ -68,15 +87,30 @@ public:
   void set_engine(std::shared_ptr<LSMEngine> engine);
   std::shared_ptr<TranContext> new_tranc(const IsolationLevel &isolation_level);
 
+  // 分配新的事务 id, 在 update_max_finished_tranc_id 之前它都是运行中的事务
   uint64_t getNextTransactionId();
   uint64_t get_max_flushed_tranc_id();
+  // 已结束事务的水位: 不大于它的事务 id 都已经提交或回滚, 可以作为快照的事务 id
   uint64_t get_max_finished_tranc_id_();
 
+  // 事务提交或回滚后调用, 推进已结束事务的水位
   void update_max_finished_tranc_id(uint64_t tranc_id);
+  // 刷盘后调用, tranc_id 为刷入 sst 的最大事务 id; 实际的水位不超过已结束事务的水位
+  // 和 memtable 中的最小事务 id, 保证恢复时跳过的事务都已经在 sst 中
   void update_max_flushed_tranc_id(uint64_t tranc_id);
 
   bool write_to_wal(const std::vector<Record> &records);
 
+  // 按分片下标从小到大锁住 keys 所在的提交分片, 避免死锁
+  // 事务提交和 LSM 的普通写入都需要持有写入的 key 所在的分片, 见 commit_shards_
+  std::vector<std::unique_lock<std::mutex>>
+  lock_commit_shards(const std::vector<std::string_view> &keys);
+
+  // 将记录交给 WAL 的写线程, 返回的 future 在记录所在的批次落盘后就绪
+  std::shared_future<bool>
+  write_to_wal_async(const std::vector<Record> &records,
+                     WalSyncMode sync_mode = WalSyncMode::Default);
+
   std::map<uint64_t, std::vector<Record>> check_recover();
 
   std::string get_tranc_id_file_path();
@@ -86,6 +120,14 @@ public:
 
 private:
   mutable std::mutex mutex_;
+  // 写入的冲突域: 事务提交时按 key 的哈希锁住读写集合涉及的分片, 分片内串行化
+  // 冲突检测、写入 WAL 缓冲区和写入 memtable; LSM 的普通写入同样锁住写入的 key
+  // 所在的分片, 因此校验通过到写入 memtable 之间不会有其他写入插入.
+  // 校验不是无锁的: memtable 不支持按版本比较并交换, 冲突检测和写入只能用锁
+  // 组成原子操作; 分片让读写集合不相交的事务可以并行提交.
+  // 等待 WAL 落盘在锁外进行, 多个事务因此可以合并为一次刷盘
+  static constexpr size_t kCommitShards = 64;
+  std::array<std::mutex, kCommitShards> commit_shards_;
   std::shared_ptr<LSMEngine> engine_;
   std::shared_ptr<WAL> wal;
   std::string data_dir_;
@@ -93,6 +135,9 @@ private:
   std::atomic<uint64_t> nextTransactionId_ = 1;
   std::atomic<uint64_t> max_flushed_tranc_id_ = 0;
   std::atomic<uint64_t> max_finished_tranc_id_ = 0;
+  // 已经分配但还没有结束的事务 id, 分配和结束事务 id 时都持有 tranc_ids_mtx_
+  std::mutex tranc_ids_mtx_;
+  std::set<uint64_t> running_tranc_ids_;
   std::map<uint64_t, std::shared_ptr<TranContext>> activeTrans_;
   FileObj tranc_id_file_;
 };
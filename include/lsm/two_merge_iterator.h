@@ -7,15 +7,22 @@
 
 namespace tiny_lsm {
 
+// 合并两个迭代器, it_a 的数据比 it_b 新, key 相同时只输出 it_a 的元素
+// 支持双向迭代, 切换方向时把未被选中的迭代器重新定位到当前 key 的另一侧
 class TwoMergeIterator : public BaseIterator {
 private:
   std::shared_ptr<BaseIterator> it_a;
   std::shared_ptr<BaseIterator> it_b;
   bool choose_a = false;
+  bool forward_ = true; // 当前的迭代方向
   mutable std::shared_ptr<value_type> current; // 用于存储当前元素
   uint64_t max_tranc_id_ = 0;
 
   void update_current() const;
+  bool valid_a() const;
+  bool valid_b() const;
+  // 切换迭代方向, 未被选中的迭代器越过当前 key
+  void switch_direction();
 
 public:
   TwoMergeIterator();
@@ -27,6 +34,9 @@ public:
   void skip_it_b();
 
   virtual BaseIterator &operator++() override;
+  virtual BaseIterator &operator--() override;
+  void seek(const std::string &key) override;
+  void seek_for_prev(const std::string &key) override;
   virtual bool operator==(const BaseIterator &other) const override;
   virtual bool operator!=(const BaseIterator &other) const override;
   virtual value_type operator*() const override;
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "../sst/sst.h"
+#include "file_indexer.h"
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tiny_lsm {
+
+/**
+ * 引擎中各层 sst 组成的一个不可变快照
+ * 每次 flush 或 compact 改变 sst 的组成后, 引擎发布一个新的 Version;
+ * 点查和迭代器持有发布时的 Version 而不是 ssts_mtx 的读锁, 因此长时间的
+ * 扫描不会阻塞 compact 安装结果. Version 通过 shared_ptr 引用计数,
+ * 被 compact 移除的 sst 在最后一个引用它的 Version 或迭代器释放后才删除文件
+ */
+struct Version {
+  std::map<size_t, std::deque<size_t>> level_sst_ids;
+  std::unordered_map<size_t, std::shared_ptr<SST>> ssts;
+  // L1 及以上的点查索引
+  FileIndexer file_indexer;
+
+  // 根据各层的 sst 构建一个 Version
+  static std::shared_ptr<const Version>
+  create(const std::map<size_t, std::deque<size_t>> &level_sst_ids,
+         const std::unordered_map<size_t, std::shared_ptr<SST>> &ssts);
+
+  // 按照新 -> 旧的顺序返回 key 范围覆盖了 key 的 sst
+  std::vector<std::shared_ptr<SST>> sst_candidates(const std::string &key) const;
+};
+} // namespace tiny_lsm
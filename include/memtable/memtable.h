@@ -13,6 +13,8 @@
 #include <utility>
 #include "../iterator/iterator.h"
 #include "../skiplist/skiplist.h"
+#include "memtable_iterator.h"
+#include "write_batch.h"
 
 namespace tiny_lsm {
 
@@ -43,6 +45,11 @@ class MemTable {
 
   void put(const std::string &key, const std::string &value, uint64_t tranc_id);
   void put_batch(const std::vector<std::pair<std::string, std::string>> &kvs, uint64_t tranc_id);
+  // 在一次加锁中按顺序写入 batch 的所有操作, 读者不会看到只写入了一部分的 batch
+  void write(const WriteBatch &batch, uint64_t tranc_id);
+  // 批量加载按 key 严格递增的数据, 每个元素为 (key, value, tranc_id), value 为空表示删除
+  // 数据按单表大小限制切分到新的跳表中, 除最后一个外都会被冻结, 用于 WAL 重放
+  void load_sorted(const std::vector<std::tuple<std::string, std::string, uint64_t>> &entries);
 
   SkipListIterator get(const std::string &key, uint64_t tranc_id);
   std::vector<std::pair<std::string, std::optional<std::pair<std::string, uint64_t>>>> get_batch(
@@ -52,18 +59,27 @@ class MemTable {
 
   void clear();
   // 当MemTable中的数据量达到阈值时, 会调用这个函数将最古老的一个SST进行持久化, 形成一个Level 0的SST
+  // install 在持有冻结表的写锁时调用, 用于发布新的 sst: 读者在 memtable 中看不到这部分数据时,
+  // 之后获取的 sst 组成中一定包含新的 sst; install 抛出异常时冻结表保留在 memtable 中
   std::shared_ptr<SST> flush_last(SSTBuilder &builder, std::string &sst_path, size_t sst_id,
-                                  std::shared_ptr<BlockCache> block_cache);
+                                  std::shared_ptr<BlockCache> block_cache,
+                                  const std::function<void(const std::shared_ptr<SST> &)> &install = nullptr);
   void frozen_cur_table();
   // 获取当前活跃跳表的大小
   size_t get_cur_size();
   size_t get_frozen_size();
   size_t get_total_size();
-  HeapIterator begin(uint64_t tranc_id);
-  HeapIterator end();
-  HeapIterator iters_preffix(const std::string &preffix, uint64_t tranc_id);
+  // 所有跳表中写入过的最小事务 id, 没有数据时为 UINT64_MAX
+  uint64_t get_min_tranc_id();
+  // keep_deleted 为 true 时迭代器会输出删除标记, 供上层屏蔽 sst 中更旧的版本
+  MemTableIterator begin(uint64_t tranc_id, bool keep_deleted = false);
+  MemTableIterator end();
+  MemTableIterator iters_preffix(const std::string &preffix, uint64_t tranc_id);
+  // [lower, upper) 范围内的迭代器, 每个跳表通过查找定位范围的首尾, 不需要扫描
+  MemTableIterator range(const std::string &lower, const std::string &upper, uint64_t tranc_id,
+                         bool keep_deleted = false);
 
-  std::optional<std::pair<HeapIterator, HeapIterator>> iters_monotony_predicate(
+  std::optional<std::pair<MemTableIterator, MemTableIterator>> iters_monotony_predicate(
       uint64_t tranc_id, std::function<int(const std::string &)> predicate);
 
       void print_memtable();
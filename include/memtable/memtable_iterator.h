@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+#include "../iterator/iterator.h"
+#include "../iterator/loser_tree.h"
+#include "../skiplist/skiplist.h"
+
+namespace tiny_lsm {
+
+// *************************** MemTableIterator ***************************
+/**
+ * MemTable 的多路归并迭代器
+ * 每个跳表只保留一个游标(当前节点), 不会像 HeapIterator 一样把所有键值对拷贝出来;
+ * 游标之间通过败者树按 key 归并, 比较直接使用节点中的 key, 每次前进只需 log2(k) 次比较.
+ * 第 0 路为活跃表, 之后为冻结表, 由新到旧; key 相同时只输出第一个可见的版本
+ * 活跃表的节点可能被并发的 put 原地修改, 因此访问第 0 路时会临时持有活跃表的读锁,
+ * 冻结表不会再被修改, 访问时不需要加锁. 迭代器的生命周期不能超过所属的 MemTable
+ * 支持双向迭代: 游标总是停在某个 key 的第一个(最新的)版本上, 反向时沿 backward_ 指针移动
+ */
+class MemTableIterator : public BaseIterator {
+ public:
+  // 一路数据源: 跳表中 [begin, end) 范围内的节点
+  struct Cursor {
+    std::shared_ptr<SkipList> table;      // 所属的跳表, 用于 seek
+    std::shared_ptr<SkipListNode> begin;  // 范围内的第一个节点, 为空表示范围为空
+    std::shared_ptr<SkipListNode> end;    // 范围之后的第一个节点, 为空表示直到跳表末尾
+    std::shared_ptr<SkipListNode> node;   // 当前 key 的第一个版本, 为空表示耗尽
+  };
+
+  MemTableIterator() = default;
+  // active_mtx 为活跃表(第 0 路)的锁, 为空表示不需要加锁
+  // keep_deleted 为 true 时保留删除标记, 由上层继续屏蔽更旧的版本
+  MemTableIterator(std::vector<Cursor> cursors, std::shared_mutex *active_mtx, uint64_t max_tranc_id,
+                   bool keep_deleted = false);
+
+  static Cursor make_cursor(std::shared_ptr<SkipList> table, const SkipListIterator &begin,
+                            const SkipListIterator &end);
+
+  pointer operator->() const;
+  virtual value_type operator*() const override;
+  BaseIterator &operator++() override;
+  BaseIterator &operator--() override;
+  // 只在构造时的范围内定位
+  void seek(const std::string &key) override;
+  void seek_for_prev(const std::string &key) override;
+  virtual bool operator==(const BaseIterator &other) const override;
+  virtual bool operator!=(const BaseIterator &other) const override;
+
+  virtual IteratorType get_type() const override;
+  virtual uint64_t get_tranc_id() const override;
+  virtual bool is_end() const override;
+  virtual bool is_valid() const override;
+
+ private:
+  bool exhausted(size_t idx) const;
+  // 比较两路游标的当前 key, 耗尽的排在最后, key 相同时新的表优先
+  bool source_less(size_t a, size_t b) const;
+  void rebuild_tree();
+  // 冠军所在的游标沿当前方向移动到下一个 key 并重新比赛
+  void advance_winner();
+  // 游标定位到第一个不小于(strict 时大于) key 的 key
+  void seek_cursor(Cursor &cursor, const std::string &key, bool strict);
+  // 游标定位到最后一个不大于(strict 时小于) key 的 key
+  void seek_cursor_for_prev(Cursor &cursor, const std::string &key, bool strict);
+  // 当前 key 中第一个对事务可见的版本
+  std::shared_ptr<SkipListNode> first_visible(const std::shared_ptr<SkipListNode> &node) const;
+  // 沿当前方向定位到下一个可见的 key, 调用者需要持有活跃表的读锁
+  void settle();
+  std::shared_lock<std::shared_mutex> lock_active() const;
+
+  std::vector<Cursor> cursors_;
+  LoserTree tree_;
+  bool forward_ = true;                     // 当前的迭代方向
+  std::shared_ptr<SkipListNode> cur_node_;  // 当前输出的节点, 为空表示结束
+  size_t cur_idx_ = 0;                      // 当前节点所在的游标
+  std::shared_mutex *active_mtx_ = nullptr;
+  uint64_t max_tranc_id_ = 0;
+  bool keep_deleted_ = false;
+  mutable std::optional<value_type> current_;
+};
+}  // namespace tiny_lsm
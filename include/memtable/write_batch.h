@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace tiny_lsm {
+
+// 一组需要原子写入的 put/remove 操作
+// 操作按添加顺序追加编码到同一个缓冲区, 每个操作的格式为:
+// | type(8) | key_len(varint) | key | value_len(varint) | value |
+// remove 没有 value 部分. 写入时整个 batch 共用一个事务 id,
+// 在 WAL 中作为一个事务写入一次, 在 memtable 中一次加锁全部插入
+class WriteBatch {
+public:
+  enum class OpType : uint8_t { Put = 0, Remove = 1 };
+
+  WriteBatch() = default;
+
+  void put(const std::string &key, const std::string &value);
+  void remove(const std::string &key);
+  void clear();
+
+  // 操作的数量
+  size_t count() const;
+  bool empty() const;
+  // 编码后的字节数
+  size_t data_size() const;
+
+  // 按添加顺序遍历所有操作, remove 的 value 为空字符串
+  // 同一个 key 出现多次时, 后添加的操作覆盖先添加的操作
+  void for_each(const std::function<void(OpType, const std::string &,
+                                         const std::string &)> &fn) const;
+
+private:
+  std::vector<uint8_t> rep_;
+  size_t count_ = 0;
+};
+
+} // namespace tiny_lsm
@@ -58,6 +58,8 @@ struct SkipListNode {
 // ************************ SkipListIterator ************************
 
 class SkipListIterator : public BaseIterator {
+  friend class MemTableIterator;
+
  public:
   // ! deprecated: 构造函数，接收锁
   // SkipListIterator(std::shared_ptr<SkipListNode> node, std::shared_mutex
@@ -72,6 +74,12 @@ class SkipListIterator : public BaseIterator {
   SkipListIterator() : current(nullptr), lock(nullptr) {}
 
   virtual BaseIterator &operator++() override;
+  // 沿 backward_ 指针移动到前一个节点, 到达头节点时变为 end
+  virtual BaseIterator &operator--() override;
+  // 从当前节点出发, 沿各层的 forward_ 或 backward_ 指针查找, 代价与移动距离的对数相关
+  // 迭代器为 end 时没有出发点, 保持不变; 需要从头查找时使用 SkipList::seek
+  virtual void seek(const std::string &key) override;
+  virtual void seek_for_prev(const std::string &key) override;
   virtual bool operator==(const BaseIterator &other) const override;
   virtual bool operator!=(const BaseIterator &other) const override;
   virtual value_type operator*() const override;
@@ -88,6 +96,24 @@ class SkipListIterator : public BaseIterator {
   std::shared_ptr<std::shared_lock<std::shared_mutex>> lock;  // 持有读锁, 整个迭代器有效期间都持有读锁, memtable的锁用于保护整个跳表的读写操作，迭代器读锁用于保护迭代器范围元素的访问
 };
 
+// ************************ SkipListScan ************************
+
+// 跳表的只读顺序扫描(见 iterator/scan.h), 直接引用节点中的 key 和 value, 用于 flush
+// 不持有节点, 调用者需要保证扫描期间跳表存活且不再被修改(例如已经冻结的表)
+class SkipListScan {
+ public:
+  explicit SkipListScan(const SkipListNode *first) : node_(first) {}
+
+  bool valid() const { return node_ != nullptr; }
+  const std::string &key() const { return node_->key_; }
+  const std::string &value() const { return node_->value_; }
+  uint64_t tranc_id() const { return node_->tranc_id_; }
+  void next() { node_ = node_->forward_[0].get(); }
+
+ private:
+  const SkipListNode *node_;
+};
+
 // ************************ SkipList ************************
 
 class SkipList {
@@ -96,6 +122,7 @@ class SkipList {
   int max_level;                       // 跳表的最大层级数，限制跳表的高度
   int current_level;                   // 跳表当前的实际层级数，动态变化
   size_t size_bytes = 0;               // 跳表当前占用的内存大小（字节数），用于跟踪内存使用
+  uint64_t min_tranc_id_ = UINT64_MAX;  // 写入过的最小事务 id, 删除节点时不更新
   // std::shared_mutex rw_mutex; // ! 目前看起来这个锁是冗余的, 在上层控制即可,
   // 后续考虑是否需要细粒度的锁
 
@@ -115,13 +142,20 @@ class SkipList {
     // ... 清理资源
   }
 
-  // 插入或更新键值对
+  // 插入一个版本, 同一个 key 的多个版本按事务 id 从大到小排列
+  // key 和 tranc_id 都相同时原地更新值
   // 这里不对 tranc_id 进行检查，由上层保证 tranc_id 的合法性
   void put(const std::string &key, const std::string &value, uint64_t tranc_id);
 
+  // 批量加载按 key 严格递增的数据, 只能用于空跳表
+  // 新节点总是追加到各层的尾部, 不需要逐个查找插入位置
+  // 从 entries[start] 开始加载, 占用内存达到 size_limit 时停止, 返回下一个未加载的下标
+  size_t bulk_load(const std::vector<std::tuple<std::string, std::string, uint64_t>> &entries, size_t start,
+                   size_t size_limit);
+
   // 查找键对应的值
-  // 事务 id 为0 表示没有开启事务
-  // 否则只能查找事务 id 小于等于 tranc_id 的值
+  // 事务 id 为0 表示没有开启事务, 返回最新的版本
+  // 否则返回事务 id 小于等于 tranc_id 的最新版本
   // 返回值: 如果找到，返回 value 和 tranc_id，否则返回空
   SkipListIterator get(const std::string &key, uint64_t tranc_id);
 
@@ -131,8 +165,12 @@ class SkipList {
   // 将跳表数据刷出，返回有序键值对列表
   // value 为 真实 value 和 tranc_id 的二元组
   std::vector<std::tuple<std::string, std::string, uint64_t>> flush();
+  // 顺序扫描所有节点, 不拷贝数据
+  SkipListScan scan() const;
 
   size_t get_size();
+  // 写入过的最小事务 id, 没有写入时为 UINT64_MAX
+  uint64_t get_min_tranc_id() const;
 
   void clear();  // 清空跳表，释放内存
 
@@ -142,6 +180,11 @@ class SkipList {
   SkipListIterator end();
   SkipListIterator end_preffix(const std::string &preffix);
 
+  // 第一个 key 不小于 key 的节点, 同一个 key 有多个版本时为最新的版本
+  SkipListIterator seek(const std::string &key);
+  // 最后一个 key 不大于 key 的节点, 同一个 key 有多个版本时为最旧的版本
+  SkipListIterator seek_for_prev(const std::string &key);
+
   /**
    * @brief 查询满足谓词的一段连续区间
    * @param predicate 谓词函数， 返回值：
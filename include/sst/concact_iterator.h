@@ -3,6 +3,9 @@
 #include "sst.h"
 #include "sst_iterator.h"
 #include <memory>
+#include <optional>
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace tiny_lsm {
@@ -12,14 +15,37 @@ private:
   size_t cur_idx; // 不是真实的sst_id, 而是在需要连接的sst数组中的索引
   std::vector<std::shared_ptr<SST>> ssts;
   uint64_t max_tranc_id_;
+  // 范围迭代的 [lower, upper), 为空表示不限制范围
+  std::optional<std::pair<std::string, std::string>> bounds_;
+  size_t fixed_readahead_ = 0; // 见 SstIterator::set_readahead
+
+  // 跳过已经遍历完的 sst
+  void skip_exhausted();
+  // 反向遍历时跳过已经遍历完的 sst, 移动到上一个 sst 的末尾
+  void skip_exhausted_backward();
+  // 第 idx 个 sst 上尚未定位的迭代器, 避免读取第一个 block
+  // 范围迭代时首尾两个 sst 只访问范围内的 block
+  SstIterator unpositioned(size_t idx) const;
+  void set_end();
 
 public:
   ConcactIterator(std::vector<std::shared_ptr<SST>> ssts, uint64_t tranc_id);
+  // 只连接 key 范围与 [lower, upper) 相交的 sst, 并移动到第一个不小于 lower
+  // 的位置; 其他 sst 不会被打开
+  ConcactIterator(std::vector<std::shared_ptr<SST>> ssts, uint64_t tranc_id,
+                  const std::string &lower, const std::string &upper);
+
+  // 之后打开的每个 sst 都使用固定的预读窗口, 用于 compaction 的输入
+  void set_readahead(size_t blocks);
 
   std::string key();
   std::string value();
 
   virtual BaseIterator &operator++() override;
+  virtual BaseIterator &operator--() override;
+  // 先按 sst 的 key 范围二分找到目标 sst, 只打开这一个 sst
+  void seek(const std::string &key) override;
+  void seek_for_prev(const std::string &key) override;
   virtual bool operator==(const BaseIterator &other) const override;
   virtual bool operator!=(const BaseIterator &other) const override;
   virtual value_type operator*() const override;
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tiny_lsm {
+
+/**
+ * block 分隔 key 上的分段线性模型, 预测 key 所在 block 的下标
+ * key 去掉所有 key 的公共前缀后, 取之后的 8 个字节按大端序转换为数值,
+ * 对定长编码的 key (如有序集合中补齐的分数) 近似线性.
+ * 训练时使用收缩锥算法贪心分段, 保证每个训练点的预测误差不超过 error_bound,
+ * 查询时只需在预测位置附近的小范围内查找.
+ * 编码格式:
+ * ------------------------------------------------------------------------
+ * | prefix_len(16) | prefix | error_bound(32) | num_segments(32) |
+ * ------------------------------------------------------------------------
+ * | Segment | ... | crc32c(32) |
+ * ------------------------------------------------------------------------
+ * Segment: | start_x(64) | slope(64) | first_idx(32) | last_idx(32) |
+ */
+class LearnedIndex {
+public:
+  // 根据有序的分隔 key 训练模型, 模型不比索引小很多时返回 std::nullopt
+  static std::optional<LearnedIndex> train(const std::vector<std::string> &keys,
+                                           size_t error_bound);
+
+  // 返回 key 的 lower_bound 下标可能所在的区间 [lo, hi), hi 不超过 key 的数量
+  std::pair<size_t, size_t> predict(const std::string &key) const;
+
+  size_t num_segments() const;
+
+  void encode(std::vector<uint8_t> &out) const;
+  // 校验失败时抛出异常
+  static LearnedIndex decode(const uint8_t *data, size_t size);
+
+private:
+  struct Segment {
+    double start_x; // 第一个训练点的 key 数值
+    double slope;
+    uint32_t first_idx; // 第一个训练点的下标, 模型经过 (start_x, first_idx)
+    uint32_t last_idx;  // 最后一个训练点的下标
+  };
+
+  double to_number(const std::string &key) const;
+
+  std::string prefix_;
+  uint32_t error_bound_ = 0;
+  uint32_t num_keys_ = 0;
+  std::vector<Segment> segments_;
+};
+} // namespace tiny_lsm
@@ -5,9 +5,14 @@
 #include "../block/blockmeta.h"
 #include "../utils/bloom_filter.h"
 #include "../utils/files.h"
+#include "learned_index.h"
+#include "sst_index.h"
 #include <cstddef>
+#include <atomic>
 #include <cstdint>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -15,17 +20,46 @@
 namespace tiny_lsm {
 
 class SstIterator;
+class TableCache;
+
+// 打开 sst 后常驻内存的部分: 文件句柄、顶层索引和布隆过滤器
+// 可以被表缓存卸载, 卸载前取得引用的调用者仍然可以继续使用
+struct SstTable {
+  FileObj file;
+  std::vector<IndexPartitionMeta> index;
+  // 旧格式的 sst 没有索引分区, 加载时在内存中构建, 不经过 block cache
+  std::vector<std::shared_ptr<Block>> pinned_partitions;
+  // 可选的分段线性模型, 预测 key 所在 block 的下标
+  std::optional<LearnedIndex> learned_index;
+  size_t num_blocks = 0;
+  uint32_t bloom_offset = 0;
+  uint32_t meta_block_offset = 0;
+  std::shared_ptr<BloomFilter> bloom_filter;
+  uint64_t min_tranc_id = UINT64_MAX;
+  uint64_t max_tranc_id = 0;
+};
 
 /**
  * SST文件的结构, 参考自 https://skyzh.github.io/mini-lsm/week1-04-sst.html
- * ------------------------------------------------------------------------
- * |         Block Section         |  Meta Section | Extra                |
- * ------------------------------------------------------------------------
- * | data block | ... | data block |    metadata   | metadata offset (32) |
- * ------------------------------------------------------------------------
-
- * 其中, metadata 是一个数组加上一些描述信息, 数组每个元素由一个 BlockMeta
- 编码形成 MetaEntry, MetaEntry 结构如下:
+ * -------------------------------------------------------------------------
+ * |         Block Section         |  Index Section   |  Meta Section |
+ * -------------------------------------------------------------------------
+ * | data block | ... | data block | index partitions | top-level index |
+ * -------------------------------------------------------------------------
+ * | Bloom Section | Extra |
+ * -------------------------
+ * | bloom filter  | ...   |
+ * -------------------------
+ * 索引分区和顶层索引的格式见 SstIndex
+
+ * 其中 Extra 的结构如下:
+ * ------------------------------------------------------------------------------
+ * | meta offset (32) | bloom offset (32) | min_tranc_id (64) | max_tranc_id (64) |
+ * ------------------------------------------------------------------------------
+ * data block 均以带 hash 的形式编码 (Block::encode(true))
+
+ * 旧格式的 sst 没有 Index Section, Meta Section 是一个数组加上一些描述信息,
+ 数组每个元素由一个 BlockMeta 编码形成 MetaEntry, MetaEntry 结构如下:
  * ---------------------------------------------------------------------------------------------------
  * | offset(32) | 1st_key_len(16) | 1st_key(1st_key_len) | last_key_len(16) |
  last_key(last_key_len) |
@@ -47,23 +81,72 @@ class SST : public std::enable_shared_from_this<SST> {
       std::function<int(const std::string &)> predicate);
 
 private:
-  FileObj file;
-  std::vector<BlockMeta> meta_entries;
-  uint32_t bloom_offset;
-  uint32_t meta_block_offset;
   size_t sst_id;
   std::string first_key;
   std::string last_key;
-  std::shared_ptr<BloomFilter> bloom_filter;
   std::shared_ptr<BlockCache> block_cache;
   uint64_t min_tranc_id_ = UINT64_MAX;
   uint64_t max_tranc_id_ = 0;
+  std::string path_; // 文件路径, 为空时不能卸载后重新加载
+  size_t file_size_ = 0;
+  // 已加载的文件和索引, 为空表示尚未加载或者已经被卸载
+  std::atomic<std::shared_ptr<SstTable>> table_;
+  std::mutex load_mtx_;
+  std::shared_ptr<TableCache> table_cache_;
+  std::atomic<bool> referenced_{false}; // CLOCK 引用位, 每次访问时设置
+  std::atomic<bool> obsolete_{false};   // 已被 compact 移除, 释放时删除文件
+
+  // 返回已加载的文件和索引, 未加载时打开文件并加载
+  std::shared_ptr<SstTable> table();
+
+  // 从文件中读取尾部的 Extra、布隆过滤器和顶层索引
+  // 不修改 sst 的成员, 重新加载时可以和读取首尾 key 的线程并发
+  static std::shared_ptr<SstTable> load_table(FileObj file);
+
+  // 读取索引分区, 优先从 block cache 中获取
+  std::shared_ptr<Block> read_index_partition(SstTable &table,
+                                              size_t partition_idx);
+  // block 的索引项所在的分区及其在分区中的下标
+  std::pair<std::shared_ptr<Block>, size_t>
+  locate_index_entry(SstTable &table, size_t block_idx);
+  // block 在文件中的 (偏移, 长度)
+  std::pair<size_t, size_t> block_range(SstTable &table, size_t block_idx);
+  // block 的分隔 key, 不小于 block 中的所有 key, 小于下一个 block 的 key
+  std::string index_key(SstTable &table, size_t block_idx);
+  // [lo, hi) 中第一个分隔 key 不小于 key 的 block, 都小于 key 时返回 hi
+  size_t index_lower_bound(SstTable &table, const std::string &key, size_t lo,
+                           size_t hi);
+
+  // 从文件中读取并解码 block, 不经过缓存
+  std::shared_ptr<Block> load_block(SstTable &table, size_t block_idx);
 
 public:
   // 从文件中打开sst
   static std::shared_ptr<SST> open(size_t sst_id, FileObj file,
                                    std::shared_ptr<BlockCache> block_cache);
+  // 根据 MANIFEST 中记录的元数据延迟打开sst, 不读取文件,
+  // 第一次访问 block 时才打开文件并加载元数据和布隆过滤器
+  static std::shared_ptr<SST>
+  open_lazy(size_t sst_id, const std::string &path, size_t file_size,
+            const std::string &first_key, const std::string &last_key,
+            std::pair<uint64_t, uint64_t> tranc_id_range,
+            std::shared_ptr<BlockCache> block_cache);
+  // 保证文件和元数据已经加载, 可以提前调用以预热
+  void ensure_loaded();
+
+  // 由表缓存管理已加载的 sst, 加载时登记, 超出容量时被卸载
+  void set_table_cache(std::shared_ptr<TableCache> table_cache);
+  // 关闭文件并释放索引和布隆过滤器, 不知道文件路径时无法卸载, 返回 false
+  bool unload();
+  bool is_loaded() const;
+  // 清除引用位, 返回清除前的值
+  bool clear_referenced();
+
   void del_sst();
+  // 标记为已被移除, 最后一个引用(Version 或迭代器)释放时才删除文件,
+  // 正在读取它的迭代器不受影响
+  void mark_obsolete();
+  ~SST();
   // 创建一个sst, 只包含首尾key的元数据
   static std::shared_ptr<SST> create_sst_with_meta_only(
       size_t sst_id, size_t file_size, const std::string &first_key,
@@ -71,14 +154,29 @@ public:
   // 根据索引读取block
   std::shared_ptr<Block> read_block(size_t block_idx);
 
+  // 批量读取多个 (sst, block_idx), 未命中缓存的 block 合并为一次批量 IO
+  static std::vector<std::shared_ptr<Block>> read_blocks_batch(
+      const std::vector<std::pair<std::shared_ptr<SST>, size_t>> &reqs);
+
+  // 预读 [first_block, first_block + n) 中的 block, 用于顺序扫描
+  // std/mmap 模式提示内核在后台读入 page cache; direct 模式没有 page cache,
+  // 未缓存的 block 合并为一次批量读放入 block cache
+  void readahead(size_t first_block, size_t n);
+
   // 找到key所在的block的idx
   size_t find_block_idx(const std::string &key);
+  // 第一个可能包含不小于 key 的记录的 block, 都不满足时返回 num_blocks()
+  // 不经过布隆过滤器, 用于迭代器定位
+  size_t lower_bound_block(const std::string &key);
 
   // 根据key返回迭代器
   SstIterator get(const std::string &key, uint64_t tranc_id);
 
   // 返回sst中block的数量
-  size_t num_blocks() const;
+  size_t num_blocks();
+
+  // SST 文件使用的 IO 后端, 由配置 LSM_SST_IO_MODE 决定
+  static FileIOMode file_io_mode();
 
   // 返回sst的首key
   std::string get_first_key() const;
@@ -103,15 +201,22 @@ public:
 
 class SSTBuilder {
 private:
+  // data block 的 hash 索引利用率, 为 0 时不构建 hash 索引
+  double block_hash_util_ratio_;
   Block block;
   std::string first_key;
   std::string last_key;
-  std::vector<BlockMeta> meta_entries;
+  // 已完成的 block 的索引项 (分隔 key, 偏移和长度)
+  std::vector<std::pair<std::string, uint64_t>> index_entries;
+  // 最后一个已完成 block 的最后一个 key, 遇到下一个 key 时才能确定分隔 key
+  std::optional<std::string> pending_last_key_;
   std::vector<uint8_t> data;
   size_t block_size;
   std::shared_ptr<BloomFilter> bloom_filter;
   uint64_t min_tranc_id_ = UINT64_MAX;
   uint64_t max_tranc_id_ = 0;
+  // LearnedIndex 的误差上限, 为 0 时不训练模型
+  size_t learned_index_error_;
 
 public:
   // 创建一个sst构建器, 指定目标block的大小
@@ -119,6 +224,8 @@ public:
   void add(const std::string &key, const std::string &value, uint64_t tranc_id);
   // 估计sst的大小
   size_t estimated_size() const;
+  // 覆盖配置中的 LearnedIndex 误差上限, 为 0 时不训练模型
+  void set_learned_index_error(size_t error_bound);
   // 完成当前block的构建, 即将block写入data, 并创建新的block
   void finish_block();
   // 构建sst, 将sst写入文件并返回SST描述类
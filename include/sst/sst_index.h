@@ -0,0 +1,73 @@
+#pragma once
+
+#include "../block/block.h"
+#include "../block/blockmeta.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tiny_lsm {
+
+// 顶层索引的一项, 描述一个索引分区
+struct IndexPartitionMeta {
+  size_t offset;          // 分区在文件中的偏移量
+  size_t size;            // 分区编码后的长度
+  size_t first_block_idx; // 分区中第一个 data block 的下标
+  std::string last_key;   // 分区中最后一个索引项的 key
+};
+
+/**
+ * sst 的两级索引
+ * 每个 data block 对应一个索引项, key 是最短分隔 key: 不小于 block 的最后一个
+ * key 且小于下一个 block 的第一个 key, 最后一个 block 使用它的最后一个 key;
+ * block 的偏移和长度打包在索引项的事务 id 字段中, value 为空.
+ * 索引项按顺序切分为若干索引分区, 每个分区编码为一个 Block,
+ * 和 data block 一样通过 block cache 加载; 只有顶层索引常驻内存:
+ * ------------------------------------------------------------------------
+ * | magic(32) | num_blocks(32) | num_partitions(32) | PartitionEntry | ... |
+ * ------------------------------------------------------------------------
+ * | crc32c(32) |
+ * --------------
+ * PartitionEntry 的结构如下:
+ * ------------------------------------------------------------------------
+ * | offset(32) | size(32) | first_block_idx(32) | key_len(16) | last_key |
+ * ------------------------------------------------------------------------
+ * 顶层索引之后可以跟随一个 LearnedIndex, 直到 Meta Section 结束
+ * 旧格式的 Meta Section 以 num_entries 开头, 通过 magic 区分
+ */
+class SstIndex {
+public:
+  static constexpr uint32_t MAGIC = 0x58444953; // "SIDX"
+
+  static uint64_t pack_handle(size_t offset, size_t size);
+  // 返回 (偏移, 长度)
+  static std::pair<size_t, size_t> unpack_handle(uint64_t handle);
+
+  // 返回满足 start <= sep < limit 的尽量短的 key, 要求 start < limit
+  static std::string shortest_separator(const std::string &start,
+                                        const std::string &limit);
+
+  // 将索引项 (key, handle) 按顺序切分为索引分区, 每个分区不超过
+  // partition_size 字节, 返回各分区及其第一个 block 的下标
+  static std::vector<std::pair<std::shared_ptr<Block>, size_t>>
+  build_partitions(const std::vector<std::pair<std::string, uint64_t>> &entries,
+                   size_t partition_size);
+
+  static void
+  encode_top_level(const std::vector<IndexPartitionMeta> &partitions,
+                   size_t num_blocks, std::vector<uint8_t> &out);
+  // 输入不是新格式的顶层索引时返回 false, 格式正确但校验失败时抛出异常
+  // consumed 返回顶层索引的长度, 之后的部分是可选的 LearnedIndex
+  static bool decode_top_level(const std::vector<uint8_t> &data,
+                               std::vector<IndexPartitionMeta> &partitions,
+                               size_t &num_blocks, size_t &consumed);
+
+  // 把旧格式的 BlockMeta 数组转换为索引项, data_end 为最后一个 block 的结尾
+  static std::vector<std::pair<std::string, uint64_t>>
+  entries_from_block_metas(const std::vector<BlockMeta> &metas,
+                           size_t data_end);
+};
+} // namespace tiny_lsm
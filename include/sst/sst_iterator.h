@@ -1,6 +1,7 @@
 #pragma once
 #include "../block/block_iterator.h"
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <optional>
@@ -23,24 +24,58 @@ class SstIterator : public BaseIterator {
       std::function<int(const std::string &)> predicate);
 
   friend SST;
+  friend class ConcactIterator;
 
 private:
   std::shared_ptr<SST> m_sst;
   size_t m_block_idx;
   uint64_t max_tranc_id_;
   std::shared_ptr<BlockIterator> m_block_it;
+  // 只访问 [m_first_block, m_end_block) 中的 block, 见 set_bounds
+  size_t m_first_block = 0;
+  size_t m_end_block = SIZE_MAX;
+  // 顺序读取 block 时的预读状态
+  size_t readahead_window_ = 0; // 当前的预读窗口, 为 0 表示还没有开始预读
+  size_t readahead_end_ = 0;    // 已经提交预读的 block 的上界
+  size_t fixed_readahead_ = 0;  // 固定的预读窗口, 为 0 时自适应
   mutable std::optional<value_type> cached_value; // 缓存当前值
 
   void update_current() const;
   void set_block_idx(size_t idx);
   void set_block_it(std::shared_ptr<BlockIterator> it);
+  // 当前 block 已经没有可见记录时, 移动到下一个 block
+  void skip_empty_blocks();
+  // 反向移动时当前 block 已经没有更小的可见记录, 移动到上一个 block 的末尾
+  void skip_empty_blocks_backward();
+  // 打开第 idx 个 block, 已经打开时复用当前的 BlockIterator
+  void open_block(size_t idx);
+  void set_end();
+  // 允许访问的最后一个 block 之后的下标
+  size_t end_block();
+  // 顺序进入第 m_block_idx 个 block 时调用, 已预读的 block 用掉一半后
+  // 加倍窗口(不超过配置的上限)并预读之后的 block
+  void readahead_sequential();
+  // 随机定位后重新检测顺序访问
+  void reset_readahead();
 
 public:
   // 创建迭代器, 并移动到第一个key
   SstIterator(std::shared_ptr<SST> sst, uint64_t tranc_id);
-  // 创建迭代器, 并移动到第指定key
+  // 创建迭代器, 并移动到第一个不小于 key 的位置
   SstIterator(std::shared_ptr<SST> sst, const std::string &key,
               uint64_t tranc_id);
+  // 创建只访问 [lower, upper) 所在 block 的迭代器, 并移动到第一个不小于 lower
+  // 的位置
+  SstIterator(std::shared_ptr<SST> sst, const std::string &lower,
+              const std::string &upper, uint64_t tranc_id);
+
+  // 只访问可能包含 [lower, upper) 中 key 的 block, 不移动迭代器
+  // 边界 block 中仍然可能输出范围之外的 key, 由上层比较 key 过滤
+  void set_bounds(const std::string &lower, const std::string &upper);
+
+  // 使用固定的预读窗口(单位为 block), 用于 compaction 等整个 sst 的顺序扫描
+  // blocks 为 0 时恢复自适应预读
+  void set_readahead(size_t blocks);
 
   // 创建迭代器, 并移动到第指定前缀的首端或者尾端
   static std::optional<std::pair<SstIterator, SstIterator>>
@@ -48,11 +83,14 @@ public:
                            std::function<bool(const std::string &)> predicate);
 
   void seek_first();
-  void seek(const std::string &key);
+  void seek_to_last();
+  void seek(const std::string &key) override;
+  void seek_for_prev(const std::string &key) override;
   std::string key();
   std::string value();
 
   virtual BaseIterator &operator++() override;
+  virtual BaseIterator &operator--() override;
   virtual bool operator==(const BaseIterator &other) const override;
   virtual bool operator!=(const BaseIterator &other) const override;
   virtual value_type operator*() const override;
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "../block/block.h"
+#include "sst.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tiny_lsm {
+
+// *************************** SstScan ***************************
+/**
+ * sst 的只读顺序扫描(见 iterator/scan.h), 用作 compaction 的输入
+ * 输出所有版本, 不做事务过滤; key 和 value 读入复用的缓冲区,
+ * 按固定窗口预读后续的 block
+ */
+class SstScan {
+public:
+  SstScan() = default;
+  // readahead_blocks 为 0 时不预读
+  SstScan(std::shared_ptr<SST> sst, size_t readahead_blocks);
+
+  bool valid() const { return block_ != nullptr; }
+  const std::string &key() const { return key_; }
+  const std::string &value() const { return value_; }
+  uint64_t tranc_id() const { return tranc_id_; }
+
+  void next() {
+    if (++entry_idx_ < block_entries_) {
+      block_->read_entry_at_idx(entry_idx_, key_, value_, tranc_id_);
+      return;
+    }
+    load_block(block_idx_ + 1);
+  }
+
+private:
+  // 打开第 block_idx 个 block 并读取第一个元素, 越过最后一个 block 时结束
+  void load_block(size_t block_idx);
+
+  std::shared_ptr<SST> sst_;
+  size_t num_blocks_ = 0;
+  size_t readahead_blocks_ = 0;
+  size_t readahead_end_ = 0; // 已经预读到的 block 下标(不含)
+  std::shared_ptr<Block> block_;
+  size_t block_idx_ = 0;
+  size_t block_entries_ = 0;
+  size_t entry_idx_ = 0;
+  std::string key_;
+  std::string value_;
+  uint64_t tranc_id_ = 0;
+};
+
+// *************************** LevelScan ***************************
+// 依次扫描同一层中按 key 有序且互不重叠的 sst
+class LevelScan {
+public:
+  LevelScan(std::vector<std::shared_ptr<SST>> ssts, size_t readahead_blocks);
+
+  bool valid() const { return cur_.valid(); }
+  const std::string &key() const { return cur_.key(); }
+  const std::string &value() const { return cur_.value(); }
+  uint64_t tranc_id() const { return cur_.tranc_id(); }
+
+  void next() {
+    cur_.next();
+    if (!cur_.valid()) {
+      open_next();
+    }
+  }
+
+private:
+  // 打开下一个非空的 sst
+  void open_next();
+
+  std::vector<std::shared_ptr<SST>> ssts_;
+  size_t next_idx_ = 0;
+  size_t readahead_blocks_;
+  SstScan cur_;
+};
+} // namespace tiny_lsm
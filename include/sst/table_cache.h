@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+
+namespace tiny_lsm {
+
+class SST;
+
+// 限制同时打开的 sst 数量, 超出容量时卸载冷的 sst:
+// 关闭文件并释放 block 索引和布隆过滤器, 下次访问时重新加载
+// 使用 CLOCK 近似 LRU: 访问 sst 只设置一个引用位, 不需要加锁
+class TableCache {
+public:
+  explicit TableCache(size_t capacity);
+
+  // sst 加载完成后登记, 超出容量时按 CLOCK 顺序卸载其他的 sst
+  void insert(const std::shared_ptr<SST> &sst);
+
+  // 当前登记的 sst 数量
+  size_t size();
+
+  size_t capacity() const { return capacity_; }
+
+private:
+  // 调用者需持有 mtx_
+  void evict_();
+
+  size_t capacity_;
+  std::mutex mtx_;
+  // 已加载的 sst, hand_ 指向下一个检查的位置
+  std::list<std::weak_ptr<SST>> tables_;
+  std::list<std::weak_ptr<SST>>::iterator hand_;
+};
+} // namespace tiny_lsm
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tiny_lsm {
+
+// 访问模式提示, 只对支持的后端生效
+enum class FileAccessHint {
+  Normal,
+  Random,     // 随机读, 关闭预读
+  Sequential, // 顺序读, 加大预读
+  WillNeed,   // 即将访问, 提前载入
+};
+
+// 文件后端的统一接口, FileObj 通过它屏蔽具体的 IO 实现
+class BaseFile {
+public:
+  virtual ~BaseFile() = default;
+
+  // 打开文件
+  virtual bool open(const std::string &filename, bool create) = 0;
+
+  // 创建文件并写入初始内容
+  virtual bool create(const std::string &filename,
+                      std::vector<uint8_t> &buf) = 0;
+
+  // 关闭文件
+  virtual void close() = 0;
+
+  // 获取文件大小
+  virtual size_t size() = 0;
+
+  // 写入数据
+  virtual bool write(size_t offset, const void *data, size_t size) = 0;
+
+  // 读取数据
+  virtual std::vector<uint8_t> read(size_t offset, size_t length) = 0;
+
+  // 同步到磁盘
+  virtual bool sync() = 0;
+
+  // 删除文件
+  virtual bool remove() = 0;
+
+  // 访问模式提示, 默认忽略
+  virtual void advise(size_t /*offset*/, size_t /*length*/,
+                      FileAccessHint /*hint*/) {}
+};
+} // namespace tiny_lsm
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tiny_lsm {
+
+// CRC32C (Castagnoli), 用于校验 WAL 帧
+// x86 上支持 SSE4.2 时使用 crc32 指令, aarch64 上使用 CRC 扩展, 否则查表计算
+// crc 为之前数据的校验值, 用于分段计算
+uint32_t crc32c(const void *data, size_t length, uint32_t crc = 0);
+
+} // namespace tiny_lsm
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "base_file.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tiny_lsm {
+
+// 绕过 page cache 的文件后端:
+//   - 读: O_DIRECT + 对齐缓冲区的 pread, 批量读优先使用 io_uring
+//   - 写: 普通 fd 写入, sync 时 fdatasync 并丢弃对应的 page cache
+// 这样 SST 的数据只会缓存在 BlockCache 中, 不会在内核中再缓存一份
+// 文件系统不支持 O_DIRECT(例如 tmpfs)时退化为普通 pread
+class DirectFile;
+
+// 跨文件批量读的一个区间
+struct DirectReadRange {
+  DirectFile *file;
+  size_t offset;
+  size_t length;
+};
+
+class DirectFile : public BaseFile {
+public:
+  // O_DIRECT 要求偏移, 长度和缓冲区地址都按逻辑块大小对齐
+  static constexpr size_t kAlignment = 4096;
+
+  DirectFile() = default;
+  ~DirectFile() override { close(); }
+
+  DirectFile(const DirectFile &) = delete;
+  DirectFile &operator=(const DirectFile &) = delete;
+
+  bool open(const std::string &filename, bool create) override;
+
+  bool create(const std::string &filename,
+              std::vector<uint8_t> &buf) override;
+
+  void close() override;
+
+  size_t size() override { return file_size_; }
+
+  bool write(size_t offset, const void *data, size_t size) override;
+
+  std::vector<uint8_t> read(size_t offset, size_t length) override;
+
+  // 批量读取多个区间, 一次 io_uring 提交完成; 不支持时逐个 pread
+  std::vector<std::vector<uint8_t>>
+  read_batch(const std::vector<std::pair<size_t, size_t>> &ranges);
+
+  // 同上, 但区间可以来自不同的文件
+  static std::vector<std::vector<uint8_t>>
+  read_batch(const std::vector<DirectReadRange> &ranges);
+
+  bool sync() override;
+
+  bool remove() override;
+
+  // 是否真正启用了 O_DIRECT
+  bool is_direct() const { return direct_; }
+
+private:
+  int fd_ = -1;        // 读描述符, 尽量带 O_DIRECT
+  int write_fd_ = -1;  // 写描述符, 按需打开
+  bool direct_ = false;
+  size_t file_size_ = 0;
+  std::string filename_;
+
+  bool open_write_fd();
+};
+} // namespace tiny_lsm
@@ -1,19 +1,42 @@
 #pragma once
 
+#include "base_file.h"
+#include "direct_file.h"
 #include "mmap_file.h"
 #include "std_file.h"
 #include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace tiny_lsm {
 
+// 文件对象使用的 IO 后端
+enum class FileIOMode {
+  Std,        // std::fstream, 经过 page cache
+  Direct,     // O_DIRECT + pread/io_uring, 绕过 page cache
+  Mmap,       // 只读 mmap, 读取 block 时不拷贝数据
+  MmapAppend, // 可写 mmap, 按块预分配空间, 用于 WAL 等追加写的文件
+};
+
+class FileObj;
+
+// 跨文件批量读的一个区间
+struct FileReadRange {
+  FileObj *file;
+  size_t offset;
+  size_t length;
+};
+
 class FileObj {
 private:
-  std::unique_ptr<StdFile> m_file;
+  std::unique_ptr<BaseFile> m_file;
   size_t m_size;
+  FileIOMode m_mode;
+
+  explicit FileObj(FileIOMode mode);
 
 public:
   FileObj();
@@ -31,6 +54,9 @@ public:
   // 文件大小
   size_t size() const;
 
+  // 文件使用的 IO 后端
+  FileIOMode mode() const;
+
   // 设置文件大小
   void set_size(size_t size);
 
@@ -39,14 +65,36 @@ public:
 
   // 创建文件对象, 并写入到磁盘
   static FileObj create_and_write(const std::string &path,
-                                  std::vector<uint8_t> buf);
+                                  std::vector<uint8_t> buf,
+                                  FileIOMode mode = FileIOMode::Std);
 
   // 打开文件对象
-  static FileObj open(const std::string &path, bool create);
+  static FileObj open(const std::string &path, bool create,
+                      FileIOMode mode = FileIOMode::Std);
+
+  // 以 MmapAppend 模式覆盖写一个已有的文件, 逻辑大小从 0 开始, 保留原有的文件空间
+  static FileObj reuse(const std::string &path);
+
+  // 解析配置中的 IO 模式字符串, 未知的取值按 Std 处理
+  static FileIOMode io_mode_from_string(const std::string &mode);
 
   // 读取并返回切片
   std::vector<uint8_t> read_to_slice(size_t offset, size_t length);
 
+  // 批量读取多个切片, Direct 模式下一次 io_uring 提交完成
+  std::vector<std::vector<uint8_t>>
+  read_batch(const std::vector<std::pair<size_t, size_t>> &ranges);
+
+  // 跨文件的批量读取, Direct 模式的文件合并为一次 io_uring 提交
+  static std::vector<std::vector<uint8_t>>
+  read_batch(const std::vector<FileReadRange> &ranges);
+
+  // 零拷贝读取, 只有 Mmap 模式支持, 其他模式返回 nullptr
+  std::shared_ptr<const uint8_t> view(size_t offset, size_t length);
+
+  // 访问模式提示
+  void advise(size_t offset, size_t length, FileAccessHint hint);
+
   // 读取 uint8_t
   uint8_t read_uint8(size_t offset);
 
@@ -66,5 +114,12 @@ public:
   bool append(std::vector<uint8_t> &buf);
 
   bool sync();
+
+  // 预分配 size 大小的空间, 只有 MmapAppend 模式支持, Std/Direct 模式下不做处理
+  bool preallocate(size_t size);
+
+  // 同步指定区间, async 为 true 时只提交回写而不等待
+  // 只有 MmapAppend 模式支持按区间同步, 其他模式退化为 sync
+  bool sync_range(size_t offset, size_t length, bool async);
 };
 } // namespace tiny_lsm
\ No newline at end of file
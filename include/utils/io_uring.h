@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <vector>
+
+namespace tiny_lsm {
+
+// 一次读请求的描述, buf 由调用者保证对齐与生命周期
+struct IoReadRequest {
+  int fd;
+  void *buf;
+  size_t length;
+  size_t offset;
+};
+
+// 基于 io_uring 系统调用的最小封装, 只用于批量提交读请求
+// 不依赖 liburing; 内核不支持(或被 seccomp 禁用)时 valid() 返回 false,
+// 调用者需要自行回退到 pread
+class IoUring {
+public:
+  explicit IoUring(unsigned entries = 64);
+  ~IoUring();
+
+  IoUring(const IoUring &) = delete;
+  IoUring &operator=(const IoUring &) = delete;
+
+  bool valid() const { return ring_fd_ >= 0; }
+
+  // 批量提交读请求并等待全部完成
+  // 返回值与请求一一对应: >=0 为读取的字节数, <0 为 -errno
+  // 返回时不会有仍在进行的读, 失败的请求可以直接用原来的缓冲区重试
+  std::vector<int> read_batch(const std::vector<IoReadRequest> &reqs);
+
+  // 每个线程一个 ring, 避免提交队列上的锁竞争
+  static IoUring &thread_local_ring();
+
+private:
+  int ring_fd_ = -1;
+  unsigned sq_entries_ = 0;
+
+  void *sq_ring_ptr_ = nullptr;
+  void *cq_ring_ptr_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  size_t cq_ring_size_ = 0;
+  io_uring_sqe *sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+
+  unsigned *sq_head_ = nullptr;
+  unsigned *sq_tail_ = nullptr;
+  unsigned *sq_mask_ = nullptr;
+  unsigned *sq_array_ = nullptr;
+  unsigned *cq_head_ = nullptr;
+  unsigned *cq_tail_ = nullptr;
+  unsigned *cq_mask_ = nullptr;
+  io_uring_cqe *cqes_ = nullptr;
+
+  void release();
+};
+} // namespace tiny_lsm
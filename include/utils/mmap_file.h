@@ -1,8 +1,10 @@
 #pragma once
 
+#include "base_file.h"
 #include <cstddef>
 #include <cstdint>
 #include <fcntl.h>
+#include <memory>
 #include <string>
 #include <sys/mman.h>
 #include <unistd.h>
@@ -10,47 +12,112 @@
 
 namespace tiny_lsm {
 
-class MmapFile {
+// 一段 mmap 映射, 析构时 munmap
+struct MmapRegion {
+  uint8_t *addr = nullptr;
+  size_t length = 0;
+
+  MmapRegion(uint8_t *addr, size_t length) : addr(addr), length(length) {}
+  ~MmapRegion() {
+    if (addr != nullptr) {
+      munmap(addr, length);
+    }
+  }
+
+  MmapRegion(const MmapRegion &) = delete;
+  MmapRegion &operator=(const MmapRegion &) = delete;
+};
+
+// 基于 mmap 的文件后端, 有两种模式:
+//   - 只读: 用于不可变的 SST, 可以通过 view 零拷贝地引用映射区域
+//   - 读写: 用于追加写, 文件按块预分配(fallocate)并通过 mremap 扩展映射,
+//     file_size_ 记录逻辑末尾, 关闭时截断掉预分配的尾部;
+//     通过 preallocate 或 reuse 得到的空间在关闭时保留, 供日志文件回收复用
+// 注意: 读写模式下进程崩溃时文件尾部可能残留预分配的 0,
+// 上层的格式需要能够识别这部分无效数据
+class MmapFile : public BaseFile {
 private:
-  int fd_;               // 文件描述符
-  void *mapped_data_;    // 映射的内存地址
-  size_t file_size_;     // 文件大小
-  std::string filename_; // 文件名
+  int fd_;                             // 文件描述符
+  std::shared_ptr<MmapRegion> region_; // 当前映射, 只读模式下可被 Block 共享
+  size_t file_size_;                   // 逻辑文件大小, 即已写入数据的末尾
+  size_t capacity_;                    // 已预分配并映射的大小
+  size_t dirty_begin_;                 // 尚未 sync 的区间 [begin, end)
+  size_t dirty_end_;
+  size_t writeback_end_;               // 已经提交异步回写的位置
+  std::string filename_;               // 文件名
+  bool read_only_;                     // 只读映射, 用于不可变的 SST
+  bool keep_capacity_;                 // 关闭时保留预分配的空间
+
+  // 每次扩展的最小/最大预分配大小
+  static constexpr size_t kMinGrowSize = 1 << 20;  // 1MB
+  static constexpr size_t kMaxGrowSize = 64 << 20; // 64MB
+  // 脏数据累计到该大小时提交一次异步回写, 避免 sync 时积压
+  static constexpr size_t kWritebackChunk = 4 << 20; // 4MB
 
   // 获取映射的内存指针
-  void *data() const { return mapped_data_; }
+  uint8_t *data() const { return region_ ? region_->addr : nullptr; }
+
+  // 按照当前的模式映射 [0, size)
+  bool map(size_t size);
+
+  // 保证预分配的空间至少为 size
+  bool reserve(size_t size);
 
-  // 创建文件并映射到内存
-  bool create_and_map(const std::string &path, size_t size);
+  // 预分配磁盘空间并扩展映射到 new_capacity
+  bool extend(size_t new_capacity);
 
 public:
-  MmapFile() : fd_(-1), mapped_data_(nullptr), file_size_(0) {}
-  ~MmapFile() { close(); }
+  explicit MmapFile(bool read_only = false)
+      : fd_(-1), region_(nullptr), file_size_(0), capacity_(0),
+        dirty_begin_(0), dirty_end_(0), writeback_end_(0),
+        read_only_(read_only), keep_capacity_(false) {}
+  ~MmapFile() override { close(); }
 
   // 打开文件并映射到内存
-  bool open(const std::string &filename, bool create = false);
+  bool open(const std::string &filename, bool create = false) override;
+
+  // 以覆盖写的方式打开已有文件: 逻辑大小从 0 开始, 已有的文件空间作为预分配空间,
+  // 旧数据不会被清零, 由上层的格式识别; 只有读写模式支持
+  bool reuse(const std::string &filename);
+
+  // 一次性预分配 size 大小的空间, 之后的追加写在此范围内不会改变文件大小
+  bool preallocate(size_t size);
 
   // 创建文件
-  bool create(const std::string &filename, std::vector<uint8_t> &buf);
+  bool create(const std::string &filename, std::vector<uint8_t> &buf) override;
 
-  // 关闭文件
-  void close();
+  // 关闭文件, 读写模式下会先 sync 并截断预分配的尾部
+  void close() override;
 
   // 获取文件大小
-  size_t size() const { return file_size_; }
+  size_t size() override { return file_size_; }
 
-  // 写入数据
-  bool write(size_t offset, const void *data, size_t size);
+  // 写入数据, 只读模式下返回 false
+  // 写入只修改映射区域, 持久化需要调用 sync
+  bool write(size_t offset, const void *data, size_t size) override;
 
   // 读取数据
-  std::vector<uint8_t> read(size_t offset, size_t length);
+  std::vector<uint8_t> read(size_t offset, size_t length) override;
+
+  // 只读模式下返回 [offset, offset + length) 的零拷贝视图
+  // 视图与映射共享生命周期, 文件关闭后依然有效; 其他情况返回 nullptr
+  std::shared_ptr<const uint8_t> view(size_t offset, size_t length) const;
+
+  // 同步所有尚未落盘的数据
+  bool sync() override;
+
+  // 同步指定区间, async 为 true 时只提交回写而不等待
+  bool sync_range(size_t offset, size_t length, bool async);
+
+  // 删除文件
+  bool remove() override;
 
-  // 同步到磁盘
-  bool sync();
+  // madvise 访问模式提示
+  void advise(size_t offset, size_t length, FileAccessHint hint) override;
 
 private:
   // 禁止拷贝
   MmapFile(const MmapFile &) = delete;
   MmapFile &operator=(const MmapFile &) = delete;
 };
-} // namespace tiny_lsm
\ No newline at end of file
+} // namespace tiny_lsm
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "base_file.h"
+#include <atomic>
 #include <cstddef>
 #include <filesystem>
 #include <fstream>
@@ -7,42 +9,49 @@
 #include <vector>
 
 namespace tiny_lsm {
-class StdFile {
+class StdFile : public BaseFile {
 
 private:
   std::fstream file_;
   std::filesystem::path filename_;
+  // fstream 不暴露文件描述符, 预读提示使用单独打开的只读描述符,
+  // 第一次提示时打开, 多个线程同时提示时只保留一个
+  std::atomic<int> advise_fd_{-1};
 
 public:
   StdFile() {}
-  ~StdFile() {
+  ~StdFile() override {
     if (file_.is_open()) {
       close();
     }
   }
 
   // 打开文件并映射到内存
-  bool open(const std::string &filename, bool create);
+  bool open(const std::string &filename, bool create) override;
 
   // 创建文件
-  bool create(const std::string &filename, std::vector<uint8_t> &buf);
+  bool create(const std::string &filename,
+              std::vector<uint8_t> &buf) override;
 
   // 关闭文件
-  void close();
+  void close() override;
 
   // 获取文件大小
-  size_t size();
+  size_t size() override;
 
   // 写入数据
-  bool write(size_t offset, const void *data, size_t size);
+  bool write(size_t offset, const void *data, size_t size) override;
 
   // 读取数据
-  std::vector<uint8_t> read(size_t offset, size_t length);
+  std::vector<uint8_t> read(size_t offset, size_t length) override;
 
   // 同步到磁盘
-  bool sync();
+  bool sync() override;
 
   // 删除文件
-  bool remove();
+  bool remove() override;
+
+  // 通过 posix_fadvise 提示内核, WillNeed 会在后台把区间读入 page cache
+  void advise(size_t offset, size_t length, FileAccessHint hint) override;
 };
 } // namespace tiny_lsm
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../memtable/write_batch.h"
 #include <cstdint>
 #include <iostream>
 #include <stdexcept>
@@ -30,13 +31,31 @@ public:
   static Record putRecord(uint64_t tranc_id, const std::string &key,
                           const std::string &value);
   static Record deleteRecord(uint64_t tranc_id, const std::string &key);
+  // 将 batch 中的操作按顺序转换为同一事务的 PUT/DELETE 记录, 追加到 records
+  static void batchRecords(uint64_t tranc_id, const WriteBatch &batch,
+                           std::vector<Record> &records);
 
-  // 编码记录
+  // 编码记录, 追加到 buf 的末尾
+  void encode(std::vector<uint8_t> &buf) const;
   std::vector<uint8_t> encode() const;
 
-  // 解码记录
+  // 解码连续编码的多条记录, 遇到不完整的记录时停止
   static std::vector<Record> decode(const std::vector<uint8_t> &data);
 
+  // WAL 中的记录以帧为单位写入, 一次组提交对应一帧:
+  // | payload_len(32) | crc32c(32) | payload |
+  // payload 为帧内所有记录的编码, 校验和同时覆盖日志文件的序号 log_seq,
+  // 回收复用的日志文件中残留的旧帧无法通过校验
+  static void encode_frame(const std::vector<Record> &records,
+                           std::vector<uint8_t> &buf, uint64_t log_seq = 0);
+
+  // 依次解码所有的帧, 遇到长度为 0、越界或者校验失败的帧时停止,
+  // 即忽略预分配的空间、复用文件的旧数据和崩溃时写入不完整的尾部
+  static std::vector<Record> decode_frames(const uint8_t *data, size_t size,
+                                           uint64_t log_seq = 0);
+  static std::vector<Record> decode_frames(const std::vector<uint8_t> &data,
+                                           uint64_t log_seq = 0);
+
   // 获取记录的各个部分
   uint64_t getTrancId() const { return tranc_id_; }
   OperationType getOperationType() const { return operation_type_; }
@@ -50,10 +69,12 @@ public:
   bool operator!=(const Record &other) const;
 
 private:
+  static bool decode_records(const uint8_t *p, const uint8_t *end,
+                             std::vector<Record> &records);
+
   uint64_t tranc_id_;
   OperationType operation_type_;
   std::string key_;
   std::string value_;
-  uint16_t record_len_;
 };
 } // namespace tiny_lsm
\ No newline at end of file
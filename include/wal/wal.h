@@ -7,7 +7,10 @@
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
+#include <deque>
+#include <future>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
@@ -15,24 +18,88 @@
 
 namespace tiny_lsm {
 
+// WAL 的持久化策略, 类似 redis 的 appendfsync
+enum class WalSyncMode {
+  Default,  // 使用 WAL 配置的策略, 只用于单次调用的覆盖参数
+  Always,   // 每次提交都等待刷盘
+  Periodic, // 写入文件后返回, 由后台线程定期刷盘
+  None,     // 写入文件后返回, 由操作系统决定何时刷盘
+};
+
+// WAL 采用组提交: 调用者只把记录追加到缓冲区,
+// 由唯一的写线程把一段时间内积累的记录合并为一次写入和一次刷盘
+// 日志文件创建时预分配到 file_size_limit, recycle_num > 0 时清理线程把不再需要的
+// 文件重命名为 recycle.<seq> 留待复用, 切换文件时优先覆盖写回收的文件
 class WAL {
 public:
   WAL(const std::string &log_dir, size_t buffer_size,
       uint64_t max_finished_tranc_id, uint64_t clean_interval,
-      uint64_t file_size_limit);
+      uint64_t file_size_limit,
+      WalSyncMode sync_mode = WalSyncMode::Always,
+      uint64_t sync_interval_ms = 1000, size_t recycle_num = 0);
   ~WAL();
 
+  // 解析配置中的持久化策略: "always", "periodic", "none", 未知的取值按 Always
+  static WalSyncMode sync_mode_from_string(const std::string &mode);
+
   static std::map<uint64_t, std::vector<Record>>
   recover(const std::string &log_dir, uint64_t max_finished_tranc_id);
 
-  // 将记录添加到缓冲区
+  // 将记录添加到缓冲区, force_flush 为 true 时等待记录落盘
   void log(const std::vector<Record> &records, bool force_flush = false);
 
-  // 写入 WAL 文件
+  // 提交一组记录, 返回的 future 在记录所在的批次完成后就绪:
+  // Always 模式下为刷盘完成, 其他模式下为写入文件完成
+  // mode 为 Default 时使用 WAL 配置的策略
+  std::shared_future<bool>
+  log_async(const std::vector<Record> &records,
+            WalSyncMode mode = WalSyncMode::Default);
+
+  // 写入 WAL 文件并刷盘
   void flush();
 
+  // 更新已经刷入 sst 的最大事务 id, 不超过该 id 的日志文件可以被清理
+  void set_max_finished_tranc_id(uint64_t tranc_id);
+
 private:
+  // 同一批次的提交者共享一个 promise
+  struct CommitGroup {
+    std::promise<bool> promise;
+    std::shared_future<bool> future;
+    bool need_write = false; // 需要立即写入文件
+    bool need_sync = false;  // 需要立即写入文件并刷盘
+
+    CommitGroup() : future(promise.get_future().share()) {}
+  };
+
+  // 将记录添加到缓冲区, 按需唤醒写线程
+  std::shared_future<bool> enqueue(const std::vector<Record> &records,
+                                   bool write, bool sync);
+
+  void writer();
   void cleaner();
+  // Periodic 模式下定期请求写线程刷盘
+  void syncer();
+
+  // 将一个批次的数据写入当前日志文件, 超出大小限制时切换到新文件
+  bool write_group(std::vector<uint8_t> &data, bool sync);
+
+  // 打开序号为 seq 的日志文件作为当前文件, 优先复用回收的文件
+  void open_log_file(uint64_t seq);
+  // 处理一个不再需要的日志文件: 回收池未满时留待复用, 否则删除
+  void retire_log_file(uint64_t seq, const std::string &path);
+
+  // 读取并解码序号为 seq 的日志文件, 只保留事务 id 大于 max_flushed_tranc_id 的记录
+  static std::vector<Record> read_log_file(const std::string &path,
+                                           uint64_t seq,
+                                           uint64_t max_flushed_tranc_id);
+
+  // 日志文件名为 wal.<seq>, 等待复用的文件名为 recycle.<seq>
+  static std::string get_log_path(const std::string &log_dir, uint64_t seq);
+  static std::string get_recycle_path(const std::string &log_dir,
+                                      uint64_t seq);
+  static std::vector<std::pair<uint64_t, std::string>>
+  list_log_files(const std::string &log_dir);
 
 protected:
   std::string active_log_path_;
@@ -42,7 +109,24 @@ protected:
   std::vector<Record> log_buffer_;
   size_t buffer_size_;
   std::thread cleaner_thread_;
-  uint64_t max_finished_tranc_id_;
+  std::atomic<uint64_t> max_finished_tranc_id_;
   uint64_t clean_interval_;
+
+private:
+  std::string log_dir_;
+  std::atomic<uint64_t> active_seq_; // 当前日志文件的序号, 清理线程会跳过它
+  std::shared_ptr<CommitGroup> group_; // 正在积累的批次, 由 mutex_ 保护
+  std::condition_variable writer_cv_;
+  std::thread writer_thread_;
+  std::condition_variable cleaner_cv_;
+  WalSyncMode sync_mode_;
+  uint64_t sync_interval_ms_;
+  std::atomic<bool> has_unsynced_; // 有写入文件但还没有刷盘的数据
+  std::thread syncer_thread_;
+  std::condition_variable syncer_cv_;
+  bool stop_ = false; // 由 mutex_ 保护
+  size_t recycle_num_;
+  std::mutex recycle_mtx_;
+  std::deque<std::string> recycle_files_; // 等待复用的文件, 由 recycle_mtx_ 保护
 };
-} // namespace tiny_lsm
\ No newline at end of file
+} // namespace tiny_lsm
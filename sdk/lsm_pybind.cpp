@@ -40,13 +40,34 @@ using TranContext = tiny_lsm::TranContext;
 void bind_TranContext(py::module &m) {
   py::class_<TranContext, std::shared_ptr<TranContext>>(m, "TranContext")
       .def("commit", &tiny_lsm::TranContext::commit,
-           py::arg("test_fail") = false) // 处理默认参数
+           py::arg("test_fail") = false,
+           py::arg("sync_mode") = tiny_lsm::WalSyncMode::Default) // 处理默认参数
       .def("abort", &tiny_lsm::TranContext::abort)
       .def("get", &tiny_lsm::TranContext::get)
       .def("remove", &tiny_lsm::TranContext::remove)
       .def("put", &tiny_lsm::TranContext::put);
 }
 
+void bind_Snapshot(py::module &m) {
+  // 快照对象被回收时自动释放, 也可以通过 release 或 with 语句提前释放
+  py::class_<tiny_lsm::Snapshot>(m, "Snapshot")
+      .def("get_tranc_id", &tiny_lsm::Snapshot::get_tranc_id)
+      .def("release", &tiny_lsm::Snapshot::release)
+      .def("__enter__", [](tiny_lsm::Snapshot &self) -> tiny_lsm::Snapshot & { return self; },
+           py::return_value_policy::reference)
+      .def("__exit__", [](tiny_lsm::Snapshot &self, py::args) { self.release(); });
+}
+
+void bind_WriteBatch(py::module &m) {
+  py::class_<tiny_lsm::WriteBatch>(m, "WriteBatch")
+      .def(py::init<>())
+      .def("put", &tiny_lsm::WriteBatch::put, py::arg("key"), py::arg("value"))
+      .def("remove", &tiny_lsm::WriteBatch::remove, py::arg("key"))
+      .def("clear", &tiny_lsm::WriteBatch::clear)
+      .def("count", &tiny_lsm::WriteBatch::count)
+      .def("__len__", &tiny_lsm::WriteBatch::count);
+}
+
 void bind_IsolationLevel(py::module &m) {
   py::enum_<tiny_lsm::IsolationLevel>(m, "IsolationLevel")
       .value("READ_UNCOMMITTED", tiny_lsm::IsolationLevel::READ_UNCOMMITTED)
@@ -56,30 +77,54 @@ void bind_IsolationLevel(py::module &m) {
       .export_values();
 }
 
+void bind_WalSyncMode(py::module &m) {
+  py::enum_<tiny_lsm::WalSyncMode>(m, "WalSyncMode")
+      .value("DEFAULT", tiny_lsm::WalSyncMode::Default)
+      .value("ALWAYS", tiny_lsm::WalSyncMode::Always)
+      .value("PERIODIC", tiny_lsm::WalSyncMode::Periodic)
+      .value("NONE", tiny_lsm::WalSyncMode::None)
+      .export_values();
+}
+
 PYBIND11_MODULE(lsm_pybind, m) {
-  // 绑定辅助类
+  // 绑定辅助类, 枚举要先于使用它作为默认参数的函数注册
+  bind_WalSyncMode(m);
   bind_TwoMergeIterator(m);
   bind_Level_Iterator(m);
   bind_TranContext(m);
+  bind_Snapshot(m);
+  bind_WriteBatch(m);
   bind_IsolationLevel(m);
 
   // 主类 LSM
   py::class_<tiny_lsm::LSM>(m, "LSM")
       .def(py::init<const std::string &>())
       // 基础操作
-      .def("put", &tiny_lsm::LSM::put, py::arg("key"), py::arg("value"), py::arg("tranc_off"),
+      .def("put", &tiny_lsm::LSM::put, py::arg("key"), py::arg("value"),
+           py::arg("tranc_off") = false,
+           py::arg("sync_mode") = tiny_lsm::WalSyncMode::Default,
            "Insert a key-value pair (bytes type)")
-      .def("get", &tiny_lsm::LSM::get, py::arg("key"), py::arg("tranc_off"),
-           "Get value by key, returns None if not found")
-      .def("remove", &tiny_lsm::LSM::remove, py::arg("key"), "Delete a key")
+      .def("get", py::overload_cast<const std::string &, bool>(&tiny_lsm::LSM::get), py::arg("key"),
+           py::arg("tranc_off"), "Get value by key, returns None if not found")
+      .def("get",
+           py::overload_cast<const std::string &, const tiny_lsm::Snapshot &>(&tiny_lsm::LSM::get),
+           py::arg("key"), py::arg("snapshot"), "Get value by key as of a snapshot")
+      // 快照
+      .def("get_snapshot", &tiny_lsm::LSM::get_snapshot, "Create a snapshot of the committed data")
+      .def("remove", &tiny_lsm::LSM::remove, py::arg("key"),
+           py::arg("sync_mode") = tiny_lsm::WalSyncMode::Default, "Delete a key")
       // 批量操作
       .def("put_batch", &tiny_lsm::LSM::put_batch, py::arg("kvs"),
-           "Batch insert key-value pairs")
+           py::arg("sync_mode") = tiny_lsm::WalSyncMode::Default, "Batch insert key-value pairs")
       .def("remove_batch", &tiny_lsm::LSM::remove_batch, py::arg("keys"),
-           "Batch delete keys")
+           py::arg("sync_mode") = tiny_lsm::WalSyncMode::Default, "Batch delete keys")
+      .def("write", &tiny_lsm::LSM::write, py::arg("batch"),
+           py::arg("sync_mode") = tiny_lsm::WalSyncMode::Default, "Atomically apply a write batch")
       // 迭代器
-      .def("begin", &tiny_lsm::LSM::begin, py::arg("tranc_id"),
+      .def("begin", py::overload_cast<uint64_t>(&tiny_lsm::LSM::begin), py::arg("tranc_id"),
            "Start an iterator with transaction ID")
+      .def("begin", py::overload_cast<const tiny_lsm::Snapshot &>(&tiny_lsm::LSM::begin),
+           py::arg("snapshot"), "Start an iterator on a snapshot")
       .def("end", &tiny_lsm::LSM::end, "Get end iterator")
       // 事务
       .def("begin_tran", &tiny_lsm::LSM::begin_tran, py::arg("isolation_level"),
@@ -1,4 +1,5 @@
 #include "../../include/block/block.h"
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
@@ -11,9 +12,10 @@
 #include <string_view>
 #include <vector>
 #include "../../include/block/block_iterator.h"
+#include "../../include/utils/crc32c.h"
 
 namespace tiny_lsm {
-Block::Block(size_t capacity) : capacity(capacity) {}
+Block::Block(size_t capacity, double hash_util_ratio) : capacity(capacity), hash_util_ratio_(hash_util_ratio) {}
 
 std::vector<uint8_t> Block::encode(bool with_hash) {
   // (done)TODO Lab 3.1 编码单个类实例形成一段字节数组
@@ -26,13 +28,27 @@ std::vector<uint8_t> Block::encode(bool with_hash) {
   size_t n_pos = 0;  // 当前写入偏移
   // 写入entry数据
   auto data_ptr = encoded.data();
-  memcpy(data_ptr, data.data(), data.size());
+  memcpy(data_ptr, this->data_ptr(), data_size());
   // 写入偏移数组
-  n_pos += data.size();
+  n_pos += data_size();
   memcpy(data_ptr + n_pos, offsets.data(), offsets.size() * sizeof(uint16_t));
-  // 写入元素个数
   n_pos += offsets.size() * sizeof(uint16_t);
   uint16_t num_elements = static_cast<uint16_t>(offsets.size());
+  if (hash_index_size(hash_entries_.size()) > 0) {
+    // 写入 hash 索引, 并在元素个数的最高位标记
+    std::vector<uint16_t> buckets(num_hash_buckets(hash_entries_.size()), HASH_BUCKET_EMPTY);
+    for (auto &[hash, idx] : hash_entries_) {
+      auto &bucket = buckets[hash % buckets.size()];
+      bucket = bucket == HASH_BUCKET_EMPTY ? idx : HASH_BUCKET_COLLISION;
+    }
+    memcpy(data_ptr + n_pos, buckets.data(), buckets.size() * sizeof(uint16_t));
+    n_pos += buckets.size() * sizeof(uint16_t);
+    uint16_t num_buckets = static_cast<uint16_t>(buckets.size());
+    memcpy(data_ptr + n_pos, &num_buckets, sizeof(uint16_t));
+    n_pos += sizeof(uint16_t);
+    num_elements |= HASH_INDEX_FLAG;
+  }
+  // 写入元素个数
   memcpy(data_ptr + n_pos, &num_elements, sizeof(uint16_t));
 
   if (with_hash) {
@@ -45,22 +61,19 @@ std::vector<uint8_t> Block::encode(bool with_hash) {
   return encoded;
 }
 
-std::shared_ptr<Block> Block::decode(const std::vector<uint8_t> &encoded, bool with_hash) {
-  // (done)TODO Lab 3.1 解码字节数组形成类实例
-  auto block_ptr = std::make_shared<Block>();
-  if (encoded.size() <= sizeof(uint16_t) + sizeof(uint32_t)) {
+size_t Block::decode_offsets(const uint8_t *encoded, size_t size, bool with_hash, std::vector<uint16_t> &offsets,
+                             std::vector<uint16_t> &hash_buckets) {
+  if (size <= sizeof(uint16_t) + sizeof(uint32_t)) {
     throw std::runtime_error("Encoded data is too small to decode");
   }
-  size_t n_pos = encoded.size();
-  auto encoded_data_ptr = encoded.data();
+  size_t n_pos = size;
   if (with_hash) {
     // hash校验
     n_pos -= sizeof(uint32_t);
     uint32_t hash_value;
-    memcpy(&hash_value, encoded_data_ptr + n_pos, sizeof(uint32_t));
+    memcpy(&hash_value, encoded + n_pos, sizeof(uint32_t));
     std::hash<std::string_view> hash_func;
-    uint32_t expected_hash =
-        hash_func(std::string_view(reinterpret_cast<const char *>(encoded_data_ptr), n_pos - sizeof(uint16_t)));
+    uint32_t expected_hash = hash_func(std::string_view(reinterpret_cast<const char *>(encoded), n_pos - sizeof(uint16_t)));
     if (hash_value != expected_hash) {
       throw std::runtime_error("Block decode: Hash mismatch");
     }
@@ -68,33 +81,75 @@ std::shared_ptr<Block> Block::decode(const std::vector<uint8_t> &encoded, bool w
   // 读取元素个数
   n_pos -= sizeof(uint16_t);
   uint16_t num_elements;
-  memcpy(&num_elements, encoded_data_ptr + n_pos, sizeof(uint16_t));
+  memcpy(&num_elements, encoded + n_pos, sizeof(uint16_t));
+  if (num_elements & HASH_INDEX_FLAG) {
+    // 读取 hash 索引
+    num_elements &= ~HASH_INDEX_FLAG;
+    uint16_t num_buckets;
+    if (n_pos < sizeof(uint16_t)) {
+      throw std::runtime_error("Block decode: Hash index out of range");
+    }
+    n_pos -= sizeof(uint16_t);
+    memcpy(&num_buckets, encoded + n_pos, sizeof(uint16_t));
+    if (num_buckets == 0 || n_pos < num_buckets * sizeof(uint16_t)) {
+      throw std::runtime_error("Block decode: Hash index out of range");
+    }
+    n_pos -= num_buckets * sizeof(uint16_t);
+    hash_buckets.resize(num_buckets);
+    memcpy(hash_buckets.data(), encoded + n_pos, num_buckets * sizeof(uint16_t));
+  }
   if (num_elements == 0) {
-    return block_ptr;  // 空block
+    return 0;  // 空block
   }
   // 读取偏移数组
+  if (n_pos < num_elements * sizeof(uint16_t)) {
+    throw std::runtime_error("Block decode: Offset section out of range");
+  }
   n_pos -= num_elements * sizeof(uint16_t);
-  block_ptr->offsets.resize(num_elements);
-  memcpy(block_ptr->offsets.data(), encoded_data_ptr + n_pos, num_elements * sizeof(uint16_t));
+  offsets.resize(num_elements);
+  memcpy(offsets.data(), encoded + n_pos, num_elements * sizeof(uint16_t));
+
+  return n_pos;
+}
+
+std::shared_ptr<Block> Block::decode(const std::vector<uint8_t> &encoded, bool with_hash) {
+  // (done)TODO Lab 3.1 解码字节数组形成类实例
+  auto block_ptr = std::make_shared<Block>();
+  size_t data_len =
+      decode_offsets(encoded.data(), encoded.size(), with_hash, block_ptr->offsets, block_ptr->hash_buckets_);
 
   // 读取数据
-  block_ptr->data.resize(n_pos);
-  memcpy(block_ptr->data.data(), encoded_data_ptr, n_pos);
+  block_ptr->data.assign(encoded.begin(), encoded.begin() + data_len);
+
+  return block_ptr;
+}
+
+std::shared_ptr<Block> Block::decode_view(std::shared_ptr<const uint8_t> encoded, size_t size, bool with_hash) {
+  auto block_ptr = std::make_shared<Block>();
+  size_t data_len = decode_offsets(encoded.get(), size, with_hash, block_ptr->offsets, block_ptr->hash_buckets_);
+
+  // Offset Section 很小且可能没有按 2 字节对齐, 仍然拷贝; Data Section 直接引用
+  block_ptr->data_view_ = std::move(encoded);
+  block_ptr->data_view_size_ = data_len;
 
   return block_ptr;
 }
 
+const uint8_t *Block::data_ptr() const { return data_view_ ? data_view_.get() : data.data(); }
+
+size_t Block::data_size() const { return data_view_ ? data_view_size_ : data.size(); }
+
 std::string Block::get_first_key() {
-  if (data.empty() || offsets.empty()) {
+  if (data_size() == 0 || offsets.empty()) {
     return "";
   }
 
   // 读取第一个key的长度（前2字节）
   uint16_t key_len;
-  memcpy(&key_len, data.data(), sizeof(uint16_t));
+  memcpy(&key_len, data_ptr(), sizeof(uint16_t));
 
   // 读取key
-  std::string key(reinterpret_cast<char *>(data.data() + sizeof(uint16_t)), key_len);
+  std::string key(reinterpret_cast<const char *>(data_ptr() + sizeof(uint16_t)), key_len);
   return key;
 }
 
@@ -110,11 +165,21 @@ bool Block::add_entry(const std::string &key, const std::string &value, uint64_t
   // ? 返回值说明：
   // ? true: 成功添加
   // ? false: block已满, 拒绝此次添加
+  if (data_view_) {
+    throw std::runtime_error("Block is read-only");
+  }
   size_t entry_size = sizeof(uint16_t) * 2 + key.size() + value.size() + sizeof(uint64_t);
-  size_t total_bytes = cur_size() + entry_size;
+  // 同一个 key 的多个版本只在 hash 索引中记录第一个
+  bool new_key = hash_util_ratio_ > 0 && (offsets.empty() || compare_key_at(offsets.back(), key) != 0);
+  size_t num_keys = hash_entries_.size() + (new_key ? 1 : 0);
+  size_t total_bytes =
+      data.size() + (offsets.size() + 1) * sizeof(uint16_t) + sizeof(uint16_t) + hash_index_size(num_keys) + entry_size;
   if (total_bytes > capacity && !force_write) {
     return false;  // block已满且不强制写入
   }
+  if (new_key) {
+    hash_entries_.emplace_back(hash_key(key), static_cast<uint16_t>(offsets.size()));
+  }
   uint16_t new_entry_offset = static_cast<uint16_t>(data.size());
   // 写入entry数据
   data.resize(data.size() + entry_size);
@@ -135,10 +200,10 @@ std::string Block::get_key_at(size_t offset) const {
   // (done)TODO Lab 3.1 从指定偏移量获取entry的key
   // 先读取长度
   uint16_t key_len;
-  memcpy(&key_len, data.data() + offset, sizeof(uint16_t));
+  memcpy(&key_len, data_ptr() + offset, sizeof(uint16_t));
 
   // 读取key
-  std::string key(reinterpret_cast<const char *>(data.data() + offset + sizeof(uint16_t)), key_len);
+  std::string key(reinterpret_cast<const char *>(data_ptr() + offset + sizeof(uint16_t)), key_len);
   return key;
 }
 
@@ -146,13 +211,13 @@ std::string Block::get_key_at(size_t offset) const {
 std::string Block::get_value_at(size_t offset) const {
   // (done)TODO Lab 3.1 从指定偏移量获取entry的value
   uint16_t key_len;
-  memcpy(&key_len, data.data() + offset, sizeof(uint16_t));
+  memcpy(&key_len, data_ptr() + offset, sizeof(uint16_t));
   // 读取value长度
   uint16_t value_len;
   size_t value_len_offset = offset + sizeof(uint16_t) + key_len;
-  memcpy(&value_len, data.data() + value_len_offset, sizeof(uint16_t));
+  memcpy(&value_len, data_ptr() + value_len_offset, sizeof(uint16_t));
   // 读取value
-  std::string value(reinterpret_cast<const char *>(data.data() + value_len_offset + sizeof(uint16_t)), value_len);
+  std::string value(reinterpret_cast<const char *>(data_ptr() + value_len_offset + sizeof(uint16_t)), value_len);
   return value;
 }
 
@@ -160,43 +225,52 @@ uint64_t Block::get_tranc_id_at(size_t offset) const {
   // (done)TODO Lab 3.1 从指定偏移量获取entry的tranc_id
   // ? 你不需要理解tranc_id的具体含义, 直接返回即可
   uint16_t key_len;
-  memcpy(&key_len, data.data() + offset, sizeof(uint16_t));
+  memcpy(&key_len, data_ptr() + offset, sizeof(uint16_t));
   // 读取value长度
   uint16_t value_len;
   size_t value_len_offset = offset + sizeof(uint16_t) + key_len;
-  memcpy(&value_len, data.data() + value_len_offset, sizeof(uint16_t));
+  memcpy(&value_len, data_ptr() + value_len_offset, sizeof(uint16_t));
   // 读取tranc_id
   uint64_t tranc_id;
   size_t tranc_id_offset = value_len_offset + sizeof(uint16_t) + value_len;
-  memcpy(&tranc_id, data.data() + tranc_id_offset, sizeof(uint64_t));
+  memcpy(&tranc_id, data_ptr() + tranc_id_offset, sizeof(uint64_t));
   return tranc_id;
 }
 
 // 比较指定偏移量处的key与目标key
 // <0: offset小于目标key
 int Block::compare_key_at(size_t offset, const std::string &target) const {
-  std::string key = get_key_at(offset);
+  // 直接比较 Data Section 中的 key, 不构造临时字符串
+  uint16_t key_len;
+  memcpy(&key_len, data_ptr() + offset, sizeof(uint16_t));
+  std::string_view key(reinterpret_cast<const char *>(data_ptr() + offset + sizeof(uint16_t)), key_len);
   return key.compare(target);
 }
 
 // 相同的key连续分布, 且相同的key的事务id从大到小排布
 // 这里的逻辑是找到最接近 tranc_id 的键值对的索引位置
 int Block::adjust_idx_by_tranc_id(size_t idx, uint64_t tranc_id) {
-  // TODO Lab3.1 不需要在Lab3.1中实现, 只是进行标记,
+  // (done)TODO Lab3.1 不需要在Lab3.1中实现, 只是进行标记,
   // ? 后续实现事务后需要更新这里的实现
   if (idx >= offsets.size()) {
     return -1;  // 索引超出范围
   }
-  // 如果没有开启事务，选择事务id最大的返回
   auto target_key = get_key_at(offsets[idx]);
+  auto pre_idx = idx;
+  // 向前查找直到找到第一个不同的key
+  while (pre_idx > 0 && is_same_key(pre_idx - 1, target_key)) {
+    pre_idx--;
+  }
+  // 如果没有开启事务，选择事务id最大的返回
   if (tranc_id == 0) {
-    auto pre_idx = idx;
-    // 向前查找直到找到第一个不同的key
-    while (pre_idx > 0 && is_same_key(pre_idx - 1, target_key)) {
-      pre_idx--;
-    }
     return pre_idx;
   }
+  // 否则向后找到第一个可见(事务id不超过 tranc_id)的版本
+  for (auto i = pre_idx; i < offsets.size() && is_same_key(i, target_key); i++) {
+    if (get_tranc_id_at(offsets[i]) <= tranc_id) {
+      return i;
+    }
+  }
   return -1;
 }
 
@@ -204,7 +278,7 @@ bool Block::is_same_key(size_t idx, const std::string &target_key) const {
   if (idx >= offsets.size()) {
     return false;  // 索引超出范围
   }
-  return get_key_at(offsets[idx]) == target_key;
+  return compare_key_at(offsets[idx], target_key) == 0;
 }
 
 // 使用二分查找获取value
@@ -218,11 +292,38 @@ std::optional<std::string> Block::get_value_binary(const std::string &key, uint6
   return get_value_at(offsets[*idx]);
 }
 
+std::optional<std::pair<std::string, uint64_t>> Block::get_value_tranc_binary(const std::string &key,
+                                                                              uint64_t tranc_id) {
+  auto idx = get_idx_binary(key, tranc_id);
+  if (!idx.has_value()) {
+    return std::nullopt;
+  }
+
+  return std::make_pair(get_value_at(offsets[*idx]), get_tranc_id_at(offsets[*idx]));
+}
+
 std::optional<size_t> Block::get_idx_binary(const std::string &key, uint64_t tranc_id) {
   // (done)TODO Lab 3.1 使用二分查找获取key对应的索引
   if (offsets.empty()) {
     return std::nullopt;  // 空block
   }
+  if (!hash_buckets_.empty()) {
+    // 先查 hash 索引, 桶中有多个不同的 key 时才回退到二分查找
+    uint16_t bucket = hash_buckets_[hash_key(key) % hash_buckets_.size()];
+    if (bucket == HASH_BUCKET_EMPTY) {
+      return std::nullopt;
+    }
+    if (bucket != HASH_BUCKET_COLLISION && bucket < offsets.size()) {
+      if (compare_key_at(offsets[bucket], key) != 0) {
+        return std::nullopt;
+      }
+      auto idx = adjust_idx_by_tranc_id(bucket, tranc_id);
+      if (idx == -1) {
+        return std::nullopt;
+      }
+      return idx;
+    }
+  }
   int left = 0;
   int right = offsets.size() - 1;
   //   if (compare_key_at(offsets[left], key) > 0 || compare_key_at(offsets[right], key) < 0) {
@@ -312,13 +413,14 @@ Block::get_monotony_predicate_iters(uint64_t tranc_id, std::function<int(const s
     return std::nullopt;  // 空block
   }
   // 左右边界
-  size_t left_bound = 0;
-  size_t right_bound = 0;
-  size_t left = 0;
-  size_t right = offsets.size() - 1;
+  // 使用有符号数, 避免 mid 为 0 时 right = mid - 1 下溢
+  int left_bound = 0;
+  int right_bound = 0;
+  int left = 0;
+  int right = static_cast<int>(offsets.size()) - 1;
   // 二分查找左边界left
   while (left <= right) {
-    size_t mid = left + (right - left) / 2;
+    int mid = left + (right - left) / 2;
     size_t mid_offset = offsets[mid];
     std::string key = get_key_at(mid_offset);
     int cmp = predicate(key);
@@ -330,9 +432,9 @@ Block::get_monotony_predicate_iters(uint64_t tranc_id, std::function<int(const s
   }
   left_bound = left;  // 左边界
   // 二分查找右边界right+1
-  right = offsets.size() - 1;
+  right = static_cast<int>(offsets.size()) - 1;
   while (left <= right) {
-    size_t mid = left + (right - left) / 2;
+    int mid = left + (right - left) / 2;
     size_t mid_offset = offsets[mid];
     std::string key = get_key_at(mid_offset);
     int cmp = predicate(key);
@@ -343,7 +445,7 @@ Block::get_monotony_predicate_iters(uint64_t tranc_id, std::function<int(const s
     }
   }
   right_bound = right + 1;  // 右边界
-  if (left_bound > right_bound) {
+  if (left_bound >= right_bound) {
     // 没有找到满足谓词的区间
     return std::nullopt;
   }
@@ -364,7 +466,58 @@ Block::Entry Block::get_entry_at(size_t offset) const {
 
 size_t Block::size() const { return offsets.size(); }
 
-size_t Block::cur_size() const { return data.size() + offsets.size() * sizeof(uint16_t) + sizeof(uint16_t); }
+size_t Block::lower_bound(const std::string &key, size_t lo, size_t hi) const {
+  size_t left = lo;
+  size_t right = std::min(hi, offsets.size());
+  while (left < right) {
+    size_t mid = left + (right - left) / 2;
+    if (compare_key_at(offsets[mid], key) < 0) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+  return left;
+}
+
+std::string Block::get_key_at_idx(size_t idx) const { return get_key_at(offsets.at(idx)); }
+
+uint64_t Block::get_tranc_id_at_idx(size_t idx) const { return get_tranc_id_at(offsets.at(idx)); }
+
+void Block::read_entry_at_idx(size_t idx, std::string &key, std::string &value, uint64_t &tranc_id) const {
+  const uint8_t *ptr = data_ptr() + offsets.at(idx);
+  uint16_t key_len;
+  memcpy(&key_len, ptr, sizeof(uint16_t));
+  ptr += sizeof(uint16_t);
+  key.assign(reinterpret_cast<const char *>(ptr), key_len);
+  ptr += key_len;
+  uint16_t value_len;
+  memcpy(&value_len, ptr, sizeof(uint16_t));
+  ptr += sizeof(uint16_t);
+  value.assign(reinterpret_cast<const char *>(ptr), value_len);
+  ptr += value_len;
+  memcpy(&tranc_id, ptr, sizeof(uint64_t));
+}
+
+size_t Block::cur_size() const {
+  size_t hash_index_bytes = hash_buckets_.empty() ? hash_index_size(hash_entries_.size())
+                                                  : (hash_buckets_.size() + 1) * sizeof(uint16_t);
+  return data_size() + offsets.size() * sizeof(uint16_t) + sizeof(uint16_t) + hash_index_bytes;
+}
+
+uint32_t Block::hash_key(const std::string &key) { return crc32c(key.data(), key.size()); }
+
+size_t Block::num_hash_buckets(size_t num_keys) const {
+  size_t num_buckets = static_cast<size_t>(static_cast<double>(num_keys) / hash_util_ratio_) + 1;
+  return std::min<size_t>(num_buckets, UINT16_MAX);
+}
+
+size_t Block::hash_index_size(size_t num_keys) const {
+  if (hash_util_ratio_ <= 0 || num_keys == 0) {
+    return 0;
+  }
+  return num_hash_buckets(num_keys) * sizeof(uint16_t) + sizeof(uint16_t);
+}
 
 bool Block::is_empty() const { return offsets.empty(); }
 
@@ -13,12 +13,44 @@ BlockCache::BlockCache(size_t capacity, size_t k)
 BlockCache::~BlockCache() = default;
 
 std::shared_ptr<Block> BlockCache::get(int sst_id, int block_id) {
-  // TODO: Lab 4.8 查询一个 Block
-  return nullptr;
+  // (done)TODO: Lab 4.8 查询一个 Block
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++total_requests_;
+  auto it = cache_map_.find({sst_id, block_id});
+  if (it == cache_map_.end()) {
+    return nullptr;
+  }
+  ++hit_requests_;
+  update_access_count(it->second);
+  return it->second->cache_block;
 }
 
 void BlockCache::put(int sst_id, int block_id, std::shared_ptr<Block> block) {
-  // TODO: Lab 4.8 插入一个 Block
+  // (done)TODO: Lab 4.8 插入一个 Block
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (capacity_ == 0) {
+    return;
+  }
+  auto key = std::make_pair(sst_id, block_id);
+  auto it = cache_map_.find(key);
+  if (it != cache_map_.end()) {
+    // 已经存在, 更新数据并视为一次访问
+    it->second->cache_block = block;
+    update_access_count(it->second);
+    return;
+  }
+
+  if (cache_map_.size() >= capacity_) {
+    // 优先淘汰访问次数不足 k 的缓存项, 两个链表都是尾部最久未访问
+    auto &victim_list = cache_list_less_k.empty() ? cache_list_greater_k
+                                                  : cache_list_less_k;
+    auto &victim = victim_list.back();
+    cache_map_.erase({victim.sst_id, victim.block_id});
+    victim_list.pop_back();
+  }
+
+  cache_list_less_k.push_front({sst_id, block_id, block, 1});
+  cache_map_[key] = cache_list_less_k.begin();
 }
 
 double BlockCache::hit_rate() const {
@@ -29,6 +61,18 @@ double BlockCache::hit_rate() const {
 }
 
 void BlockCache::update_access_count(std::list<CacheItem>::iterator it) {
-  // TODO: Lab 4.8 更新统计信息
+  // (done)TODO: Lab 4.8 更新统计信息
+  ++it->access_count;
+  // splice 只移动节点, cache_map_ 中保存的迭代器仍然有效
+  if (it->access_count < k_) {
+    cache_list_less_k.splice(cache_list_less_k.begin(), cache_list_less_k, it);
+  } else if (it->access_count == k_) {
+    // 访问次数刚达到 k, 从 less_k 晋升到 greater_k
+    cache_list_greater_k.splice(cache_list_greater_k.begin(),
+                                cache_list_less_k, it);
+  } else {
+    cache_list_greater_k.splice(cache_list_greater_k.begin(),
+                                cache_list_greater_k, it);
+  }
 }
 } // namespace tiny_lsm
\ No newline at end of file
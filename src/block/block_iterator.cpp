@@ -63,6 +63,68 @@ BlockIterator &BlockIterator::operator++() {
 return *this;
 }
 
+BlockIterator &BlockIterator::operator--() {
+  if (block && current_index < block->offsets.size()) {
+    // 回到当前 key 的第一个版本, 再向前查找
+    auto key = block->get_key_at(block->get_offset_at(current_index));
+    size_t begin = current_index;
+    while (begin > 0 && block->is_same_key(begin - 1, key)) {
+      begin--;
+    }
+    seek_prev_before(begin);
+  }
+  return *this;
+}
+
+void BlockIterator::seek(const std::string &key) {
+  if (!block) {
+    return;
+  }
+  current_index = block->lower_bound(key);
+  cached_value = std::nullopt;
+  skip_by_tranc_id();
+}
+
+void BlockIterator::seek_for_prev(const std::string &key) {
+  if (!block) {
+    return;
+  }
+  size_t end = block->lower_bound(key);
+  while (end < block->offsets.size() && block->is_same_key(end, key)) {
+    end++;
+  }
+  seek_prev_before(end);
+}
+
+void BlockIterator::seek_to_last() {
+  if (!block) {
+    return;
+  }
+  seek_prev_before(block->offsets.size());
+}
+
+void BlockIterator::seek_prev_before(size_t end) {
+  cached_value = std::nullopt;
+  while (end > 0) {
+    // [begin, end) 为同一个 key 的所有版本, 事务 id 从大到小排列
+    auto key = block->get_key_at(block->get_offset_at(end - 1));
+    size_t begin = end - 1;
+    while (begin > 0 && block->is_same_key(begin - 1, key)) {
+      begin--;
+    }
+    for (size_t idx = begin; idx < end; idx++) {
+      if (tranc_id_ == 0 ||
+          block->get_tranc_id_at(block->get_offset_at(idx)) <= tranc_id_) {
+        current_index = idx;
+        return;
+      }
+    }
+    end = begin;
+  }
+  // 没有更小的可见 key
+  current_index = block->offsets.size();
+}
+
 bool BlockIterator::operator==(const BlockIterator &other) const {
   // TODO: Lab3.2 == 重载
   return block == other.block &&
@@ -99,8 +161,22 @@ void BlockIterator::update_current() const {
 }
 
 void BlockIterator::skip_by_tranc_id() {
-  // TODO: Lab3.2 * 跳过事务ID
+  // (done)TODO: Lab3.2 * 跳过事务ID
   // ? 只是进行标记以供你在后续Lab实现事务功能后修改
   // ? 现在你不需要考虑这个函数
+  if (tranc_id_ == 0 || !block) {
+    // 没有开启事务功能, 所有记录都可见
+    return;
+  }
+  // 相同 key 的记录按照事务 id 从大到小排列, 跳过不可见的版本即可
+  // 如果某个 key 的所有版本都不可见, 会自然地移动到下一个 key
+  while (current_index < block->offsets.size()) {
+    auto offset = block->get_offset_at(current_index);
+    if (block->get_tranc_id_at(offset) <= tranc_id_) {
+      break;
+    }
+    current_index++;
+  }
+  cached_value = std::nullopt;
 }
 } // namespace tiny_lsm
\ No newline at end of file
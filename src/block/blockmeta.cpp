@@ -2,6 +2,7 @@
 #include <cstring>
 #include <functional>
 #include <stdexcept>
+#include <string_view>
 
 namespace tiny_lsm {
 BlockMeta::BlockMeta() : offset(0), first_key(""), last_key("") {}
@@ -12,13 +13,105 @@ BlockMeta::BlockMeta(size_t offset, const std::string &first_key,
 
 void BlockMeta::encode_meta_to_slice(std::vector<BlockMeta> &meta_entries,
                                      std::vector<uint8_t> &metadata) {
-  // TODO: Lab 3.4 将内存中所有`Blcok`的元数据编码为二进制字节数组
+  // (done)TODO: Lab 3.4 将内存中所有`Blcok`的元数据编码为二进制字节数组
   // ? 输入输出都由参数中的引用给定, 你不需要自己创建`vector`
+  uint32_t num_entries = meta_entries.size();
+  size_t total_size = sizeof(uint32_t);
+  for (const auto &meta : meta_entries) {
+    total_size += sizeof(uint32_t) + sizeof(uint16_t) * 2 +
+                  meta.first_key.size() + meta.last_key.size();
+  }
+  total_size += sizeof(uint32_t);
+
+  metadata.resize(total_size);
+  uint8_t *ptr = metadata.data();
+
+  memcpy(ptr, &num_entries, sizeof(uint32_t));
+  ptr += sizeof(uint32_t);
+
+  for (const auto &meta : meta_entries) {
+    uint32_t offset = meta.offset;
+    memcpy(ptr, &offset, sizeof(uint32_t));
+    ptr += sizeof(uint32_t);
+
+    uint16_t first_key_len = meta.first_key.size();
+    memcpy(ptr, &first_key_len, sizeof(uint16_t));
+    ptr += sizeof(uint16_t);
+    memcpy(ptr, meta.first_key.data(), first_key_len);
+    ptr += first_key_len;
+
+    uint16_t last_key_len = meta.last_key.size();
+    memcpy(ptr, &last_key_len, sizeof(uint16_t));
+    ptr += sizeof(uint16_t);
+    memcpy(ptr, meta.last_key.data(), last_key_len);
+    ptr += last_key_len;
+  }
+
+  // hash 只覆盖 MetaEntry 数组部分
+  const uint8_t *entries_begin = metadata.data() + sizeof(uint32_t);
+  uint32_t hash = std::hash<std::string_view>{}(
+      std::string_view(reinterpret_cast<const char *>(entries_begin),
+                       ptr - entries_begin));
+  memcpy(ptr, &hash, sizeof(uint32_t));
 }
 
 std::vector<BlockMeta>
 BlockMeta::decode_meta_from_slice(const std::vector<uint8_t> &metadata) {
-  // TODO: Lab 3.4 将二进制字节数组解码为内存中的`Blcok`元数据
-  return {};
+  // (done)TODO: Lab 3.4 将二进制字节数组解码为内存中的`Blcok`元数据
+  if (metadata.size() < sizeof(uint32_t) * 2) {
+    throw std::runtime_error("Invalid metadata size");
+  }
+
+  std::vector<BlockMeta> meta_entries;
+  const uint8_t *ptr = metadata.data();
+  const uint8_t *end = metadata.data() + metadata.size() - sizeof(uint32_t);
+
+  uint32_t num_entries;
+  memcpy(&num_entries, ptr, sizeof(uint32_t));
+  ptr += sizeof(uint32_t);
+  const uint8_t *entries_begin = ptr;
+
+  meta_entries.reserve(num_entries);
+  for (uint32_t i = 0; i < num_entries; ++i) {
+    if (ptr + sizeof(uint32_t) + sizeof(uint16_t) > end) {
+      throw std::runtime_error("Metadata truncated");
+    }
+    BlockMeta meta;
+    uint32_t offset;
+    memcpy(&offset, ptr, sizeof(uint32_t));
+    meta.offset = offset;
+    ptr += sizeof(uint32_t);
+
+    uint16_t first_key_len;
+    memcpy(&first_key_len, ptr, sizeof(uint16_t));
+    ptr += sizeof(uint16_t);
+    if (ptr + first_key_len + sizeof(uint16_t) > end) {
+      throw std::runtime_error("Metadata truncated");
+    }
+    meta.first_key.assign(reinterpret_cast<const char *>(ptr), first_key_len);
+    ptr += first_key_len;
+
+    uint16_t last_key_len;
+    memcpy(&last_key_len, ptr, sizeof(uint16_t));
+    ptr += sizeof(uint16_t);
+    if (ptr + last_key_len > end) {
+      throw std::runtime_error("Metadata truncated");
+    }
+    meta.last_key.assign(reinterpret_cast<const char *>(ptr), last_key_len);
+    ptr += last_key_len;
+
+    meta_entries.push_back(std::move(meta));
+  }
+
+  uint32_t stored_hash;
+  memcpy(&stored_hash, end, sizeof(uint32_t));
+  uint32_t computed_hash = std::hash<std::string_view>{}(
+      std::string_view(reinterpret_cast<const char *>(entries_begin),
+                       ptr - entries_begin));
+  if (ptr != end || stored_hash != computed_hash) {
+    throw std::runtime_error("Metadata hash mismatch");
+  }
+
+  return meta_entries;
 }
 } // namespace tiny_lsm
\ No newline at end of file
@@ -11,12 +11,28 @@ void TomlConfig::setDefaultValues() {
   lsm_tol_mem_size_limit_ = 67108864; // Default: 64 * 1024 * 1024
   lsm_per_mem_size_limit_ = 4194304;  // Default: 4 * 1024 * 1024
   lsm_block_size_ = 32768;            // Default: 32 * 1024
+  lsm_block_hash_util_ratio_ = 0.75;  // Default: 0.75
+  lsm_sst_learned_index_error_ = 8;   // Default: predict within 8 blocks
   lsm_sst_level_ratio_ = 4;           // Default: 4
 
   // --- LSM Cache ---
   lsm_block_cache_capacity_ = 1024; // Default: 1024
   lsm_block_cache_k_ = 8;           // Default: 8
 
+  // --- LSM IO ---
+  lsm_sst_io_mode_ = "std"; // Default: std::fstream
+  lsm_max_open_files_ = 1000; // Default: keep at most 1000 SSTs open
+  lsm_sst_readahead_max_blocks_ = 16;    // Default: up to 16 blocks
+  lsm_compaction_readahead_blocks_ = 64; // Default: 64 blocks
+
+  // --- LSM WAL ---
+  lsm_wal_buffer_size_ = 128;           // Default: 128 records
+  lsm_wal_file_size_limit_ = 67108864; // Default: 64 * 1024 * 1024
+  lsm_wal_clean_interval_ = 1;          // Default: 1s
+  lsm_wal_sync_mode_ = "always";        // Default: fsync on every commit
+  lsm_wal_sync_interval_ms_ = 1000;     // Default: 1000ms
+  lsm_wal_recycle_num_ = 4;             // Default: keep 4 segments for reuse
+
   // --- Redis Headers/Separators ---
   redis_expire_header_ = "REDIS_EXPIRE_";
   redis_hash_value_preffix_ = "REDIS_HASH_VALUE_";
@@ -68,6 +84,12 @@ bool TomlConfig::loadFromFile(const std::string &filePath) {
     lsm_per_mem_size_limit_ =
         core_config.at("LSM_PER_MEM_SIZE_LIMIT").as_integer();
     lsm_block_size_ = core_config.at("LSM_BLOCK_SIZE").as_integer();
+    lsm_block_hash_util_ratio_ =
+        toml::find_or<double>(config, "lsm", "core", "LSM_BLOCK_HASH_UTIL_RATIO",
+                              lsm_block_hash_util_ratio_);
+    lsm_sst_learned_index_error_ =
+        toml::find_or<int>(config, "lsm", "core", "LSM_SST_LEARNED_INDEX_ERROR",
+                           lsm_sst_learned_index_error_);
     lsm_sst_level_ratio_ = core_config.at("LSM_SST_LEVEL_RATIO").as_integer();
 
     // --- Load LSM Cache ---
@@ -77,6 +99,38 @@ bool TomlConfig::loadFromFile(const std::string &filePath) {
         cache_config.at("LSM_BLOCK_CACHE_CAPACITY").as_integer();
     lsm_block_cache_k_ = cache_config.at("LSM_BLOCK_CACHE_K").as_integer();
 
+    // --- Load LSM IO ---
+    // 该表是后加入的, 旧的配置文件中可能不存在, 缺失时保留默认值
+    lsm_sst_io_mode_ = toml::find_or<std::string>(config, "lsm", "io",
+                                                  "LSM_SST_IO_MODE",
+                                                  lsm_sst_io_mode_);
+    lsm_max_open_files_ = toml::find_or<int>(
+        config, "lsm", "io", "LSM_MAX_OPEN_FILES", lsm_max_open_files_);
+    lsm_sst_readahead_max_blocks_ =
+        toml::find_or<int>(config, "lsm", "io", "LSM_SST_READAHEAD_MAX_BLOCKS",
+                           lsm_sst_readahead_max_blocks_);
+    lsm_compaction_readahead_blocks_ = toml::find_or<int>(
+        config, "lsm", "io", "LSM_COMPACTION_READAHEAD_BLOCKS",
+        lsm_compaction_readahead_blocks_);
+
+    // --- Load LSM WAL ---
+    lsm_wal_buffer_size_ = toml::find_or<int>(
+        config, "lsm", "wal", "LSM_WAL_BUFFER_SIZE", lsm_wal_buffer_size_);
+    lsm_wal_file_size_limit_ =
+        toml::find_or<long long>(config, "lsm", "wal", "LSM_WAL_FILE_SIZE_LIMIT",
+                                 lsm_wal_file_size_limit_);
+    lsm_wal_clean_interval_ =
+        toml::find_or<int>(config, "lsm", "wal", "LSM_WAL_CLEAN_INTERVAL",
+                           lsm_wal_clean_interval_);
+    lsm_wal_sync_mode_ = toml::find_or<std::string>(
+        config, "lsm", "wal", "LSM_WAL_SYNC_MODE", lsm_wal_sync_mode_);
+    lsm_wal_sync_interval_ms_ =
+        toml::find_or<int>(config, "lsm", "wal", "LSM_WAL_SYNC_INTERVAL_MS",
+                           lsm_wal_sync_interval_ms_);
+    lsm_wal_recycle_num_ =
+        toml::find_or<int>(config, "lsm", "wal", "LSM_WAL_RECYCLE_NUM",
+                           lsm_wal_recycle_num_);
+
     // --- Load Redis Headers/Separators ---
     auto redis_config = config["redis"];
 
@@ -130,6 +184,14 @@ long long TomlConfig::getLsmPerMemSizeLimit() const {
   return lsm_per_mem_size_limit_;
 }
 int TomlConfig::getLsmBlockSize() const { return lsm_block_size_; }
+
+double TomlConfig::getLsmBlockHashUtilRatio() const {
+  return lsm_block_hash_util_ratio_;
+}
+
+int TomlConfig::getLsmSstLearnedIndexError() const {
+  return lsm_sst_learned_index_error_;
+}
 int TomlConfig::getLsmSstLevelRatio() const { return lsm_sst_level_ratio_; }
 
 int TomlConfig::getLsmBlockCacheCapacity() const {
@@ -137,6 +199,35 @@ int TomlConfig::getLsmBlockCacheCapacity() const {
 }
 int TomlConfig::getLsmBlockCacheK() const { return lsm_block_cache_k_; }
 
+const std::string &TomlConfig::getLsmSstIoMode() const {
+  return lsm_sst_io_mode_;
+}
+
+int TomlConfig::getLsmMaxOpenFiles() const { return lsm_max_open_files_; }
+
+int TomlConfig::getLsmSstReadaheadMaxBlocks() const {
+  return lsm_sst_readahead_max_blocks_;
+}
+
+int TomlConfig::getLsmCompactionReadaheadBlocks() const {
+  return lsm_compaction_readahead_blocks_;
+}
+
+int TomlConfig::getLsmWalBufferSize() const { return lsm_wal_buffer_size_; }
+long long TomlConfig::getLsmWalFileSizeLimit() const {
+  return lsm_wal_file_size_limit_;
+}
+int TomlConfig::getLsmWalCleanInterval() const {
+  return lsm_wal_clean_interval_;
+}
+const std::string &TomlConfig::getLsmWalSyncMode() const {
+  return lsm_wal_sync_mode_;
+}
+int TomlConfig::getLsmWalSyncIntervalMs() const {
+  return lsm_wal_sync_interval_ms_;
+}
+int TomlConfig::getLsmWalRecycleNum() const { return lsm_wal_recycle_num_; }
+
 const std::string &TomlConfig::getRedisExpireHeader() const {
   return redis_expire_header_;
 }
@@ -203,6 +294,10 @@ bool TomlConfig::saveToFile(const std::string &filePath) {
     config["lsm"]["core"]["LSM_TOL_MEM_SIZE_LIMIT"] = lsm_tol_mem_size_limit_;
     config["lsm"]["core"]["LSM_PER_MEM_SIZE_LIMIT"] = lsm_per_mem_size_limit_;
     config["lsm"]["core"]["LSM_BLOCK_SIZE"] = lsm_block_size_;
+    config["lsm"]["core"]["LSM_BLOCK_HASH_UTIL_RATIO"] =
+        lsm_block_hash_util_ratio_;
+    config["lsm"]["core"]["LSM_SST_LEARNED_INDEX_ERROR"] =
+        lsm_sst_learned_index_error_;
     config["lsm"]["core"]["LSM_SST_LEVEL_RATIO"] = lsm_sst_level_ratio_;
 
     // --- LSM Cache ---
@@ -210,6 +305,22 @@ bool TomlConfig::saveToFile(const std::string &filePath) {
         lsm_block_cache_capacity_;
     config["lsm"]["cache"]["LSM_BLOCK_CACHE_K"] = lsm_block_cache_k_;
 
+    // --- LSM IO ---
+    config["lsm"]["io"]["LSM_SST_IO_MODE"] = lsm_sst_io_mode_;
+    config["lsm"]["io"]["LSM_MAX_OPEN_FILES"] = lsm_max_open_files_;
+    config["lsm"]["io"]["LSM_SST_READAHEAD_MAX_BLOCKS"] =
+        lsm_sst_readahead_max_blocks_;
+    config["lsm"]["io"]["LSM_COMPACTION_READAHEAD_BLOCKS"] =
+        lsm_compaction_readahead_blocks_;
+
+    // --- LSM WAL ---
+    config["lsm"]["wal"]["LSM_WAL_BUFFER_SIZE"] = lsm_wal_buffer_size_;
+    config["lsm"]["wal"]["LSM_WAL_FILE_SIZE_LIMIT"] = lsm_wal_file_size_limit_;
+    config["lsm"]["wal"]["LSM_WAL_CLEAN_INTERVAL"] = lsm_wal_clean_interval_;
+    config["lsm"]["wal"]["LSM_WAL_SYNC_MODE"] = lsm_wal_sync_mode_;
+    config["lsm"]["wal"]["LSM_WAL_SYNC_INTERVAL_MS"] = lsm_wal_sync_interval_ms_;
+    config["lsm"]["wal"]["LSM_WAL_RECYCLE_NUM"] = lsm_wal_recycle_num_;
+
     // --- Redis Headers/Separators ---
     config["redis"]["REDIS_EXPIRE_HEADER"] = redis_expire_header_;
     config["redis"]["REDIS_HASH_VALUE_PREFFIX"] = redis_hash_value_preffix_;
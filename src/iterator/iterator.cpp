@@ -1,10 +1,22 @@
 #include "../../include/iterator/iterator.h"
 #include <memory>
+#include <stdexcept>
 #include <tuple>
 #include <vector>
 
 namespace tiny_lsm {
 
+// *************************** BaseIterator ***************************
+BaseIterator &BaseIterator::operator--() { throw std::logic_error("operator-- is not supported by this iterator"); }
+
+void BaseIterator::seek(const std::string & /*key*/) {
+  throw std::logic_error("seek is not supported by this iterator");
+}
+
+void BaseIterator::seek_for_prev(const std::string & /*key*/) {
+  throw std::logic_error("seek_for_prev is not supported by this iterator");
+}
+
 // *************************** SearchItem ***************************
 // 比较规则：按 key 升序，tranc_id 降序, idx 升序
 bool operator<(const SearchItem &a, const SearchItem &b) {
@@ -0,0 +1,160 @@
+#include "../../include/iterator/merge_iterator.h"
+#include <stdexcept>
+
+namespace tiny_lsm {
+
+bool MergeIterator::source_less(size_t a, size_t b) const {
+  // 耗尽的子迭代器排在最后
+  if (valid_[a] != valid_[b]) {
+    return valid_[a];
+  }
+  if (!valid_[a]) {
+    return a < b;
+  }
+  int cmp = keys_[a].compare(keys_[b]);
+  if (cmp != 0) {
+    return forward_ ? cmp < 0 : cmp > 0;
+  }
+  // key 相同时新的子迭代器优先
+  return a < b;
+}
+
+MergeIterator::MergeIterator() = default;
+
+MergeIterator::MergeIterator(
+    std::vector<std::shared_ptr<BaseIterator>> children, uint64_t max_tranc_id)
+    : children_(std::move(children)), keys_(children_.size()),
+      valid_(children_.size(), false), max_tranc_id_(max_tranc_id) {
+  for (size_t i = 0; i < children_.size(); ++i) {
+    load_key(i);
+  }
+  rebuild_tree();
+}
+
+void MergeIterator::rebuild_tree() {
+  tree_.build(children_.size(),
+              [this](size_t a, size_t b) { return source_less(a, b); });
+}
+
+void MergeIterator::load_key(size_t idx) {
+  auto &child = children_[idx];
+  valid_[idx] = child != nullptr && child->is_valid();
+  if (valid_[idx]) {
+    keys_[idx] = (**child).first;
+  } else {
+    keys_[idx].clear();
+  }
+}
+
+const std::string &MergeIterator::key() const {
+  if (!is_valid()) {
+    throw std::runtime_error("MergeIterator is invalid");
+  }
+  return keys_[tree_.winner()];
+}
+
+size_t MergeIterator::source_idx() const { return tree_.winner(); }
+
+MergeIterator::pointer MergeIterator::operator->() const {
+  current_ = **this;
+  return &(*current_);
+}
+
+MergeIterator::value_type MergeIterator::operator*() const {
+  if (!is_valid()) {
+    throw std::runtime_error("MergeIterator is invalid");
+  }
+  return **children_[tree_.winner()];
+}
+
+BaseIterator &MergeIterator::operator++() {
+  if (!is_valid()) {
+    return *this;
+  }
+  if (!forward_) {
+    // 反向时其他子迭代器停在当前 key 之前, 重新定位到当前 key 之后
+    std::string key = keys_[tree_.winner()];
+    seek(key);
+    while (is_valid() && keys_[tree_.winner()] == key) {
+      ++(*this);
+    }
+    return *this;
+  }
+  // 只有冠军所在的子迭代器前进, 其余子迭代器保持不动
+  size_t winner = tree_.winner();
+  ++(*children_[winner]);
+  load_key(winner);
+  tree_.replay([this](size_t a, size_t b) { return source_less(a, b); });
+  return *this;
+}
+
+BaseIterator &MergeIterator::operator--() {
+  if (!is_valid()) {
+    return *this;
+  }
+  if (forward_) {
+    std::string key = keys_[tree_.winner()];
+    seek_for_prev(key);
+    while (is_valid() && keys_[tree_.winner()] == key) {
+      --(*this);
+    }
+    return *this;
+  }
+  size_t winner = tree_.winner();
+  --(*children_[winner]);
+  load_key(winner);
+  tree_.replay([this](size_t a, size_t b) { return source_less(a, b); });
+  return *this;
+}
+
+void MergeIterator::seek(const std::string &key) {
+  for (size_t i = 0; i < children_.size(); ++i) {
+    if (children_[i] != nullptr) {
+      children_[i]->seek(key);
+    }
+    load_key(i);
+  }
+  forward_ = true;
+  rebuild_tree();
+}
+
+void MergeIterator::seek_for_prev(const std::string &key) {
+  for (size_t i = 0; i < children_.size(); ++i) {
+    if (children_[i] != nullptr) {
+      children_[i]->seek_for_prev(key);
+    }
+    load_key(i);
+  }
+  forward_ = false;
+  rebuild_tree();
+}
+
+bool MergeIterator::operator==(const BaseIterator &other) const {
+  if (other.get_type() != IteratorType::MergeIterator) {
+    return false;
+  }
+  if (!is_valid() && !other.is_valid()) {
+    return true;
+  }
+  if (!is_valid() || !other.is_valid()) {
+    return false;
+  }
+  return **this == *other;
+}
+
+bool MergeIterator::operator!=(const BaseIterator &other) const {
+  return !(*this == other);
+}
+
+IteratorType MergeIterator::get_type() const {
+  return IteratorType::MergeIterator;
+}
+
+uint64_t MergeIterator::get_tranc_id() const { return max_tranc_id_; }
+
+bool MergeIterator::is_end() const { return !is_valid(); }
+
+bool MergeIterator::is_valid() const {
+  return !children_.empty() && valid_[tree_.winner()];
+}
+} // namespace tiny_lsm
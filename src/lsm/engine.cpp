@@ -6,13 +6,21 @@
 #include "../../include/sst/concact_iterator.h"
 #include "../../include/sst/sst.h"
 #include "../../include/sst/sst_iterator.h"
+#include "../../include/sst/sst_scan.h"
 #include "spdlog/spdlog.h"
 #include <algorithm>
 #include <cstddef>
 #include <filesystem>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -23,73 +31,327 @@ LSMEngine::LSMEngine(std::string path) : data_dir(path) {
   // 初始化日志
   init_spdlog_file();
 
-  // TODO: Lab 4.2 引擎初始化
+  // (done)TODO: Lab 4.2 引擎初始化
+  block_cache = std::make_shared<BlockCache>(
+      TomlConfig::getInstance().getLsmBlockCacheCapacity(),
+      TomlConfig::getInstance().getLsmBlockCacheK());
+  table_cache = std::make_shared<TableCache>(
+      TomlConfig::getInstance().getLsmMaxOpenFiles());
+
+  if (!std::filesystem::exists(path)) {
+    std::filesystem::create_directories(path);
+  }
+
+  // 各层的组成记录在 MANIFEST 中, 启动时不需要扫描目录和读取 sst 文件
+  // 旧版本的数据目录没有 MANIFEST, 退化为扫描目录
+  auto metas = Manifest::load(path);
+  if (!metas.has_value()) {
+    metas = scan_sst_files_();
+  }
+  for (auto &meta : *metas) {
+    if (ssts.find(meta.sst_id) == ssts.end()) {
+      ssts[meta.sst_id] = SST::open_lazy(
+          meta.sst_id, get_sst_path(meta.sst_id, meta.level), meta.file_size,
+          meta.first_key, meta.last_key,
+          {meta.min_tranc_id, meta.max_tranc_id}, block_cache);
+      ssts[meta.sst_id]->set_table_cache(table_cache);
+    }
+    level_sst_ids[meta.level].push_back(meta.sst_id);
+    next_sst_id = std::max(next_sst_id, meta.sst_id + 1);
+    cur_max_level = std::max(cur_max_level, meta.level);
+  }
+  spdlog::info("LSMEngine--Loaded {} SSTs from {}", ssts.size(), path);
+
+  for (auto &[level, sst_ids] : level_sst_ids) {
+    std::sort(sst_ids.begin(), sst_ids.end());
+    if (level == 0) {
+      // L0 的 sst 之间 key 可能重叠, 新的 sst 排在前面
+      std::reverse(sst_ids.begin(), sst_ids.end());
+    }
+  }
+
+  install_version_();
+
+  // 重写为只包含当前状态的 MANIFEST, 之后的变更追加到其中
+  manifest_.reset(path, *metas);
+  preload_ssts_();
+}
+
+LSMEngine::~LSMEngine() {
+  stop_loading_ = true;
+  for (auto &loader : sst_loaders_) {
+    loader.join();
+  }
+}
+
+std::vector<SstFileMeta> LSMEngine::scan_sst_files_() {
+  std::vector<SstFileMeta> metas;
+  auto io_mode = SST::file_io_mode();
+  for (const auto &entry : std::filesystem::directory_iterator(data_dir)) {
+    if (!entry.is_regular_file()) {
+      continue;
+    }
+    // sst的文件名格式为: sst_<sst_id>.<level>
+    std::string filename = entry.path().filename().string();
+    if (filename.substr(0, 4) != "sst_") {
+      continue;
+    }
+    auto dot_pos = filename.find('.');
+    if (dot_pos == std::string::npos) {
+      continue;
+    }
+    size_t sst_id = std::stoull(filename.substr(4, dot_pos - 4));
+    size_t level = std::stoull(filename.substr(dot_pos + 1));
+
+    // 只读取元数据, 之后和 MANIFEST 中的 sst 一样延迟打开
+    auto file = FileObj::open(entry.path().string(), false, io_mode);
+    auto sst = SST::open(sst_id, std::move(file), block_cache);
+    metas.push_back(sst_file_meta_(sst, level));
+
+    spdlog::info("LSMEngine--"
+                 "Loaded SST {} at level {}",
+                 sst_id, level);
+  }
+  return metas;
+}
+
+void LSMEngine::preload_ssts_() {
+  auto pending = std::make_shared<std::vector<std::shared_ptr<SST>>>();
+  // 低层的 sst 更新, 更可能被访问; 超出表缓存容量的部分预加载后也会被卸载
+  size_t limit = table_cache->capacity() > 0 ? table_cache->capacity()
+                                             : ssts.size();
+  for (auto &[level, sst_ids] : level_sst_ids) {
+    for (auto sst_id : sst_ids) {
+      if (pending->size() < limit) {
+        pending->push_back(ssts[sst_id]);
+      }
+    }
+  }
+  if (pending->empty()) {
+    return;
+  }
+
+  // 加载失败的 sst 在第一次被访问时会重新尝试并抛出异常
+  auto next = std::make_shared<std::atomic<size_t>>(0);
+  size_t loader_num = std::min<size_t>(
+      pending->size(), std::max(1u, std::thread::hardware_concurrency()));
+  for (size_t i = 0; i < loader_num; ++i) {
+    sst_loaders_.emplace_back([this, pending, next]() {
+      for (size_t idx = (*next)++; idx < pending->size() && !stop_loading_;
+           idx = (*next)++) {
+        try {
+          (*pending)[idx]->ensure_loaded();
+        } catch (const std::exception &e) {
+          spdlog::error("LSMEngine--preload SST {}: {}",
+                        (*pending)[idx]->get_sst_id(), e.what());
+        }
+      }
+    });
+  }
 }
 
-LSMEngine::~LSMEngine() = default;
+SstFileMeta LSMEngine::sst_file_meta_(const std::shared_ptr<SST> &sst,
+                                      size_t level) {
+  SstFileMeta meta;
+  meta.sst_id = sst->get_sst_id();
+  meta.level = level;
+  meta.file_size = sst->sst_size();
+  meta.first_key = sst->get_first_key();
+  meta.last_key = sst->get_last_key();
+  std::tie(meta.min_tranc_id, meta.max_tranc_id) = sst->get_tranc_id_range();
+  return meta;
+}
 
 std::optional<std::pair<std::string, uint64_t>>
 LSMEngine::get(const std::string &key, uint64_t tranc_id) {
-  // TODO: Lab 4.2 查询
+  // (done)TODO: Lab 4.2 查询
+  auto res = get_version(key, tranc_id);
+  if (res.has_value() && res->first.empty()) {
+    // 空值表示删除标记
+    return std::nullopt;
+  }
+  return res;
+}
 
-  return std::nullopt;
+std::optional<std::pair<std::string, uint64_t>>
+LSMEngine::get_version(const std::string &key, uint64_t tranc_id) {
+  // 1. 先查 memtable
+  auto mem_res = memtable.get(key, tranc_id);
+  if (mem_res.is_valid()) {
+    return std::make_pair(mem_res.get_value(), mem_res.get_tranc_id());
+  }
+
+  // 2. 再查 sst
+  return sst_get_version_(key, tranc_id);
 }
 
 std::vector<
     std::pair<std::string, std::optional<std::pair<std::string, uint64_t>>>>
 LSMEngine::get_batch(const std::vector<std::string> &keys, uint64_t tranc_id) {
-  // TODO: Lab 4.2 批量查询
+  // (done)TODO: Lab 4.2 批量查询
+  // 1. 先在 memtable 中批量查询, 命中的 key (包括删除标记) 结果已经确定
+  auto results = memtable.get_batch(keys, tranc_id);
+
+  std::vector<size_t> pending;
+  for (size_t i = 0; i < results.size(); ++i) {
+    auto &value = results[i].second;
+    if (!value.has_value()) {
+      pending.push_back(i);
+    } else if (value->first.empty()) {
+      value = std::nullopt;
+    }
+  }
+  if (pending.empty()) {
+    return results;
+  }
+
+  // memtable 之后再获取 sst 组成, 期间刷盘的数据一定在其中
+  auto version = current_version();
+
+  // 2. 借助 key 范围和布隆过滤器, 为每个 key 按照新 -> 旧的顺序
+  // 列出所有可能包含它的 (sst, block)
+  struct Probe {
+    size_t result_idx;
+    std::vector<std::pair<std::shared_ptr<SST>, size_t>> candidates;
+    size_t next = 0;
+  };
+  std::vector<Probe> probes;
+  for (auto idx : pending) {
+    Probe probe{idx, {}, 0};
+    for (auto &sst : version->sst_candidates(keys[idx])) {
+      size_t block_idx = sst->find_block_idx(keys[idx]);
+      if (block_idx != static_cast<size_t>(-1)) {
+        probe.candidates.emplace_back(sst, block_idx);
+      }
+    }
+    if (!probe.candidates.empty()) {
+      probes.push_back(std::move(probe));
+    }
+  }
+
+  // 3. 逐轮推进: 每轮取每个 key 的下一个候选 block, 去重后一次批量读取,
+  // 读完后立即在 block 内解析对应的 key, 未找到可见版本的 key 进入下一轮
+  while (!probes.empty()) {
+    std::vector<std::pair<std::shared_ptr<SST>, size_t>> reqs;
+    std::map<std::pair<size_t, size_t>, size_t> req_pos;
+    for (auto &probe : probes) {
+      auto &[sst, block_idx] = probe.candidates[probe.next];
+      auto [it, inserted] =
+          req_pos.emplace(std::make_pair(sst->get_sst_id(), block_idx),
+                          reqs.size());
+      if (inserted) {
+        reqs.emplace_back(sst, block_idx);
+      }
+    }
+
+    auto blocks = SST::read_blocks_batch(reqs);
+
+    std::vector<Probe> remain;
+    for (auto &probe : probes) {
+      auto &[sst, block_idx] = probe.candidates[probe.next];
+      auto &block =
+          blocks[req_pos.at(std::make_pair(sst->get_sst_id(), block_idx))];
+      auto res =
+          block->get_value_tranc_binary(keys[probe.result_idx], tranc_id);
+      if (res.has_value()) {
+        if (!res->first.empty()) {
+          results[probe.result_idx].second = std::move(res);
+        }
+        continue;
+      }
+      if (++probe.next < probe.candidates.size()) {
+        remain.push_back(std::move(probe));
+      }
+    }
+    probes = std::move(remain);
+  }
 
-  return {};
+  return results;
 }
 
 std::optional<std::pair<std::string, uint64_t>>
 LSMEngine::sst_get_(const std::string &key, uint64_t tranc_id) {
-  // TODO: Lab 4.2 sst 内部查询
+  // (done)TODO: Lab 4.2 sst 内部查询
+  auto res = sst_get_version_(key, tranc_id);
+  if (res.has_value() && res->first.empty()) {
+    // 空值表示删除标记
+    return std::nullopt;
+  }
+  return res;
+}
+
+std::optional<std::pair<std::string, uint64_t>>
+LSMEngine::sst_get_version_(const std::string &key, uint64_t tranc_id) {
+  // 持有 Version 而不是读锁, 查找期间 compact 可以安装新的 sst
+  auto version = current_version();
+
+  for (auto &sst : version->sst_candidates(key)) {
+    size_t block_idx = sst->find_block_idx(key);
+    if (block_idx == static_cast<size_t>(-1)) {
+      continue;
+    }
+    auto res = sst->read_block(block_idx)->get_value_tranc_binary(key, tranc_id);
+    if (!res.has_value()) {
+      // 没有可见的版本, 继续查找更旧的 sst
+      continue;
+    }
+    return res;
+  }
   return std::nullopt;
 }
 
 uint64_t LSMEngine::put(const std::string &key, const std::string &value,
                         uint64_t tranc_id) {
-  // TODO: Lab 4.1 插入
+  // (done)TODO: Lab 4.1 插入
   // ? 由于 put 操作可能触发 flush
   // ? 如果触发了 flush 则返回新刷盘的 sst 的 id
   // ? 在没有实现  flush 的情况下，你返回 0即可
-  return 0;
+  memtable.put(key, value, tranc_id);
+  return flush_if_needed_();
 }
 
 uint64_t LSMEngine::put_batch(
     const std::vector<std::pair<std::string, std::string>> &kvs,
     uint64_t tranc_id) {
-  // TODO: Lab 4.1 批量插入
+  // (done)TODO: Lab 4.1 批量插入
   // ? 由于 put 操作可能触发 flush
   // ? 如果触发了 flush 则返回新刷盘的 sst 的 id
   // ? 在没有实现  flush 的情况下，你返回 0即可
-  return 0;
+  memtable.put_batch(kvs, tranc_id);
+  return flush_if_needed_();
 }
 uint64_t LSMEngine::remove(const std::string &key, uint64_t tranc_id) {
-  // TODO: Lab 4.1 删除
+  // (done)TODO: Lab 4.1 删除
   // ? 在 LSM 中，删除实际上是插入一个空值
   // ? 由于 put 操作可能触发 flush
   // ? 如果触发了 flush 则返回新刷盘的 sst 的 id
   // ? 在没有实现  flush 的情况下，你返回 0即可
-  return 0;
+  memtable.remove(key, tranc_id);
+  return flush_if_needed_();
 }
 
 uint64_t LSMEngine::remove_batch(const std::vector<std::string> &keys,
                                  uint64_t tranc_id) {
-  // TODO: Lab 4.1 批量删除
+  // (done)TODO: Lab 4.1 批量删除
   // ? 在 LSM 中，删除实际上是插入一个空值
   // ? 由于 put 操作可能触发 flush
   // ? 如果触发了 flush 则返回新刷盘的 sst 的 id
   // ? 在没有实现  flush 的情况下，你返回 0即可
-  return 0;
+  memtable.remove_batch(keys, tranc_id);
+  return flush_if_needed_();
+}
+
+uint64_t LSMEngine::write(const WriteBatch &batch, uint64_t tranc_id) {
+  memtable.write(batch, tranc_id);
+  return flush_if_needed_();
 }
 
 void LSMEngine::clear() {
+  std::unique_lock<std::shared_mutex> lock(ssts_mtx);
   memtable.clear();
   level_sst_ids.clear();
   ssts.clear();
+  install_version_();
   // 清空当前文件夹的所有内容
   try {
     for (const auto &entry : std::filesystem::directory_iterator(data_dir)) {
@@ -106,13 +368,92 @@ void LSMEngine::clear() {
     // 处理文件系统错误
     spdlog::error("Error clearing directory: {}", e.what());
   }
+  manifest_.reset(data_dir, {});
 }
 
 uint64_t LSMEngine::flush() {
-  // TODO: Lab 4.1 刷盘形成sst文件
+  // (done)TODO: Lab 4.1 刷盘形成sst文件
+  if (memtable.get_total_size() == 0) {
+    return 0;
+  }
+
+  std::unique_lock<std::shared_mutex> lock(ssts_mtx);
+
+  // L0 的 sst 数量达到阈值时, 先向下层 compact
+  auto l0_it = level_sst_ids.find(0);
+  if (l0_it != level_sst_ids.end() &&
+      l0_it->second.size() >=
+          static_cast<size_t>(TomlConfig::getInstance().getLsmSstLevelRatio())) {
+    full_compact(0);
+  }
+
+  size_t new_sst_id = next_sst_id++;
+  SSTBuilder builder(TomlConfig::getInstance().getLsmBlockSize(), true);
+  auto sst_path = get_sst_path(new_sst_id, 0);
+  // 在冻结表移除之前发布新的 sst, 读者总能在 memtable 或 sst 中找到这部分数据
+  auto new_sst = memtable.flush_last(
+      builder, sst_path, new_sst_id, block_cache,
+      [&](const std::shared_ptr<SST> &sst) {
+        // sst 文件已经落盘, 记录到 MANIFEST 后才算生效; 记录失败时不发布,
+        // 数据留在 memtable 中. 无法确定变更是否已经部分写入, 保留 sst 文件
+        if (!manifest_.log_edit({sst_file_meta_(sst, 0)}, {})) {
+          throw std::runtime_error("LSMEngine--flush: failed to log SST " +
+                                   std::to_string(new_sst_id) +
+                                   " to MANIFEST");
+        }
+        ssts[new_sst_id] = sst;
+        level_sst_ids[0].push_front(new_sst_id);
+        // 刚刷盘的 sst 已经加载, 登记到表缓存中
+        sst->set_table_cache(table_cache);
+        install_version_();
+      });
+  if (new_sst == nullptr) {
+    return 0;
+  }
+
+  return new_sst->get_tranc_id_range().second;
+}
+
+uint64_t LSMEngine::load_sorted(
+    const std::vector<std::tuple<std::string, std::string, uint64_t>>
+        &entries) {
+  memtable.load_sorted(entries);
+  if (memtable.get_total_size() <
+      static_cast<size_t>(TomlConfig::getInstance().getLsmTolMemSizeLimit())) {
+    return 0;
+  }
+
+  // 加载的数据按 key 而不是事务 id 切分到多个跳表中,
+  // 只刷入一部分时无法确定哪些事务已经完整持久化, 因此全部刷盘
+  uint64_t max_tranc_id = 0;
+  while (memtable.get_total_size() > 0) {
+    max_tranc_id = std::max(max_tranc_id, flush());
+  }
+  return max_tranc_id;
+}
+
+uint64_t LSMEngine::flush_if_needed_() {
+  // 内存表的总大小超出阈值时刷盘
+  if (memtable.get_total_size() >=
+      static_cast<size_t>(TomlConfig::getInstance().getLsmTolMemSizeLimit())) {
+    return flush();
+  }
   return 0;
 }
 
+void LSMEngine::install_version_() {
+  version_.store(Version::create(level_sst_ids, ssts),
+                 std::memory_order_release);
+}
+
+std::shared_ptr<const Version> LSMEngine::current_version() const {
+  return version_.load(std::memory_order_acquire);
+}
+
+Snapshot LSMEngine::create_snapshot(uint64_t tranc_id) {
+  return snapshots_.create(tranc_id);
+}
+
 std::string LSMEngine::get_sst_path(size_t sst_id, size_t target_level) {
   // sst的文件路径格式为: data_dir/sst_<sst_id>，sst_id格式化为32位数字
   std::stringstream ss;
@@ -121,49 +462,261 @@ std::string LSMEngine::get_sst_path(size_t sst_id, size_t target_level) {
   return ss.str();
 }
 
+namespace {
+// memtable 和各层 sst 中满足 predicate(key) == 0 的最小 key,
+// 每个数据源内部二分查找; 删除标记和不可见的版本也参与比较, 结果不会大于
+// 第一个可见的满足谓词的 key
+std::optional<std::string>
+first_matching_key(LSMEngine &engine, uint64_t tranc_id,
+                   const std::function<int(const std::string &)> &predicate) {
+  std::optional<std::string> result;
+  auto update = [&](const std::string &key) {
+    if (!result.has_value() || key < *result) {
+      result = key;
+    }
+  };
+  // 满足谓词的版本对事务都不可见时返回的迭代器无效
+  auto search_sst = [&](const std::shared_ptr<SST> &sst) {
+    auto res = sst_iters_monotony_predicate(sst, tranc_id, predicate);
+    if (!res.has_value() || !res->first.is_valid()) {
+      return false;
+    }
+    update(res->first.key());
+    return true;
+  };
+
+  auto mem_res = engine.memtable.iters_monotony_predicate(tranc_id, predicate);
+  if (mem_res.has_value() && mem_res->first.is_valid()) {
+    update((*mem_res->first).first);
+  }
+
+  // 与 Level_Iterator 相同, 先访问 memtable 再获取 sst 组成
+  auto version = engine.current_version();
+  for (auto &[level, sst_ids] : version->level_sst_ids) {
+    if (level == 0) {
+      // L0 的 sst 之间可能重叠, 按首尾 key 过滤后逐个查找
+      for (auto sst_id : sst_ids) {
+        auto &sst = version->ssts.at(sst_id);
+        if (predicate(sst->get_last_key()) > 0 ||
+            predicate(sst->get_first_key()) < 0) {
+          continue;
+        }
+        search_sst(sst);
+      }
+      continue;
+    }
+    // 其他层的 sst 有序且不重叠, 二分找到第一个尾 key 不在区间左侧的 sst
+    size_t left = 0;
+    size_t right = sst_ids.size();
+    while (left < right) {
+      size_t mid = left + (right - left) / 2;
+      if (predicate(version->ssts.at(sst_ids[mid])->get_last_key()) > 0) {
+        left = mid + 1;
+      } else {
+        right = mid;
+      }
+    }
+    // 满足谓词的区间可能落在两个 sst 之间, 此时继续检查下一个 sst
+    for (size_t i = left; i < sst_ids.size(); ++i) {
+      auto &sst = version->ssts.at(sst_ids[i]);
+      if (predicate(sst->get_first_key()) < 0 || search_sst(sst)) {
+        break;
+      }
+    }
+  }
+  return result;
+}
+} // namespace
+
 std::optional<std::pair<TwoMergeIterator, TwoMergeIterator>>
 LSMEngine::lsm_iters_monotony_predicate(
     uint64_t tranc_id, std::function<int(const std::string &)> predicate) {
-  // TODO: Lab 4.7 谓词查询
-  return std::nullopt;
+  // (done)TODO: Lab 4.7 谓词查询
+  auto lower = first_matching_key(*this, tranc_id, predicate);
+  if (!lower.has_value()) {
+    return std::nullopt;
+  }
+  // 区间右侧的 key 也构成一个单调的区间, 它的最小 key 就是迭代的上界
+  auto upper = first_matching_key(
+      *this, tranc_id,
+      [&](const std::string &key) { return predicate(key) < 0 ? 0 : 1; });
+
+  std::shared_ptr<Level_Iterator> level_it;
+  if (upper.has_value()) {
+    level_it = std::make_shared<Level_Iterator>(shared_from_this(), tranc_id,
+                                                *lower, *upper);
+  } else {
+    level_it = std::make_shared<Level_Iterator>(shared_from_this(), tranc_id);
+    level_it->seek(*lower);
+  }
+  if (!level_it->is_valid()) {
+    // 满足谓词的 key 都已经被删除
+    return std::nullopt;
+  }
+  return std::make_pair(TwoMergeIterator(level_it, nullptr, tranc_id),
+                        TwoMergeIterator());
 }
 
 Level_Iterator LSMEngine::begin(uint64_t tranc_id) {
-  // TODO: Lab 4.7
-  throw std::runtime_error("Not implemented");
+  // (done)TODO: Lab 4.7
+  return Level_Iterator(shared_from_this(), tranc_id);
 }
 
 Level_Iterator LSMEngine::end() {
-  // TODO: Lab 4.7
-  throw std::runtime_error("Not implemented");
+  // (done)TODO: Lab 4.7
+  return Level_Iterator{};
+}
+
+Level_Iterator LSMEngine::range(uint64_t tranc_id, const std::string &lower,
+                                const std::string &upper) {
+  return Level_Iterator(shared_from_this(), tranc_id, lower, upper);
 }
 
 void LSMEngine::full_compact(size_t src_level) {
-  // TODO: Lab 4.5 负责完成整个 full compact
-  // ? 你可能需要控制`Compact`流程需要递归地进行
+  // (done)TODO: Lab 4.5 负责完成整个 full compact
+  // 调用者需持有 ssts_mtx 的写锁
+  size_t dst_level = src_level + 1;
+  // 目标层的 sst 数量也达到阈值时, 先把目标层向下 compact
+  if (level_sst_ids[dst_level].size() >=
+      static_cast<size_t>(TomlConfig::getInstance().getLsmSstLevelRatio())) {
+    full_compact(dst_level);
+  }
+
+  std::vector<size_t> src_ids(level_sst_ids[src_level].begin(),
+                              level_sst_ids[src_level].end());
+  std::vector<size_t> dst_ids(level_sst_ids[dst_level].begin(),
+                              level_sst_ids[dst_level].end());
+  if (src_ids.empty()) {
+    return;
+  }
+  auto new_ssts = src_level == 0
+                      ? full_l0_l1_compact(src_ids, dst_ids)
+                      : full_common_compact(src_ids, dst_ids, dst_level);
+
+  // 新的 sst 记录到 MANIFEST 后才能删除旧的文件
+  std::vector<SstFileMeta> added;
+  for (auto &sst : new_ssts) {
+    added.push_back(sst_file_meta_(sst, dst_level));
+  }
+  std::vector<size_t> deleted = src_ids;
+  deleted.insert(deleted.end(), dst_ids.begin(), dst_ids.end());
+  if (!manifest_.log_edit(added, deleted)) {
+    // 不安装新的 sst, 旧的 sst 继续生效, 它们的文件不能删除
+    throw std::runtime_error("LSMEngine--full_compact: failed to log "
+                             "compaction of level " +
+                             std::to_string(src_level) + " to MANIFEST");
+  }
+
+  // 旧的 sst 可能还被之前的 Version 和迭代器引用, 最后一个引用释放时才删除文件
+  for (auto id : deleted) {
+    ssts.at(id)->mark_obsolete();
+    ssts.erase(id);
+  }
+  level_sst_ids[src_level].clear();
+  auto &dst = level_sst_ids[dst_level];
+  dst.clear();
+  // 新 sst 的 id 按 key 递增, 恢复时按 id 排序即可还原层内顺序
+  for (auto &sst : new_ssts) {
+    sst->set_table_cache(table_cache);
+    ssts[sst->get_sst_id()] = sst;
+    dst.push_back(sst->get_sst_id());
+  }
+  cur_max_level = std::max(cur_max_level, dst_level);
+  install_version_();
+
+  spdlog::info("LSMEngine--full_compact: level {} ({} SSTs) + level {} ({} "
+               "SSTs) -> {} SSTs",
+               src_level, src_ids.size(), dst_level, dst_ids.size(),
+               new_ssts.size());
 }
 
 std::vector<std::shared_ptr<SST>>
 LSMEngine::full_l0_l1_compact(std::vector<size_t> &l0_ids,
                               std::vector<size_t> &l1_ids) {
-  // TODO: Lab 4.5 负责完成 l0 和 l1 的 full compact
-  return {};
+  // (done)TODO: Lab 4.5 负责完成 l0 和 l1 的 full compact
+  size_t readahead =
+      TomlConfig::getInstance().getLsmCompactionReadaheadBlocks();
+  // L0 的 sst 之间可能重叠, 按新 -> 旧多路归并
+  std::vector<SstScan> l0;
+  for (auto id : l0_ids) {
+    l0.emplace_back(ssts.at(id), readahead);
+  }
+  std::vector<std::shared_ptr<SST>> l1;
+  for (auto id : l1_ids) {
+    l1.push_back(ssts.at(id));
+  }
+
+  // 未释放的快照能看到的旧版本需要保留
+  NewestScan scan(TwoMergeScan(MergeScan<SstScan>(std::move(l0)),
+                               LevelScan(std::move(l1), readahead)),
+                  is_bottom_level_(1), snapshots_.tranc_ids());
+  return gen_sst_from_iter(scan, get_sst_size(1), 1);
 }
 
 std::vector<std::shared_ptr<SST>>
 LSMEngine::full_common_compact(std::vector<size_t> &lx_ids,
                                std::vector<size_t> &ly_ids, size_t level_y) {
-  // TODO: Lab 4.5 负责完成其他相邻 level 的 full compact
+  // (done)TODO: Lab 4.5 负责完成其他相邻 level 的 full compact
+  size_t readahead =
+      TomlConfig::getInstance().getLsmCompactionReadaheadBlocks();
+  std::vector<std::shared_ptr<SST>> lx;
+  for (auto id : lx_ids) {
+    lx.push_back(ssts.at(id));
+  }
+  std::vector<std::shared_ptr<SST>> ly;
+  for (auto id : ly_ids) {
+    ly.push_back(ssts.at(id));
+  }
 
-  return {};
+  NewestScan scan(TwoMergeScan(LevelScan(std::move(lx), readahead),
+                               LevelScan(std::move(ly), readahead)),
+                  is_bottom_level_(level_y), snapshots_.tranc_ids());
+  return gen_sst_from_iter(scan, get_sst_size(level_y), level_y);
 }
 
+template <Scan S>
 std::vector<std::shared_ptr<SST>>
-LSMEngine::gen_sst_from_iter(BaseIterator &iter, size_t target_sst_size,
+LSMEngine::gen_sst_from_iter(S &scan, size_t target_sst_size,
                              size_t target_level) {
-  // TODO: Lab 4.5 实现从迭代器构造新的 SST
+  // (done)TODO: Lab 4.5 实现从迭代器构造新的 SST
+  std::vector<std::shared_ptr<SST>> new_ssts;
+  std::optional<SSTBuilder> builder;
+  // 达到大小后记录当时的 key, 同一个 key 的所有版本写入同一个 sst
+  std::optional<std::string> split_key;
+
+  auto finish = [&]() {
+    size_t sst_id = next_sst_id++;
+    new_ssts.push_back(builder->build(
+        sst_id, get_sst_path(sst_id, target_level), block_cache));
+    builder.reset();
+    split_key.reset();
+  };
+
+  for (; scan.valid(); scan.next()) {
+    if (split_key.has_value() && scan.key() != *split_key) {
+      finish();
+    }
+    if (!builder.has_value()) {
+      builder.emplace(TomlConfig::getInstance().getLsmBlockSize(), true);
+    }
+    builder->add(scan.key(), scan.value(), scan.tranc_id());
+    if (!split_key.has_value() && builder->estimated_size() >= target_sst_size) {
+      split_key = scan.key();
+    }
+  }
+  if (builder.has_value()) {
+    finish();
+  }
+  return new_ssts;
+}
 
-  return {};
+bool LSMEngine::is_bottom_level_(size_t level) const {
+  for (auto &[l, ids] : level_sst_ids) {
+    if (l > level && !ids.empty()) {
+      return false;
+    }
+  }
+  return true;
 }
 
 size_t LSMEngine::get_sst_size(size_t level) {
@@ -180,18 +733,78 @@ size_t LSMEngine::get_sst_size(size_t level) {
 LSM::LSM(std::string path)
     : engine(std::make_shared<LSMEngine>(path)),
       tran_manager_(std::make_shared<TranManager>(path)) {
-  // TODO: Lab 5.5 控制WAL重放与组件的初始化
+  // (done)TODO: Lab 5.5 控制WAL重放与组件的初始化
+  tran_manager_->set_engine(engine);
+
+  // 重放已经提交但还没有刷入 sst 的事务
+  // 按事务 id 从小到大合并, 同一个 key 只保留最后一次写入, 删除记为空值
+  auto check_recover_res = tran_manager_->check_recover();
+  std::unordered_map<std::string, std::pair<std::string, uint64_t>> replay;
+  uint64_t max_replayed_tranc_id = 0;
+  for (auto &[tranc_id, records] : check_recover_res) {
+    if (records.empty() ||
+        records.back().getOperationType() != OperationType::COMMIT) {
+      continue;
+    }
+    for (auto &record : records) {
+      if (record.getOperationType() == OperationType::PUT) {
+        replay[record.getKey()] = {record.getValue(), tranc_id};
+      } else if (record.getOperationType() == OperationType::DELETE) {
+        replay[record.getKey()] = {"", tranc_id};
+      }
+    }
+    max_replayed_tranc_id = tranc_id;
+  }
+
+  if (!replay.empty()) {
+    // 排序后直接追加构建跳表, 不需要逐条查找插入位置
+    std::vector<std::tuple<std::string, std::string, uint64_t>> entries;
+    entries.reserve(replay.size());
+    for (auto &[key, value] : replay) {
+      entries.emplace_back(key, std::move(value.first), value.second);
+    }
+    replay.clear();
+    std::sort(entries.begin(), entries.end(),
+              [](const auto &a, const auto &b) {
+                return std::get<0>(a) < std::get<0>(b);
+              });
+    auto max_flushed_tranc_id = engine->load_sorted(entries);
+    if (max_flushed_tranc_id != 0) {
+      tran_manager_->update_max_flushed_tranc_id(max_flushed_tranc_id);
+    }
+  }
+  if (max_replayed_tranc_id != 0) {
+    tran_manager_->update_max_finished_tranc_id(max_replayed_tranc_id);
+  }
+
+  // 重放完成后再开启新的 WAL
+  tran_manager_->init_new_wal();
 }
 
 LSM::~LSM() {
-  flush_all();
+  try {
+    flush_all();
+  } catch (const std::exception &e) {
+    // 析构函数不能抛出异常, 未刷盘的数据仍然可以通过 WAL 恢复
+    spdlog::error("LSM--~LSM: flush_all failed: {}", e.what());
+  }
   tran_manager_->write_tranc_id_file();
 }
 
-std::optional<std::string> LSM::get(const std::string &key, bool tranc_off) {
-  auto tranc_id = tranc_off ? 0 : tran_manager_->getNextTransactionId();
-  auto res = engine->get(key, tranc_id);
+std::optional<std::string> LSM::get(const std::string &key,
+                                    bool /*tranc_off*/) {
+  // 事务 id 为 0 表示读取最新的版本, 不需要为读操作分配事务 id
+  auto res = engine->get(key, 0);
+
+  if (res.has_value()) {
+    return res.value().first;
+  }
+  return std::nullopt;
+}
 
+std::optional<std::string> LSM::get(const std::string &key,
+                                    const Snapshot &snapshot) {
+  auto res = engine->get(key, snapshot.get_tranc_id());
   if (res.has_value()) {
     return res.value().first;
   }
@@ -200,13 +813,22 @@ std::optional<std::string> LSM::get(const std::string &key, bool tranc_off) {
 
 std::vector<std::pair<std::string, std::optional<std::string>>>
 LSM::get_batch(const std::vector<std::string> &keys) {
-  // 1. 获取事务ID
-  auto tranc_id = tran_manager_->getNextTransactionId();
+  // 没有快照时读取最新的版本
+  return get_batch_(keys, 0);
+}
+
+std::vector<std::pair<std::string, std::optional<std::string>>>
+LSM::get_batch(const std::vector<std::string> &keys,
+               const Snapshot &snapshot) {
+  return get_batch_(keys, snapshot.get_tranc_id());
+}
 
-  // 2. 调用 engine 的批量查询接口
+std::vector<std::pair<std::string, std::optional<std::string>>>
+LSM::get_batch_(const std::vector<std::string> &keys, uint64_t tranc_id) {
+  // 1. 调用 engine 的批量查询接口
   auto batch_results = engine->get_batch(keys, tranc_id);
 
-  // 3. 构造最终结果
+  // 2. 构造最终结果
   std::vector<std::pair<std::string, std::optional<std::string>>> results;
   for (const auto &[key, value] : batch_results) {
     if (value.has_value()) {
@@ -219,30 +841,109 @@ LSM::get_batch(const std::vector<std::string> &keys) {
   return results;
 }
 
-void LSM::put(const std::string &key, const std::string &value,
-              bool tranc_off) {
-  auto tranc_id = tranc_off ? 0 : tran_manager_->getNextTransactionId();
-  engine->put(key, value, tranc_id);
+// 单次写入在 WAL 中记录为只有一个操作的事务, 以 COMMIT 结尾才会被重放
+// 写入 WAL 和 memtable 时持有 key 所在的提交分片, 与事务提交时的冲突检测互斥;
+// 写入结束后标记事务 id 已结束, 之后创建的快照才能看到这次写入
+void LSM::commit_write_(uint64_t tranc_id,
+                        const std::vector<std::string_view> &keys,
+                        const std::vector<Record> &records,
+                        WalSyncMode sync_mode,
+                        const std::function<uint64_t()> &apply) {
+  std::shared_future<bool> wal_future;
+  auto finish = [&]() {
+    if (wal_future.valid()) {
+      wal_future.wait();
+    }
+    tran_manager_->update_max_finished_tranc_id(tranc_id);
+  };
+
+  try {
+    uint64_t max_flushed_tranc_id;
+    {
+      auto locks = tran_manager_->lock_commit_shards(keys);
+      if (!records.empty()) {
+        wal_future = tran_manager_->write_to_wal_async(records, sync_mode);
+      }
+      max_flushed_tranc_id = apply();
+    }
+    if (max_flushed_tranc_id != 0) {
+      tran_manager_->update_max_flushed_tranc_id(max_flushed_tranc_id);
+    }
+  } catch (...) {
+    // 写入 memtable 之后的刷盘失败, 事务 id 不能一直处于运行中
+    finish();
+    throw;
+  }
+  finish();
 }
 
-void LSM::put_batch(
-    const std::vector<std::pair<std::string, std::string>> &kvs) {
+void LSM::put(const std::string &key, const std::string &value, bool tranc_off,
+              WalSyncMode sync_mode) {
+  // 关闭事务时同样分配事务 id, 否则 0 号版本会排在同一个 key 的所有版本之后
   auto tranc_id = tran_manager_->getNextTransactionId();
-  engine->put_batch(kvs, tranc_id);
+  // 关闭事务时不写入 WAL, 崩溃后这次写入不会被重放
+  std::vector<Record> records;
+  if (!tranc_off) {
+    records = {Record::putRecord(tranc_id, key, value),
+               Record::commitRecord(tranc_id)};
+  }
+  commit_write_(tranc_id, {key}, records, sync_mode,
+                [&]() { return engine->put(key, value, tranc_id); });
 }
-void LSM::remove(const std::string &key) {
+
+void LSM::put_batch(
+    const std::vector<std::pair<std::string, std::string>> &kvs,
+    WalSyncMode sync_mode) {
+  WriteBatch batch;
+  for (auto &[key, value] : kvs) {
+    batch.put(key, value);
+  }
+  write(batch, sync_mode);
+}
+
+void LSM::remove(const std::string &key, WalSyncMode sync_mode) {
   auto tranc_id = tran_manager_->getNextTransactionId();
-  engine->remove(key, tranc_id);
+  commit_write_(
+      tranc_id, {key},
+      {Record::deleteRecord(tranc_id, key), Record::commitRecord(tranc_id)},
+      sync_mode, [&]() { return engine->remove(key, tranc_id); });
+}
+
+void LSM::remove_batch(const std::vector<std::string> &keys,
+                       WalSyncMode sync_mode) {
+  WriteBatch batch;
+  for (auto &key : keys) {
+    batch.remove(key);
+  }
+  write(batch, sync_mode);
 }
 
-void LSM::remove_batch(const std::vector<std::string> &keys) {
+void LSM::write(const WriteBatch &batch, WalSyncMode sync_mode) {
+  if (batch.empty()) {
+    return;
+  }
   auto tranc_id = tran_manager_->getNextTransactionId();
-  engine->remove_batch(keys, tranc_id);
+
+  std::vector<Record> records;
+  Record::batchRecords(tranc_id, batch, records);
+  records.push_back(Record::commitRecord(tranc_id));
+  std::vector<std::string> keys;
+  keys.reserve(batch.count());
+  batch.for_each([&](WriteBatch::OpType, const std::string &key,
+                     const std::string &) { keys.push_back(key); });
+
+  commit_write_(tranc_id,
+                std::vector<std::string_view>(keys.begin(), keys.end()),
+                records, sync_mode,
+                [&]() { return engine->write(batch, tranc_id); });
 }
 
 void LSM::clear() { engine->clear(); }
 
-void LSM::flush() { auto max_tranc_id = engine->flush(); }
+void LSM::flush() {
+  auto max_tranc_id = engine->flush();
+  tran_manager_->update_max_flushed_tranc_id(max_tranc_id);
+}
 
 void LSM::flush_all() {
   while (engine->memtable.get_total_size() > 0) {
@@ -251,24 +952,49 @@ void LSM::flush_all() {
   }
 }
 
+Snapshot LSM::get_snapshot() {
+  return engine->create_snapshot(tran_manager_->get_max_finished_tranc_id_());
+}
+
 LSM::LSMIterator LSM::begin(uint64_t tranc_id) {
   return engine->begin(tranc_id);
 }
 
+LSM::LSMIterator LSM::begin(const Snapshot &snapshot) {
+  return engine->begin(snapshot.get_tranc_id());
+}
+
 LSM::LSMIterator LSM::end() { return engine->end(); }
 
+LSM::LSMIterator LSM::range(uint64_t tranc_id, const std::string &lower,
+                            const std::string &upper) {
+  return engine->range(tranc_id, lower, upper);
+}
+
+LSM::LSMIterator LSM::range(const Snapshot &snapshot,
+                            const std::string &lower,
+                            const std::string &upper) {
+  return engine->range(snapshot.get_tranc_id(), lower, upper);
+}
+
 std::optional<std::pair<TwoMergeIterator, TwoMergeIterator>>
 LSM::lsm_iters_monotony_predicate(
     uint64_t tranc_id, std::function<int(const std::string &)> predicate) {
   return engine->lsm_iters_monotony_predicate(tranc_id, predicate);
 }
 
+std::optional<std::pair<TwoMergeIterator, TwoMergeIterator>>
+LSM::lsm_iters_monotony_predicate(
+    const Snapshot &snapshot,
+    std::function<int(const std::string &)> predicate) {
+  return engine->lsm_iters_monotony_predicate(snapshot.get_tranc_id(),
+                                              predicate);
+}
+
 // 开启一个事务
 std::shared_ptr<TranContext>
 LSM::begin_tran(const IsolationLevel &isolation_level) {
-  // TODO: xx
-
-  return {};
+  return tran_manager_->new_tranc(isolation_level);
 }
 
 void LSM::set_log_level(const std::string &level) { reset_log_level(level); }
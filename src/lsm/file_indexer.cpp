@@ -0,0 +1,94 @@
+#include "../../include/lsm/file_indexer.h"
+#include <algorithm>
+
+namespace tiny_lsm {
+
+void FileIndexer::build(
+    const std::map<size_t, std::deque<size_t>> &level_sst_ids,
+    const std::unordered_map<size_t, std::shared_ptr<SST>> &ssts) {
+  levels_.clear();
+  for (auto &[level, sst_ids] : level_sst_ids) {
+    if (level == 0 || sst_ids.empty()) {
+      continue;
+    }
+    auto &level_files = levels_.emplace_back();
+    level_files.files.reserve(sst_ids.size());
+    for (auto sst_id : sst_ids) {
+      auto &sst = ssts.at(sst_id);
+      level_files.files.push_back(
+          {sst->get_first_key(), sst->get_last_key(), sst, 0});
+    }
+  }
+
+  // 两层的 last_key 都是有序的, 双指针计算 next_lb
+  for (size_t i = 0; i + 1 < levels_.size(); ++i) {
+    auto &files = levels_[i].files;
+    auto &next_files = levels_[i + 1].files;
+    size_t j = 0;
+    for (auto &file : files) {
+      while (j < next_files.size() && next_files[j].last_key < file.last_key) {
+        ++j;
+      }
+      file.next_lb = j;
+    }
+  }
+}
+
+void FileIndexer::find(const std::string &key,
+                       std::vector<std::shared_ptr<SST>> &res) const {
+  size_t lo = 0;
+  size_t hi = levels_.empty() ? 0 : levels_.front().files.size();
+  for (size_t i = 0; i < levels_.size(); ++i) {
+    auto &level = levels_[i];
+    size_t pos = search(level, key, lo, hi);
+    if (pos < level.files.size() && level.files[pos].first_key <= key) {
+      res.push_back(level.files[pos].sst);
+    }
+
+    if (i + 1 == levels_.size()) {
+      break;
+    }
+    // 下一层的位置位于 [next_lb[pos - 1], next_lb[pos]] 之间
+    size_t next_size = levels_[i + 1].files.size();
+    lo = pos > 0 ? level.files[pos - 1].next_lb : 0;
+    hi = pos < level.files.size() ? level.files[pos].next_lb + 1 : next_size;
+    hi = std::min(hi, next_size);
+  }
+}
+
+size_t FileIndexer::lower_bound(const LevelFiles &level,
+                                const std::string &key, size_t lo, size_t hi) {
+  auto &files = level.files;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (files[mid].last_key < key) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+size_t FileIndexer::search(const LevelFiles &level, const std::string &key,
+                           size_t lo, size_t hi) {
+  auto &files = level.files;
+  size_t last_hit = level.last_hit.load(std::memory_order_relaxed);
+  for (size_t pos = last_hit; pos < last_hit + 2 && pos < files.size();
+       ++pos) {
+    // 同层的 sst 不重叠, 落在某个 sst 的范围内时它就是二分的结果
+    if (files[pos].first_key <= key && key <= files[pos].last_key) {
+      if (pos != last_hit) {
+        level.last_hit.store(pos, std::memory_order_relaxed);
+      }
+      return pos;
+    }
+  }
+
+  size_t pos = lower_bound(level, key, lo, hi);
+  if (pos < files.size() && files[pos].first_key <= key) {
+    level.last_hit.store(pos, std::memory_order_relaxed);
+  }
+  return pos;
+}
+} // namespace tiny_lsm
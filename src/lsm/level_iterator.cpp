@@ -2,142 +2,179 @@
 #include "../../include/lsm/engine.h"
 #include "../../include/sst/concact_iterator.h"
 #include "../../include/sst/sst.h"
+#include "../../include/sst/sst_iterator.h"
 #include <memory>
-#include <shared_mutex>
 #include <string>
+#include <vector>
 
-// TODO: 需要进行单元测试
 namespace tiny_lsm {
 Level_Iterator::Level_Iterator(std::shared_ptr<LSMEngine> engine,
                                uint64_t max_tranc_id)
-    : engine_(engine), max_tranc_id_(max_tranc_id), rlock_(engine_->ssts_mtx) {
-  // 成员变量获取sst读锁
+    : engine_(engine), max_tranc_id_(max_tranc_id) {
+  // 子迭代器按从新到旧排列, key 相同时归并迭代器优先输出新的版本
+  std::vector<std::shared_ptr<BaseIterator>> iters;
 
   // 1. 获取内存部分迭代器
-  // TODO: 这里最好修改 memtable.begin 使其返回一个指针, 避免多余的内存拷贝
-  auto mem_iter = engine_->memtable.begin(max_tranc_id_);
-  std::shared_ptr<HeapIterator> mem_iter_ptr = std::make_shared<HeapIterator>();
-  *mem_iter_ptr = mem_iter;
-  iter_vec.push_back(mem_iter_ptr);
+  // 保留删除标记, 否则 memtable 中的删除无法屏蔽 sst 中更旧的版本
+  iters.push_back(std::make_shared<MemTableIterator>(
+      engine_->memtable.begin(max_tranc_id_, true)));
+  // memtable 之后再获取 sst 组成, 期间从 memtable 刷盘的数据一定在其中
+  version_ = engine_->current_version();
 
   // 2. 获取 L0 层的迭代器
-  std::vector<SearchItem> item_vec;
-  for (auto &sst_id : engine_->level_sst_ids[0]) {
-    auto sst = engine_->ssts[sst_id];
-    for (auto iter = sst->begin(max_tranc_id_);
-         iter.is_valid() && iter != sst->end(); ++iter) {
-      // 这里越新的sst的idx越大, 我们需要让新的sst优先在堆顶
-      // 让新的sst(拥有更大的idx)排序在前面, 反转符号就行了
-      if (max_tranc_id_ != 0 && iter.get_tranc_id() > max_tranc_id_) {
-        // 如果开启了事务, 比当前事务 id 更大的记录是不可见的
+  // L0 的 sst 之间 key 可能重叠, 每个 sst 单独作为一路, 越新的 sst 越靠前
+  auto l0_it = version_->level_sst_ids.find(0);
+  if (l0_it != version_->level_sst_ids.end()) {
+    for (auto sst_id : l0_it->second) {
+      auto &sst = version_->ssts.at(sst_id);
+      iters.push_back(std::make_shared<SstIterator>(sst->begin(max_tranc_id_)));
+    }
+  }
+
+  // 3. 获取其他层的迭代器
+  // 同一层的 sst 不重叠, 整层连接为一路
+  for (auto &[level, sst_id_list] : version_->level_sst_ids) {
+    if (level == 0 || sst_id_list.empty()) {
+      continue;
+    }
+    std::vector<std::shared_ptr<SST>> ssts;
+    for (auto sst_id : sst_id_list) {
+      ssts.push_back(version_->ssts.at(sst_id));
+    }
+    iters.push_back(std::make_shared<ConcactIterator>(ssts, max_tranc_id_));
+  }
+
+  merge_ = std::make_shared<MergeIterator>(std::move(iters), max_tranc_id_);
+  settle();
+}
+
+Level_Iterator::Level_Iterator(std::shared_ptr<LSMEngine> engine,
+                               uint64_t max_tranc_id, const std::string &lower,
+                               const std::string &upper)
+    : engine_(engine), max_tranc_id_(max_tranc_id), lower_(lower),
+      upper_(upper) {
+  std::vector<std::shared_ptr<BaseIterator>> iters;
+
+  // 1. 跳表通过查找定位范围的首尾
+  iters.push_back(std::make_shared<MemTableIterator>(
+      engine_->memtable.range(lower, upper, max_tranc_id_, true)));
+  version_ = engine_->current_version();
+
+  // 2. L0 的 sst 按首尾 key 过滤, 只访问范围内的 block
+  auto l0_it = version_->level_sst_ids.find(0);
+  if (l0_it != version_->level_sst_ids.end()) {
+    for (auto sst_id : l0_it->second) {
+      auto &sst = version_->ssts.at(sst_id);
+      if (sst->get_last_key() < lower || sst->get_first_key() >= upper) {
         continue;
       }
-      item_vec.emplace_back(iter.key(), iter.value(), -sst_id, 0,
-                            iter.get_tranc_id());
+      iters.push_back(
+          std::make_shared<SstIterator>(sst, lower, upper, max_tranc_id_));
     }
   }
-  std::shared_ptr<HeapIterator> l0_iter_ptr =
-      std::make_shared<HeapIterator>(item_vec, max_tranc_id);
-  iter_vec.push_back(l0_iter_ptr);
 
-  // 3. 获取其他层的迭代器
-  for (auto &[level, sst_id_list] : engine_->level_sst_ids) {
-    if (level == 0) {
+  // 3. 其他层只连接与范围相交的 sst
+  for (auto &[level, sst_id_list] : version_->level_sst_ids) {
+    if (level == 0 || sst_id_list.empty()) {
       continue;
     }
     std::vector<std::shared_ptr<SST>> ssts;
     for (auto sst_id : sst_id_list) {
-      auto sst = engine_->ssts[sst_id];
-      ssts.push_back(sst);
-      std::shared_ptr<ConcactIterator> level_i_iter =
-          std::make_shared<ConcactIterator>(ssts, max_tranc_id);
-      iter_vec.push_back(level_i_iter);
+      ssts.push_back(version_->ssts.at(sst_id));
     }
+    iters.push_back(
+        std::make_shared<ConcactIterator>(ssts, max_tranc_id_, lower, upper));
   }
 
-  while (!is_end()) {
-    auto [min_idx, _] = get_min_key_idx();
-    cur_idx_ = min_idx;
-    update_current();
-    auto cached_kv = *cached_value;
-    if (cached_kv.second.size() == 0) {
+  merge_ = std::make_shared<MergeIterator>(std::move(iters), max_tranc_id_);
+  settle();
+}
+
+void Level_Iterator::settle() {
+  cached_value.reset();
+  while (merge_->is_valid()) {
+    // 沿当前方向越过范围的边界后结束, 子迭代器不再前进
+    if (forward_ ? upper_ && merge_->key() >= *upper_
+                 : lower_ && merge_->key() < *lower_) {
+      return;
+    }
+    // 归并迭代器先输出最新的版本
+    auto kv = **merge_;
+    while (merge_->is_valid() && merge_->key() == kv.first) {
+      if (forward_) {
+        ++(*merge_);
+      } else {
+        --(*merge_);
+      }
+    }
+    if (kv.second.empty()) {
       // 如果当前值为空, 说明当前key已经被删除了
-      // 需要跳过这个key
-      skip_key(cached_value->first);
       continue;
-    } else {
-      // 找到一个合法的键值对, 跳出循环
-      break;
     }
+    // 找到一个合法的键值对
+    cached_value = std::move(kv);
+    return;
   }
 }
 
-std::pair<size_t, std::string> Level_Iterator::get_min_key_idx() const {
-  size_t min_idx = 0;
-  std::string min_key = "";
-  for (size_t i = 0; i < iter_vec.size(); ++i) {
-    if (!iter_vec[i]->is_valid()) {
-      // 如果当前迭代器无效, 则跳过
-      continue;
-    } else if (min_key == "") {
-      // 第一次初始化
-      min_key = (**iter_vec[i]).first;
-      min_idx = i;
-    } else if ((**iter_vec[i]).first < (**iter_vec[min_idx]).first) {
-      // 更新最小key和索引
-      min_key = (**iter_vec[i]).first;
-      min_idx = i;
-    } else if ((**iter_vec[i]).first == min_key) {
-      // key相同时, 事务id大的排前面
-      if (max_tranc_id_ != 0) {
-        if ((*iter_vec[i]).get_tranc_id() >
-            (*iter_vec[min_idx]).get_tranc_id()) {
-          min_idx = i;
-        }
-      }
+BaseIterator &Level_Iterator::operator++() {
+  if (merge_ == nullptr || !is_valid()) {
+    return *this;
+  }
+  if (!forward_) {
+    // 反向时归并迭代器停在当前 key 之前, 重新定位到当前 key 之后
+    auto key = cached_value->first;
+    merge_->seek(key);
+    while (merge_->is_valid() && merge_->key() == key) {
+      ++(*merge_);
     }
+    forward_ = true;
   }
-  return std::make_pair(min_idx, min_key);
+  // 归并迭代器已经越过了当前 key 的所有版本
+  settle();
+  return *this;
 }
 
-void Level_Iterator::skip_key(const std::string &key) {
-  for (size_t i = 0; i < iter_vec.size(); ++i) {
-    while ((*iter_vec[i]).is_valid() && (**iter_vec[i]).first == key) {
-      // 如果找到当前key, 则跳过这个key
-      ++(*iter_vec[i]);
+BaseIterator &Level_Iterator::operator--() {
+  if (merge_ == nullptr || !is_valid()) {
+    return *this;
+  }
+  if (forward_) {
+    auto key = cached_value->first;
+    merge_->seek_for_prev(key);
+    while (merge_->is_valid() && merge_->key() == key) {
+      --(*merge_);
     }
+    forward_ = false;
   }
+  settle();
+  return *this;
 }
 
-void Level_Iterator::update_current() const {
-  if (!(*iter_vec[cur_idx_]).is_valid()) {
-    throw std::runtime_error("Level_Iterator is invalid");
+void Level_Iterator::seek(const std::string &key) {
+  if (merge_ == nullptr) {
+    return;
   }
-  // Ensure cached_value points to the correct value_type
-  auto cur_kv = *(*iter_vec[cur_idx_]);
-  cached_value = std::make_optional<value_type>(cur_kv.first, cur_kv.second);
+  merge_->seek(lower_ && key < *lower_ ? *lower_ : key);
+  forward_ = true;
+  settle();
 }
 
-BaseIterator &Level_Iterator::operator++() {
-  // 先跳过和当前 key 相同的部分
-  skip_key(cached_value->first);
-
-  // 重新选择key最小的迭代器
-  while (!is_end()) {
-    auto [min_idx, _] = get_min_key_idx();
-    cur_idx_ = min_idx;
-    update_current();
-    if (cached_value->second.size() == 0) {
-      // 如果当前值为空, 说明当前key已经被删除了
-      // 需要跳过这个key
-      skip_key(cached_value->first);
-      continue;
-    } else {
-      // 找到一个合法的键值对, 跳出循环
-      break;
+void Level_Iterator::seek_for_prev(const std::string &key) {
+  if (merge_ == nullptr) {
+    return;
+  }
+  if (upper_ && key >= *upper_) {
+    // 定位到 upper 之前的最后一个 key
+    merge_->seek_for_prev(*upper_);
+    while (merge_->is_valid() && merge_->key() == *upper_) {
+      --(*merge_);
     }
+  } else {
+    merge_->seek_for_prev(key);
   }
-  return *this;
+  forward_ = false;
+  settle();
 }
 
 bool Level_Iterator::operator==(const BaseIterator &other) const {
@@ -171,19 +208,14 @@ IteratorType Level_Iterator::get_type() const {
 
 uint64_t Level_Iterator::get_tranc_id() const { return max_tranc_id_; }
 
-bool Level_Iterator::is_end() const {
-  for (auto &iter : iter_vec) {
-    if ((*iter).is_valid()) {
-      return false;
-    }
-  }
-  return true;
-}
+bool Level_Iterator::is_end() const { return !cached_value.has_value(); }
 
-bool Level_Iterator::is_valid() const { return !is_end(); }
+bool Level_Iterator::is_valid() const { return cached_value.has_value(); }
 
 BaseIterator::pointer Level_Iterator::operator->() const {
-  update_current();
+  if (!cached_value.has_value()) {
+    throw std::runtime_error("Level_Iterator is invalid");
+  }
   return &(*cached_value);
 }
-} // namespace tiny_lsm
\ No newline at end of file
+} // namespace tiny_lsm
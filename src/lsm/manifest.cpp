@@ -0,0 +1,196 @@
+#include "../../include/lsm/manifest.h"
+#include "../../include/utils/crc32c.h"
+#include "spdlog/spdlog.h"
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <stdexcept>
+
+namespace tiny_lsm {
+
+namespace {
+constexpr size_t kFrameHeaderSize = 2 * sizeof(uint32_t);
+constexpr uint8_t kAddSst = 0;
+constexpr uint8_t kDeleteSst = 1;
+
+template <typename T> void put_fixed(std::vector<uint8_t> &buf, T value) {
+  size_t pos = buf.size();
+  buf.resize(pos + sizeof(T));
+  memcpy(buf.data() + pos, &value, sizeof(T));
+}
+
+void put_key(std::vector<uint8_t> &buf, const std::string &key) {
+  put_fixed<uint16_t>(buf, static_cast<uint16_t>(key.size()));
+  buf.insert(buf.end(), key.begin(), key.end());
+}
+
+template <typename T>
+bool get_fixed(const uint8_t *&p, const uint8_t *end, T &value) {
+  if (static_cast<size_t>(end - p) < sizeof(T)) {
+    return false;
+  }
+  memcpy(&value, p, sizeof(T));
+  p += sizeof(T);
+  return true;
+}
+
+bool get_key(const uint8_t *&p, const uint8_t *end, std::string &key) {
+  uint16_t len;
+  if (!get_fixed(p, end, len) || static_cast<size_t>(end - p) < len) {
+    return false;
+  }
+  key.assign(reinterpret_cast<const char *>(p), len);
+  p += len;
+  return true;
+}
+
+// 解码一帧中的所有操作, 格式错误时返回 false
+bool decode_edit(const uint8_t *p, const uint8_t *end,
+                 std::vector<SstFileMeta> &added, std::vector<size_t> &deleted) {
+  while (p < end) {
+    uint8_t type;
+    uint64_t sst_id;
+    if (!get_fixed(p, end, type) || !get_fixed(p, end, sst_id)) {
+      return false;
+    }
+    if (type == kDeleteSst) {
+      deleted.push_back(sst_id);
+      continue;
+    }
+    if (type != kAddSst) {
+      return false;
+    }
+
+    SstFileMeta meta;
+    uint32_t level;
+    uint64_t file_size;
+    if (!get_fixed(p, end, level) || !get_fixed(p, end, file_size) ||
+        !get_fixed(p, end, meta.min_tranc_id) ||
+        !get_fixed(p, end, meta.max_tranc_id) ||
+        !get_key(p, end, meta.first_key) || !get_key(p, end, meta.last_key)) {
+      return false;
+    }
+    meta.sst_id = sst_id;
+    meta.level = level;
+    meta.file_size = file_size;
+    added.push_back(std::move(meta));
+  }
+  return true;
+}
+} // namespace
+
+std::optional<std::vector<SstFileMeta>>
+Manifest::load(const std::string &data_dir) {
+  auto path = get_manifest_path(data_dir);
+  if (!std::filesystem::exists(path)) {
+    return std::nullopt;
+  }
+
+  auto file = FileObj::open(path, false);
+  auto data = file.read_to_slice(0, file.size());
+
+  std::map<size_t, SstFileMeta> ssts;
+  size_t pos = 0;
+  while (pos + kFrameHeaderSize <= data.size()) {
+    uint32_t payload_len, crc;
+    memcpy(&payload_len, data.data() + pos, sizeof(uint32_t));
+    memcpy(&crc, data.data() + pos + sizeof(uint32_t), sizeof(uint32_t));
+    pos += kFrameHeaderSize;
+    if (payload_len > data.size() - pos ||
+        crc32c(data.data() + pos, payload_len) != crc) {
+      // 崩溃时写入不完整的最后一帧, 对应的变更没有生效
+      spdlog::warn("Manifest--load: ignored a torn edit at offset {}",
+                   pos - kFrameHeaderSize);
+      break;
+    }
+
+    // 校验通过的帧内容是完整的, 解码失败说明格式有误
+    std::vector<SstFileMeta> added;
+    std::vector<size_t> deleted;
+    if (!decode_edit(data.data() + pos, data.data() + pos + payload_len, added,
+                     deleted)) {
+      throw std::runtime_error("Invalid MANIFEST: corrupted edit in " + path);
+    }
+    for (auto &meta : added) {
+      size_t sst_id = meta.sst_id;
+      ssts[sst_id] = std::move(meta);
+    }
+    for (auto sst_id : deleted) {
+      ssts.erase(sst_id);
+    }
+    pos += payload_len;
+  }
+
+  std::vector<SstFileMeta> res;
+  res.reserve(ssts.size());
+  for (auto &[sst_id, meta] : ssts) {
+    res.push_back(std::move(meta));
+  }
+  return res;
+}
+
+void Manifest::reset(const std::string &data_dir,
+                     const std::vector<SstFileMeta> &ssts) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  auto path = get_manifest_path(data_dir);
+  auto tmp_path = path + ".tmp";
+
+  std::vector<uint8_t> buf;
+  encode_edit(ssts, {}, buf);
+  // 新文件完整落盘后再替换旧文件, 崩溃时总有一个完整的 MANIFEST
+  FileObj::create_and_write(tmp_path, buf);
+  std::filesystem::rename(tmp_path, path);
+
+  file_ = FileObj::open(path, false);
+  opened_ = true;
+}
+
+bool Manifest::log_edit(const std::vector<SstFileMeta> &added,
+                        const std::vector<size_t> &deleted) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (!opened_) {
+    return false;
+  }
+  std::vector<uint8_t> buf;
+  encode_edit(added, deleted, buf);
+  if (file_.append(buf) && file_.sync()) {
+    return true;
+  }
+  // 文件末尾可能留下不完整的帧, 恢复时会停在这里, 之后追加的变更都会被忽略,
+  // 因此不再接受新的变更, 直到 reset 重写 MANIFEST
+  opened_ = false;
+  return false;
+}
+
+std::string Manifest::get_manifest_path(const std::string &data_dir) {
+  return data_dir + "/MANIFEST";
+}
+
+void Manifest::encode_edit(const std::vector<SstFileMeta> &added,
+                           const std::vector<size_t> &deleted,
+                           std::vector<uint8_t> &buf) {
+  size_t header_pos = buf.size();
+  buf.resize(header_pos + kFrameHeaderSize);
+
+  for (auto &meta : added) {
+    put_fixed<uint8_t>(buf, kAddSst);
+    put_fixed<uint64_t>(buf, meta.sst_id);
+    put_fixed<uint32_t>(buf, static_cast<uint32_t>(meta.level));
+    put_fixed<uint64_t>(buf, meta.file_size);
+    put_fixed<uint64_t>(buf, meta.min_tranc_id);
+    put_fixed<uint64_t>(buf, meta.max_tranc_id);
+    put_key(buf, meta.first_key);
+    put_key(buf, meta.last_key);
+  }
+  for (auto sst_id : deleted) {
+    put_fixed<uint8_t>(buf, kDeleteSst);
+    put_fixed<uint64_t>(buf, sst_id);
+  }
+
+  uint32_t payload_len = buf.size() - header_pos - kFrameHeaderSize;
+  uint32_t crc =
+      crc32c(buf.data() + header_pos + kFrameHeaderSize, payload_len);
+  memcpy(buf.data() + header_pos, &payload_len, sizeof(uint32_t));
+  memcpy(buf.data() + header_pos + sizeof(uint32_t), &crc, sizeof(uint32_t));
+}
+} // namespace tiny_lsm
@@ -0,0 +1,56 @@
+#include "../../include/lsm/snapshot.h"
+#include <utility>
+
+namespace tiny_lsm {
+
+Snapshot::Snapshot(std::shared_ptr<SnapshotRegistry> registry,
+                   uint64_t tranc_id)
+    : registry_(std::move(registry)), tranc_id_(tranc_id) {}
+
+Snapshot::~Snapshot() { release(); }
+
+Snapshot::Snapshot(Snapshot &&other) noexcept
+    : registry_(std::move(other.registry_)), tranc_id_(other.tranc_id_) {}
+
+Snapshot &Snapshot::operator=(Snapshot &&other) noexcept {
+  if (this != &other) {
+    release();
+    registry_ = std::move(other.registry_);
+    tranc_id_ = other.tranc_id_;
+  }
+  return *this;
+}
+
+void Snapshot::release() {
+  if (registry_ == nullptr) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(registry_->mtx);
+    auto it = registry_->tranc_ids.find(tranc_id_);
+    if (it != registry_->tranc_ids.end()) {
+      registry_->tranc_ids.erase(it);
+    }
+  }
+  registry_.reset();
+}
+
+SnapshotList::SnapshotList()
+    : registry_(std::make_shared<SnapshotRegistry>()) {}
+
+Snapshot SnapshotList::create(uint64_t tranc_id) {
+  std::lock_guard<std::mutex> lock(registry_->mtx);
+  registry_->tranc_ids.insert(tranc_id);
+  return Snapshot(registry_, tranc_id);
+}
+
+std::vector<uint64_t> SnapshotList::tranc_ids() const {
+  std::lock_guard<std::mutex> lock(registry_->mtx);
+  return {registry_->tranc_ids.begin(), registry_->tranc_ids.end()};
+}
+
+size_t SnapshotList::size() const {
+  std::lock_guard<std::mutex> lock(registry_->mtx);
+  return registry_->tranc_ids.size();
+}
+} // namespace tiny_lsm
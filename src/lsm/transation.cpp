@@ -1,3 +1,4 @@
+#include "../../include/config/config.h"
 #include "../../include/lsm/engine.h"
 #include "../../include/lsm/transaction.h"
 #include "../../include/utils/files.h"
@@ -32,30 +33,205 @@ inline std::string isolation_level_to_string(const IsolationLevel &level) {
 // *********************** TranContext ***********************
 TranContext::TranContext(uint64_t tranc_id, std::shared_ptr<LSMEngine> engine,
                          std::shared_ptr<TranManager> tranManager,
-                         const enum IsolationLevel &isolation_level) {
-  // TODO: Lab 5.2 构造函数初始化
+                         const enum IsolationLevel &isolation_level)
+    : engine_(std::move(engine)), tranManager_(std::move(tranManager)),
+      tranc_id_(tranc_id), isolation_level_(isolation_level) {
+  // (done)TODO: Lab 5.2 构造函数初始化
+  if (isolation_level_ == IsolationLevel::REPEATABLE_READ ||
+      isolation_level_ == IsolationLevel::SERIALIZABLE) {
+    // 比本事务 id 小的事务可能还没有结束, 读取已结束事务的水位而不是 tranc_id_
+    snapshot_ = engine_->create_snapshot(
+        tranManager_->get_max_finished_tranc_id_());
+  }
+}
+
+TranContext::~TranContext() {
+  // 没有提交也没有回滚就被销毁的事务(如只读事务)同样需要结束
+  if (!isCommited && !isAborted) {
+    finish_();
+  }
+}
+
+void TranContext::finish_() {
+  snapshot_.reset();
+  tranManager_->update_max_finished_tranc_id(tranc_id_);
 }
 
 void TranContext::put(const std::string &key, const std::string &value) {
-  // TODO: Lab 5.2 put 实现
+  // (done)TODO: Lab 5.2 put 实现
+  if (isolation_level_ == IsolationLevel::READ_UNCOMMITTED) {
+    // 直接写入 memtable, 先保存旧值以便回滚
+    if (rollback_map_.find(key) == rollback_map_.end()) {
+      rollback_map_[key] = engine_->get(key, 0);
+    }
+    engine_->put(key, value, tranc_id_);
+  } else {
+    // 其他隔离级别先写入事务的私有空间, 提交时统一写入
+    temp_map_[key] = value;
+  }
+  write_batch_.put(key, value);
 }
 
 void TranContext::remove(const std::string &key) {
-  // TODO: Lab 5.2 remove 实现
+  // (done)TODO: Lab 5.2 remove 实现
+  if (isolation_level_ == IsolationLevel::READ_UNCOMMITTED) {
+    if (rollback_map_.find(key) == rollback_map_.end()) {
+      rollback_map_[key] = engine_->get(key, 0);
+    }
+    engine_->remove(key, tranc_id_);
+  } else {
+    // 空值表示删除
+    temp_map_[key] = "";
+  }
+  write_batch_.remove(key);
 }
 
 std::optional<std::string> TranContext::get(const std::string &key) {
-  // TODO: Lab 5.2 get 实现
-  return {};
+  // (done)TODO: Lab 5.2 get 实现
+  // 先查询事务自己的修改
+  auto temp_it = temp_map_.find(key);
+  if (temp_it != temp_map_.end()) {
+    if (temp_it->second.empty()) {
+      return std::nullopt;
+    }
+    return temp_it->second;
+  }
+
+  std::optional<std::pair<std::string, uint64_t>> query;
+  if (isolation_level_ == IsolationLevel::READ_UNCOMMITTED ||
+      isolation_level_ == IsolationLevel::READ_COMMITTED) {
+    // 总是读取最新的数据
+    query = engine_->get(key, 0);
+  } else {
+    // 可重复读: 同一个 key 总是返回第一次读取的结果
+    auto read_it = read_map_.find(key);
+    if (read_it != read_map_.end()) {
+      query = read_it->second;
+    } else if (isolation_level_ == IsolationLevel::SERIALIZABLE) {
+      // 记录看到的版本(包括删除标记), 提交时校验它没有被其他事务修改
+      auto version = engine_->get_version(key, snapshot_->get_tranc_id());
+      read_set_[key] = version.has_value() ? version->second : 0;
+      if (version.has_value() && !version->first.empty()) {
+        query = std::move(version);
+      }
+      read_map_[key] = query;
+    } else {
+      query = engine_->get(key, snapshot_->get_tranc_id());
+      read_map_[key] = query;
+    }
+  }
+
+  if (query.has_value()) {
+    return query->first;
+  }
+  return std::nullopt;
 }
 
-bool TranContext::commit(bool test_fail) {
-  // TODO: Lab 5.2 commit 实现
-  return true;
+bool TranContext::commit(bool test_fail, WalSyncMode sync_mode) {
+  // (done)TODO: Lab 5.2 commit 实现
+  if (isCommited || isAborted) {
+    return false;
+  }
+
+  std::shared_future<bool> wal_future;
+  {
+    std::vector<std::string_view> keys;
+    for (auto &[key, value] : temp_map_) {
+      keys.push_back(key);
+    }
+    for (auto &[key, tranc_id] : read_set_) {
+      keys.push_back(key);
+    }
+    auto locks = tranManager_->lock_commit_shards(keys);
+
+    if (isolation_level_ == IsolationLevel::REPEATABLE_READ ||
+        isolation_level_ == IsolationLevel::SERIALIZABLE) {
+      // 写冲突检测: 同一个 key 有本事务的视图之外的版本, 即其他事务在本事务
+      // 开始后提交了修改(包括删除); 开始时还没有结束的事务即使 id 更小也算冲突
+      for (auto &[key, value] : temp_map_) {
+        auto res = engine_->get_version(key, 0);
+        if (res.has_value() && res->second > snapshot_->get_tranc_id()) {
+          isAborted = true;
+          finish_();
+          return false;
+        }
+      }
+    }
+    if (isolation_level_ == IsolationLevel::SERIALIZABLE) {
+      // 读集合校验: 读取过的 key 的最新版本必须仍是当时看到的版本,
+      // 否则其他事务的提交使本事务的读取结果失效
+      for (auto &[key, observed] : read_set_) {
+        auto res = engine_->get_version(key, 0);
+        if ((res.has_value() ? res->second : 0) != observed) {
+          isAborted = true;
+          finish_();
+          return false;
+        }
+      }
+    }
+
+    // 在锁内把记录交给 WAL, 保证修改同一个 key 的事务日志顺序与提交顺序一致
+    std::vector<Record> records;
+    records.reserve(write_batch_.count() + 2);
+    records.push_back(Record::createRecord(tranc_id_));
+    Record::batchRecords(tranc_id_, write_batch_, records);
+    records.push_back(Record::commitRecord(tranc_id_));
+    wal_future = tranManager_->write_to_wal_async(records, sync_mode);
+
+    // test_fail 模拟写入 WAL 之后、写入 memtable 之前的崩溃
+    // 读未提交的修改已经写入 memtable, 其他隔离级别在这里一次性写入
+    if (!test_fail && isolation_level_ != IsolationLevel::READ_UNCOMMITTED &&
+        !write_batch_.empty()) {
+      try {
+        auto max_flushed_tranc_id = engine_->write(write_batch_, tranc_id_);
+        if (max_flushed_tranc_id != 0) {
+          tranManager_->update_max_flushed_tranc_id(max_flushed_tranc_id);
+        }
+      } catch (...) {
+        // 修改已经写入 memtable, 只是随后的刷盘失败, 事务仍然算作已提交
+        wal_future.wait();
+        isCommited = true;
+        finish_();
+        throw;
+      }
+    }
+  }
+
+  // 在锁外等待组提交完成, 期间其他事务可以继续提交并进入同一批次
+  bool wal_success = wal_future.get();
+  if (!wal_success) {
+    spdlog::error("TranContext--commit({}): failed to write WAL", tranc_id_);
+  }
+
+  isCommited = true;
+  finish_();
+  return wal_success;
 }
 
 bool TranContext::abort() {
-  // TODO: Lab 5.2 abort 实现
+  // (done)TODO: Lab 5.2 abort 实现
+  if (isCommited || isAborted) {
+    return false;
+  }
+
+  if (isolation_level_ == IsolationLevel::READ_UNCOMMITTED) {
+    // 已经写入 memtable 的修改需要恢复为旧值: 用旧值覆盖本事务写入的版本,
+    // 本事务的版本比旧版本新, 只写回旧版本的事务 id 会被本事务的版本遮住
+    for (auto &[key, prev] : rollback_map_) {
+      if (prev.has_value()) {
+        engine_->put(key, prev->first, tranc_id_);
+      } else {
+        engine_->remove(key, tranc_id_);
+      }
+    }
+  }
+
+  // 没有 COMMIT 记录的事务不会被重放, 因此不需要写入 WAL
+  temp_map_.clear();
+  rollback_map_.clear();
+  write_batch_.clear();
+  isAborted = true;
+  finish_();
   return true;
 }
 
@@ -67,11 +243,30 @@ enum IsolationLevel TranContext::get_isolation_level() {
 TranManager::TranManager(std::string data_dir) : data_dir_(data_dir) {
   auto file_path = get_tranc_id_file_path();
 
-  // TODO: Lab 5.2 初始化时读取持久化的事务状态信息
+  // (done)TODO: Lab 5.2 初始化时读取持久化的事务状态信息
+  if (!std::filesystem::exists(file_path)) {
+    tranc_id_file_ = FileObj::open(file_path, true);
+  } else {
+    tranc_id_file_ = FileObj::open(file_path, false);
+    read_tranc_id_file();
+  }
+  // 事务 id 0 表示读取最新的版本, 不能作为快照的事务 id;
+  // 保留事务 id 1, 使已结束事务的水位至少为 1
+  if (nextTransactionId_.load() < 2) {
+    nextTransactionId_ = 2;
+    max_finished_tranc_id_ = 1;
+  }
+  write_tranc_id_file();
 }
 
 void TranManager::init_new_wal() {
-  // TODO: Lab 5.x 初始化 wal
+  // (done)TODO: Lab 5.x 初始化 wal
+  auto &config = TomlConfig::getInstance();
+  wal = std::make_shared<WAL>(
+      data_dir_, config.getLsmWalBufferSize(), get_max_flushed_tranc_id(),
+      config.getLsmWalCleanInterval(), config.getLsmWalFileSizeLimit(),
+      WAL::sync_mode_from_string(config.getLsmWalSyncMode()),
+      config.getLsmWalSyncIntervalMs(), config.getLsmWalRecycleNum());
 }
 
 void TranManager::set_engine(std::shared_ptr<LSMEngine> engine) {
@@ -80,24 +275,90 @@ void TranManager::set_engine(std::shared_ptr<LSMEngine> engine) {
 
 TranManager::~TranManager() { write_tranc_id_file(); }
 
+// 格式: | next_tranc_id(64) | max_flushed_tranc_id(64) |
+//       | max_finished_tranc_id(64) |
 void TranManager::write_tranc_id_file() {
-  // TODO: Lab 5.2 持久化事务状态信息
+  // (done)TODO: Lab 5.2 持久化事务状态信息
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t ids[3] = {nextTransactionId_.load(), max_flushed_tranc_id_.load(),
+                     max_finished_tranc_id_.load()};
+  std::vector<uint8_t> buf(sizeof(ids));
+  memcpy(buf.data(), ids, sizeof(ids));
+  tranc_id_file_.write(0, buf);
+  tranc_id_file_.sync();
 }
 
 void TranManager::read_tranc_id_file() {
-  // TODO: Lab 5.2 读取持久化的事务状态信息
+  // (done)TODO: Lab 5.2 读取持久化的事务状态信息
+  if (tranc_id_file_.size() < 3 * sizeof(uint64_t)) {
+    return;
+  }
+  nextTransactionId_ = tranc_id_file_.read_uint64(0);
+  max_flushed_tranc_id_ = tranc_id_file_.read_uint64(sizeof(uint64_t));
+  max_finished_tranc_id_ = tranc_id_file_.read_uint64(2 * sizeof(uint64_t));
 }
 
 void TranManager::update_max_finished_tranc_id(uint64_t tranc_id) {
-  // TODO: Lab 5.2 更新持久化的事务状态信息
+  // (done)TODO: Lab 5.2 更新持久化的事务状态信息
+  // 事务可能不按 id 的顺序结束, 水位是最小的运行中事务 id 之前的位置
+  std::lock_guard<std::mutex> lock(tranc_ids_mtx_);
+  running_tranc_ids_.erase(tranc_id);
+  uint64_t watermark = running_tranc_ids_.empty()
+                           ? nextTransactionId_.load() - 1
+                           : *running_tranc_ids_.begin() - 1;
+  if (watermark > max_finished_tranc_id_.load()) {
+    max_finished_tranc_id_.store(watermark);
+  }
 }
 
 void TranManager::update_max_flushed_tranc_id(uint64_t tranc_id) {
-  // TODO: Lab 5.2 更新持久化的事务状态信息
+  // (done)TODO: Lab 5.2 更新持久化的事务状态信息
+  // 事务 id 在开始时分配, 提交时才写入 memtable: id 更小的事务可能在刷盘之后才提交,
+  // 或者它的记录还在 memtable 中. 恢复时跳过、WAL 清理时丢弃的事务必须都已经在 sst 中,
+  // 因此水位不能超过已结束事务的水位和 memtable 中的最小事务 id.
+  // 先读取已结束事务的水位再读取 memtable: 比两者都小的事务在读取 memtable 之前就已经
+  // 写完 memtable, 而此时它的记录已经不在 memtable 中, 只能是已经刷入了 sst
+  tranc_id = std::min(tranc_id, max_finished_tranc_id_.load());
+  if (engine_) {
+    uint64_t mem_min_tranc_id = engine_->memtable.get_min_tranc_id();
+    if (mem_min_tranc_id != UINT64_MAX) {
+      tranc_id = std::min(tranc_id, mem_min_tranc_id - 1);
+    }
+  }
+  uint64_t cur = max_flushed_tranc_id_.load();
+  while (cur < tranc_id &&
+         !max_flushed_tranc_id_.compare_exchange_weak(cur, tranc_id)) {
+  }
+  // 先持久化再通知 WAL, 保证被清理的日志一定不会再被重放
+  write_tranc_id_file();
+  if (wal) {
+    wal->set_max_finished_tranc_id(max_flushed_tranc_id_.load());
+  }
 }
 
 uint64_t TranManager::getNextTransactionId() {
-  return nextTransactionId_.fetch_add(1, std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(tranc_ids_mtx_);
+  auto tranc_id = nextTransactionId_.fetch_add(1, std::memory_order_relaxed);
+  running_tranc_ids_.insert(tranc_id);
+  return tranc_id;
+}
+
+std::vector<std::unique_lock<std::mutex>> TranManager::lock_commit_shards(
+    const std::vector<std::string_view> &keys) {
+  std::vector<size_t> shards;
+  shards.reserve(keys.size());
+  for (auto key : keys) {
+    shards.push_back(std::hash<std::string_view>{}(key) % kCommitShards);
+  }
+  std::sort(shards.begin(), shards.end());
+  shards.erase(std::unique(shards.begin(), shards.end()), shards.end());
+
+  std::vector<std::unique_lock<std::mutex>> locks;
+  locks.reserve(shards.size());
+  for (auto shard : shards) {
+    locks.emplace_back(commit_shards_[shard]);
+  }
+  return locks;
 }
 
 uint64_t TranManager::get_max_flushed_tranc_id() {
@@ -110,8 +371,10 @@ uint64_t TranManager::get_max_finished_tranc_id_() {
 
 std::shared_ptr<TranContext>
 TranManager::new_tranc(const IsolationLevel &isolation_level) {
-  // TODO: Lab 5.2 事务上下文分配
-  return nullptr;
+  // (done)TODO: Lab 5.2 事务上下文分配
+  auto tranc_id = getNextTransactionId();
+  return std::make_shared<TranContext>(tranc_id, engine_, shared_from_this(),
+                                       isolation_level);
 }
 std::string TranManager::get_tranc_id_file_path() {
   if (data_dir_.empty()) {
@@ -121,14 +384,30 @@ std::string TranManager::get_tranc_id_file_path() {
 }
 
 std::map<uint64_t, std::vector<Record>> TranManager::check_recover() {
-  // TODO: Lab 5.5
-  return {};
+  // (done)TODO: Lab 5.5
+  auto tranc_records = WAL::recover(data_dir_, max_flushed_tranc_id_.load());
+
+  // 崩溃时事务 id 文件可能没有及时更新, 新的事务 id 需要大于日志中的所有 id
+  if (!tranc_records.empty()) {
+    uint64_t max_tranc_id = tranc_records.rbegin()->first;
+    if (nextTransactionId_.load() <= max_tranc_id) {
+      nextTransactionId_ = max_tranc_id + 1;
+    }
+  }
+  // 恢复时没有运行中的事务, 崩溃前没有结束的事务都视为已经回滚
+  max_finished_tranc_id_ = nextTransactionId_.load() - 1;
+  return tranc_records;
 }
 
 bool TranManager::write_to_wal(const std::vector<Record> &records) {
-  // TODO: Lab 5.4
+  // (done)TODO: Lab 5.4
+  return write_to_wal_async(records).get();
+}
 
-  return true;
+std::shared_future<bool>
+TranManager::write_to_wal_async(const std::vector<Record> &records,
+                                WalSyncMode sync_mode) {
+  return wal->log_async(records, sync_mode);
 }
 
 // void TranManager::flusher() {
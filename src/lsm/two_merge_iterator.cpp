@@ -1,4 +1,5 @@
 #include "../../include/lsm/two_merge_iterator.h"
+#include <stdexcept>
 
 namespace tiny_lsm {
 
@@ -15,38 +16,147 @@ TwoMergeIterator::TwoMergeIterator(std::shared_ptr<BaseIterator> it_a,
   choose_a = choose_it_a(); // 决定使用哪个迭代器
 }
 
+bool TwoMergeIterator::valid_a() const { return it_a && it_a->is_valid(); }
+
+bool TwoMergeIterator::valid_b() const { return it_b && it_b->is_valid(); }
+
 bool TwoMergeIterator::choose_it_a() {
-  // TODO: Lab 4.4: 实现选择迭代器的逻辑
-  return false;
+  // (done)TODO: Lab 4.4: 实现选择迭代器的逻辑
+  if (!valid_a()) {
+    return false;
+  }
+  if (!valid_b()) {
+    return true;
+  }
+  // skip_it_b 之后两者的 key 不会相同
+  auto key_a = (**it_a).first;
+  auto key_b = (**it_b).first;
+  return forward_ ? key_a < key_b : key_a > key_b;
 }
 
 void TwoMergeIterator::skip_it_b() {
-  if (!it_a->is_end() && !it_b->is_end() && (**it_a).first == (**it_b).first) {
-    ++(*it_b);
+  // it_b 中与 it_a 相同的 key 是旧版本, 直接跳过
+  if (valid_a() && valid_b() && (**it_a).first == (**it_b).first) {
+    if (forward_) {
+      ++(*it_b);
+    } else {
+      --(*it_b);
+    }
   }
 }
 
 void TwoMergeIterator::skip_by_tranc_id() {
-  // TODO: Lab xx
+  // 子迭代器创建时已经传入了 max_tranc_id, 只会输出可见的版本
+}
+
+void TwoMergeIterator::switch_direction() {
+  auto key = (**this).first;
+  auto &other = choose_a ? it_b : it_a;
+  forward_ = !forward_;
+  if (other == nullptr) {
+    return;
+  }
+  if (forward_) {
+    other->seek(key);
+    if (other->is_valid() && (**other).first == key) {
+      ++(*other);
+    }
+  } else {
+    other->seek_for_prev(key);
+    if (other->is_valid() && (**other).first == key) {
+      --(*other);
+    }
+  }
 }
 
 BaseIterator &TwoMergeIterator::operator++() {
-  // TODO: Lab 4.4: 实现 ++ 重载
+  // (done)TODO: Lab 4.4: 实现 ++ 重载
+  if (!is_valid()) {
+    return *this;
+  }
+  if (!forward_) {
+    switch_direction();
+  }
+  if (choose_a) {
+    ++(*it_a);
+  } else {
+    ++(*it_b);
+  }
+  skip_it_b();
+  choose_a = choose_it_a();
+  current.reset();
+  return *this;
+}
+
+BaseIterator &TwoMergeIterator::operator--() {
+  if (!is_valid()) {
+    return *this;
+  }
+  if (forward_) {
+    switch_direction();
+  }
+  if (choose_a) {
+    --(*it_a);
+  } else {
+    --(*it_b);
+  }
+  skip_it_b();
+  choose_a = choose_it_a();
+  current.reset();
+  return *this;
+}
+
+void TwoMergeIterator::seek(const std::string &key) {
+  forward_ = true;
+  if (it_a) {
+    it_a->seek(key);
+  }
+  if (it_b) {
+    it_b->seek(key);
+  }
+  skip_it_b();
+  choose_a = choose_it_a();
+  current.reset();
+}
+
+void TwoMergeIterator::seek_for_prev(const std::string &key) {
+  forward_ = false;
+  if (it_a) {
+    it_a->seek_for_prev(key);
+  }
+  if (it_b) {
+    it_b->seek_for_prev(key);
+  }
+  skip_it_b();
+  choose_a = choose_it_a();
+  current.reset();
 }
 
 bool TwoMergeIterator::operator==(const BaseIterator &other) const {
-  // TODO: Lab 4.4: 实现 == 重载
-  return false;
+  // (done)TODO: Lab 4.4: 实现 == 重载
+  if (other.get_type() != IteratorType::TwoMergeIterator) {
+    return false;
+  }
+  if (!is_valid() && !other.is_valid()) {
+    return true;
+  }
+  if (!is_valid() || !other.is_valid()) {
+    return false;
+  }
+  return **this == *other;
 }
 
 bool TwoMergeIterator::operator!=(const BaseIterator &other) const {
-  // TODO: Lab 4.4: 实现 != 重载
-  return false;
+  // (done)TODO: Lab 4.4: 实现 != 重载
+  return !(*this == other);
 }
 
 BaseIterator::value_type TwoMergeIterator::operator*() const {
-  // TODO: Lab 4.4: 实现 * 重载
-  return {};
+  // (done)TODO: Lab 4.4: 实现 * 重载
+  if (!is_valid()) {
+    throw std::runtime_error("TwoMergeIterator is invalid");
+  }
+  return choose_a ? **it_a : **it_b;
 }
 
 IteratorType TwoMergeIterator::get_type() const {
@@ -82,11 +192,17 @@ bool TwoMergeIterator::is_valid() const {
 }
 
 TwoMergeIterator::pointer TwoMergeIterator::operator->() const {
-  // TODO: Lab 4.4: 实现 -> 重载
-  return nullptr;
+  // (done)TODO: Lab 4.4: 实现 -> 重载
+  update_current();
+  return current.get();
 }
 
 void TwoMergeIterator::update_current() const {
-  // TODO: Lab 4.4: 实现更新缓存键值对的辅助函数
+  // (done)TODO: Lab 4.4: 实现更新缓存键值对的辅助函数
+  if (is_valid()) {
+    current = std::make_shared<value_type>(**this);
+  } else {
+    current.reset();
+  }
 }
 } // namespace tiny_lsm
\ No newline at end of file
@@ -0,0 +1,32 @@
+#include "../../include/lsm/version.h"
+
+namespace tiny_lsm {
+
+std::shared_ptr<const Version> Version::create(
+    const std::map<size_t, std::deque<size_t>> &level_sst_ids,
+    const std::unordered_map<size_t, std::shared_ptr<SST>> &ssts) {
+  auto version = std::make_shared<Version>();
+  version->level_sst_ids = level_sst_ids;
+  version->ssts = ssts;
+  version->file_indexer.build(version->level_sst_ids, version->ssts);
+  return version;
+}
+
+std::vector<std::shared_ptr<SST>>
+Version::sst_candidates(const std::string &key) const {
+  std::vector<std::shared_ptr<SST>> res;
+  auto l0_it = level_sst_ids.find(0);
+  if (l0_it != level_sst_ids.end()) {
+    // L0 的 sst 之间 key 可能重叠, 需要按新 -> 旧逐个检查
+    for (auto sst_id : l0_it->second) {
+      auto &sst = ssts.at(sst_id);
+      if (sst->get_first_key() <= key && key <= sst->get_last_key()) {
+        res.push_back(sst);
+      }
+    }
+  }
+  // 其他层的 sst 之间 key 不重叠, 由 FileIndexer 逐层缩小二分范围
+  file_indexer.find(key, res);
+  return res;
+}
+} // namespace tiny_lsm
@@ -58,6 +58,45 @@ void MemTable::put_batch(const std::vector<std::pair<std::string, std::string>>
   }
 }
 
+void MemTable::write(const WriteBatch &batch, uint64_t tranc_id) {
+  std::unique_lock<std::shared_mutex> lock(cur_mtx);
+  batch.for_each([&](WriteBatch::OpType type, const std::string &key, const std::string &value) {
+    if (type == WriteBatch::OpType::Put) {
+      put_(key, value, tranc_id);
+    } else {
+      remove_(key, tranc_id);
+    }
+  });
+  // batch 写入完成后再检查是否需要冻结, 保证同一个 batch 位于同一个跳表中
+  auto &config = TomlConfig::getInstance(CONFIG_PATH);
+  if (current_table->get_size() >= config.getLsmPerMemSizeLimit()) {
+    spdlog::info("MemTable--write: Current table size exceeded limit, freezing current table");
+    std::unique_lock<std::shared_mutex> lock(frozen_mtx);
+    frozen_cur_table_();
+  }
+}
+
+void MemTable::load_sorted(const std::vector<std::tuple<std::string, std::string, uint64_t>> &entries) {
+  if (entries.empty()) {
+    return;
+  }
+  std::unique_lock<std::shared_mutex> lock1(cur_mtx);
+  std::unique_lock<std::shared_mutex> lock2(frozen_mtx);
+  // 已有的数据更旧, 先冻结, 保证加载的数据从新的跳表开始
+  if (current_table->get_size() > 0) {
+    frozen_cur_table_();
+  }
+
+  auto &config = TomlConfig::getInstance(CONFIG_PATH);
+  size_t size_limit = config.getLsmPerMemSizeLimit();
+  size_t next = current_table->bulk_load(entries, 0, size_limit);
+  while (next < entries.size()) {
+    frozen_cur_table_();
+    next = current_table->bulk_load(entries, next, size_limit);
+  }
+  spdlog::info("MemTable--load_sorted(): loaded {} entries", entries.size());
+}
+
 SkipListIterator MemTable::cur_get_(const std::string &key, uint64_t tranc_id) {
   // 检查当前活跃的memtable
   // (done)TODO: Lab2.1 从活跃跳表中查o
@@ -220,7 +259,8 @@ void MemTable::clear() {
 
 // 将最老的 memtable 写入 SST, 并返回控制类
 std::shared_ptr<SST> MemTable::flush_last(SSTBuilder &builder, std::string &sst_path, size_t sst_id,
-                                          std::shared_ptr<BlockCache> block_cache) {
+                                          std::shared_ptr<BlockCache> block_cache,
+                                          const std::function<void(const std::shared_ptr<SST> &)> &install) {
   spdlog::debug("MemTable--flush_last(): Starting to flush memtable to SST{}", sst_id);
 
   // 由于 flush 后需要移除最老的 memtable, 因此需要加写锁
@@ -243,18 +283,21 @@ std::shared_ptr<SST> MemTable::flush_last(SSTBuilder &builder, std::string &sst_
     current_table = std::make_shared<SkipList>();
   }
 
-  // 将最老的 memtable 写入 SST
+  // 将最老的 memtable 写入 SST, 构建或发布失败时保留这个冻结表
   std::shared_ptr<SkipList> table = frozen_tables.back();
-  frozen_tables.pop_back();
-  frozen_bytes -= table->get_size();
 
-  std::vector<std::tuple<std::string, std::string, uint64_t>> flush_data = table->flush();
-  for (auto &[k, v, t] : flush_data) {
-    max_tranc_id = std::max(t, max_tranc_id);
-    min_tranc_id = std::min(t, min_tranc_id);
-    builder.add(k, v, t);
+  // 冻结表不会再被修改, 直接从节点写入 builder, 不需要先拷贝出所有键值对
+  for (auto scan = table->scan(); scan.valid(); scan.next()) {
+    max_tranc_id = std::max(scan.tranc_id(), max_tranc_id);
+    min_tranc_id = std::min(scan.tranc_id(), min_tranc_id);
+    builder.add(scan.key(), scan.value(), scan.tranc_id());
   }
   auto sst = builder.build(sst_id, sst_path, block_cache);
+  if (install) {
+    install(sst);
+  }
+  frozen_tables.pop_back();
+  frozen_bytes -= table->get_size();
 
   spdlog::info("MemTable--flush_last(): SST{} built successfully at '{}'", sst_id, sst_path);
 
@@ -292,88 +335,103 @@ size_t MemTable::get_total_size() {
   return get_frozen_size() + current_table->get_size();
 }
 
-HeapIterator MemTable::begin(uint64_t tranc_id) {
-  // (done)TODO Lab 2.2 MemTable 的迭代器
-  std::shared_lock<std::shared_mutex> slock(cur_mtx);
-  std::vector<SearchItem> item_vec;
-  // 从当前表获取数据
-  for (auto it = current_table->begin(); it != current_table->end(); ++it) {
-    item_vec.emplace_back(it.get_key(), it.get_value(), 0, 0, it.get_tranc_id());
-  }
-  // 从冻结表获取数据
-  int table_idx = 1;
+uint64_t MemTable::get_min_tranc_id() {
+  std::shared_lock<std::shared_mutex> slock1(cur_mtx);
   std::shared_lock<std::shared_mutex> slock2(frozen_mtx);
+  uint64_t min_tranc_id = current_table->get_min_tranc_id();
   for (const auto &table : frozen_tables) {
-    for (auto it = table->begin(); it != table->end(); ++it) {
-      item_vec.emplace_back(it.get_key(), it.get_value(), table_idx, 0, it.get_tranc_id());
+    min_tranc_id = std::min(min_tranc_id, table->get_min_tranc_id());
+  }
+  return min_tranc_id;
+}
+
+MemTableIterator MemTable::begin(uint64_t tranc_id, bool keep_deleted) {
+  // (done)TODO Lab 2.2 MemTable 的迭代器
+  // 每个跳表只记录起始节点, 不拷贝数据; 先释放锁再构造迭代器, 迭代器内部会按需获取活跃表的读锁
+  std::vector<MemTableIterator::Cursor> cursors;
+  {
+    std::shared_lock<std::shared_mutex> slock(cur_mtx);
+    cursors.push_back(MemTableIterator::make_cursor(current_table, current_table->begin(), current_table->end()));
+    std::shared_lock<std::shared_mutex> slock2(frozen_mtx);
+    for (const auto &table : frozen_tables) {
+      cursors.push_back(MemTableIterator::make_cursor(table, table->begin(), table->end()));
     }
-    table_idx++;
   }
-  return HeapIterator{std::move(item_vec), tranc_id};
+  return MemTableIterator{std::move(cursors), &cur_mtx, tranc_id, keep_deleted};
 }
 
-HeapIterator MemTable::end() {
+MemTableIterator MemTable::end() {
   // (done)TODO Lab 2.2 MemTable 的迭代器
-  return HeapIterator{};
+  return MemTableIterator{};
 }
 
-HeapIterator MemTable::iters_preffix(const std::string &preffix, uint64_t tranc_id) {
+MemTableIterator MemTable::iters_preffix(const std::string &preffix, uint64_t tranc_id) {
   // (done)TODO Lab 2.3 MemTable 的前缀迭代器
-  // 调用跳表的前缀查询，找到前缀范围的起始和终止位置迭代器
-  int table_idx = 0;
-  std::vector<SearchItem> item_vec;
-  std::shared_lock<std::shared_mutex> slock(cur_mtx);
-  auto cur_begin = current_table->begin_preffix(preffix);
-  auto cur_end = current_table->end_preffix(preffix);
-  for (auto it = cur_begin; it != cur_end; ++it) {
-    item_vec.emplace_back(it.get_key(), it.get_value(), table_idx, 0, it.get_tranc_id());
+  // 调用跳表的前缀查询，找到前缀范围的起始和终止位置
+  std::vector<MemTableIterator::Cursor> cursors;
+  {
+    std::shared_lock<std::shared_mutex> slock(cur_mtx);
+    cursors.push_back(MemTableIterator::make_cursor(current_table, current_table->begin_preffix(preffix),
+                                                    current_table->end_preffix(preffix)));
+    // 从冻结表获取范围
+    std::shared_lock<std::shared_mutex> slock2(frozen_mtx);
+    for (const auto &table : frozen_tables) {
+      cursors.push_back(
+          MemTableIterator::make_cursor(table, table->begin_preffix(preffix), table->end_preffix(preffix)));
+    }
   }
-  table_idx++;
-  // 从冻结表获取数据
-  std::shared_lock<std::shared_mutex> slock2(frozen_mtx);
-  for (const auto &table : frozen_tables) {
-    auto begin = table->begin_preffix(preffix);
-    auto end = table->end_preffix(preffix);
-    for (auto it = begin; it != end; ++it) {
-      item_vec.emplace_back(it.get_key(), it.get_value(), table_idx, 0, it.get_tranc_id());
+  return MemTableIterator{std::move(cursors), &cur_mtx, tranc_id};
+}
+
+MemTableIterator MemTable::range(const std::string &lower, const std::string &upper, uint64_t tranc_id,
+                                 bool keep_deleted) {
+  std::vector<MemTableIterator::Cursor> cursors;
+  if (lower >= upper) {
+    return MemTableIterator{std::move(cursors), nullptr, tranc_id, keep_deleted};
+  }
+  {
+    std::shared_lock<std::shared_mutex> slock(cur_mtx);
+    cursors.push_back(
+        MemTableIterator::make_cursor(current_table, current_table->seek(lower), current_table->seek(upper)));
+    std::shared_lock<std::shared_mutex> slock2(frozen_mtx);
+    for (const auto &table : frozen_tables) {
+      cursors.push_back(MemTableIterator::make_cursor(table, table->seek(lower), table->seek(upper)));
     }
-    table_idx++;
   }
-  return HeapIterator{std::move(item_vec), tranc_id};
+  return MemTableIterator{std::move(cursors), &cur_mtx, tranc_id, keep_deleted};
 }
 
-std::optional<std::pair<HeapIterator, HeapIterator>> MemTable::iters_monotony_predicate(
+std::optional<std::pair<MemTableIterator, MemTableIterator>> MemTable::iters_monotony_predicate(
     uint64_t tranc_id, std::function<int(const std::string &)> predicate) {
   // (done)TODO Lab 2.3 MemTable 的谓词查询迭代器起始范围
-  int table_idx = 0;
-  std::vector<SearchItem> item_vec;
-  std::shared_lock<std::shared_mutex> slock(cur_mtx);
-  std::shared_lock<std::shared_mutex> slock2(frozen_mtx);
-  auto cur_res = current_table->iters_monotony_predicate(predicate);
-  if (cur_res.has_value()) {
-    auto &[start, end] = cur_res.value();
-    for (auto it = start; it != end; ++it) {
-      item_vec.emplace_back(it.get_key(), it.get_value(), table_idx, 0, it.get_tranc_id());
+  std::vector<MemTableIterator::Cursor> cursors;
+  bool found = false;
+  {
+    std::shared_lock<std::shared_mutex> slock(cur_mtx);
+    std::shared_lock<std::shared_mutex> slock2(frozen_mtx);
+    auto cur_res = current_table->iters_monotony_predicate(predicate);
+    if (cur_res.has_value()) {
+      cursors.push_back(MemTableIterator::make_cursor(current_table, cur_res->first, cur_res->second));
+      found = true;
+    } else {
+      // 活跃表始终占据第 0 路
+      cursors.push_back(MemTableIterator::Cursor{});
     }
-  }
-  table_idx++;
-  // 从冻结表获取数据
-  for (const auto &table : frozen_tables) {
-    auto res = table->iters_monotony_predicate(predicate);
-    if (res.has_value()) {
-      auto &[start, end] = res.value();
-      for (auto it = start; it != end; ++it) {
-        item_vec.emplace_back(it.get_key(), it.get_value(), table_idx, 0, it.get_tranc_id());
+    // 从冻结表获取范围
+    for (const auto &table : frozen_tables) {
+      auto res = table->iters_monotony_predicate(predicate);
+      if (res.has_value()) {
+        cursors.push_back(MemTableIterator::make_cursor(table, res->first, res->second));
+        found = true;
       }
     }
-    table_idx++;
   }
-  if (item_vec.empty()) {
+  if (!found) {
     return std::nullopt;  // 如果没有找到满足谓词的元素，返回
   }
 
   // 返回一个包含起始和结束迭代器的可选值
-  return std::make_pair(HeapIterator{std::move(item_vec), tranc_id}, HeapIterator{});
+  return std::make_pair(MemTableIterator{std::move(cursors), &cur_mtx, tranc_id}, MemTableIterator{});
 }
 
 void MemTable::print_memtable() {
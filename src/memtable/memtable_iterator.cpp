@@ -0,0 +1,261 @@
+#include "../../include/memtable/memtable_iterator.h"
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace tiny_lsm {
+
+namespace {
+// 头节点不存储数据, key 为空
+bool is_head(const std::shared_ptr<SkipListNode> &node) { return node->key_.empty(); }
+
+// 同一个 key 的多个版本相邻, 按事务 id 从大到小排列, 返回第一个版本
+std::shared_ptr<SkipListNode> group_start(std::shared_ptr<SkipListNode> node) {
+  for (auto prev = node->backward_[0].lock(); prev && !is_head(prev) && prev->key_ == node->key_;
+       prev = node->backward_[0].lock()) {
+    node = prev;
+  }
+  return node;
+}
+
+// 节点是否已经越过了游标范围的右端
+bool past_end(const MemTableIterator::Cursor &cursor, const std::shared_ptr<SkipListNode> &node) {
+  return node == nullptr || (cursor.end != nullptr && node->key_ >= cursor.end->key_);
+}
+
+void step_forward(MemTableIterator::Cursor &cursor) {
+  auto node = cursor.node->forward_[0];
+  while (node && node->key_ == cursor.node->key_) {
+    node = node->forward_[0];
+  }
+  cursor.node = past_end(cursor, node) ? nullptr : node;
+}
+
+void step_backward(MemTableIterator::Cursor &cursor) {
+  if (cursor.node->key_ <= cursor.begin->key_) {
+    cursor.node = nullptr;
+    return;
+  }
+  auto prev = cursor.node->backward_[0].lock();
+  cursor.node = (prev && !is_head(prev)) ? group_start(prev) : nullptr;
+}
+}  // namespace
+
+MemTableIterator::MemTableIterator(std::vector<Cursor> cursors, std::shared_mutex *active_mtx, uint64_t max_tranc_id,
+                                   bool keep_deleted)
+    : cursors_(std::move(cursors)), active_mtx_(active_mtx), max_tranc_id_(max_tranc_id), keep_deleted_(keep_deleted) {
+  auto lock = lock_active();
+  rebuild_tree();
+  settle();
+}
+
+MemTableIterator::Cursor MemTableIterator::make_cursor(std::shared_ptr<SkipList> table, const SkipListIterator &begin,
+                                                       const SkipListIterator &end) {
+  if (begin.current == nullptr || begin.current == end.current) {
+    return Cursor{std::move(table), nullptr, nullptr, nullptr};
+  }
+  return Cursor{std::move(table), begin.current, end.current, begin.current};
+}
+
+std::shared_lock<std::shared_mutex> MemTableIterator::lock_active() const {
+  // 只有第 0 路是活跃表, 没有活跃表时不加锁
+  if (active_mtx_ == nullptr || cursors_.empty()) {
+    return std::shared_lock<std::shared_mutex>();
+  }
+  return std::shared_lock<std::shared_mutex>(*active_mtx_);
+}
+
+bool MemTableIterator::exhausted(size_t idx) const { return cursors_[idx].node == nullptr; }
+
+bool MemTableIterator::source_less(size_t a, size_t b) const {
+  bool a_end = exhausted(a);
+  bool b_end = exhausted(b);
+  if (a_end != b_end) {
+    return b_end;
+  }
+  if (a_end) {
+    return a < b;
+  }
+  // key 创建后不会被修改, 可以直接比较节点中的 key
+  int cmp = std::string_view(cursors_[a].node->key_).compare(cursors_[b].node->key_);
+  if (cmp != 0) {
+    return forward_ ? cmp < 0 : cmp > 0;
+  }
+  return a < b;
+}
+
+void MemTableIterator::rebuild_tree() {
+  tree_.build(cursors_.size(), [this](size_t a, size_t b) { return source_less(a, b); });
+}
+
+void MemTableIterator::advance_winner() {
+  auto &cursor = cursors_[tree_.winner()];
+  if (forward_) {
+    step_forward(cursor);
+  } else {
+    step_backward(cursor);
+  }
+  tree_.replay([this](size_t a, size_t b) { return source_less(a, b); });
+}
+
+void MemTableIterator::seek_cursor(Cursor &cursor, const std::string &key, bool strict) {
+  if (cursor.begin == nullptr) {
+    cursor.node = nullptr;
+    return;
+  }
+  if (key < cursor.begin->key_) {
+    cursor.node = cursor.begin;
+    return;
+  }
+  auto node = cursor.table->seek(key).current;
+  cursor.node = past_end(cursor, node) ? nullptr : node;
+  if (strict && cursor.node && cursor.node->key_ == key) {
+    step_forward(cursor);
+  }
+}
+
+void MemTableIterator::seek_cursor_for_prev(Cursor &cursor, const std::string &key, bool strict) {
+  if (cursor.begin == nullptr || key < cursor.begin->key_) {
+    cursor.node = nullptr;
+    return;
+  }
+  std::shared_ptr<SkipListNode> node;
+  if (cursor.end != nullptr && key >= cursor.end->key_) {
+    // 范围右端之前的最后一个节点
+    node = cursor.end->backward_[0].lock();
+  } else {
+    node = cursor.table->seek_for_prev(key).current;
+  }
+  cursor.node = node ? group_start(node) : nullptr;
+  if (strict && cursor.node && cursor.node->key_ == key) {
+    step_backward(cursor);
+  }
+}
+
+std::shared_ptr<SkipListNode> MemTableIterator::first_visible(const std::shared_ptr<SkipListNode> &node) const {
+  for (auto cur = node; cur && cur->key_ == node->key_; cur = cur->forward_[0]) {
+    if (max_tranc_id_ == 0 || cur->tranc_id_ <= max_tranc_id_) {
+      return cur;
+    }
+  }
+  return nullptr;
+}
+
+void MemTableIterator::settle() {
+  cur_node_.reset();
+  current_.reset();
+  while (!cursors_.empty() && !exhausted(tree_.winner())) {
+    // 持有节点保证 key 有效
+    auto first = cursors_[tree_.winner()].node;
+    std::string_view key = first->key_;
+    // 同一个 key 按表由新到旧出现, 取第一个有可见版本的表, 并让所有表越过这个 key
+    std::shared_ptr<SkipListNode> found;
+    size_t found_idx = 0;
+    while (!exhausted(tree_.winner()) && cursors_[tree_.winner()].node->key_ == key) {
+      if (found == nullptr) {
+        found = first_visible(cursors_[tree_.winner()].node);
+        found_idx = tree_.winner();
+      }
+      advance_winner();
+    }
+    if (found == nullptr || (!keep_deleted_ && found->value_.empty())) {
+      // 没有可见的版本, 或者已经被删除
+      continue;
+    }
+    cur_node_ = std::move(found);
+    cur_idx_ = found_idx;
+    return;
+  }
+}
+
+MemTableIterator::pointer MemTableIterator::operator->() const {
+  current_ = **this;
+  return &(*current_);
+}
+
+MemTableIterator::value_type MemTableIterator::operator*() const {
+  if (cur_node_ == nullptr) {
+    throw std::runtime_error("MemTableIterator is invalid");
+  }
+  if (cur_idx_ == 0) {
+    // 活跃表的 value 可能被并发的 put 修改
+    auto lock = lock_active();
+    return std::make_pair(cur_node_->key_, cur_node_->value_);
+  }
+  return std::make_pair(cur_node_->key_, cur_node_->value_);
+}
+
+BaseIterator &MemTableIterator::operator++() {
+  if (cur_node_ == nullptr) {
+    return *this;
+  }
+  auto lock = lock_active();
+  if (!forward_) {
+    // 反向时游标停在当前 key 之前, 需要重新定位到当前 key 之后
+    auto node = cur_node_;
+    for (auto &cursor : cursors_) {
+      seek_cursor(cursor, node->key_, true);
+    }
+    forward_ = true;
+    rebuild_tree();
+  }
+  // 正向时 settle 已经越过了当前 key 的所有版本
+  settle();
+  return *this;
+}
+
+BaseIterator &MemTableIterator::operator--() {
+  if (cur_node_ == nullptr) {
+    return *this;
+  }
+  auto lock = lock_active();
+  if (forward_) {
+    auto node = cur_node_;
+    for (auto &cursor : cursors_) {
+      seek_cursor_for_prev(cursor, node->key_, true);
+    }
+    forward_ = false;
+    rebuild_tree();
+  }
+  settle();
+  return *this;
+}
+
+void MemTableIterator::seek(const std::string &key) {
+  auto lock = lock_active();
+  for (auto &cursor : cursors_) {
+    seek_cursor(cursor, key, false);
+  }
+  forward_ = true;
+  rebuild_tree();
+  settle();
+}
+
+void MemTableIterator::seek_for_prev(const std::string &key) {
+  auto lock = lock_active();
+  for (auto &cursor : cursors_) {
+    seek_cursor_for_prev(cursor, key, false);
+  }
+  forward_ = false;
+  rebuild_tree();
+  settle();
+}
+
+bool MemTableIterator::operator==(const BaseIterator &other) const {
+  if (other.get_type() != IteratorType::MemTableIterator) {
+    return false;
+  }
+  auto &other2 = static_cast<const MemTableIterator &>(other);
+  return cur_node_ == other2.cur_node_;
+}
+
+bool MemTableIterator::operator!=(const BaseIterator &other) const { return !(*this == other); }
+
+IteratorType MemTableIterator::get_type() const { return IteratorType::MemTableIterator; }
+
+uint64_t MemTableIterator::get_tranc_id() const { return max_tranc_id_; }
+
+bool MemTableIterator::is_end() const { return cur_node_ == nullptr; }
+
+bool MemTableIterator::is_valid() const { return cur_node_ != nullptr; }
+}  // namespace tiny_lsm
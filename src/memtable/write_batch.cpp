@@ -0,0 +1,86 @@
+#include "../../include/memtable/write_batch.h"
+#include <stdexcept>
+
+namespace tiny_lsm {
+
+namespace {
+void put_varint(std::vector<uint8_t> &buf, uint64_t value) {
+  while (value >= 0x80) {
+    buf.push_back(static_cast<uint8_t>(value) | 0x80);
+    value >>= 7;
+  }
+  buf.push_back(static_cast<uint8_t>(value));
+}
+
+void put_bytes(std::vector<uint8_t> &buf, const std::string &s) {
+  put_varint(buf, s.size());
+  buf.insert(buf.end(), s.begin(), s.end());
+}
+
+uint64_t get_varint(const uint8_t *&p, const uint8_t *end) {
+  uint64_t value = 0;
+  for (int shift = 0; shift < 64 && p < end; shift += 7) {
+    uint8_t byte = *p++;
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+  throw std::runtime_error("WriteBatch: corrupted varint");
+}
+
+void get_bytes(const uint8_t *&p, const uint8_t *end, std::string &out) {
+  uint64_t len = get_varint(p, end);
+  if (len > static_cast<size_t>(end - p)) {
+    throw std::runtime_error("WriteBatch: corrupted entry");
+  }
+  out.assign(reinterpret_cast<const char *>(p), len);
+  p += len;
+}
+} // namespace
+
+void WriteBatch::put(const std::string &key, const std::string &value) {
+  rep_.push_back(static_cast<uint8_t>(OpType::Put));
+  put_bytes(rep_, key);
+  put_bytes(rep_, value);
+  ++count_;
+}
+
+void WriteBatch::remove(const std::string &key) {
+  rep_.push_back(static_cast<uint8_t>(OpType::Remove));
+  put_bytes(rep_, key);
+  ++count_;
+}
+
+void WriteBatch::clear() {
+  rep_.clear();
+  count_ = 0;
+}
+
+size_t WriteBatch::count() const { return count_; }
+
+bool WriteBatch::empty() const { return count_ == 0; }
+
+size_t WriteBatch::data_size() const { return rep_.size(); }
+
+void WriteBatch::for_each(
+    const std::function<void(OpType, const std::string &, const std::string &)>
+        &fn) const {
+  // key 和 value 的缓冲区在操作之间复用
+  std::string key;
+  std::string value;
+  const uint8_t *p = rep_.data();
+  const uint8_t *end = p + rep_.size();
+  while (p < end) {
+    auto type = static_cast<OpType>(*p++);
+    get_bytes(p, end, key);
+    if (type == OpType::Put) {
+      get_bytes(p, end, value);
+    } else {
+      value.clear();
+    }
+    fn(type, key, value);
+  }
+}
+
+} // namespace tiny_lsm
@@ -1,5 +1,6 @@
 #include "../../include/skiplist/skiplist.h"
 #include <spdlog/spdlog.h>
+#include <algorithm>
 #include <cstdint>
 #include <iostream>
 #include <memory>
@@ -10,6 +11,60 @@
 
 namespace tiny_lsm {
 
+namespace {
+// 头节点不存储数据, key 为空
+bool is_head(const std::shared_ptr<SkipListNode> &node) { return node->key_.empty(); }
+
+// 从 from 出发查找最后一个 key 满足 before 的节点(可能是头节点), before 关于 key 单调
+// 先沿当前节点能到达的最高层移动, 再逐层下降, 代价与移动距离的对数相关
+template <typename Before>
+std::shared_ptr<SkipListNode> finger_find(std::shared_ptr<SkipListNode> from, const Before &before) {
+  auto cur = from;
+  int level = 0;
+  if (is_head(cur) || before(cur->key_)) {
+    // 目标在右侧
+    while (true) {
+      while (level + 1 < static_cast<int>(cur->forward_.size()) && cur->forward_[level + 1] &&
+             before(cur->forward_[level + 1]->key_)) {
+        level++;
+      }
+      auto next = cur->forward_[level];
+      if (!next || !before(next->key_)) {
+        break;
+      }
+      cur = next;
+    }
+    for (; level >= 0; --level) {
+      while (cur->forward_[level] && before(cur->forward_[level]->key_)) {
+        cur = cur->forward_[level];
+      }
+    }
+    return cur;
+  }
+
+  // 目标在左侧: 找到第一个不满足 before 的节点, 它的前驱即为所求
+  auto stop_at = [&](const std::shared_ptr<SkipListNode> &prev) {
+    return !prev || is_head(prev) || before(prev->key_);
+  };
+  while (true) {
+    while (level + 1 < static_cast<int>(cur->backward_.size()) && !stop_at(cur->backward_[level + 1].lock())) {
+      level++;
+    }
+    auto prev = cur->backward_[level].lock();
+    if (stop_at(prev)) {
+      break;
+    }
+    cur = prev;
+  }
+  for (; level >= 0; --level) {
+    for (auto prev = cur->backward_[level].lock(); !stop_at(prev); prev = cur->backward_[level].lock()) {
+      cur = prev;
+    }
+  }
+  return cur->backward_[0].lock();
+}
+}  // namespace
+
 // ************************ SkipListIterator ************************
 BaseIterator &SkipListIterator::operator++() {
   // (done)TODO: Lab1.2 任务：实现SkipListIterator的++操作符
@@ -17,6 +72,31 @@ BaseIterator &SkipListIterator::operator++() {
   return *this;
 }
 
+BaseIterator &SkipListIterator::operator--() {
+  if (!current) {
+    return *this;
+  }
+  auto prev = current->backward_[0].lock();
+  current = (prev && !is_head(prev)) ? prev : nullptr;
+  return *this;
+}
+
+void SkipListIterator::seek(const std::string &key) {
+  if (!current) {
+    return;
+  }
+  auto prev = finger_find(current, [&key](const std::string &k) { return k < key; });
+  current = prev ? prev->forward_[0] : nullptr;
+}
+
+void SkipListIterator::seek_for_prev(const std::string &key) {
+  if (!current) {
+    return;
+  }
+  auto prev = finger_find(current, [&key](const std::string &k) { return k <= key; });
+  current = (prev && !is_head(prev)) ? prev : nullptr;
+}
+
 bool SkipListIterator::operator==(const BaseIterator &other) const {
   // (done)TODO: Lab1.2 任务：实现SkipListIterator的==操作符
   return current == dynamic_cast<const SkipListIterator &>(other).current;
@@ -68,7 +148,7 @@ int SkipList::random_level() {
   return level;
 }
 
-// 插入或更新键值对
+// 插入新版本, 同一个 key 的版本按事务 id 从大到小相邻排列
 void SkipList::put(const std::string &key, const std::string &value, uint64_t tranc_id) {
   spdlog::trace("SkipList--put({}, {}, {})", key, value, tranc_id);
 
@@ -80,6 +160,7 @@ void SkipList::put(const std::string &key, const std::string &value, uint64_t tr
   std::vector<std::shared_ptr<SkipListNode>> update_forward(max_level, nullptr);
   // 创建新节点
   auto new_node = std::make_shared<SkipListNode>(key, value, new_level, tranc_id);
+  min_tranc_id_ = std::min(min_tranc_id_, tranc_id);
   auto current = head;
   // 寻找插入位置
   for (int level = current_level - 1; level >= 0; --level) {
@@ -89,13 +170,14 @@ void SkipList::put(const std::string &key, const std::string &value, uint64_t tr
     update_forward[level] = current;
   }
   current = current->forward_[0];
-  // key已存在, 更新值
-  if (current && current->key_ == key) {
+  // 同一个事务重复写入同一个 key, 原地更新值; 其他事务的写入作为新版本插入,
+  // 旧版本保留给快照和事务读取
+  if (current && current->key_ == key && current->tranc_id_ == tranc_id) {
     size_bytes += value.size() - current->value_.size();
     current->value_ = value;
     return;
   }
-  // key不存在, 插入新节点,更新各层指针
+  // 插入新节点,更新各层指针
   // 如果新节点的层数大于当前跳表的层数，更新更高层的指针head
   if (new_level > current_level) {
     for (int level = current_level; level < new_level; ++level) {
@@ -117,6 +199,31 @@ void SkipList::put(const std::string &key, const std::string &value, uint64_t tr
   size_bytes += sizeof(uint64_t) + key.size() + value.size();
 }
 
+size_t SkipList::bulk_load(const std::vector<std::tuple<std::string, std::string, uint64_t>> &entries, size_t start,
+                           size_t size_limit) {
+  if (head->forward_[0] != nullptr) {
+    throw std::logic_error("SkipList::bulk_load requires an empty skiplist");
+  }
+
+  // 每一层当前的尾节点
+  std::vector<std::shared_ptr<SkipListNode>> tails(max_level, head);
+  size_t i = start;
+  while (i < entries.size() && size_bytes < size_limit) {
+    auto &[key, value, tranc_id] = entries[i++];
+    int new_level = random_level();
+    auto new_node = std::make_shared<SkipListNode>(key, value, new_level, tranc_id);
+    for (int level = 0; level < new_level; ++level) {
+      tails[level]->forward_[level] = new_node;
+      new_node->set_backward(level, tails[level]);
+      tails[level] = new_node;
+    }
+    current_level = std::max(current_level, new_level);
+    min_tranc_id_ = std::min(min_tranc_id_, tranc_id);
+    size_bytes += sizeof(uint64_t) + key.size() + value.size();
+  }
+  return i;
+}
+
 // 查找键值对
 SkipListIterator SkipList::get(const std::string &key, uint64_t tranc_id) {
   spdlog::trace("SkipList--get({}) called", key);
@@ -125,9 +232,13 @@ SkipListIterator SkipList::get(const std::string &key, uint64_t tranc_id) {
 
   // (done)TODO: Lab1.1 任务：实现查找键值对,
   // (done)TODO: 并且你后续需要额外实现SkipListIterator中的TODO部分(Lab1.2)
+  // 定位到第一个对事务可见的版本: 之前的节点 key 更小, 或者 key 相同但事务 id 更大
+  auto before = [&](const std::shared_ptr<SkipListNode> &node) {
+    return node->key_ < key || (node->key_ == key && tranc_id != 0 && node->tranc_id_ > tranc_id);
+  };
   auto current = head;
   for (int level = current_level - 1; level >= 0; --level) {
-    while (current->forward_[level] && current->forward_[level]->key_ < key) {
+    while (current->forward_[level] && before(current->forward_[level])) {
       current = current->forward_[level];
     }
   }
@@ -199,16 +310,21 @@ std::vector<std::tuple<std::string, std::string, uint64_t>> SkipList::flush() {
   return data;
 }
 
+SkipListScan SkipList::scan() const { return SkipListScan(head->forward_[0].get()); }
+
 size_t SkipList::get_size() {
   // std::shared_lock<std::shared_mutex> slock(rw_mutex);
   return size_bytes;
 }
 
+uint64_t SkipList::get_min_tranc_id() const { return min_tranc_id_; }
+
 // 清空跳表，释放内存
 void SkipList::clear() {
   // std::unique_lock<std::shared_mutex> lock(rw_mutex);
   head = std::make_shared<SkipListNode>("", "", max_level, 0);
   size_bytes = 0;
+  min_tranc_id_ = UINT64_MAX;
 }
 
 SkipListIterator SkipList::begin() {
@@ -220,6 +336,19 @@ SkipListIterator SkipList::end() {
   return SkipListIterator();  // 使用空构造函数
 }
 
+SkipListIterator SkipList::seek(const std::string &key) {
+  auto prev = finger_find(head, [&key](const std::string &k) { return k < key; });
+  return SkipListIterator(prev->forward_[0]);
+}
+
+SkipListIterator SkipList::seek_for_prev(const std::string &key) {
+  auto prev = finger_find(head, [&key](const std::string &k) { return k <= key; });
+  if (is_head(prev)) {
+    return SkipListIterator{};
+  }
+  return SkipListIterator(prev);
+}
+
 // 找到前缀的起始位置
 // 返回第一个前缀匹配或者大于前缀的迭代器
 SkipListIterator SkipList::begin_preffix(const std::string &preffix) {
@@ -297,9 +426,10 @@ std::optional<std::pair<SkipListIterator, SkipListIterator>> SkipList::iters_mon
         end_node = end_node->forward_[i];
       }
     }
-    // 向左遍历直到不满足谓词
+    // 向左遍历直到不满足谓词, 头节点没有 key, 不参与判断
     for (int i = level; i >= 0; --i) {
       while (start_node_weak.lock()->backward_[i].lock() &&
+             start_node_weak.lock()->backward_[i].lock() != head &&
              predicate(start_node_weak.lock()->backward_[i].lock()->key_) == 0) {
         start_node_weak = start_node_weak.lock()->backward_[i].lock();
       }
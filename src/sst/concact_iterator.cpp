@@ -1,4 +1,5 @@
 #include "../../include/sst/concact_iterator.h"
+#include <algorithm>
 
 namespace tiny_lsm {
 
@@ -8,27 +9,152 @@ ConcactIterator::ConcactIterator(std::vector<std::shared_ptr<SST>> ssts,
       max_tranc_id_(tranc_id) {
   if (!this->ssts.empty()) {
     cur_iter = ssts[0]->begin(max_tranc_id_);
+    skip_exhausted();
   }
 }
 
+ConcactIterator::ConcactIterator(std::vector<std::shared_ptr<SST>> ssts,
+                                 uint64_t tranc_id, const std::string &lower,
+                                 const std::string &upper)
+    : cur_iter(nullptr, tranc_id), cur_idx(0), max_tranc_id_(tranc_id),
+      bounds_(std::make_pair(lower, upper)) {
+  // sst 按 key 有序且不重叠, 与范围相交的 sst 是连续的一段
+  auto first = std::lower_bound(ssts.begin(), ssts.end(), lower,
+                                [](const std::shared_ptr<SST> &sst,
+                                   const std::string &target) {
+                                  return sst->get_last_key() < target;
+                                });
+  auto last = std::lower_bound(first, ssts.end(), upper,
+                               [](const std::shared_ptr<SST> &sst,
+                                  const std::string &target) {
+                                 return sst->get_first_key() < target;
+                               });
+  if (lower < upper) {
+    this->ssts.assign(first, last);
+  }
+  if (!this->ssts.empty()) {
+    cur_iter = unpositioned(0);
+    cur_iter.seek(lower);
+    skip_exhausted();
+  }
+}
+
+void ConcactIterator::skip_exhausted() {
+  // 当前 sst 已经遍历完(或者没有可见的记录)时, 打开下一个 sst
+  while (!cur_iter.is_valid() && cur_idx + 1 < ssts.size()) {
+    cur_idx++;
+    cur_iter = unpositioned(cur_idx);
+    cur_iter.seek_first();
+  }
+}
+
+void ConcactIterator::skip_exhausted_backward() {
+  while (!cur_iter.is_valid() && cur_idx > 0) {
+    cur_idx--;
+    cur_iter = unpositioned(cur_idx);
+    cur_iter.seek_to_last();
+  }
+}
+
+SstIterator ConcactIterator::unpositioned(size_t idx) const {
+  SstIterator it(nullptr, max_tranc_id_);
+  it.m_sst = ssts[idx];
+  if (fixed_readahead_ > 0) {
+    it.set_readahead(fixed_readahead_);
+  }
+  if (bounds_ && (idx == 0 || idx + 1 == ssts.size())) {
+    // 中间的 sst 整体位于范围内, 不需要限制
+    it.set_bounds(bounds_->first, bounds_->second);
+  }
+  return it;
+}
+
+void ConcactIterator::set_readahead(size_t blocks) {
+  fixed_readahead_ = blocks;
+  cur_iter.set_readahead(blocks);
+}
+
+void ConcactIterator::set_end() {
+  cur_idx = ssts.empty() ? 0 : ssts.size() - 1;
+  cur_iter = SstIterator(nullptr, max_tranc_id_);
+}
+
+void ConcactIterator::seek(const std::string &key) {
+  // 同一层的 sst 按 key 有序且不重叠, 找到第一个最大 key 不小于目标 key 的 sst
+  auto it = std::lower_bound(ssts.begin(), ssts.end(), key,
+                             [](const std::shared_ptr<SST> &sst,
+                                const std::string &target) {
+                               return sst->get_last_key() < target;
+                             });
+  if (it == ssts.end()) {
+    set_end();
+    return;
+  }
+  cur_idx = it - ssts.begin();
+  cur_iter = unpositioned(cur_idx);
+  cur_iter.seek(key);
+  skip_exhausted();
+}
+
+void ConcactIterator::seek_for_prev(const std::string &key) {
+  // 找到最后一个最小 key 不大于目标 key 的 sst
+  auto it = std::upper_bound(ssts.begin(), ssts.end(), key,
+                             [](const std::string &target,
+                                const std::shared_ptr<SST> &sst) {
+                               return target < sst->get_first_key();
+                             });
+  if (it == ssts.begin()) {
+    set_end();
+    return;
+  }
+  cur_idx = it - ssts.begin() - 1;
+  cur_iter = unpositioned(cur_idx);
+  cur_iter.seek_for_prev(key);
+  skip_exhausted_backward();
+}
+
+BaseIterator &ConcactIterator::operator--() {
+  if (!is_valid()) {
+    return *this;
+  }
+  --cur_iter;
+  skip_exhausted_backward();
+  return *this;
+}
+
 BaseIterator &ConcactIterator::operator++() {
-  // TODO: Lab 4.3 自增运算符重载
+  // (done)TODO: Lab 4.3 自增运算符重载
+  if (!is_valid()) {
+    return *this;
+  }
+  ++cur_iter;
+  skip_exhausted();
   return *this;
 }
 
 bool ConcactIterator::operator==(const BaseIterator &other) const {
-  // TODO: Lab 4.3 比较运算符重载
-  return false;
+  // (done)TODO: Lab 4.3 比较运算符重载
+  if (other.get_type() != IteratorType::ConcactIterator) {
+    return false;
+  }
+  const auto &other2 = dynamic_cast<const ConcactIterator &>(other);
+  if (!is_valid() && !other2.is_valid()) {
+    return true;
+  }
+  if (!is_valid() || !other2.is_valid()) {
+    return false;
+  }
+  return cur_idx == other2.cur_idx && cur_iter == other2.cur_iter;
 }
 
 bool ConcactIterator::operator!=(const BaseIterator &other) const {
-  // TODO: Lab 4.3 比较运算符重载
-  return false;
+  // (done)TODO: Lab 4.3 比较运算符重载
+  return !(*this == other);
 }
 
 ConcactIterator::value_type ConcactIterator::operator*() const {
-  // TODO: Lab 4.3 解引用运算符重载
-  return value_type();
+  // (done)TODO: Lab 4.3 解引用运算符重载
+  return *cur_iter;
 }
 
 IteratorType ConcactIterator::get_type() const {
@@ -46,8 +172,8 @@ bool ConcactIterator::is_valid() const {
 }
 
 ConcactIterator::pointer ConcactIterator::operator->() const {
-  // TODO: Lab 4.3 ->运算符重载
-  return nullptr;
+  // (done)TODO: Lab 4.3 ->运算符重载
+  return cur_iter.operator->();
 }
 
 std::string ConcactIterator::key() { return cur_iter.key(); }
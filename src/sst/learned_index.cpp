@@ -0,0 +1,189 @@
+#include "../../include/sst/learned_index.h"
+#include "../../include/utils/crc32c.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace tiny_lsm {
+
+namespace {
+template <typename T> void put_fixed(std::vector<uint8_t> &buf, T value) {
+  size_t pos = buf.size();
+  buf.resize(pos + sizeof(T));
+  memcpy(buf.data() + pos, &value, sizeof(T));
+}
+
+template <typename T> T get_fixed(const uint8_t *&p, const uint8_t *end) {
+  if (static_cast<size_t>(end - p) < sizeof(T)) {
+    throw std::runtime_error("Learned index truncated");
+  }
+  T value;
+  memcpy(&value, p, sizeof(T));
+  p += sizeof(T);
+  return value;
+}
+} // namespace
+
+std::optional<LearnedIndex>
+LearnedIndex::train(const std::vector<std::string> &keys, size_t error_bound) {
+  if (keys.empty()) {
+    return std::nullopt;
+  }
+
+  LearnedIndex model;
+  // keys 有序, 首尾的公共前缀就是所有 key 的公共前缀
+  auto &front = keys.front();
+  auto &back = keys.back();
+  size_t prefix_len = 0;
+  while (prefix_len < front.size() && prefix_len < back.size() &&
+         front[prefix_len] == back[prefix_len]) {
+    prefix_len++;
+  }
+  model.prefix_ = front.substr(0, prefix_len);
+  model.error_bound_ = error_bound;
+  model.num_keys_ = keys.size();
+
+  std::vector<double> xs;
+  xs.reserve(keys.size());
+  for (auto &key : keys) {
+    xs.push_back(model.to_number(key));
+    // 分隔 key 无序时模型没有意义
+    if (xs.size() > 1 && xs.back() < xs[xs.size() - 2]) {
+      return std::nullopt;
+    }
+  }
+
+  // 收缩锥: 维护经过起点且误差不超过 error_bound 的斜率范围, 范围为空时分段
+  double eps = static_cast<double>(error_bound);
+  size_t start = 0;
+  while (start < xs.size()) {
+    double slope_lo = 0;
+    double slope_hi = std::numeric_limits<double>::infinity();
+    size_t end = start + 1;
+    for (; end < xs.size(); ++end) {
+      double dx = xs[end] - xs[start];
+      double dy = static_cast<double>(end - start);
+      if (dx == 0) {
+        // 数值相同的 key 只能由误差容纳
+        if (dy > eps) {
+          break;
+        }
+        continue;
+      }
+      double lo = std::max(slope_lo, (dy - eps) / dx);
+      double hi = std::min(slope_hi, (dy + eps) / dx);
+      if (lo > hi) {
+        break;
+      }
+      slope_lo = lo;
+      slope_hi = hi;
+    }
+    double slope = std::isinf(slope_hi) ? 0 : (slope_lo + slope_hi) / 2;
+    model.segments_.push_back({xs[start], slope, static_cast<uint32_t>(start),
+                               static_cast<uint32_t>(end - 1)});
+    start = end;
+  }
+
+  // 分段太多时模型不比二分查找快
+  if (model.segments_.size() * 4 > keys.size()) {
+    return std::nullopt;
+  }
+  return model;
+}
+
+std::pair<size_t, size_t>
+LearnedIndex::predict(const std::string &key) const {
+  if (key.compare(0, prefix_.size(), prefix_) != 0) {
+    // 没有公共前缀的 key 小于或者大于所有的分隔 key
+    return key < prefix_ ? std::make_pair<size_t, size_t>(0, 1)
+                         : std::make_pair<size_t, size_t>(num_keys_, num_keys_);
+  }
+  double x = to_number(key);
+  auto it = std::upper_bound(
+      segments_.begin(), segments_.end(), x,
+      [](double target, const Segment &seg) { return target < seg.start_x; });
+  if (it == segments_.begin()) {
+    // 小于第一个分隔 key
+    return std::make_pair<size_t, size_t>(0, 1);
+  }
+  auto &seg = *(it - 1);
+  double pred = seg.first_idx + seg.slope * (x - seg.start_x);
+  // 落在两个分段之间的 key 的结果是下一个分段的第一个下标
+  pred = std::clamp(pred, static_cast<double>(seg.first_idx),
+                    static_cast<double>(seg.last_idx) + 1);
+
+  double eps = static_cast<double>(error_bound_) + 1;
+  size_t lo = static_cast<size_t>(std::max(0.0, std::floor(pred - eps)));
+  size_t hi = static_cast<size_t>(std::floor(pred + eps)) + 1;
+  return std::make_pair(lo, std::min<size_t>(hi, num_keys_));
+}
+
+size_t LearnedIndex::num_segments() const { return segments_.size(); }
+
+double LearnedIndex::to_number(const std::string &key) const {
+  uint64_t value = 0;
+  size_t len = key.size() > prefix_.size() ? key.size() - prefix_.size() : 0;
+  len = std::min<size_t>(len, sizeof(uint64_t));
+  for (size_t i = 0; i < sizeof(uint64_t); ++i) {
+    value <<= 8;
+    if (i < len) {
+      value |= static_cast<uint8_t>(key[prefix_.size() + i]);
+    }
+  }
+  return static_cast<double>(value);
+}
+
+void LearnedIndex::encode(std::vector<uint8_t> &out) const {
+  size_t begin = out.size();
+  put_fixed<uint16_t>(out, static_cast<uint16_t>(prefix_.size()));
+  out.insert(out.end(), prefix_.begin(), prefix_.end());
+  put_fixed<uint32_t>(out, error_bound_);
+  put_fixed<uint32_t>(out, static_cast<uint32_t>(segments_.size()));
+  for (auto &seg : segments_) {
+    put_fixed<double>(out, seg.start_x);
+    put_fixed<double>(out, seg.slope);
+    put_fixed<uint32_t>(out, seg.first_idx);
+    put_fixed<uint32_t>(out, seg.last_idx);
+  }
+  put_fixed<uint32_t>(out, crc32c(out.data() + begin, out.size() - begin));
+}
+
+LearnedIndex LearnedIndex::decode(const uint8_t *data, size_t size) {
+  if (size < sizeof(uint32_t)) {
+    throw std::runtime_error("Learned index truncated");
+  }
+  const uint8_t *p = data;
+  const uint8_t *end = data + size - sizeof(uint32_t);
+  uint32_t stored_crc;
+  memcpy(&stored_crc, end, sizeof(uint32_t));
+  if (crc32c(data, end - data) != stored_crc) {
+    throw std::runtime_error("Learned index checksum mismatch");
+  }
+
+  LearnedIndex model;
+  uint16_t prefix_len = get_fixed<uint16_t>(p, end);
+  if (static_cast<size_t>(end - p) < prefix_len) {
+    throw std::runtime_error("Learned index truncated");
+  }
+  model.prefix_.assign(reinterpret_cast<const char *>(p), prefix_len);
+  p += prefix_len;
+  model.error_bound_ = get_fixed<uint32_t>(p, end);
+  uint32_t num_segments = get_fixed<uint32_t>(p, end);
+  model.segments_.reserve(num_segments);
+  for (uint32_t i = 0; i < num_segments; ++i) {
+    Segment seg;
+    seg.start_x = get_fixed<double>(p, end);
+    seg.slope = get_fixed<double>(p, end);
+    seg.first_idx = get_fixed<uint32_t>(p, end);
+    seg.last_idx = get_fixed<uint32_t>(p, end);
+    model.segments_.push_back(seg);
+  }
+  if (p != end || model.segments_.empty()) {
+    throw std::runtime_error("Invalid learned index");
+  }
+  model.num_keys_ = model.segments_.back().last_idx + 1;
+  return model;
+}
+} // namespace tiny_lsm
@@ -2,10 +2,12 @@
 #include "../../include/config/config.h"
 #include "../../include/consts.h"
 #include "../../include/sst/sst_iterator.h"
+#include "../../include/sst/table_cache.h"
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <filesystem>
 #include <functional>
 #include <memory>
 #include <stdexcept>
@@ -18,64 +20,469 @@ namespace tiny_lsm {
 
 std::shared_ptr<SST> SST::open(size_t sst_id, FileObj file,
                                std::shared_ptr<BlockCache> block_cache) {
-  // TODO Lab 3.6 打开一个SST文件, 返回一个描述类
+  // (done)TODO Lab 3.6 打开一个SST文件, 返回一个描述类
+  auto sst = std::make_shared<SST>();
+  sst->sst_id = sst_id;
+  sst->block_cache = block_cache;
+  auto table = load_table(std::move(file));
+  sst->file_size_ = table->file.size();
+  sst->min_tranc_id_ = table->min_tranc_id;
+  sst->max_tranc_id_ = table->max_tranc_id;
+  size_t num_blocks = table->num_blocks;
+  if (num_blocks > 0) {
+    // 最后一个索引项的 key 就是 sst 的最后一个 key
+    sst->last_key = table->index.back().last_key;
+  }
+  sst->table_ = std::move(table);
+  if (num_blocks > 0) {
+    // 索引中只有分隔 key, 首 key 需要从第一个 block 中读取
+    sst->first_key = sst->read_block(0)->get_first_key();
+  }
+  return sst;
+}
+
+std::shared_ptr<SST>
+SST::open_lazy(size_t sst_id, const std::string &path, size_t file_size,
+               const std::string &first_key, const std::string &last_key,
+               std::pair<uint64_t, uint64_t> tranc_id_range,
+               std::shared_ptr<BlockCache> block_cache) {
+  auto sst = std::make_shared<SST>();
+  sst->sst_id = sst_id;
+  sst->path_ = path;
+  sst->file_size_ = file_size;
+  sst->first_key = first_key;
+  sst->last_key = last_key;
+  sst->min_tranc_id_ = tranc_id_range.first;
+  sst->max_tranc_id_ = tranc_id_range.second;
+  sst->block_cache = block_cache;
+  return sst;
+}
+
+void SST::ensure_loaded() { table(); }
+
+std::shared_ptr<SstTable> SST::table() {
+  referenced_.store(true, std::memory_order_relaxed);
+  auto table = table_.load(std::memory_order_acquire);
+  if (table != nullptr) {
+    return table;
+  }
+
+  std::unique_lock<std::mutex> lock(load_mtx_);
+  table = table_.load(std::memory_order_acquire);
+  if (table != nullptr) {
+    return table;
+  }
+  table = load_table(FileObj::open(path_, false, file_io_mode()));
+  table_.store(table, std::memory_order_release);
+  lock.unlock();
+
+  // 登记时可能卸载其他的 sst, 不能持有本 sst 的锁
+  if (table_cache_ != nullptr) {
+    table_cache_->insert(shared_from_this());
+  }
+  return table;
+}
+
+void SST::set_table_cache(std::shared_ptr<TableCache> table_cache) {
+  table_cache_ = std::move(table_cache);
+  if (table_cache_ != nullptr && is_loaded()) {
+    table_cache_->insert(shared_from_this());
+  }
+}
+
+bool SST::unload() {
+  if (path_.empty()) {
+    return false;
+  }
+  // 正在使用的调用者持有 SstTable 的引用, 在它们释放后文件才真正关闭
+  std::lock_guard<std::mutex> lock(load_mtx_);
+  table_.store(nullptr, std::memory_order_release);
+  return true;
+}
+
+bool SST::is_loaded() const {
+  return table_.load(std::memory_order_acquire) != nullptr;
+}
 
-  return nullptr;
+bool SST::clear_referenced() {
+  return referenced_.exchange(false, std::memory_order_relaxed);
 }
 
-void SST::del_sst() { file.del_file(); }
+std::shared_ptr<SstTable> SST::load_table(FileObj file_obj) {
+  auto table = std::make_shared<SstTable>();
+  auto &file = table->file;
+  auto &meta_block_offset = table->meta_block_offset;
+  auto &bloom_offset = table->bloom_offset;
+  file = std::move(file_obj);
+
+  size_t file_size = file.size();
+  // 尾部的 Extra: meta_offset(32) | bloom_offset(32) | min_tranc_id(64) |
+  // max_tranc_id(64)
+  constexpr size_t extra_size = sizeof(uint32_t) * 2 + sizeof(uint64_t) * 2;
+  if (file_size < extra_size) {
+    throw std::runtime_error("Invalid SST file: too small");
+  }
+
+  // 尾部元数据一次性读出, 避免多次小读
+  auto extra = file.read_to_slice(file_size - extra_size, extra_size);
+  const uint8_t *ptr = extra.data();
+  memcpy(&meta_block_offset, ptr, sizeof(uint32_t));
+  ptr += sizeof(uint32_t);
+  memcpy(&bloom_offset, ptr, sizeof(uint32_t));
+  ptr += sizeof(uint32_t);
+  memcpy(&table->min_tranc_id, ptr, sizeof(uint64_t));
+  ptr += sizeof(uint64_t);
+  memcpy(&table->max_tranc_id, ptr, sizeof(uint64_t));
+
+  size_t extra_offset = file_size - extra_size;
+  if (meta_block_offset > bloom_offset || bloom_offset > extra_offset) {
+    throw std::runtime_error("Invalid SST file: corrupted offsets");
+  }
+
+  // 读取布隆过滤器
+  if (bloom_offset < extra_offset) {
+    auto bloom_bytes =
+        file.read_to_slice(bloom_offset, extra_offset - bloom_offset);
+    table->bloom_filter =
+        std::make_shared<BloomFilter>(BloomFilter::decode(bloom_bytes));
+  }
+
+  // 读取顶层索引, 旧格式的 sst 在内存中构建索引分区
+  auto meta_bytes = file.read_to_slice(meta_block_offset,
+                                       bloom_offset - meta_block_offset);
+  size_t index_len = 0;
+  if (SstIndex::decode_top_level(meta_bytes, table->index, table->num_blocks,
+                                 index_len)) {
+    if (index_len < meta_bytes.size()) {
+      table->learned_index = LearnedIndex::decode(
+          meta_bytes.data() + index_len, meta_bytes.size() - index_len);
+    }
+  } else {
+    auto metas = BlockMeta::decode_meta_from_slice(meta_bytes);
+    auto entries =
+        SstIndex::entries_from_block_metas(metas, meta_block_offset);
+    auto partitions = SstIndex::build_partitions(
+        entries, TomlConfig::getInstance().getLsmBlockSize());
+    for (size_t i = 0; i < partitions.size(); ++i) {
+      auto &[partition, first_block_idx] = partitions[i];
+      table->index.push_back(
+          {0, 0, first_block_idx,
+           partition->get_key_at_idx(partition->size() - 1)});
+      table->pinned_partitions.push_back(partition);
+    }
+    table->num_blocks = metas.size();
+  }
+
+  // 点查是随机访问, 关闭内核预读; 顺序扫描时由迭代器逐 block 预读
+  file.advise(0, meta_block_offset, FileAccessHint::Random);
+  return table;
+}
+
+void SST::del_sst() {
+  if (!path_.empty()) {
+    // 已经打开的文件句柄在释放前依然可以读取
+    std::filesystem::remove(path_);
+  } else if (auto table = table_.load()) {
+    table->file.del_file();
+  }
+}
+
+void SST::mark_obsolete() { obsolete_.store(true, std::memory_order_release); }
+
+SST::~SST() {
+  if (!obsolete_.load(std::memory_order_acquire)) {
+    return;
+  }
+  // 析构函数中不能抛出异常, 删除失败时留下无用的文件
+  try {
+    del_sst();
+  } catch (const std::exception &) {
+  }
+}
 
 std::shared_ptr<SST> SST::create_sst_with_meta_only(
     size_t sst_id, size_t file_size, const std::string &first_key,
     const std::string &last_key, std::shared_ptr<BlockCache> block_cache) {
   auto sst = std::make_shared<SST>();
-  sst->file.set_size(file_size);
+  auto table = std::make_shared<SstTable>();
+  table->file.set_size(file_size);
+  sst->table_ = table;
+  sst->file_size_ = file_size;
   sst->sst_id = sst_id;
   sst->first_key = first_key;
   sst->last_key = last_key;
-  sst->meta_block_offset = 0;
   sst->block_cache = block_cache;
 
   return sst;
 }
 
 std::shared_ptr<Block> SST::read_block(size_t block_idx) {
-  // TODO: Lab 3.6 根据 block 的 id 读取一个 `Block`
-  return nullptr;
+  // (done)TODO: Lab 3.6 根据 block 的 id 读取一个 `Block`
+  auto table = this->table();
+  if (block_idx >= table->num_blocks) {
+    throw std::out_of_range("Block index out of range");
+  }
+
+  if (block_cache != nullptr) {
+    auto cache_ptr = block_cache->get(sst_id, block_idx);
+    if (cache_ptr != nullptr) {
+      return cache_ptr;
+    }
+  }
+
+  auto block_res = load_block(*table, block_idx);
+
+  if (block_cache != nullptr) {
+    block_cache->put(sst_id, block_idx, block_res);
+  }
+  return block_res;
+}
+
+std::vector<std::shared_ptr<Block>> SST::read_blocks_batch(
+    const std::vector<std::pair<std::shared_ptr<SST>, size_t>> &reqs) {
+  std::vector<std::shared_ptr<Block>> blocks(reqs.size());
+  std::vector<FileReadRange> ranges;
+  std::vector<size_t> miss_idx;
+  // 批量读取完成前持有文件, 避免被表缓存关闭
+  std::vector<std::shared_ptr<SstTable>> tables;
+
+  for (size_t i = 0; i < reqs.size(); ++i) {
+    auto &[sst, block_idx] = reqs[i];
+    auto table = sst->table();
+    if (block_idx >= table->num_blocks) {
+      throw std::out_of_range("Block index out of range");
+    }
+    if (sst->block_cache != nullptr) {
+      blocks[i] = sst->block_cache->get(sst->sst_id, block_idx);
+      if (blocks[i] != nullptr) {
+        continue;
+      }
+    }
+    auto [offset, block_size] = sst->block_range(*table, block_idx);
+    if (table->file.view(offset, block_size) != nullptr) {
+      // mmap 模式下没有真正的 IO, 直接解码
+      blocks[i] = sst->load_block(*table, block_idx);
+      if (sst->block_cache != nullptr) {
+        sst->block_cache->put(sst->sst_id, block_idx, blocks[i]);
+      }
+      continue;
+    }
+    ranges.push_back({&table->file, offset, block_size});
+    miss_idx.push_back(i);
+    tables.push_back(std::move(table));
+  }
+
+  if (ranges.empty()) {
+    return blocks;
+  }
+
+  auto datas = FileObj::read_batch(ranges);
+  for (size_t i = 0; i < miss_idx.size(); ++i) {
+    auto &[sst, block_idx] = reqs[miss_idx[i]];
+    auto block = Block::decode(datas[i], true);
+    if (sst->block_cache != nullptr) {
+      sst->block_cache->put(sst->sst_id, block_idx, block);
+    }
+    blocks[miss_idx[i]] = block;
+  }
+  return blocks;
 }
 
 size_t SST::find_block_idx(const std::string &key) {
   // 先在布隆过滤器判断key是否存在
-  // TODO: Lab 3.6 二分查找
+  // (done)TODO: Lab 3.6 二分查找
   // ? 给定一个 `key`, 返回其所属的 `block` 的索引
   // ? 如果没有找到包含该 `key` 的 Block，返回-1
-  return 0;
+  // ? 索引中只有分隔 key, 返回的 block 是唯一可能包含 `key` 的 block
+  if (key < first_key) {
+    return -1;
+  }
+  auto table = this->table();
+  if (table->bloom_filter != nullptr &&
+      !table->bloom_filter->possibly_contains(key)) {
+    return -1;
+  }
+  size_t idx = lower_bound_block(key);
+  return idx < table->num_blocks ? idx : -1;
+}
+
+size_t SST::lower_bound_block(const std::string &key) {
+  auto table = this->table();
+  if (table->learned_index.has_value()) {
+    // 范围向前多查一项, 用于验证范围之前的分隔 key 都小于 key,
+    // 验证通过时范围内的结果就是答案, 否则回退到二分查找
+    auto [lo, hi] = table->learned_index->predict(key);
+    size_t begin = lo > 0 ? lo - 1 : 0;
+    if (hi <= table->num_blocks) {
+      size_t idx = index_lower_bound(*table, key, begin, hi);
+      if ((lo == 0 || idx > begin) && (idx < hi || hi == table->num_blocks)) {
+        return std::min(idx, table->num_blocks);
+      }
+    }
+  }
+
+  // 先在顶层索引中找到第一个最后 key 不小于 key 的分区
+  auto &index = table->index;
+  auto it = std::lower_bound(
+      index.begin(), index.end(), key,
+      [](const IndexPartitionMeta &meta, const std::string &target) {
+        return meta.last_key < target;
+      });
+  if (it == index.end()) {
+    return table->num_blocks;
+  }
+  auto partition = read_index_partition(*table, it - index.begin());
+  size_t idx = partition->lower_bound(key);
+  if (idx >= partition->size()) {
+    return table->num_blocks;
+  }
+  return it->first_block_idx + idx;
 }
 
 SstIterator SST::get(const std::string &key, uint64_t tranc_id) {
-  // TODO: Lab 3.6 根据查询`key`返回一个迭代器
+  // (done)TODO: Lab 3.6 根据查询`key`返回一个迭代器
   // ? 如果`key`不存在, 返回一个无效的迭代器即可
-  throw std::runtime_error("Not implemented");
+  if (key < first_key || key > last_key) {
+    return this->end();
+  }
+  // 迭代器定位到第一个不小于 key 的位置, 需要确认 key 存在
+  SstIterator it(shared_from_this(), key, tranc_id);
+  if (!it.is_valid() || it.key() != key) {
+    return this->end();
+  }
+  return it;
+}
+
+size_t SST::num_blocks() { return table()->num_blocks; }
+
+std::shared_ptr<Block> SST::read_index_partition(SstTable &table,
+                                                 size_t partition_idx) {
+  if (!table.pinned_partitions.empty()) {
+    return table.pinned_partitions[partition_idx];
+  }
+  // 索引分区和 data block 共用 block cache, 使用负数的 block id 区分
+  int cache_id = -1 - static_cast<int>(partition_idx);
+  if (block_cache != nullptr) {
+    auto cache_ptr = block_cache->get(sst_id, cache_id);
+    if (cache_ptr != nullptr) {
+      return cache_ptr;
+    }
+  }
+
+  auto &meta = table.index[partition_idx];
+  std::shared_ptr<Block> partition;
+  if (auto view = table.file.view(meta.offset, meta.size)) {
+    partition = Block::decode_view(std::move(view), meta.size, true);
+  } else {
+    partition =
+        Block::decode(table.file.read_to_slice(meta.offset, meta.size), true);
+  }
+
+  if (block_cache != nullptr) {
+    block_cache->put(sst_id, cache_id, partition);
+  }
+  return partition;
+}
+
+std::pair<std::shared_ptr<Block>, size_t>
+SST::locate_index_entry(SstTable &table, size_t block_idx) {
+  // 最后一个第一个 block 下标不超过 block_idx 的分区
+  auto it = std::upper_bound(
+      table.index.begin(), table.index.end(), block_idx,
+      [](size_t target, const IndexPartitionMeta &meta) {
+        return target < meta.first_block_idx;
+      });
+  size_t partition_idx = it - table.index.begin() - 1;
+  auto partition = read_index_partition(table, partition_idx);
+  return std::make_pair(partition, block_idx - it[-1].first_block_idx);
+}
+
+std::string SST::index_key(SstTable &table, size_t block_idx) {
+  auto [partition, idx] = locate_index_entry(table, block_idx);
+  return partition->get_key_at_idx(idx);
+}
+
+size_t SST::index_lower_bound(SstTable &table, const std::string &key,
+                              size_t lo, size_t hi) {
+  // 范围可能跨越多个分区, 逐个分区查找
+  while (lo < hi) {
+    auto [partition, local] = locate_index_entry(table, lo);
+    size_t local_hi = std::min(partition->size(), local + (hi - lo));
+    size_t res = partition->lower_bound(key, local, local_hi);
+    if (res < local_hi) {
+      return lo + (res - local);
+    }
+    lo += local_hi - local;
+  }
+  return hi;
+}
+
+std::shared_ptr<Block> SST::load_block(SstTable &table, size_t block_idx) {
+  auto [offset, block_size] = block_range(table, block_idx);
+  if (auto view = table.file.view(offset, block_size)) {
+    // mmap 模式下 Block 直接引用映射区域, 不拷贝数据
+    return Block::decode_view(std::move(view), block_size, true);
+  }
+  return Block::decode(table.file.read_to_slice(offset, block_size), true);
+}
+
+void SST::readahead(size_t first_block, size_t n) {
+  auto table = this->table();
+  size_t last_block = std::min(first_block + n, table->num_blocks);
+  if (first_block >= last_block) {
+    return;
+  }
+  // 按文件实际使用的后端选择预读方式, 不一定与配置相同
+  if (table->file.mode() == FileIOMode::Direct) {
+    if (block_cache == nullptr) {
+      return;
+    }
+    std::vector<std::pair<std::shared_ptr<SST>, size_t>> reqs;
+    for (size_t idx = first_block; idx < last_block; ++idx) {
+      reqs.emplace_back(shared_from_this(), idx);
+    }
+    read_blocks_batch(reqs);
+    return;
+  }
+  // data block 在文件中连续存放, 一次提示覆盖整个区间
+  auto [offset, block_size] = block_range(*table, first_block);
+  auto [last_offset, last_size] = block_range(*table, last_block - 1);
+  table->file.advise(offset, last_offset + last_size - offset,
+                     FileAccessHint::WillNeed);
+}
+
+std::pair<size_t, size_t> SST::block_range(SstTable &table,
+                                           size_t block_idx) {
+  auto [partition, idx] = locate_index_entry(table, block_idx);
+  return SstIndex::unpack_handle(partition->get_tranc_id_at_idx(idx));
 }
 
-size_t SST::num_blocks() const { return meta_entries.size(); }
+FileIOMode SST::file_io_mode() {
+  return FileObj::io_mode_from_string(
+      TomlConfig::getInstance().getLsmSstIoMode());
+}
 
 std::string SST::get_first_key() const { return first_key; }
 
 std::string SST::get_last_key() const { return last_key; }
 
-size_t SST::sst_size() const { return file.size(); }
+size_t SST::sst_size() const { return file_size_; }
 
 size_t SST::get_sst_id() const { return sst_id; }
 
 SstIterator SST::begin(uint64_t tranc_id) {
-  // TODO: Lab 3.6 返回起始位置迭代器
-  throw std::runtime_error("Not implemented");
+  // (done)TODO: Lab 3.6 返回起始位置迭代器
+  return SstIterator(shared_from_this(), tranc_id);
 }
 
 SstIterator SST::end() {
-  // TODO: Lab 3.6 返回终止位置迭代器
-  throw std::runtime_error("Not implemented");
+  // (done)TODO: Lab 3.6 返回终止位置迭代器
+  // 先用空指针构造, 避免 seek_first 读取数据块
+  SstIterator res(nullptr, 0);
+  res.m_sst = shared_from_this();
+  res.m_block_idx = num_blocks();
+  res.m_block_it = nullptr;
+  return res;
 }
 
 std::pair<uint64_t, uint64_t> SST::get_tranc_id_range() const {
@@ -86,14 +493,19 @@ std::pair<uint64_t, uint64_t> SST::get_tranc_id_range() const {
 // SSTBuilder
 // **************************************************
 
-SSTBuilder::SSTBuilder(size_t block_size, bool has_bloom) : block(block_size) {
+SSTBuilder::SSTBuilder(size_t block_size, bool has_bloom)
+    : block_hash_util_ratio_(
+          TomlConfig::getInstance().getLsmBlockHashUtilRatio()),
+      block(block_size, block_hash_util_ratio_), block_size(block_size),
+      learned_index_error_(
+          TomlConfig::getInstance().getLsmSstLearnedIndexError()) {
   // 初始化第一个block
   if (has_bloom) {
     bloom_filter = std::make_shared<BloomFilter>(
         TomlConfig::getInstance().getBloomFilterExpectedSize(),
         TomlConfig::getInstance().getBloomFilterExpectedErrorRate());
   }
-  meta_entries.clear();
+  index_entries.clear();
   data.clear();
   first_key.clear();
   last_key.clear();
@@ -101,21 +513,144 @@ SSTBuilder::SSTBuilder(size_t block_size, bool has_bloom) : block(block_size) {
 
 void SSTBuilder::add(const std::string &key, const std::string &value,
                      uint64_t tranc_id) {
-  // TODO: Lab 3.5 添加键值对
+  // (done)TODO: Lab 3.5 添加键值对
+  if (first_key.empty()) {
+    first_key = key;
+  }
+  if (pending_last_key_.has_value()) {
+    // 上一个 block 的分隔 key 只需要小于新 block 的第一个 key
+    index_entries.back().first =
+        SstIndex::shortest_separator(*pending_last_key_, key);
+    pending_last_key_.reset();
+  }
+
+  if (bloom_filter != nullptr) {
+    bloom_filter->add(key);
+  }
+
+  min_tranc_id_ = std::min(min_tranc_id_, tranc_id);
+  max_tranc_id_ = std::max(max_tranc_id_, tranc_id);
+
+  // 相同 key 的不同版本必须位于同一个 block, 因此与上一个 key 相同时强制写入
+  bool force_write = key == last_key;
+  if (block.add_entry(key, value, tranc_id, force_write)) {
+    last_key = key;
+    return;
+  }
+
+  // block 已满, 编码后开启新的 block
+  finish_block();
+  index_entries.back().first =
+      SstIndex::shortest_separator(*pending_last_key_, key);
+  pending_last_key_.reset();
+  block.add_entry(key, value, tranc_id, false);
+  last_key = key;
 }
 
 size_t SSTBuilder::estimated_size() const { return data.size(); }
 
+void SSTBuilder::set_learned_index_error(size_t error_bound) {
+  learned_index_error_ = error_bound;
+}
+
 void SSTBuilder::finish_block() {
-  // TODO: Lab 3.5 构建块
+  // (done)TODO: Lab 3.5 构建块
   // ? 当 add
   // 函数发现当前的`block`容量超出阈值时，需要将其编码到`data`，并清空`block`
+  auto old_block = std::move(this->block);
+  auto encoded_block = old_block.encode(true);
+
+  // 先记录最后一个 key, 下一个 block 开始时替换为分隔 key
+  index_entries.emplace_back(
+      last_key, SstIndex::pack_handle(data.size(), encoded_block.size()));
+  pending_last_key_ = last_key;
+
+  data.insert(data.end(), encoded_block.begin(), encoded_block.end());
+  block = Block(block_size, block_hash_util_ratio_);
 }
 
 std::shared_ptr<SST>
 SSTBuilder::build(size_t sst_id, const std::string &path,
                   std::shared_ptr<BlockCache> block_cache) {
-  // TODO 3.5 构建一个SST
-  return nullptr;
+  // (done)TODO 3.5 构建一个SST
+  if (!block.is_empty()) {
+    finish_block();
+  }
+  if (index_entries.empty()) {
+    throw std::runtime_error("Cannot build empty SST");
+  }
+  // 最后一个 block 保留真实的最后一个 key
+  pending_last_key_.reset();
+
+  // | blocks | index partitions | top-level index | bloom | meta_offset |
+  // | bloom_offset | min_id | max_id |
+  std::vector<IndexPartitionMeta> index;
+  for (auto &[partition, first_block_idx] :
+       SstIndex::build_partitions(index_entries, block_size)) {
+    auto encoded = partition->encode(true);
+    index.push_back({data.size(), encoded.size(), first_block_idx,
+                     partition->get_key_at_idx(partition->size() - 1)});
+    data.insert(data.end(), encoded.begin(), encoded.end());
+  }
+
+  uint32_t meta_offset = static_cast<uint32_t>(data.size());
+  SstIndex::encode_top_level(index, index_entries.size(), data);
+
+  // 模型紧跟在顶层索引之后, 训练失败(分段过多)时不写入
+  std::optional<LearnedIndex> learned_index;
+  if (learned_index_error_ > 0) {
+    std::vector<std::string> keys;
+    keys.reserve(index_entries.size());
+    for (auto &[key, handle] : index_entries) {
+      keys.push_back(key);
+    }
+    learned_index = LearnedIndex::train(keys, learned_index_error_);
+    if (learned_index.has_value()) {
+      learned_index->encode(data);
+    }
+  }
+
+  uint32_t bloom_offset = static_cast<uint32_t>(data.size());
+  if (bloom_filter != nullptr) {
+    auto bf_data = bloom_filter->encode();
+    data.insert(data.end(), bf_data.begin(), bf_data.end());
+  }
+
+  size_t extra_pos = data.size();
+  data.resize(extra_pos + sizeof(uint32_t) * 2 + sizeof(uint64_t) * 2);
+  uint8_t *ptr = data.data() + extra_pos;
+  memcpy(ptr, &meta_offset, sizeof(uint32_t));
+  ptr += sizeof(uint32_t);
+  memcpy(ptr, &bloom_offset, sizeof(uint32_t));
+  ptr += sizeof(uint32_t);
+  memcpy(ptr, &min_tranc_id_, sizeof(uint64_t));
+  ptr += sizeof(uint64_t);
+  memcpy(ptr, &max_tranc_id_, sizeof(uint64_t));
+
+  auto file = FileObj::create_and_write(path, data, SST::file_io_mode());
+
+  auto table = std::make_shared<SstTable>();
+  table->file = std::move(file);
+  table->meta_block_offset = meta_offset;
+  table->bloom_offset = bloom_offset;
+  table->bloom_filter = bloom_filter;
+  table->file.advise(0, meta_offset, FileAccessHint::Random);
+
+  table->num_blocks = index_entries.size();
+  table->index = std::move(index);
+  table->learned_index = std::move(learned_index);
+
+  auto res = std::make_shared<SST>();
+  res->sst_id = sst_id;
+  res->path_ = path;
+  res->file_size_ = data.size();
+  res->first_key = first_key;
+  res->last_key = last_key;
+  res->table_ = std::move(table);
+  res->block_cache = block_cache;
+  res->min_tranc_id_ = min_tranc_id_;
+  res->max_tranc_id_ = max_tranc_id_;
+
+  return res;
 }
 } // namespace tiny_lsm
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "../../include/sst/sst_index.h"
+#include "../../include/utils/crc32c.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace tiny_lsm {
+
+namespace {
+template <typename T> void put_fixed(std::vector<uint8_t> &buf, T value) {
+  size_t pos = buf.size();
+  buf.resize(pos + sizeof(T));
+  memcpy(buf.data() + pos, &value, sizeof(T));
+}
+
+template <typename T> T get_fixed(const uint8_t *&p, const uint8_t *end) {
+  if (static_cast<size_t>(end - p) < sizeof(T)) {
+    throw std::runtime_error("SST index truncated");
+  }
+  T value;
+  memcpy(&value, p, sizeof(T));
+  p += sizeof(T);
+  return value;
+}
+} // namespace
+
+uint64_t SstIndex::pack_handle(size_t offset, size_t size) {
+  return (static_cast<uint64_t>(offset) << 32) | static_cast<uint32_t>(size);
+}
+
+std::pair<size_t, size_t> SstIndex::unpack_handle(uint64_t handle) {
+  return std::make_pair(static_cast<size_t>(handle >> 32),
+                        static_cast<size_t>(handle & 0xffffffff));
+}
+
+std::string SstIndex::shortest_separator(const std::string &start,
+                                         const std::string &limit) {
+  size_t min_len = std::min(start.size(), limit.size());
+  size_t diff = 0;
+  while (diff < min_len && start[diff] == limit[diff]) {
+    diff++;
+  }
+  if (diff >= min_len) {
+    // start 是 limit 的前缀, 无法缩短
+    return start;
+  }
+  // 公共前缀之后的第一个字节加一, 只要仍然小于 limit 就是合法的分隔 key
+  uint8_t byte = static_cast<uint8_t>(start[diff]);
+  uint8_t limit_byte = static_cast<uint8_t>(limit[diff]);
+  if (byte >= limit_byte) {
+    return start;
+  }
+  // 加一后等于 limit 的字节时, 只要 limit 更长, 结果仍是 limit 的真前缀
+  if (byte + 1 < limit_byte || diff + 1 < limit.size()) {
+    std::string sep = start.substr(0, diff + 1);
+    sep[diff] = static_cast<char>(byte + 1);
+    return sep.size() < start.size() ? sep : start;
+  }
+  // 两个字节相邻时, 在 start 的剩余部分中找一个可以加一的字节,
+  // 结果的前 diff + 1 个字节和 start 相同, 一定小于 limit
+  for (size_t i = diff + 1; i + 1 < start.size(); ++i) {
+    if (static_cast<uint8_t>(start[i]) < 0xff) {
+      std::string sep = start.substr(0, i + 1);
+      sep[i] = static_cast<char>(static_cast<uint8_t>(start[i]) + 1);
+      return sep;
+    }
+  }
+  return start;
+}
+
+std::vector<std::pair<std::shared_ptr<Block>, size_t>>
+SstIndex::build_partitions(
+    const std::vector<std::pair<std::string, uint64_t>> &entries,
+    size_t partition_size) {
+  std::vector<std::pair<std::shared_ptr<Block>, size_t>> partitions;
+  auto partition = std::make_shared<Block>(partition_size);
+  size_t first_block_idx = 0;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    auto &[key, handle] = entries[i];
+    // 空分区总是可以写入, 避免超长的 key 无法放入任何分区
+    if (!partition->add_entry(key, "", handle, partition->is_empty())) {
+      partitions.emplace_back(partition, first_block_idx);
+      partition = std::make_shared<Block>(partition_size);
+      first_block_idx = i;
+      partition->add_entry(key, "", handle, true);
+    }
+  }
+  if (!partition->is_empty()) {
+    partitions.emplace_back(partition, first_block_idx);
+  }
+  return partitions;
+}
+
+void SstIndex::encode_top_level(
+    const std::vector<IndexPartitionMeta> &partitions, size_t num_blocks,
+    std::vector<uint8_t> &out) {
+  size_t begin = out.size();
+  put_fixed<uint32_t>(out, MAGIC);
+  put_fixed<uint32_t>(out, static_cast<uint32_t>(num_blocks));
+  put_fixed<uint32_t>(out, static_cast<uint32_t>(partitions.size()));
+  for (auto &meta : partitions) {
+    put_fixed<uint32_t>(out, static_cast<uint32_t>(meta.offset));
+    put_fixed<uint32_t>(out, static_cast<uint32_t>(meta.size));
+    put_fixed<uint32_t>(out, static_cast<uint32_t>(meta.first_block_idx));
+    put_fixed<uint16_t>(out, static_cast<uint16_t>(meta.last_key.size()));
+    out.insert(out.end(), meta.last_key.begin(), meta.last_key.end());
+  }
+  put_fixed<uint32_t>(out, crc32c(out.data() + begin, out.size() - begin));
+}
+
+bool SstIndex::decode_top_level(const std::vector<uint8_t> &data,
+                                std::vector<IndexPartitionMeta> &partitions,
+                                size_t &num_blocks, size_t &consumed) {
+  const uint8_t *p = data.data();
+  const uint8_t *end = data.data() + data.size();
+  if (data.size() < sizeof(uint32_t) * 4 ||
+      get_fixed<uint32_t>(p, end) != MAGIC) {
+    return false;
+  }
+
+  num_blocks = get_fixed<uint32_t>(p, end);
+  uint32_t num_partitions = get_fixed<uint32_t>(p, end);
+  partitions.clear();
+  partitions.reserve(num_partitions);
+  for (uint32_t i = 0; i < num_partitions; ++i) {
+    IndexPartitionMeta meta;
+    meta.offset = get_fixed<uint32_t>(p, end);
+    meta.size = get_fixed<uint32_t>(p, end);
+    meta.first_block_idx = get_fixed<uint32_t>(p, end);
+    uint16_t key_len = get_fixed<uint16_t>(p, end);
+    if (static_cast<size_t>(end - p) < key_len) {
+      throw std::runtime_error("SST index truncated");
+    }
+    meta.last_key.assign(reinterpret_cast<const char *>(p), key_len);
+    p += key_len;
+    partitions.push_back(std::move(meta));
+  }
+
+  size_t len = p - data.data();
+  if (crc32c(data.data(), len) != get_fixed<uint32_t>(p, end)) {
+    throw std::runtime_error("SST index checksum mismatch");
+  }
+  consumed = len + sizeof(uint32_t);
+  return true;
+}
+
+std::vector<std::pair<std::string, uint64_t>>
+SstIndex::entries_from_block_metas(const std::vector<BlockMeta> &metas,
+                                   size_t data_end) {
+  std::vector<std::pair<std::string, uint64_t>> entries;
+  entries.reserve(metas.size());
+  for (size_t i = 0; i < metas.size(); ++i) {
+    size_t block_end = i + 1 < metas.size() ? metas[i + 1].offset : data_end;
+    entries.emplace_back(metas[i].last_key,
+                         pack_handle(metas[i].offset,
+                                     block_end - metas[i].offset));
+  }
+  return entries;
+}
+} // namespace tiny_lsm
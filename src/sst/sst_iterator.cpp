@@ -1,5 +1,7 @@
 #include "../../include/sst/sst_iterator.h"
+#include "../../include/config/config.h"
 #include "../../include/sst/sst.h"
+#include <algorithm>
 #include <cstddef>
 #include <optional>
 #include <stdexcept>
@@ -13,8 +15,93 @@ namespace tiny_lsm {
 std::optional<std::pair<SstIterator, SstIterator>> sst_iters_monotony_predicate(
     std::shared_ptr<SST> sst, uint64_t tranc_id,
     std::function<int(const std::string &)> predicate) {
-  // TODO: Lab 3.7 实现谓词查询功能
-  return {};
+  // (done)TODO: Lab 3.7 实现谓词查询功能
+  std::optional<SstIterator> final_begin = std::nullopt;
+  std::optional<SstIterator> final_end = std::nullopt;
+
+  // 索引中只有分隔 key, block mid 中的 key 都位于
+  // (前一个 block 的分隔 key, 当前 block 的分隔 key] 之间
+  // 持有已加载的索引, 查找期间不会被表缓存释放
+  auto table = sst->table();
+  auto lower_key = [&](int idx) {
+    return idx == 0 ? sst->first_key : sst->index_key(*table, idx - 1);
+  };
+
+  // 二分查找第一个包含满足谓词的 key 的 block
+  int left = 0;
+  int right = static_cast<int>(table->num_blocks) - 1;
+  while (left <= right) {
+    int mid = left + (right - left) / 2;
+    auto upper_key = sst->index_key(*table, mid);
+    if (predicate(lower_key(mid)) < 0) {
+      // 整个 block 都在满足谓词的区间右侧
+      right = mid - 1;
+      continue;
+    }
+    if (predicate(upper_key) > 0) {
+      // 整个 block 都在满足谓词的区间左侧
+      left = mid + 1;
+      continue;
+    }
+    auto block = sst->read_block(mid);
+    auto res = block->get_monotony_predicate_iters(tranc_id, predicate);
+    if (!res.has_value()) {
+      // 满足谓词的区间恰好落在两个 key 之间
+      if (predicate(upper_key) < 0) {
+        right = mid - 1;
+      } else {
+        left = mid + 1;
+      }
+      continue;
+    }
+    // 找到一个命中的 block 后, 继续向左确认是否有更早的 block
+    SstIterator it(nullptr, tranc_id);
+    it.m_sst = sst;
+    it.set_block_idx(mid);
+    it.set_block_it(res->first);
+    final_begin = it;
+    right = mid - 1;
+  }
+
+  if (!final_begin.has_value()) {
+    return std::nullopt;
+  }
+
+  // 二分查找最后一个包含满足谓词的 key 的 block
+  left = static_cast<int>(final_begin->m_block_idx);
+  right = static_cast<int>(table->num_blocks) - 1;
+  while (left <= right) {
+    int mid = left + (right - left) / 2;
+    if (predicate(lower_key(mid)) < 0) {
+      right = mid - 1;
+      continue;
+    }
+    auto block = sst->read_block(mid);
+    auto res = block->get_monotony_predicate_iters(tranc_id, predicate);
+    if (!res.has_value()) {
+      right = mid - 1;
+      continue;
+    }
+    // 区间右端点是开区间, 位于 block 末尾时移动到下一个 block 的开头
+    SstIterator it(nullptr, tranc_id);
+    it.m_sst = sst;
+    it.set_block_idx(mid);
+    it.set_block_it(res->second);
+    if (it.m_block_it->is_end()) {
+      it.set_block_idx(mid + 1);
+      if (mid + 1 < static_cast<int>(sst->num_blocks())) {
+        auto next_block = sst->read_block(mid + 1);
+        it.set_block_it(
+            std::make_shared<BlockIterator>(next_block, 0, tranc_id));
+      } else {
+        it.set_block_it(nullptr);
+      }
+    }
+    final_end = it;
+    left = mid + 1;
+  }
+
+  return std::make_pair(*final_begin, *final_end);
 }
 
 SstIterator::SstIterator(std::shared_ptr<SST> sst, uint64_t tranc_id)
@@ -32,17 +119,150 @@ SstIterator::SstIterator(std::shared_ptr<SST> sst, const std::string &key,
   }
 }
 
+SstIterator::SstIterator(std::shared_ptr<SST> sst, const std::string &lower,
+                         const std::string &upper, uint64_t tranc_id)
+    : m_sst(sst), m_block_idx(0), m_block_it(nullptr), max_tranc_id_(tranc_id) {
+  if (m_sst) {
+    set_bounds(lower, upper);
+    seek(lower);
+  }
+}
+
+void SstIterator::set_bounds(const std::string &lower,
+                             const std::string &upper) {
+  // 分隔 key 不小于 block 中的所有 key, 小于下一个 block 的所有 key:
+  // 分隔 key 小于 lower 的 block 中没有不小于 lower 的 key,
+  // 第一个分隔 key 不小于 upper 的 block 之后的 block 中没有小于 upper 的 key
+  m_first_block = m_sst->lower_bound_block(lower);
+  m_end_block =
+      std::min(m_sst->lower_bound_block(upper) + 1, m_sst->num_blocks());
+}
+
+size_t SstIterator::end_block() {
+  return std::min(m_end_block, m_sst->num_blocks());
+}
+
+void SstIterator::set_readahead(size_t blocks) {
+  fixed_readahead_ = blocks;
+  reset_readahead();
+  if (fixed_readahead_ > 0 && m_block_it) {
+    readahead_sequential();
+  }
+}
+
+void SstIterator::reset_readahead() {
+  readahead_window_ = 0;
+  readahead_end_ = 0;
+}
+
+void SstIterator::readahead_sequential() {
+  if (m_block_idx + readahead_window_ / 2 < readahead_end_) {
+    // 已经预读的 block 还剩一半以上
+    return;
+  }
+  if (fixed_readahead_ > 0) {
+    readahead_window_ = fixed_readahead_;
+  } else {
+    size_t max_window = std::max(
+        TomlConfig::getInstance().getLsmSstReadaheadMaxBlocks(), 0);
+    if (max_window == 0) {
+      return;
+    }
+    // 窗口从 2 个 block 开始, 每次提交后加倍
+    readahead_window_ =
+        std::min(std::max<size_t>(readahead_window_ * 2, 2), max_window);
+  }
+  size_t begin = std::max(m_block_idx, readahead_end_);
+  size_t end = std::min(m_block_idx + readahead_window_, end_block());
+  if (begin < end) {
+    m_sst->readahead(begin, end - begin);
+    readahead_end_ = end;
+  }
+}
+
 void SstIterator::set_block_idx(size_t idx) { m_block_idx = idx; }
 void SstIterator::set_block_it(std::shared_ptr<BlockIterator> it) {
   m_block_it = it;
 }
 
 void SstIterator::seek_first() {
-  // TODO: Lab 3.6 将迭代器定位到第一个key
+  // (done)TODO: Lab 3.6 将迭代器定位到第一个key
+  if (!m_sst || m_first_block >= end_block()) {
+    m_block_it = nullptr;
+    return;
+  }
+  m_block_idx = m_first_block;
+  // 从头开始的遍历通常是顺序扫描, 直接开始预读
+  reset_readahead();
+  readahead_sequential();
+  auto block = m_sst->read_block(m_block_idx);
+  m_block_it = std::make_shared<BlockIterator>(block, 0, max_tranc_id_);
+  skip_empty_blocks();
+}
+
+void SstIterator::seek_to_last() {
+  cached_value = std::nullopt;
+  if (!m_sst || m_first_block >= end_block()) {
+    m_block_it = nullptr;
+    return;
+  }
+  open_block(end_block() - 1);
+  m_block_it->seek_to_last();
+  skip_empty_blocks_backward();
 }
 
 void SstIterator::seek(const std::string &key) {
-  // TODO: Lab 3.6 将迭代器定位到指定key的位置
+  // (done)TODO: Lab 3.6 将迭代器定位到指定key的位置
+  // 定位到第一个不小于 key 的可见 key, 点查需要上层比较 key 是否相等
+  cached_value = std::nullopt;
+  if (!m_sst) {
+    m_block_it = nullptr;
+    return;
+  }
+  size_t idx = m_sst->lower_bound_block(key);
+  if (idx >= end_block()) {
+    // 所有 key 都小于目标 key, 置为 end
+    set_end();
+    return;
+  }
+  open_block(std::max(idx, m_first_block));
+  m_block_it->seek(key);
+  skip_empty_blocks();
+}
+
+void SstIterator::seek_for_prev(const std::string &key) {
+  cached_value = std::nullopt;
+  if (!m_sst || m_first_block >= end_block()) {
+    m_block_it = nullptr;
+    return;
+  }
+  // 第一个分隔 key 不小于目标 key 的 block 中可能没有不大于目标 key 的记录,
+  // 此时需要继续查看上一个 block
+  size_t idx = m_sst->lower_bound_block(key);
+  if (idx < m_first_block) {
+    // 不大于目标 key 的记录都在允许访问的 block 之前
+    set_end();
+    return;
+  }
+  open_block(std::min(idx, end_block() - 1));
+  m_block_it->seek_for_prev(key);
+  skip_empty_blocks_backward();
+}
+
+void SstIterator::open_block(size_t idx) {
+  if (m_block_it && m_block_idx == idx) {
+    return;
+  }
+  // 随机定位和反向移动不预读
+  reset_readahead();
+  m_block_idx = idx;
+  auto block = m_sst->read_block(m_block_idx);
+  m_block_it = std::make_shared<BlockIterator>(block, 0, max_tranc_id_);
+}
+
+void SstIterator::set_end() {
+  m_block_it = nullptr;
+  m_block_idx = m_sst->num_blocks();
 }
 
 std::string SstIterator::key() {
@@ -60,23 +280,92 @@ std::string SstIterator::value() {
 }
 
 BaseIterator &SstIterator::operator++() {
-  // TODO: Lab 3.6 实现迭代器自增
+  // (done)TODO: Lab 3.6 实现迭代器自增
+  if (!m_block_it) {
+    return *this;
+  }
+  cached_value = std::nullopt;
+  ++(*m_block_it);
+  if (m_block_it->is_end()) {
+    m_block_idx++;
+    if (m_block_idx < end_block()) {
+      // 顺序扫描时提前载入之后的 block
+      readahead_sequential();
+      auto next_block = m_sst->read_block(m_block_idx);
+      m_block_it =
+          std::make_shared<BlockIterator>(next_block, 0, max_tranc_id_);
+      skip_empty_blocks();
+    } else {
+      m_block_it = nullptr;
+    }
+  }
+  return *this;
+}
+
+BaseIterator &SstIterator::operator--() {
+  if (!m_block_it) {
+    return *this;
+  }
+  cached_value = std::nullopt;
+  --(*m_block_it);
+  skip_empty_blocks_backward();
   return *this;
 }
 
 bool SstIterator::operator==(const BaseIterator &other) const {
-  // TODO: Lab 3.6 实现迭代器比较
-  return false;
+  // (done)TODO: Lab 3.6 实现迭代器比较
+  if (other.get_type() != IteratorType::SstIterator) {
+    return false;
+  }
+  const auto &other2 = dynamic_cast<const SstIterator &>(other);
+  if (m_sst != other2.m_sst || m_block_idx != other2.m_block_idx) {
+    return false;
+  }
+  if (!m_block_it && !other2.m_block_it) {
+    return true;
+  }
+  if (!m_block_it || !other2.m_block_it) {
+    return false;
+  }
+  return *m_block_it == *other2.m_block_it;
 }
 
 bool SstIterator::operator!=(const BaseIterator &other) const {
-  // TODO: Lab 3.6 实现迭代器比较
-  return false;
+  // (done)TODO: Lab 3.6 实现迭代器比较
+  return !(*this == other);
 }
 
 SstIterator::value_type SstIterator::operator*() const {
-  // TODO: Lab 3.6 实现迭代器解引用
-  return {};
+  // (done)TODO: Lab 3.6 实现迭代器解引用
+  if (!m_block_it) {
+    throw std::runtime_error("Iterator is invalid");
+  }
+  return (**m_block_it);
+}
+
+void SstIterator::skip_empty_blocks() {
+  // 事务过滤后某些 block 可能没有可见的记录, 直接跳过
+  while (m_block_it && m_block_it->is_end()) {
+    m_block_idx++;
+    if (m_block_idx >= end_block()) {
+      m_block_it = nullptr;
+      return;
+    }
+    readahead_sequential();
+    auto block = m_sst->read_block(m_block_idx);
+    m_block_it = std::make_shared<BlockIterator>(block, 0, max_tranc_id_);
+  }
+}
+
+void SstIterator::skip_empty_blocks_backward() {
+  while (m_block_it && m_block_it->is_end()) {
+    if (m_block_idx <= m_first_block) {
+      set_end();
+      return;
+    }
+    open_block(m_block_idx - 1);
+    m_block_it->seek_to_last();
+  }
 }
 
 IteratorType SstIterator::get_type() const { return IteratorType::SstIterator; }
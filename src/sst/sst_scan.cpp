@@ -0,0 +1,50 @@
+#include "../../include/sst/sst_scan.h"
+#include <algorithm>
+#include <utility>
+
+namespace tiny_lsm {
+
+SstScan::SstScan(std::shared_ptr<SST> sst, size_t readahead_blocks)
+    : sst_(std::move(sst)), readahead_blocks_(readahead_blocks) {
+  num_blocks_ = sst_ != nullptr ? sst_->num_blocks() : 0;
+  load_block(0);
+}
+
+void SstScan::load_block(size_t block_idx) {
+  // 跳过空的 block
+  for (; block_idx < num_blocks_; ++block_idx) {
+    // 当前 block 接近已预读的末尾时预读下一个窗口
+    if (readahead_blocks_ > 0 &&
+        block_idx + readahead_blocks_ / 2 >= readahead_end_) {
+      size_t begin = std::max(block_idx, readahead_end_);
+      size_t end = std::min(block_idx + readahead_blocks_, num_blocks_);
+      if (begin < end) {
+        sst_->readahead(begin, end - begin);
+        readahead_end_ = end;
+      }
+    }
+    block_ = sst_->read_block(block_idx);
+    block_idx_ = block_idx;
+    block_entries_ = block_->size();
+    if (block_entries_ > 0) {
+      entry_idx_ = 0;
+      block_->read_entry_at_idx(0, key_, value_, tranc_id_);
+      return;
+    }
+  }
+  block_.reset();
+  block_entries_ = 0;
+}
+
+LevelScan::LevelScan(std::vector<std::shared_ptr<SST>> ssts,
+                     size_t readahead_blocks)
+    : ssts_(std::move(ssts)), readahead_blocks_(readahead_blocks) {
+  open_next();
+}
+
+void LevelScan::open_next() {
+  while (!cur_.valid() && next_idx_ < ssts_.size()) {
+    cur_ = SstScan(ssts_[next_idx_++], readahead_blocks_);
+  }
+}
+} // namespace tiny_lsm
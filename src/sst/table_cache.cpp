@@ -0,0 +1,51 @@
+#include "../../include/sst/table_cache.h"
+#include "../../include/sst/sst.h"
+#include "spdlog/spdlog.h"
+
+namespace tiny_lsm {
+
+TableCache::TableCache(size_t capacity)
+    : capacity_(capacity), hand_(tables_.end()) {}
+
+void TableCache::insert(const std::shared_ptr<SST> &sst) {
+  if (capacity_ == 0) {
+    // 不限制打开的数量, 不需要记录
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mtx_);
+  // 新加载的 sst 放在指针之前, 一轮扫描之后才会被检查
+  tables_.insert(hand_, sst);
+  evict_();
+}
+
+size_t TableCache::size() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return tables_.size();
+}
+
+void TableCache::evict_() {
+  // 每个 sst 最多被跳过一次, 两轮之内一定能找到可以卸载的 sst
+  size_t budget = tables_.size() * 2;
+  while (tables_.size() > capacity_ && budget-- > 0) {
+    if (hand_ == tables_.end()) {
+      hand_ = tables_.begin();
+    }
+    auto sst = hand_->lock();
+    if (sst == nullptr || !sst->is_loaded()) {
+      // sst 已经被删除或者已经被卸载
+      hand_ = tables_.erase(hand_);
+      continue;
+    }
+    if (sst->clear_referenced()) {
+      // 最近被访问过, 给一次机会
+      ++hand_;
+      continue;
+    }
+    // 不知道文件路径的 sst 无法重新加载, 不再由缓存管理
+    if (sst->unload()) {
+      spdlog::debug("TableCache--evict: unloaded SST {}", sst->get_sst_id());
+    }
+    hand_ = tables_.erase(hand_);
+  }
+}
+} // namespace tiny_lsm
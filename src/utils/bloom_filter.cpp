@@ -1,10 +1,12 @@
 // include/utils/bloom_filter.cpp
 
 #include "../..//include/utils/bloom_filter.h"
+#include <algorithm>
 #include <cstring>
 #include <functional>
 #include <iostream>
 #include <numeric>
+#include <stdexcept>
 #include <string>
 
 namespace tiny_lsm {
@@ -17,17 +19,32 @@ BloomFilter::BloomFilter() {};
 BloomFilter::BloomFilter(size_t expected_elements, double false_positive_rate)
     : expected_elements_(expected_elements),
       false_positive_rate_(false_positive_rate) {
-  // TODO: Lab 4.9: 初始化数组长度
+  // (done)TODO: Lab 4.9: 初始化数组长度
+  // m = -n * ln(p) / (ln2)^2, k = m / n * ln2
+  double m = -static_cast<double>(expected_elements) *
+             std::log(false_positive_rate) / (std::log(2) * std::log(2));
+  num_bits_ = std::max<size_t>(static_cast<size_t>(std::ceil(m)), 1);
+  num_hashes_ = std::max<size_t>(
+      static_cast<size_t>(std::ceil(m / expected_elements * std::log(2))), 1);
+  bits_.resize(num_bits_, false);
 }
 
 void BloomFilter::add(const std::string &key) {
-  // TODO: Lab 4.9: 添加一个记录到布隆过滤器中
+  // (done)TODO: Lab 4.9: 添加一个记录到布隆过滤器中
+  for (size_t i = 0; i < num_hashes_; ++i) {
+    bits_[hash(key, i)] = true;
+  }
 }
 
 //  如果key可能存在于布隆过滤器中，返回true；否则返回false
 bool BloomFilter::possibly_contains(const std::string &key) const {
-  // TODO: Lab 4.9: 检查一个记录是否可能存在于布隆过滤器中
-  return false;
+  // (done)TODO: Lab 4.9: 检查一个记录是否可能存在于布隆过滤器中
+  for (size_t i = 0; i < num_hashes_; ++i) {
+    if (!bits_[hash(key, i)]) {
+      return false;
+    }
+  }
+  return true;
 }
 
 // 清空布隆过滤器
@@ -44,22 +61,66 @@ size_t BloomFilter::hash2(const std::string &key) const {
 }
 
 size_t BloomFilter::hash(const std::string &key, size_t idx) const {
-  // TODO: Lab 4.9: 计算哈希值
+  // (done)TODO: Lab 4.9: 计算哈希值
   // ? idx 标识这是第几个哈希函数
   // ? 你需要按照某些方式, 从 hash1 和 hash2 中组合成新的哈希函数
-  return 0;
+  // 双重哈希: h_i = h1 + i * h2
+  return (hash1(key) + idx * hash2(key)) % num_bits_;
 }
 
 // 编码布隆过滤器为 std::vector<uint8_t>
 std::vector<uint8_t> BloomFilter::encode() {
-  // TODO: Lab 4.9: 编码布隆过滤器
-  return std::vector<uint8_t>();
+  // (done)TODO: Lab 4.9: 编码布隆过滤器
+  // | expected_elements | false_positive_rate | num_bits | num_hashes | bits |
+  size_t header_size = sizeof(expected_elements_) +
+                       sizeof(false_positive_rate_) + sizeof(num_bits_) +
+                       sizeof(num_hashes_);
+  std::vector<uint8_t> data(header_size + (num_bits_ + 7) / 8, 0);
+  uint8_t *ptr = data.data();
+  memcpy(ptr, &expected_elements_, sizeof(expected_elements_));
+  ptr += sizeof(expected_elements_);
+  memcpy(ptr, &false_positive_rate_, sizeof(false_positive_rate_));
+  ptr += sizeof(false_positive_rate_);
+  memcpy(ptr, &num_bits_, sizeof(num_bits_));
+  ptr += sizeof(num_bits_);
+  memcpy(ptr, &num_hashes_, sizeof(num_hashes_));
+  ptr += sizeof(num_hashes_);
+
+  for (size_t i = 0; i < num_bits_; ++i) {
+    if (bits_[i]) {
+      ptr[i / 8] |= (1 << (i % 8));
+    }
+  }
+  return data;
 }
 
 // 从 std::vector<uint8_t> 解码布隆过滤器
 BloomFilter BloomFilter::decode(const std::vector<uint8_t> &data) {
   BloomFilter bf;
-  // TODO: Lab 4.9: 解码布隆过滤器
+  // (done)TODO: Lab 4.9: 解码布隆过滤器
+  size_t header_size = sizeof(bf.expected_elements_) +
+                       sizeof(bf.false_positive_rate_) + sizeof(bf.num_bits_) +
+                       sizeof(bf.num_hashes_);
+  if (data.size() < header_size) {
+    throw std::runtime_error("Invalid bloom filter data");
+  }
+  const uint8_t *ptr = data.data();
+  memcpy(&bf.expected_elements_, ptr, sizeof(bf.expected_elements_));
+  ptr += sizeof(bf.expected_elements_);
+  memcpy(&bf.false_positive_rate_, ptr, sizeof(bf.false_positive_rate_));
+  ptr += sizeof(bf.false_positive_rate_);
+  memcpy(&bf.num_bits_, ptr, sizeof(bf.num_bits_));
+  ptr += sizeof(bf.num_bits_);
+  memcpy(&bf.num_hashes_, ptr, sizeof(bf.num_hashes_));
+  ptr += sizeof(bf.num_hashes_);
+
+  if (data.size() < header_size + (bf.num_bits_ + 7) / 8) {
+    throw std::runtime_error("Invalid bloom filter data");
+  }
+  bf.bits_.resize(bf.num_bits_, false);
+  for (size_t i = 0; i < bf.num_bits_; ++i) {
+    bf.bits_[i] = (ptr[i / 8] >> (i % 8)) & 1;
+  }
   return bf;
 }
 } // namespace tiny_lsm
\ No newline at end of file
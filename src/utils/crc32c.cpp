@@ -0,0 +1,95 @@
+#include "../../include/utils/crc32c.h"
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+namespace tiny_lsm {
+
+namespace {
+constexpr uint32_t kPoly = 0x82F63B78; // 反射形式的 Castagnoli 多项式
+
+std::array<uint32_t, 256> make_table() {
+  std::array<uint32_t, 256> table{};
+  for (uint32_t i = 0; i < 256; ++i) {
+    uint32_t crc = i;
+    for (int j = 0; j < 8; ++j) {
+      crc = (crc >> 1) ^ ((crc & 1) ? kPoly : 0);
+    }
+    table[i] = crc;
+  }
+  return table;
+}
+
+uint32_t crc32c_sw(const uint8_t *p, size_t length, uint32_t crc) {
+  static const std::array<uint32_t, 256> table = make_table();
+  for (size_t i = 0; i < length; ++i) {
+    crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2"))) uint32_t
+crc32c_hw(const uint8_t *p, size_t length, uint32_t crc) {
+  uint64_t crc64 = crc;
+  while (length >= sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    crc64 = _mm_crc32_u64(crc64, word);
+    p += sizeof(word);
+    length -= sizeof(word);
+  }
+  uint32_t crc32 = static_cast<uint32_t>(crc64);
+  while (length > 0) {
+    crc32 = _mm_crc32_u8(crc32, *p);
+    ++p;
+    --length;
+  }
+  return crc32;
+}
+
+bool has_hw_crc32c() {
+  static const bool supported = __builtin_cpu_supports("sse4.2");
+  return supported;
+}
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+uint32_t crc32c_hw(const uint8_t *p, size_t length, uint32_t crc) {
+  while (length >= sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    crc = __crc32cd(crc, word);
+    p += sizeof(word);
+    length -= sizeof(word);
+  }
+  while (length > 0) {
+    crc = __crc32cb(crc, *p);
+    ++p;
+    --length;
+  }
+  return crc;
+}
+
+bool has_hw_crc32c() { return true; }
+#else
+uint32_t crc32c_hw(const uint8_t *p, size_t length, uint32_t crc) {
+  return crc32c_sw(p, length, crc);
+}
+
+bool has_hw_crc32c() { return false; }
+#endif
+} // namespace
+
+uint32_t crc32c(const void *data, size_t length, uint32_t crc) {
+  auto p = static_cast<const uint8_t *>(data);
+  crc = ~crc;
+  crc = has_hw_crc32c() ? crc32c_hw(p, length, crc)
+                        : crc32c_sw(p, length, crc);
+  return ~crc;
+}
+
+} // namespace tiny_lsm
@@ -0,0 +1,235 @@
+#include "../../include/utils/direct_file.h"
+#include "../../include/utils/io_uring.h"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace tiny_lsm {
+
+namespace {
+struct FreeDeleter {
+  void operator()(uint8_t *ptr) const { std::free(ptr); }
+};
+using AlignedBuffer = std::unique_ptr<uint8_t[], FreeDeleter>;
+
+size_t align_down(size_t value) {
+  return value & ~(DirectFile::kAlignment - 1);
+}
+
+size_t align_up(size_t value) {
+  return align_down(value + DirectFile::kAlignment - 1);
+}
+
+AlignedBuffer make_aligned_buffer(size_t size) {
+  void *ptr = std::aligned_alloc(DirectFile::kAlignment, size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return AlignedBuffer(static_cast<uint8_t *>(ptr));
+}
+
+// 读满 length 字节或者遇到 EOF, 返回实际读取的字节数
+size_t pread_full(int fd, uint8_t *buf, size_t length, size_t offset) {
+  size_t done = 0;
+  while (done < length) {
+    ssize_t n = ::pread(fd, buf + done, length - done, offset + done);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error("Failed to read from file: " +
+                               std::string(strerror(errno)));
+    }
+    if (n == 0) {
+      break;
+    }
+    done += static_cast<size_t>(n);
+  }
+  return done;
+}
+} // namespace
+
+bool DirectFile::open(const std::string &filename, bool create) {
+  close();
+  filename_ = filename;
+
+  if (create) {
+    int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+      return false;
+    }
+    ::close(fd);
+  }
+
+  fd_ = ::open(filename.c_str(), O_RDONLY | O_DIRECT);
+  direct_ = fd_ != -1;
+  if (fd_ == -1 && errno == EINVAL) {
+    // 文件系统不支持 O_DIRECT, 退化为普通的 pread
+    spdlog::warn("DirectFile--open: O_DIRECT not supported for {}, "
+                 "falling back to buffered pread",
+                 filename);
+    fd_ = ::open(filename.c_str(), O_RDONLY);
+    if (fd_ != -1) {
+      posix_fadvise(fd_, 0, 0, POSIX_FADV_RANDOM);
+    }
+  }
+  if (fd_ == -1) {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd_, &st) == -1) {
+    close();
+    return false;
+  }
+  file_size_ = st.st_size;
+  return true;
+}
+
+bool DirectFile::create(const std::string &filename,
+                        std::vector<uint8_t> &buf) {
+  if (!this->open(filename, true)) {
+    return false;
+  }
+  if (!buf.empty() && !write(0, buf.data(), buf.size())) {
+    return false;
+  }
+  return sync();
+}
+
+void DirectFile::close() {
+  if (write_fd_ != -1) {
+    ::close(write_fd_);
+    write_fd_ = -1;
+  }
+  if (fd_ != -1) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+  direct_ = false;
+  file_size_ = 0;
+}
+
+bool DirectFile::write(size_t offset, const void *data, size_t size) {
+  if (write_fd_ == -1 && !open_write_fd()) {
+    return false;
+  }
+
+  const uint8_t *src = static_cast<const uint8_t *>(data);
+  size_t done = 0;
+  while (done < size) {
+    ssize_t n = ::pwrite(write_fd_, src + done, size - done, offset + done);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    done += static_cast<size_t>(n);
+  }
+  file_size_ = std::max(file_size_, offset + size);
+  return true;
+}
+
+std::vector<uint8_t> DirectFile::read(size_t offset, size_t length) {
+  std::vector<uint8_t> result(length);
+  if (length == 0) {
+    return result;
+  }
+
+  size_t aligned_begin = align_down(offset);
+  size_t aligned_len = align_up(offset + length) - aligned_begin;
+  auto buf = make_aligned_buffer(aligned_len);
+
+  size_t got = pread_full(fd_, buf.get(), aligned_len, aligned_begin);
+  if (got < offset + length - aligned_begin) {
+    throw std::runtime_error("Failed to read from file");
+  }
+  memcpy(result.data(), buf.get() + (offset - aligned_begin), length);
+  return result;
+}
+
+std::vector<std::vector<uint8_t>>
+DirectFile::read_batch(const std::vector<std::pair<size_t, size_t>> &ranges) {
+  std::vector<DirectReadRange> file_ranges;
+  file_ranges.reserve(ranges.size());
+  for (auto &[offset, length] : ranges) {
+    file_ranges.push_back({this, offset, length});
+  }
+  return read_batch(file_ranges);
+}
+
+std::vector<std::vector<uint8_t>>
+DirectFile::read_batch(const std::vector<DirectReadRange> &ranges) {
+  std::vector<AlignedBuffer> buffers;
+  std::vector<IoReadRequest> reqs;
+  buffers.reserve(ranges.size());
+  reqs.reserve(ranges.size());
+
+  for (auto &range : ranges) {
+    size_t aligned_begin = align_down(range.offset);
+    size_t aligned_len = align_up(range.offset + range.length) - aligned_begin;
+    buffers.push_back(make_aligned_buffer(aligned_len));
+    reqs.push_back(
+        {range.file->fd_, buffers.back().get(), aligned_len, aligned_begin});
+  }
+
+  std::vector<int> io_res(ranges.size(), -ENOSYS);
+  auto &ring = IoUring::thread_local_ring();
+  if (ring.valid()) {
+    io_res = ring.read_batch(reqs);
+  }
+
+  std::vector<std::vector<uint8_t>> results;
+  results.reserve(ranges.size());
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    size_t offset = ranges[i].offset;
+    size_t length = ranges[i].length;
+    size_t need = offset + length - reqs[i].offset;
+    size_t got = io_res[i] < 0 ? 0 : static_cast<size_t>(io_res[i]);
+    if (got < need) {
+      // io_uring 不可用或者短读, 回退到同步 pread
+      got = pread_full(reqs[i].fd, buffers[i].get(), reqs[i].length,
+                       reqs[i].offset);
+      if (got < need) {
+        throw std::runtime_error("Failed to read from file");
+      }
+    }
+    const uint8_t *begin = buffers[i].get() + (offset - reqs[i].offset);
+    results.emplace_back(begin, begin + length);
+  }
+  return results;
+}
+
+bool DirectFile::sync() {
+  if (write_fd_ == -1) {
+    return fd_ != -1;
+  }
+  if (fdatasync(write_fd_) == -1) {
+    return false;
+  }
+  // 数据已经落盘, 丢弃写入时留下的 page cache, 后续读只走 O_DIRECT
+  posix_fadvise(write_fd_, 0, 0, POSIX_FADV_DONTNEED);
+  return true;
+}
+
+bool DirectFile::remove() {
+  close();
+  return ::unlink(filename_.c_str()) == 0;
+}
+
+// ********************* private *********************
+
+bool DirectFile::open_write_fd() {
+  write_fd_ = ::open(filename_.c_str(), O_WRONLY);
+  return write_fd_ != -1;
+}
+} // namespace tiny_lsm
@@ -3,13 +3,32 @@
 #include <stdexcept>
 
 namespace tiny_lsm {
-FileObj::FileObj() : m_file(std::make_unique<StdFile>()) {}
+FileObj::FileObj()
+    : m_file(std::make_unique<StdFile>()), m_size(0), m_mode(FileIOMode::Std) {}
+
+FileObj::FileObj(FileIOMode mode) : m_size(0), m_mode(mode) {
+  switch (mode) {
+  case FileIOMode::Direct:
+    m_file = std::make_unique<DirectFile>();
+    break;
+  case FileIOMode::Mmap:
+    m_file = std::make_unique<MmapFile>(true);
+    break;
+  case FileIOMode::MmapAppend:
+    m_file = std::make_unique<MmapFile>(false);
+    break;
+  default:
+    m_file = std::make_unique<StdFile>();
+    break;
+  }
+}
 
 FileObj::~FileObj() = default;
 
 // 实现移动语义
 FileObj::FileObj(FileObj &&other) noexcept
-    : m_file(std::move(other.m_file)), m_size(other.m_size) {
+    : m_file(std::move(other.m_file)), m_size(other.m_size),
+      m_mode(other.m_mode) {
   other.m_size = 0;
 }
 
@@ -17,6 +36,7 @@ FileObj &FileObj::operator=(FileObj &&other) noexcept {
   if (this != &other) {
     m_file = std::move(other.m_file);
     m_size = other.m_size;
+    m_mode = other.m_mode;
     other.m_size = 0;
   }
   return *this;
@@ -24,12 +44,14 @@ FileObj &FileObj::operator=(FileObj &&other) noexcept {
 
 size_t FileObj::size() const { return m_file->size(); }
 
+FileIOMode FileObj::mode() const { return m_mode; }
+
 void FileObj::set_size(size_t size) { m_size = size; }
 
 void FileObj::del_file() { m_file->remove(); }
 FileObj FileObj::create_and_write(const std::string &path,
-                                  std::vector<uint8_t> buf) {
-  FileObj file_obj;
+                                  std::vector<uint8_t> buf, FileIOMode mode) {
+  FileObj file_obj(mode);
   if (!file_obj.m_file->create(path, buf)) {
     throw std::runtime_error("Failed to create or write file: " + path);
   }
@@ -37,18 +59,42 @@ FileObj FileObj::create_and_write(const std::string &path,
   // 同步到磁盘
   file_obj.m_file->sync();
 
-  return std::move(file_obj);
+  return file_obj;
 }
 
-FileObj FileObj::open(const std::string &path, bool create) {
-  FileObj file_obj;
+FileObj FileObj::open(const std::string &path, bool create,
+                      FileIOMode mode) {
+  FileObj file_obj(mode);
 
   // 打开文件
   if (!file_obj.m_file->open(path, create)) {
     throw std::runtime_error("Failed to open file: " + path);
   }
 
-  return std::move(file_obj);
+  return file_obj;
+}
+
+FileObj FileObj::reuse(const std::string &path) {
+  FileObj file_obj(FileIOMode::MmapAppend);
+  auto mmap_file = static_cast<MmapFile *>(file_obj.m_file.get());
+  if (!mmap_file->reuse(path)) {
+    throw std::runtime_error("Failed to reuse file: " + path);
+  }
+
+  return file_obj;
+}
+
+FileIOMode FileObj::io_mode_from_string(const std::string &mode) {
+  if (mode == "direct") {
+    return FileIOMode::Direct;
+  }
+  if (mode == "mmap") {
+    return FileIOMode::Mmap;
+  }
+  if (mode == "mmap_append") {
+    return FileIOMode::MmapAppend;
+  }
+  return FileIOMode::Std;
 }
 
 std::vector<uint8_t> FileObj::read_to_slice(size_t offset, size_t length) {
@@ -63,6 +109,69 @@ std::vector<uint8_t> FileObj::read_to_slice(size_t offset, size_t length) {
   return result;
 }
 
+std::vector<std::vector<uint8_t>>
+FileObj::read_batch(const std::vector<std::pair<size_t, size_t>> &ranges) {
+  size_t file_size = m_file->size();
+  for (auto &[offset, length] : ranges) {
+    if (offset + length > file_size) {
+      throw std::out_of_range("Read beyond file size");
+    }
+  }
+
+  if (auto direct = dynamic_cast<DirectFile *>(m_file.get())) {
+    return direct->read_batch(ranges);
+  }
+
+  std::vector<std::vector<uint8_t>> results;
+  results.reserve(ranges.size());
+  for (auto &[offset, length] : ranges) {
+    results.push_back(m_file->read(offset, length));
+  }
+  return results;
+}
+
+std::vector<std::vector<uint8_t>>
+FileObj::read_batch(const std::vector<FileReadRange> &ranges) {
+  std::vector<std::vector<uint8_t>> results(ranges.size());
+  std::vector<DirectReadRange> direct_ranges;
+  std::vector<size_t> direct_idx;
+
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    auto &range = ranges[i];
+    if (range.offset + range.length > range.file->m_file->size()) {
+      throw std::out_of_range("Read beyond file size");
+    }
+    if (auto direct = dynamic_cast<DirectFile *>(range.file->m_file.get())) {
+      direct_ranges.push_back({direct, range.offset, range.length});
+      direct_idx.push_back(i);
+    } else {
+      results[i] = range.file->m_file->read(range.offset, range.length);
+    }
+  }
+
+  if (!direct_ranges.empty()) {
+    auto direct_results = DirectFile::read_batch(direct_ranges);
+    for (size_t i = 0; i < direct_idx.size(); ++i) {
+      results[direct_idx[i]] = std::move(direct_results[i]);
+    }
+  }
+  return results;
+}
+
+std::shared_ptr<const uint8_t> FileObj::view(size_t offset, size_t length) {
+  if (offset + length > m_file->size()) {
+    throw std::out_of_range("Read beyond file size");
+  }
+  if (auto mmap_file = dynamic_cast<MmapFile *>(m_file.get())) {
+    return mmap_file->view(offset, length);
+  }
+  return nullptr;
+}
+
+void FileObj::advise(size_t offset, size_t length, FileAccessHint hint) {
+  m_file->advise(offset, length, hint);
+}
+
 uint8_t FileObj::read_uint8(size_t offset) {
   // 检查边界
   if (offset + sizeof(uint8_t) > m_file->size()) {
@@ -133,4 +242,19 @@ bool FileObj::append(std::vector<uint8_t> &buf) {
 }
 
 bool FileObj::sync() { return m_file->sync(); }
+
+bool FileObj::preallocate(size_t size) {
+  if (auto mmap_file = dynamic_cast<MmapFile *>(m_file.get())) {
+    return mmap_file->preallocate(size);
+  }
+  return true;
+}
+
+bool FileObj::sync_range(size_t offset, size_t length, bool async) {
+  if (auto mmap_file = dynamic_cast<MmapFile *>(m_file.get())) {
+    return mmap_file->sync_range(offset, length, async);
+  }
+  // 其他后端不支持按区间回写, 异步请求直接忽略
+  return async ? true : m_file->sync();
+}
 } // namespace tiny_lsm
\ No newline at end of file
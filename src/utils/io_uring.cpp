@@ -0,0 +1,209 @@
+#include "../../include/utils/io_uring.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace tiny_lsm {
+
+namespace {
+int sys_io_uring_setup(unsigned entries, io_uring_params *params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sys_io_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete,
+                       unsigned flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit,
+                                  min_complete, flags, nullptr, 0));
+}
+
+template <typename T> T *ring_field(void *base, uint32_t offset) {
+  return reinterpret_cast<T *>(static_cast<uint8_t *>(base) + offset);
+}
+} // namespace
+
+IoUring::IoUring(unsigned entries) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+
+  ring_fd_ = sys_io_uring_setup(entries, &params);
+  if (ring_fd_ < 0) {
+    // 老内核(ENOSYS)或者容器禁用了 io_uring(EPERM), 由调用者回退到 pread
+    ring_fd_ = -1;
+    return;
+  }
+  sq_entries_ = params.sq_entries;
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+
+  sq_ring_ptr_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ring_ptr_ == MAP_FAILED) {
+    sq_ring_ptr_ = nullptr;
+    release();
+    return;
+  }
+
+  if (single_mmap) {
+    cq_ring_ptr_ = sq_ring_ptr_;
+  } else {
+    cq_ring_ptr_ =
+        mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ring_ptr_ == MAP_FAILED) {
+      cq_ring_ptr_ = nullptr;
+      release();
+      return;
+    }
+  }
+
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    release();
+    return;
+  }
+  sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+  sq_head_ = ring_field<unsigned>(sq_ring_ptr_, params.sq_off.head);
+  sq_tail_ = ring_field<unsigned>(sq_ring_ptr_, params.sq_off.tail);
+  sq_mask_ = ring_field<unsigned>(sq_ring_ptr_, params.sq_off.ring_mask);
+  sq_array_ = ring_field<unsigned>(sq_ring_ptr_, params.sq_off.array);
+  cq_head_ = ring_field<unsigned>(cq_ring_ptr_, params.cq_off.head);
+  cq_tail_ = ring_field<unsigned>(cq_ring_ptr_, params.cq_off.tail);
+  cq_mask_ = ring_field<unsigned>(cq_ring_ptr_, params.cq_off.ring_mask);
+  cqes_ = ring_field<io_uring_cqe>(cq_ring_ptr_, params.cq_off.cqes);
+}
+
+IoUring::~IoUring() { release(); }
+
+void IoUring::release() {
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_size_);
+    sqes_ = nullptr;
+  }
+  if (cq_ring_ptr_ != nullptr && cq_ring_ptr_ != sq_ring_ptr_) {
+    munmap(cq_ring_ptr_, cq_ring_size_);
+  }
+  cq_ring_ptr_ = nullptr;
+  if (sq_ring_ptr_ != nullptr) {
+    munmap(sq_ring_ptr_, sq_ring_size_);
+    sq_ring_ptr_ = nullptr;
+  }
+  if (ring_fd_ >= 0) {
+    ::close(ring_fd_);
+    ring_fd_ = -1;
+  }
+}
+
+std::vector<int> IoUring::read_batch(const std::vector<IoReadRequest> &reqs) {
+  std::vector<int> results(reqs.size(), -EIO);
+  if (!valid()) {
+    std::fill(results.begin(), results.end(), -ENOSYS);
+    return results;
+  }
+
+  // 请求数可能超过提交队列的容量, 分批提交
+  size_t next = 0;
+  while (next < reqs.size()) {
+    unsigned batch =
+        static_cast<unsigned>(std::min<size_t>(sq_entries_, reqs.size() - next));
+
+    // 我们是提交队列唯一的生产者, tail 只会被当前线程修改
+    unsigned tail = *sq_tail_;
+    for (unsigned i = 0; i < batch; ++i) {
+      const auto &req = reqs[next + i];
+      unsigned idx = tail & *sq_mask_;
+      io_uring_sqe *sqe = &sqes_[idx];
+      memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = IORING_OP_READ;
+      sqe->fd = req.fd;
+      sqe->addr = reinterpret_cast<uint64_t>(req.buf);
+      sqe->len = static_cast<uint32_t>(req.length);
+      sqe->off = req.offset;
+      sqe->user_data = next + i;
+      sq_array_[idx] = idx;
+      ++tail;
+    }
+    __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+
+    // 内核可能只接收一部分 sqe (返回值小于 to_submit), 没被接收的 sqe 留在
+    // 提交队列中, 下一次 enter 时继续提交; 只等待已经被接收的请求完成
+    unsigned submitted = 0;
+    unsigned completed = 0;
+    int err = 0;
+    unsigned head = *cq_head_;
+    while (completed < submitted || (err == 0 && submitted < batch)) {
+      bool stalled = false;
+      if (err == 0 && submitted < batch) {
+        int ret = sys_io_uring_enter(ring_fd_, batch - submitted, 0, 0);
+        if (ret > 0) {
+          submitted += static_cast<unsigned>(ret);
+        } else if (ret == 0) {
+          err = -EAGAIN;
+        } else if (errno == EINTR) {
+          continue;
+        } else if ((errno == EAGAIN || errno == EBUSY) &&
+                   completed < submitted) {
+          // 内核暂时没有资源, 先等待已提交的请求完成再重试
+          stalled = true;
+        } else {
+          err = -errno;
+        }
+      }
+
+      // 收割完成事件
+      unsigned cq_tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+      while (head != cq_tail) {
+        io_uring_cqe *cqe = &cqes_[head & *cq_mask_];
+        results[cqe->user_data] = cqe->res;
+        ++head;
+        ++completed;
+      }
+      __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+
+      // 还有未提交的 sqe 时不等待, 直接回到循环开头继续提交
+      if (completed < submitted &&
+          (err != 0 || stalled || submitted == batch)) {
+        int ret = sys_io_uring_enter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS);
+        if (ret < 0 && errno != EINTR) {
+          // 已提交的读还会写入调用者的缓冲区, 不能释放 ring,
+          // 只能轮询完成队列直到它们全部完成
+          sched_yield();
+        }
+      }
+    }
+
+    if (err != 0) {
+      // 已提交的请求都已完成, 此时释放 ring 不会再有写入调用者缓冲区的读,
+      // 未提交和之后的请求由调用者回退到 pread
+      for (unsigned i = submitted; i < batch; ++i) {
+        results[next + i] = err;
+      }
+      release();
+      for (size_t i = next + batch; i < reqs.size(); ++i) {
+        results[i] = -ENOSYS;
+      }
+      return results;
+    }
+
+    next += batch;
+  }
+  return results;
+}
+
+IoUring &IoUring::thread_local_ring() {
+  thread_local IoUring ring;
+  return ring;
+}
+} // namespace tiny_lsm
@@ -1,4 +1,5 @@
 #include "../../include/utils/mmap_file.h"
+#include <algorithm>
 #include <cstdint>
 #include <errno.h>
 #include <stdexcept>
@@ -8,11 +9,25 @@
 
 namespace tiny_lsm {
 
+namespace {
+size_t page_size() {
+  static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  return size;
+}
+
+size_t page_align_down(size_t value) { return value & ~(page_size() - 1); }
+
+size_t page_align_up(size_t value) {
+  return page_align_down(value + page_size() - 1);
+}
+} // namespace
+
 bool MmapFile::open(const std::string &filename, bool create) {
+  close();
   filename_ = filename;
 
   // 打开或创建文件
-  int flags = O_RDWR;
+  int flags = read_only_ ? O_RDONLY : O_RDWR;
   if (create) {
     flags |= O_CREAT;
   }
@@ -29,117 +44,290 @@ bool MmapFile::open(const std::string &filename, bool create) {
     return false;
   }
   file_size_ = st.st_size;
+  capacity_ = st.st_size;
 
   // 映射文件
-  if (file_size_ > 0) {
-    mapped_data_ =
-        mmap(nullptr, file_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
-    if (mapped_data_ == MAP_FAILED) {
-      close();
-      return false;
-    }
+  if (file_size_ > 0 && !map(file_size_)) {
+    close();
+    return false;
   }
 
   return true;
 }
 
-bool MmapFile::create(const std::string &filename, std::vector<uint8_t> &buf) {
-  // 创建文件，设置大小并映射到内存
-  if (!create_and_map(filename, buf.size())) {
-    // throw std::runtime_error("Failed to create or wrte file: " + filename);
+bool MmapFile::reuse(const std::string &filename) {
+  close();
+  filename_ = filename;
+  if (read_only_) {
     return false;
   }
 
-  // 写入数据
-  memcpy(this->data(), buf.data(), buf.size());
-  this->sync();
+  fd_ = ::open(filename.c_str(), O_RDWR);
+  if (fd_ == -1) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd_, &st) == -1) {
+    close();
+    return false;
+  }
+  file_size_ = 0;
+  capacity_ = st.st_size;
+  keep_capacity_ = true;
+  if (capacity_ > 0 && !map(capacity_)) {
+    close();
+    return false;
+  }
   return true;
 }
+
+bool MmapFile::preallocate(size_t size) {
+  if (read_only_ || fd_ == -1) {
+    return false;
+  }
+  keep_capacity_ = true;
+  size = page_align_up(size);
+  return size <= capacity_ || extend(size);
+}
+
+bool MmapFile::create(const std::string &filename, std::vector<uint8_t> &buf) {
+  close();
+  filename_ = filename;
+
+  if (read_only_) {
+    // 只读映射不能写入, 先用 pwrite 落盘再映射
+    fd_ = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ == -1) {
+      return false;
+    }
+    size_t done = 0;
+    while (done < buf.size()) {
+      ssize_t n = ::pwrite(fd_, buf.data() + done, buf.size() - done, done);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        close();
+        return false;
+      }
+      done += static_cast<size_t>(n);
+    }
+    if (fdatasync(fd_) == -1) {
+      close();
+      return false;
+    }
+    file_size_ = buf.size();
+    capacity_ = buf.size();
+    if (file_size_ > 0 && !map(file_size_)) {
+      close();
+      return false;
+    }
+    return true;
+  }
+
+  // 创建文件并写入初始数据
+  fd_ = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd_ == -1) {
+    return false;
+  }
+  if (!buf.empty() && !write(0, buf.data(), buf.size())) {
+    close();
+    return false;
+  }
+  return sync();
+}
+
 void MmapFile::close() {
-  if (mapped_data_ != nullptr && mapped_data_ != MAP_FAILED) {
-    munmap(mapped_data_, file_size_);
-    mapped_data_ = nullptr;
+  if (fd_ != -1 && !read_only_) {
+    sync();
   }
 
+  // 只读模式下 Block 可能仍然持有视图, 映射在最后一个引用释放时解除
+  region_.reset();
+
   if (fd_ != -1) {
+    if (!read_only_ && !keep_capacity_ && capacity_ > file_size_) {
+      // 截断预分配但没有使用的尾部
+      if (ftruncate(fd_, file_size_) == -1) {
+        // 截断失败只会多占用一些空间, 不影响已写入的数据
+      }
+    }
     ::close(fd_);
     fd_ = -1;
   }
 
   file_size_ = 0;
+  capacity_ = 0;
+  dirty_begin_ = dirty_end_ = 0;
+  writeback_end_ = 0;
+  keep_capacity_ = false;
 }
 
 bool MmapFile::write(size_t offset, const void *data, size_t size) {
-  // 调整文件大小以包含 offset + size
-  size_t new_size = offset + size;
-  if (ftruncate(fd_, new_size) == -1) {
+  if (read_only_ || fd_ == -1) {
     return false;
   }
-
-  // 如果已经映射，先解除映射
-  if (mapped_data_ != nullptr && mapped_data_ != MAP_FAILED) {
-    munmap(mapped_data_, file_size_);
+  if (size == 0) {
+    return true;
   }
 
-  // 重新映射
-  file_size_ = new_size;
-  mapped_data_ =
-      mmap(nullptr, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
-  if (mapped_data_ == MAP_FAILED) {
-    mapped_data_ = nullptr;
+  size_t end = offset + size;
+  if (!reserve(end)) {
     return false;
   }
 
   // 写入数据
-  memcpy(static_cast<uint8_t *>(mapped_data_) + offset, data, size);
-  this->sync();
+  memcpy(this->data() + offset, data, size);
+  file_size_ = std::max(file_size_, end);
+
+  // 记录脏区间
+  if (dirty_begin_ == dirty_end_) {
+    dirty_begin_ = offset;
+    dirty_end_ = end;
+  } else {
+    dirty_begin_ = std::min(dirty_begin_, offset);
+    dirty_end_ = std::max(dirty_end_, end);
+  }
+
+  // 追加写时每累计一段数据就提交一次异步回写
+  if (end >= writeback_end_ + kWritebackChunk) {
+    size_t begin = std::max(dirty_begin_, writeback_end_);
+    sync_range(begin, end - begin, true);
+    writeback_end_ = end;
+  }
   return true;
 }
 
 std::vector<uint8_t> MmapFile::read(size_t offset, size_t length) {
-  // 从映射的内存中复制数据
-  // 创建结果vector
+  if (offset + length > file_size_) {
+    throw std::out_of_range("Read beyond file size");
+  }
   // 创建结果vector
   std::vector<uint8_t> result(length);
 
   // 从映射的内存中复制数据
-  const uint8_t *data = static_cast<const uint8_t *>(this->data());
-  memcpy(result.data(), data + offset, length);
+  if (length > 0) {
+    memcpy(result.data(), this->data() + offset, length);
+  }
 
   return result;
 }
 
+std::shared_ptr<const uint8_t> MmapFile::view(size_t offset,
+                                              size_t length) const {
+  if (!read_only_ || region_ == nullptr || offset + length > file_size_) {
+    return nullptr;
+  }
+  // 别名构造: 指向 offset 处, 但与整个映射共享引用计数
+  return std::shared_ptr<const uint8_t>(region_, data() + offset);
+}
+
 bool MmapFile::sync() {
-  if (mapped_data_ != nullptr && mapped_data_ != MAP_FAILED) {
-    return msync(mapped_data_, file_size_, MS_SYNC) == 0;
+  if (read_only_ || region_ == nullptr || dirty_begin_ == dirty_end_) {
+    return true;
+  }
+  if (!sync_range(dirty_begin_, dirty_end_ - dirty_begin_, false)) {
+    return false;
   }
+  dirty_begin_ = dirty_end_ = 0;
   return true;
 }
 
+bool MmapFile::sync_range(size_t offset, size_t length, bool async) {
+  if (read_only_ || region_ == nullptr || length == 0) {
+    return true;
+  }
+  size_t begin = page_align_down(offset);
+  size_t end = std::min(offset + length, capacity_);
+  if (begin >= end) {
+    return true;
+  }
+  if (async) {
+    // Linux 上 msync(MS_ASYNC) 不会真正发起回写, 使用 sync_file_range 代替
+    return sync_file_range(fd_, begin, end - begin, SYNC_FILE_RANGE_WRITE) ==
+           0;
+  }
+  return msync(data() + begin, end - begin, MS_SYNC) == 0;
+}
+
+bool MmapFile::remove() {
+  close();
+  return ::unlink(filename_.c_str()) == 0;
+}
+
+void MmapFile::advise(size_t offset, size_t length, FileAccessHint hint) {
+  if (region_ == nullptr || offset >= file_size_) {
+    return;
+  }
+  int advice;
+  switch (hint) {
+  case FileAccessHint::Random:
+    advice = MADV_RANDOM;
+    break;
+  case FileAccessHint::Sequential:
+    advice = MADV_SEQUENTIAL;
+    break;
+  case FileAccessHint::WillNeed:
+    advice = MADV_WILLNEED;
+    break;
+  default:
+    advice = MADV_NORMAL;
+    break;
+  }
+  // madvise 要求起始地址按页对齐
+  size_t begin = page_align_down(offset);
+  size_t end = std::min(offset + length, file_size_);
+  madvise(data() + begin, end - begin, advice);
+}
+
 // ********************* private *********************
 
-bool MmapFile::create_and_map(const std::string &path, size_t size) {
-  // 创建并打开文件
-  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
-  if (fd_ == -1) {
+bool MmapFile::map(size_t size) {
+  int prot = read_only_ ? PROT_READ : PROT_READ | PROT_WRITE;
+  void *ptr = mmap(nullptr, size, prot, MAP_SHARED, fd_, 0);
+  if (ptr == MAP_FAILED) {
     return false;
   }
+  region_ = std::make_shared<MmapRegion>(static_cast<uint8_t *>(ptr), size);
+  return true;
+}
 
-  // 先调整文件大小
-  if (ftruncate(fd_, size) == -1) {
-    close();
-    return false;
+bool MmapFile::reserve(size_t size) {
+  if (size <= capacity_) {
+    return true;
   }
 
-  // 映射与文件大小相同的空间
-  mapped_data_ =
-      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
-  if (mapped_data_ == MAP_FAILED) {
-    close();
+  // 按当前容量成倍扩展, 并限制单次扩展的范围
+  size_t grow = std::clamp(capacity_, kMinGrowSize, kMaxGrowSize);
+  return extend(page_align_up(std::max(size, capacity_ + grow)));
+}
+
+bool MmapFile::extend(size_t new_capacity) {
+  // 预分配磁盘空间, 文件系统不支持时退化为 ftruncate
+  int ret = fallocate(fd_, 0, capacity_, new_capacity - capacity_);
+  if (ret == -1 && (errno == EOPNOTSUPP || errno == ENOSYS)) {
+    ret = ftruncate(fd_, new_capacity);
+  }
+  if (ret == -1) {
     return false;
   }
 
-  file_size_ = size;
+  if (region_ == nullptr) {
+    if (!map(new_capacity)) {
+      return false;
+    }
+  } else {
+    // 读写模式不会对外暴露视图, 可以安全地移动映射
+    void *ptr = mremap(region_->addr, region_->length, new_capacity,
+                       MREMAP_MAYMOVE);
+    if (ptr == MAP_FAILED) {
+      return false;
+    }
+    region_->addr = static_cast<uint8_t *>(ptr);
+    region_->length = new_capacity;
+  }
+
+  capacity_ = new_capacity;
   return true;
 }
-} // namespace tiny_lsm
\ No newline at end of file
+} // namespace tiny_lsm
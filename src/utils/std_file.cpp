@@ -1,4 +1,6 @@
 #include "../../include/utils/std_file.h"
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace tiny_lsm {
 
@@ -31,6 +33,10 @@ void StdFile::close() {
     sync();
     file_.close();
   }
+  int fd = advise_fd_.exchange(-1);
+  if (fd >= 0) {
+    ::close(fd);
+  }
 }
 
 size_t StdFile::size() {
@@ -63,4 +69,35 @@ bool StdFile::sync() {
 }
 
 bool StdFile::remove() { return std::remove(filename_.c_str()) == 0; }
+
+void StdFile::advise(size_t offset, size_t length, FileAccessHint hint) {
+  int fd = advise_fd_.load();
+  if (fd < 0) {
+    fd = ::open(filename_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      return;
+    }
+    int expected = -1;
+    if (!advise_fd_.compare_exchange_strong(expected, fd)) {
+      ::close(fd);
+      fd = expected;
+    }
+  }
+  int advice;
+  switch (hint) {
+  case FileAccessHint::Random:
+    advice = POSIX_FADV_RANDOM;
+    break;
+  case FileAccessHint::Sequential:
+    advice = POSIX_FADV_SEQUENTIAL;
+    break;
+  case FileAccessHint::WillNeed:
+    advice = POSIX_FADV_WILLNEED;
+    break;
+  default:
+    advice = POSIX_FADV_NORMAL;
+    break;
+  }
+  posix_fadvise(fd, offset, length, advice);
+}
 } // namespace tiny_lsm
\ No newline at end of file
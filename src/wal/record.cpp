@@ -1,42 +1,210 @@
 // src/wal/record.cpp
 
 #include "../../include/wal/record.h"
+#include "../../include/utils/crc32c.h"
 #include <cstddef>
 #include <cstring>
 
 namespace tiny_lsm {
 
+namespace {
+constexpr size_t kFrameHeaderSize = 2 * sizeof(uint32_t);
+
+void put_varint(std::vector<uint8_t> &buf, uint64_t value) {
+  while (value >= 0x80) {
+    buf.push_back(static_cast<uint8_t>(value) | 0x80);
+    value >>= 7;
+  }
+  buf.push_back(static_cast<uint8_t>(value));
+}
+
+bool get_varint(const uint8_t *&p, const uint8_t *end, uint64_t &value) {
+  value = 0;
+  for (int shift = 0; shift < 64 && p < end; shift += 7) {
+    uint8_t byte = *p++;
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool get_bytes(const uint8_t *&p, const uint8_t *end, std::string &out) {
+  uint64_t len;
+  if (!get_varint(p, end, len) || len > static_cast<size_t>(end - p)) {
+    return false;
+  }
+  out.assign(reinterpret_cast<const char *>(p), len);
+  p += len;
+  return true;
+}
+
+// 帧的校验和以日志文件序号为种子
+uint32_t frame_crc(const uint8_t *payload, size_t len, uint64_t log_seq) {
+  return crc32c(payload, len, crc32c(&log_seq, sizeof(log_seq)));
+}
+} // namespace
+
+// 解码 [p, end) 中的所有记录, 追加到 records; 遇到不完整的记录时返回 false
+bool Record::decode_records(const uint8_t *p, const uint8_t *end,
+                            std::vector<Record> &records) {
+  while (p < end) {
+    Record record;
+    uint8_t op = *p++;
+    if (op > static_cast<uint8_t>(OperationType::DELETE)) {
+      return false;
+    }
+    record.operation_type_ = static_cast<OperationType>(op);
+    if (!get_varint(p, end, record.tranc_id_)) {
+      return false;
+    }
+
+    bool has_key = record.operation_type_ == OperationType::PUT ||
+                   record.operation_type_ == OperationType::DELETE;
+    bool has_value = record.operation_type_ == OperationType::PUT;
+    if ((has_key && !get_bytes(p, end, record.key_)) ||
+        (has_value && !get_bytes(p, end, record.value_))) {
+      return false;
+    }
+    records.push_back(std::move(record));
+  }
+  return true;
+}
+
 Record Record::createRecord(uint64_t tranc_id) {
-  // TODO: Lab 5.3 实现创建事务的Record
-  return {};
+  // (done)TODO: Lab 5.3 实现创建事务的Record
+  Record record;
+  record.operation_type_ = OperationType::CREATE;
+  record.tranc_id_ = tranc_id;
+  return record;
 }
 Record Record::commitRecord(uint64_t tranc_id) {
-  // TODO: Lab 5.3 实现提交事务的Record
-  return {};
+  // (done)TODO: Lab 5.3 实现提交事务的Record
+  Record record;
+  record.operation_type_ = OperationType::COMMIT;
+  record.tranc_id_ = tranc_id;
+  return record;
 }
 Record Record::rollbackRecord(uint64_t tranc_id) {
-  // TODO: Lab 5.3 实现回滚事务的Record
-  return {};
+  // (done)TODO: Lab 5.3 实现回滚事务的Record
+  Record record;
+  record.operation_type_ = OperationType::ROLLBACK;
+  record.tranc_id_ = tranc_id;
+  return record;
 }
 Record Record::putRecord(uint64_t tranc_id, const std::string &key,
                          const std::string &value) {
-  // TODO: Lab 5.3 实现插入键值对的Record
-  return {};
+  // (done)TODO: Lab 5.3 实现插入键值对的Record
+  Record record;
+  record.operation_type_ = OperationType::PUT;
+  record.tranc_id_ = tranc_id;
+  record.key_ = key;
+  record.value_ = value;
+  return record;
 }
 Record Record::deleteRecord(uint64_t tranc_id, const std::string &key) {
-  // TODO: Lab 5.3 实现删除键值对的Record
-  return {};
+  // (done)TODO: Lab 5.3 实现删除键值对的Record
+  Record record;
+  record.operation_type_ = OperationType::DELETE;
+  record.tranc_id_ = tranc_id;
+  record.key_ = key;
+  return record;
+}
+
+void Record::batchRecords(uint64_t tranc_id, const WriteBatch &batch,
+                          std::vector<Record> &records) {
+  records.reserve(records.size() + batch.count());
+  batch.for_each([&](WriteBatch::OpType type, const std::string &key,
+                     const std::string &value) {
+    if (type == WriteBatch::OpType::Put) {
+      records.push_back(putRecord(tranc_id, key, value));
+    } else {
+      records.push_back(deleteRecord(tranc_id, key));
+    }
+  });
+}
+
+// 记录的编码格式 (v2), 长度和事务 id 都使用 varint:
+// | operation_type(8) | tranc_id(varint) |
+// | key_len(varint) | key | value_len(varint) | value |
+// 其中 key 只有 PUT 和 DELETE 有, value 只有 PUT 有
+void Record::encode(std::vector<uint8_t> &buf) const {
+  // (done)TODO: Lab 5.3 实现Record的编码函数
+  buf.push_back(static_cast<uint8_t>(operation_type_));
+  put_varint(buf, tranc_id_);
+
+  if (operation_type_ == OperationType::PUT ||
+      operation_type_ == OperationType::DELETE) {
+    put_varint(buf, key_.size());
+    buf.insert(buf.end(), key_.begin(), key_.end());
+  }
+
+  if (operation_type_ == OperationType::PUT) {
+    put_varint(buf, value_.size());
+    buf.insert(buf.end(), value_.begin(), value_.end());
+  }
 }
 
 std::vector<uint8_t> Record::encode() const {
-  // TODO: Lab 5.3 实现Record的编码函数
-  return {};
+  std::vector<uint8_t> buf;
+  encode(buf);
+  return buf;
 }
 
 std::vector<Record> Record::decode(const std::vector<uint8_t> &data) {
-  // TODO: Lab 5.3 实现Record的解码函数
-  return {};
+  // (done)TODO: Lab 5.3 实现Record的解码函数
+  std::vector<Record> records;
+  decode_records(data.data(), data.data() + data.size(), records);
+  return records;
+}
+
+void Record::encode_frame(const std::vector<Record> &records,
+                          std::vector<uint8_t> &buf, uint64_t log_seq) {
+  size_t header_pos = buf.size();
+  buf.resize(header_pos + kFrameHeaderSize);
+  for (auto &record : records) {
+    record.encode(buf);
+  }
+
+  uint32_t payload_len = buf.size() - header_pos - kFrameHeaderSize;
+  uint32_t crc = frame_crc(buf.data() + header_pos + kFrameHeaderSize,
+                           payload_len, log_seq);
+  memcpy(buf.data() + header_pos, &payload_len, sizeof(uint32_t));
+  memcpy(buf.data() + header_pos + sizeof(uint32_t), &crc, sizeof(uint32_t));
 }
+
+std::vector<Record> Record::decode_frames(const uint8_t *data, size_t size,
+                                          uint64_t log_seq) {
+  std::vector<Record> records;
+  size_t pos = 0;
+  while (pos + kFrameHeaderSize <= size) {
+    uint32_t payload_len, crc;
+    memcpy(&payload_len, data + pos, sizeof(uint32_t));
+    memcpy(&crc, data + pos + sizeof(uint32_t), sizeof(uint32_t));
+    pos += kFrameHeaderSize;
+
+    if (payload_len == 0 || payload_len > size - pos ||
+        frame_crc(data + pos, payload_len, log_seq) != crc) {
+      break;
+    }
+
+    // 校验通过的帧内容是完整的, 解码失败说明格式有误, 同样停止
+    size_t decoded = records.size();
+    if (!decode_records(data + pos, data + pos + payload_len, records)) {
+      records.erase(records.begin() + decoded, records.end());
+      break;
+    }
+    pos += payload_len;
+  }
+  return records;
+}
+
+std::vector<Record> Record::decode_frames(const std::vector<uint8_t> &data,
+                                          uint64_t log_seq) {
+  return decode_frames(data.data(), data.size(), log_seq);
+}
+
 void Record::print() const {
   std::cout << "Record: tranc_id=" << tranc_id_
             << ", operation_type=" << static_cast<int>(operation_type_)
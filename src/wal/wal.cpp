@@ -1,8 +1,11 @@
 // src/wal/wal.cpp
 
 #include "../../include/wal/wal.h"
+#include "spdlog/spdlog.h"
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <vector>
@@ -12,32 +15,371 @@ namespace tiny_lsm {
 // 从零开始的初始化流程
 WAL::WAL(const std::string &log_dir, size_t buffer_size,
          uint64_t max_finished_tranc_id, uint64_t clean_interval,
-         uint64_t file_size_limit) {
-  // TODO Lab 5.4 : 实现WAL的初始化流程
+         uint64_t file_size_limit, WalSyncMode sync_mode,
+         uint64_t sync_interval_ms, size_t recycle_num)
+    : file_size_limit_(file_size_limit), buffer_size_(buffer_size),
+      max_finished_tranc_id_(max_finished_tranc_id),
+      clean_interval_(clean_interval), log_dir_(log_dir), active_seq_(0),
+      group_(std::make_shared<CommitGroup>()),
+      sync_mode_(sync_mode == WalSyncMode::Default ? WalSyncMode::Always
+                                                   : sync_mode),
+      sync_interval_ms_(sync_interval_ms), has_unsynced_(false),
+      recycle_num_(recycle_num) {
+  // (done)TODO Lab 5.4 : 实现WAL的初始化流程
+  if (!std::filesystem::exists(log_dir_)) {
+    std::filesystem::create_directories(log_dir_);
+  }
+
+  // 上次运行留下的回收文件继续复用, 超出数量限制的删除
+  for (const auto &entry : std::filesystem::directory_iterator(log_dir_)) {
+    if (entry.is_regular_file() &&
+        entry.path().filename().string().rfind("recycle.", 0) == 0) {
+      if (recycle_files_.size() < recycle_num_) {
+        recycle_files_.push_back(entry.path().string());
+      } else {
+        std::filesystem::remove(entry.path());
+      }
+    }
+  }
+
+  // 新的日志文件排在已有的文件之后, 旧文件留给 recover 和清理线程处理
+  auto files = list_log_files(log_dir_);
+  open_log_file(files.empty() ? 0 : files.back().first + 1);
+
+  writer_thread_ = std::thread(&WAL::writer, this);
+  cleaner_thread_ = std::thread(&WAL::cleaner, this);
+  if (sync_mode_ == WalSyncMode::Periodic) {
+    syncer_thread_ = std::thread(&WAL::syncer, this);
+  }
 }
 
 WAL::~WAL() {
-  // TODO Lab 5.4 : 实现WAL的清理流程
+  // (done)TODO Lab 5.4 : 实现WAL的清理流程
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  writer_cv_.notify_all();
+  cleaner_cv_.notify_all();
+  syncer_cv_.notify_all();
+
+  if (syncer_thread_.joinable()) {
+    syncer_thread_.join();
+  }
+  // 写线程退出前会把缓冲区中剩余的记录写入并刷盘
+  if (writer_thread_.joinable()) {
+    writer_thread_.join();
+  }
+  if (cleaner_thread_.joinable()) {
+    cleaner_thread_.join();
+  }
+}
+
+WalSyncMode WAL::sync_mode_from_string(const std::string &mode) {
+  if (mode == "periodic") {
+    return WalSyncMode::Periodic;
+  }
+  if (mode == "none") {
+    return WalSyncMode::None;
+  }
+  return WalSyncMode::Always;
 }
 
 std::map<uint64_t, std::vector<Record>>
 WAL::recover(const std::string &log_dir, uint64_t max_flushed_tranc_id) {
-  // TODO: Lab 5.5 检查需要重放的WAL日志
-  return {};
+  // (done)TODO: Lab 5.5 检查需要重放的WAL日志
+  std::map<uint64_t, std::vector<Record>> tranc_records;
+  if (!std::filesystem::exists(log_dir)) {
+    return tranc_records;
+  }
+
+  // 多个日志文件并行解码, 每个线程按序号领取下一个文件
+  auto files = list_log_files(log_dir);
+  std::vector<std::vector<Record>> file_records(files.size());
+  std::atomic<size_t> next_file{0};
+  auto decode_worker = [&]() {
+    for (size_t i = next_file++; i < files.size(); i = next_file++) {
+      auto &[seq, path] = files[i];
+      file_records[i] = read_log_file(path, seq, max_flushed_tranc_id);
+    }
+  };
+
+  size_t worker_num = std::min<size_t>(
+      files.size(), std::max(1u, std::thread::hardware_concurrency()));
+  std::vector<std::future<void>> workers;
+  for (size_t i = 1; i < worker_num; ++i) {
+    workers.push_back(std::async(std::launch::async, decode_worker));
+  }
+  decode_worker();
+  for (auto &worker : workers) {
+    worker.get();
+  }
+
+  // 按文件顺序合并, 同一事务内的记录保持写入顺序
+  for (auto &records : file_records) {
+    for (auto &record : records) {
+      tranc_records[record.getTrancId()].push_back(std::move(record));
+    }
+  }
+  return tranc_records;
 }
 
 void WAL::log(const std::vector<Record> &records, bool force_flush) {
-  // TODO Lab 5.4 : 实现WAL的写入流程
+  // (done)TODO Lab 5.4 : 实现WAL的写入流程
+  auto future = enqueue(records, force_flush, force_flush);
+  if (force_flush) {
+    future.wait();
+  }
+}
+
+std::shared_future<bool> WAL::log_async(const std::vector<Record> &records,
+                                        WalSyncMode mode) {
+  if (mode == WalSyncMode::Default) {
+    mode = sync_mode_;
+  }
+  return enqueue(records, true, mode == WalSyncMode::Always);
+}
+
+std::shared_future<bool> WAL::enqueue(const std::vector<Record> &records,
+                                      bool write, bool sync) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  log_buffer_.insert(log_buffer_.end(), records.begin(), records.end());
+  auto future = group_->future;
+  group_->need_write |= write;
+  group_->need_sync |= sync;
+  bool notify = write || sync || log_buffer_.size() >= buffer_size_;
+  lock.unlock();
+
+  if (notify) {
+    writer_cv_.notify_one();
+  }
+  return future;
 }
 
 // commit 时 强制写入
 void WAL::flush() {
-  // TODO Lab 5.4 : 强制刷盘
-  // ? 取决于你的 log 实现是否使用了缓冲区或者异步的实现
+  // (done)TODO Lab 5.4 : 强制刷盘
+  enqueue({}, true, true).wait();
+}
+
+void WAL::set_max_finished_tranc_id(uint64_t tranc_id) {
+  uint64_t cur = max_finished_tranc_id_.load();
+  while (cur < tranc_id &&
+         !max_finished_tranc_id_.compare_exchange_weak(cur, tranc_id)) {
+  }
+}
+
+void WAL::writer() {
+  while (true) {
+    std::vector<Record> records;
+    std::shared_ptr<CommitGroup> group;
+    bool stopping;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      writer_cv_.wait(lock, [this] {
+        return stop_ || group_->need_write || group_->need_sync ||
+               log_buffer_.size() >= buffer_size_;
+      });
+      if (stop_ && log_buffer_.empty() && !group_->need_write &&
+          !group_->need_sync) {
+        // 没有等待中的数据, 未刷盘的部分在关闭文件时刷盘
+        group_->promise.set_value(true);
+        return;
+      }
+
+      // 取走当前批次, 后续的提交者进入新的批次,
+      // 在本批次写盘期间积累的记录会在下一轮合并写入
+      records.swap(log_buffer_);
+      group = std::move(group_);
+      group_ = std::make_shared<CommitGroup>();
+      stopping = stop_;
+    }
+
+    // 整个批次编码为一帧, 只有一个帧头和一次校验
+    // 只有写线程会切换日志文件, 编码时的序号就是写入的文件的序号
+    std::vector<uint8_t> data;
+    if (!records.empty()) {
+      Record::encode_frame(records, data, active_seq_.load());
+    }
+
+    bool ok;
+    try {
+      ok = write_group(data, group->need_sync || stopping);
+    } catch (const std::exception &e) {
+      spdlog::error("WAL--writer: {}", e.what());
+      ok = false;
+    }
+    group->promise.set_value(ok);
+  }
+}
+
+void WAL::syncer() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    syncer_cv_.wait_for(lock, std::chrono::milliseconds(sync_interval_ms_),
+                        [this] { return stop_; });
+    if (stop_) {
+      return;
+    }
+    // 刷盘仍然由写线程完成, 这里只是发起一次只刷盘的批次
+    if (has_unsynced_.load()) {
+      group_->need_sync = true;
+      writer_cv_.notify_one();
+    }
+  }
 }
 
 void WAL::cleaner() {
-  // TODO Lab 5.4 : 实现WAL的清理线程
+  // (done)TODO Lab 5.4 : 实现WAL的清理线程
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cleaner_cv_.wait_for(lock, std::chrono::seconds(clean_interval_),
+                         [this] { return stop_; });
+    if (stop_) {
+      return;
+    }
+    lock.unlock();
+
+    try {
+      // 按序号从小到大清理, 遇到仍需保留的文件就停止,
+      // 保证剩下的文件在序号上是连续的
+      for (auto &[seq, path] : list_log_files(log_dir_)) {
+        if (seq >= active_seq_.load()) {
+          break;
+        }
+        uint64_t max_tranc_id = 0;
+        for (auto &record : read_log_file(path, seq, 0)) {
+          max_tranc_id = std::max(max_tranc_id, record.getTrancId());
+        }
+        if (max_tranc_id > max_finished_tranc_id_.load()) {
+          break;
+        }
+        retire_log_file(seq, path);
+      }
+    } catch (const std::exception &e) {
+      spdlog::error("WAL--cleaner: {}", e.what());
+    }
+
+    lock.lock();
+  }
+}
+
+// ********************* private *********************
+
+bool WAL::write_group(std::vector<uint8_t> &data, bool sync) {
+  if (!data.empty() && !log_file_.append(data)) {
+    return false;
+  }
+  if (sync) {
+    if (!log_file_.sync()) {
+      return false;
+    }
+    has_unsynced_ = false;
+  } else if (!data.empty()) {
+    has_unsynced_ = true;
+  }
+
+  if (log_file_.size() >= file_size_limit_) {
+    // 切换前保证旧文件已经完整落盘
+    if (!sync && !log_file_.sync()) {
+      return false;
+    }
+    has_unsynced_ = false;
+    open_log_file(active_seq_.load() + 1);
+  }
+  return true;
+}
+
+void WAL::open_log_file(uint64_t seq) {
+  std::string path = get_log_path(log_dir_, seq);
+  std::string recycled;
+  {
+    std::lock_guard<std::mutex> lock(recycle_mtx_);
+    if (!recycle_files_.empty()) {
+      recycled = std::move(recycle_files_.front());
+      recycle_files_.pop_front();
+    }
+  }
+
+  if (!recycled.empty()) {
+    // 重命名后覆盖写, 文件中残留的旧帧序号不同, 恢复时无法通过校验
+    std::filesystem::rename(recycled, path);
+    log_file_ = FileObj::reuse(path);
+    spdlog::debug("WAL--open_log_file: reused {} as {}", recycled, path);
+  } else {
+    // WAL 只追加写, 使用可写 mmap 并一次性预分配到文件大小限制,
+    // 追加写不会修改文件大小, 刷盘时不需要同步元数据
+    log_file_ = FileObj::open(path, true, FileIOMode::MmapAppend);
+    if (!log_file_.preallocate(file_size_limit_)) {
+      spdlog::warn("WAL--open_log_file: failed to preallocate {}", path);
+    }
+  }
+  active_log_path_ = path;
+  active_seq_ = seq;
 }
 
-} // namespace tiny_lsm
\ No newline at end of file
+void WAL::retire_log_file(uint64_t seq, const std::string &path) {
+  std::lock_guard<std::mutex> lock(recycle_mtx_);
+  if (recycle_files_.size() < recycle_num_) {
+    std::string recycle_path = get_recycle_path(log_dir_, seq);
+    std::filesystem::rename(path, recycle_path);
+    recycle_files_.push_back(recycle_path);
+    spdlog::debug("WAL--cleaner: recycled {}", path);
+  } else {
+    std::filesystem::remove(path);
+    spdlog::debug("WAL--cleaner: removed {}", path);
+  }
+}
+
+std::vector<Record> WAL::read_log_file(const std::string &path, uint64_t seq,
+                                       uint64_t max_flushed_tranc_id) {
+  // 只读映射整个文件, 直接在映射区域上解码
+  auto file = FileObj::open(path, false, FileIOMode::Mmap);
+  size_t size = file.size();
+  if (size == 0) {
+    return {};
+  }
+  file.advise(0, size, FileAccessHint::Sequential);
+  auto data = file.view(0, size);
+  auto records = Record::decode_frames(data.get(), size, seq);
+
+  // 已经刷入 sst 的事务不需要重放
+  records.erase(std::remove_if(records.begin(), records.end(),
+                               [&](const Record &record) {
+                                 return record.getTrancId() <=
+                                        max_flushed_tranc_id;
+                               }),
+                records.end());
+  return records;
+}
+
+std::string WAL::get_log_path(const std::string &log_dir, uint64_t seq) {
+  return log_dir + "/wal." + std::to_string(seq);
+}
+
+std::string WAL::get_recycle_path(const std::string &log_dir, uint64_t seq) {
+  return log_dir + "/recycle." + std::to_string(seq);
+}
+
+std::vector<std::pair<uint64_t, std::string>>
+WAL::list_log_files(const std::string &log_dir) {
+  std::vector<std::pair<uint64_t, std::string>> files;
+  for (const auto &entry : std::filesystem::directory_iterator(log_dir)) {
+    if (!entry.is_regular_file()) {
+      continue;
+    }
+    std::string filename = entry.path().filename().string();
+    if (filename.rfind("wal.", 0) != 0) {
+      continue;
+    }
+    std::string seq_str = filename.substr(4);
+    if (seq_str.empty() ||
+        !std::all_of(seq_str.begin(), seq_str.end(), ::isdigit)) {
+      continue;
+    }
+    files.emplace_back(std::stoull(seq_str), entry.path().string());
+  }
+  std::sort(files.begin(), files.end());
+  return files;
+}
+} // namespace tiny_lsm
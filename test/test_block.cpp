@@ -339,6 +339,44 @@ TEST_F(BlockTest, TrancIteratorTest) {
   EXPECT_EQ(results, expected_data);
 }
 
+// 测试 seek / seek_for_prev 以及反向遍历
+TEST_F(BlockTest, SeekAndReverseTest) {
+  auto block = std::make_shared<Block>(4096);
+  block->add_entry("key1", "value1", 1, false);
+  block->add_entry("key2", "value222", 3, false);
+  block->add_entry("key2", "value22", 2, false);
+  block->add_entry("key2", "value2", 1, false);
+  block->add_entry("key3", "value3", 1, false);
+  block->add_entry("key4", "value4", 2, false);
+  block->add_entry("key5", "value5", 3, false);
+
+  // 事务 id 为 2 时 key5 不可见, key2 的可见版本为 value22
+  BlockIterator it(block, 0, 2);
+  it.seek("key2");
+  EXPECT_EQ(*it, std::make_pair(std::string("key2"), std::string("value22")));
+  it.seek("key21");
+  EXPECT_EQ(it->first, "key3");
+  it.seek_for_prev("key9");
+  EXPECT_EQ(it->first, "key4");
+  it.seek_for_prev("key2");
+  EXPECT_EQ(it->second, "value22");
+  --it;
+  EXPECT_EQ(it->first, "key1");
+  --it;
+  EXPECT_TRUE(it.is_end());
+  it.seek("key6");
+  EXPECT_TRUE(it.is_end());
+
+  std::vector<std::pair<std::string, std::string>> expected_data = {
+      {"key5", "value5"}, {"key4", "value4"}, {"key3", "value3"}, {"key2", "value222"}, {"key1", "value1"}};
+  std::vector<std::pair<std::string, std::string>> results;
+  BlockIterator rit(block, 0, 0);
+  for (rit.seek_to_last(); !rit.is_end(); --rit) {
+    results.emplace_back(rit->first, rit->second);
+  }
+  EXPECT_EQ(results, expected_data);
+}
+
 // 包含了事务的谓词迭代器
 TEST_F(BlockTest, TrancPredicateTest) {
   std::vector<uint8_t> encoded_p;
@@ -415,6 +453,51 @@ TEST_F(BlockTest, TrancPredicateTest) {
   EXPECT_EQ(results, expected);
 }
 
+// 测试 hash 索引
+TEST_F(BlockTest, HashIndexTest) {
+  Block hash_block(8192, 0.75);
+  Block plain_block(8192);
+  // 每个 key 写入 3 个版本, 事务 id 从大到小
+  for (int i = 0; i < 60; i++) {
+    char key_buf[16];
+    snprintf(key_buf, sizeof(key_buf), "key%03d", i * 2);
+    for (uint64_t tranc_id = 3; tranc_id >= 1; tranc_id--) {
+      std::string value = "value" + std::to_string(i) + "_" + std::to_string(tranc_id);
+      ASSERT_TRUE(hash_block.add_entry(key_buf, value, tranc_id, false));
+      ASSERT_TRUE(plain_block.add_entry(key_buf, value, tranc_id, false));
+    }
+  }
+  // 编码后的大小包含 hash 索引
+  auto encoded = hash_block.encode(true);
+  EXPECT_EQ(encoded.size(), hash_block.cur_size() + sizeof(uint32_t));
+  EXPECT_GT(hash_block.cur_size(), plain_block.cur_size());
+
+  auto decoded = Block::decode(encoded, true);
+  auto plain = Block::decode(plain_block.encode(true), true);
+  EXPECT_EQ(decoded->size(), 180);
+  EXPECT_EQ(decoded->cur_size(), hash_block.cur_size());
+  for (int i = 0; i < 120; i++) {
+    char key_buf[16];
+    snprintf(key_buf, sizeof(key_buf), "key%03d", i);
+    for (uint64_t tranc_id = 0; tranc_id <= 4; tranc_id++) {
+      EXPECT_EQ(decoded->get_value_binary(key_buf, tranc_id), plain->get_value_binary(key_buf, tranc_id))
+          << key_buf << " " << tranc_id;
+    }
+  }
+  EXPECT_EQ(decoded->get_value_binary("key010", 2).value(), "value5_2");
+  EXPECT_EQ(decoded->get_value_binary("key010", 0).value(), "value5_3");
+  EXPECT_FALSE(decoded->get_value_binary("key011", 0).has_value());
+  EXPECT_FALSE(decoded->get_value_binary("", 0).has_value());
+  EXPECT_FALSE(decoded->get_value_binary("zzz", 0).has_value());
+
+  // 迭代器不受 hash 索引影响
+  size_t cnt = 0;
+  for (auto it = decoded->begin(0); it != decoded->end(); ++it) {
+    cnt++;
+  }
+  EXPECT_EQ(cnt, 60);
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   init_spdlog_file();
@@ -1,10 +1,18 @@
 #include "../include/consts.h"
+#include "../include/iterator/scan.h"
 #include "../include/logger/logger.h"
 #include "../include/lsm/engine.h"
+#include "../include/lsm/level_iterator.h"
+#include "../include/sst/sst_scan.h"
+#include <algorithm>
 #include <cstdlib>
 #include <filesystem>
 #include <gtest/gtest.h>
 #include <iostream>
+#include <map>
+#include <random>
+#include <tuple>
+#include <vector>
 
 using namespace ::tiny_lsm;
 
@@ -78,6 +86,178 @@ TEST_F(CompactTest, Persistence) {
   EXPECT_FALSE(lsm.get("nonexistent").has_value());
 }
 
+// 测试 compaction 使用的扫描组合: 多路归并、两路归并和只保留最新版本
+TEST_F(CompactTest, ScanMerge) {
+  using Entry = std::tuple<std::string, std::string, uint64_t>;
+  auto make_key = [](int i) {
+    std::string num = std::to_string(i);
+    return "key" + std::string(4 - num.size(), '0') + num;
+  };
+  auto cache = std::make_shared<BlockCache>(64, 2);
+  size_t sst_id = 0;
+  auto build = [&](const std::vector<Entry> &entries) {
+    SSTBuilder builder(256, true);
+    for (auto &[k, v, t] : entries) {
+      builder.add(k, v, t);
+    }
+    size_t id = sst_id++;
+    return builder.build(id, test_dir + "/sst_" + std::to_string(id), cache);
+  };
+
+  // 两个 L0 的 sst 相互重叠, 新的在前; 下一层的两个 sst 不重叠
+  // 按 (key, 事务 id 从大到小) 记录所有版本
+  std::map<std::string, std::map<uint64_t, std::string, std::greater<>>>
+      versions;
+  std::vector<std::vector<Entry>> inputs(4);
+  for (int i = 0; i < 1000; ++i) {
+    auto key = make_key(i);
+    // 下一层: 前后两半分别在两个 sst 中
+    inputs[2 + (i >= 500)].emplace_back(key, "old" + key, 1);
+    if (i % 3 == 0) {
+      inputs[1].emplace_back(key, "mid" + key, 2);
+    }
+    if (i % 5 == 0) {
+      // 新的 L0 中每隔 10 个 key 删除一个
+      inputs[0].emplace_back(key, i % 10 == 0 ? "" : "new" + key, 3);
+    }
+  }
+  for (auto &entries : inputs) {
+    for (auto &[k, v, t] : entries) {
+      versions[k][t] = v;
+    }
+  }
+  std::vector<std::shared_ptr<SST>> ssts;
+  for (auto &entries : inputs) {
+    ssts.push_back(build(entries));
+  }
+
+  auto merged = [&]() {
+    std::vector<SstScan> l0;
+    l0.emplace_back(ssts[0], 2);
+    l0.emplace_back(ssts[1], 2);
+    return TwoMergeScan(MergeScan<SstScan>(std::move(l0)),
+                        LevelScan({ssts[2], ssts[3]}, 2));
+  };
+
+  // 输出所有版本, 按 key 升序, 同一个 key 按事务 id 从大到小
+  std::vector<Entry> expected;
+  for (auto &[k, vs] : versions) {
+    for (auto &[t, v] : vs) {
+      expected.emplace_back(k, v, t);
+    }
+  }
+  std::vector<Entry> all;
+  for (auto scan = merged(); scan.valid(); scan.next()) {
+    all.emplace_back(scan.key(), scan.value(), scan.tranc_id());
+  }
+  EXPECT_EQ(all, expected);
+
+  for (bool drop_deleted : {false, true}) {
+    std::vector<Entry> newest_expected;
+    for (auto &[k, vs] : versions) {
+      auto &[t, v] = *vs.begin();
+      if (!drop_deleted || !v.empty()) {
+        newest_expected.emplace_back(k, v, t);
+      }
+    }
+    std::vector<Entry> newest;
+    for (NewestScan scan(merged(), drop_deleted); scan.valid(); scan.next()) {
+      newest.emplace_back(scan.key(), scan.value(), scan.tranc_id());
+    }
+    EXPECT_EQ(newest, newest_expected);
+  }
+
+  // 有快照时, 相邻两个快照之间每个 key 保留最新的一个版本
+  std::vector<uint64_t> snapshots = {1, 2};
+  auto stripe = [&](uint64_t t) {
+    return std::lower_bound(snapshots.begin(), snapshots.end(), t) -
+           snapshots.begin();
+  };
+  for (bool drop_deleted : {false, true}) {
+    std::vector<Entry> retained_expected;
+    for (auto &[k, vs] : versions) {
+      long last_stripe = -1;
+      for (auto &[t, v] : vs) {
+        if (stripe(t) == last_stripe) {
+          continue;
+        }
+        last_stripe = stripe(t);
+        if (!(drop_deleted && last_stripe == 0 && v.empty())) {
+          retained_expected.emplace_back(k, v, t);
+        }
+      }
+    }
+    std::vector<Entry> retained;
+    for (NewestScan scan(merged(), drop_deleted, snapshots); scan.valid();
+         scan.next()) {
+      retained.emplace_back(scan.key(), scan.value(), scan.tranc_id());
+    }
+    EXPECT_EQ(retained, retained_expected);
+  }
+}
+
+// 测试 L0 -> L1 的 compaction: 覆盖写和删除后点查、遍历和重启的结果一致
+TEST_F(CompactTest, L0ToL1) {
+  std::map<std::string, std::string> kvs;
+  std::mt19937 rng(7);
+  auto make_key = [](int i) {
+    std::string num = std::to_string(i);
+    return "key" + std::string(5 - num.size(), '0') + num;
+  };
+  auto check = [&](LSMEngine &engine) {
+    for (int i = 0; i < 20000; i += 13) {
+      auto key = make_key(i);
+      auto res = engine.get(key, 0);
+      auto it = kvs.find(key);
+      if (it == kvs.end()) {
+        EXPECT_FALSE(res.has_value()) << key;
+      } else {
+        ASSERT_TRUE(res.has_value()) << key;
+        EXPECT_EQ(res->first, it->second);
+      }
+    }
+    auto expected = kvs.begin();
+    for (auto it = engine.begin(0); it != engine.end(); ++it) {
+      ASSERT_NE(expected, kvs.end());
+      EXPECT_EQ(it->first, expected->first);
+      EXPECT_EQ(it->second, expected->second);
+      ++expected;
+    }
+    EXPECT_EQ(expected, kvs.end());
+  };
+
+  {
+    auto engine = std::make_shared<LSMEngine>(test_dir);
+    for (int round = 0; round < 10; ++round) {
+      for (int j = 0; j < 2000; ++j) {
+        auto key = make_key(rng() % 20000);
+        if (rng() % 8 == 0) {
+          engine->remove(key, 0);
+          kvs.erase(key);
+        } else {
+          auto value = "value" + std::to_string(round) + "_" + key;
+          engine->put(key, value, 0);
+          kvs[key] = value;
+        }
+      }
+      engine->flush();
+    }
+    EXPECT_FALSE(engine->level_sst_ids[1].empty());
+    EXPECT_LT(engine->level_sst_ids[0].size(), 4);
+    // L1 的 sst 按 key 有序且互不重叠
+    auto &l1 = engine->level_sst_ids[1];
+    for (size_t i = 1; i < l1.size(); ++i) {
+      EXPECT_LT(engine->ssts[l1[i - 1]]->get_last_key(),
+                engine->ssts[l1[i]]->get_first_key());
+    }
+    check(*engine);
+  }
+
+  auto engine = std::make_shared<LSMEngine>(test_dir);
+  EXPECT_FALSE(engine->level_sst_ids[1].empty());
+  check(*engine);
+}
+
 int main(int argc, char **argv) {
   testing::InitGoogleTest(&argc, argv);
   init_spdlog_file();
@@ -1,10 +1,16 @@
 #include "../include/logger/logger.h"
 #include "../include/lsm/engine.h"
 #include "../include/lsm/level_iterator.h"
+#include "../include/lsm/two_merge_iterator.h"
+#include "../include/memtable/memtable.h"
 #include <cstdlib>
 #include <filesystem>
 #include <gtest/gtest.h>
+#include <map>
+#include <random>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <unordered_map>
 
 using namespace ::tiny_lsm;
@@ -27,6 +33,12 @@ protected:
     }
   }
 
+  // 辅助函数：生成按数字顺序排列的 key, 数字补零到 width 位
+  static std::string make_key(int i, size_t width = 4) {
+    std::string num = std::to_string(i);
+    return "key" + std::string(width - num.size(), '0') + num;
+  }
+
   std::string test_dir;
 };
 
@@ -138,6 +150,48 @@ TEST_F(LSMTest, MixedOperations) {
   EXPECT_FALSE(lsm.get("key1").has_value());
 }
 
+// 批量查询需要同时覆盖 memtable 和多个 sst
+TEST_F(LSMTest, GetBatch) {
+  LSMEngine lsm(test_dir);
+
+  // 分三批写入并刷盘, 后一批覆盖前一批的部分 key
+  for (int round = 0; round < 3; round++) {
+    for (int i = round * 100; i < 400; i++) {
+      std::string key = "key" + std::to_string(i);
+      lsm.put(key, "value" + std::to_string(i) + "_" + std::to_string(round),
+              round + 1);
+    }
+    lsm.flush();
+  }
+  // 部分 key 在 sst 中被删除, 部分 key 只在 memtable 中
+  for (int i = 0; i < 400; i += 7) {
+    lsm.remove("key" + std::to_string(i), 4);
+  }
+  lsm.flush();
+  lsm.put("key_mem", "value_mem", 5);
+
+  std::vector<std::string> keys;
+  for (int i = 0; i < 400; i += 3) {
+    keys.push_back("key" + std::to_string(i));
+  }
+  keys.push_back("key_mem");
+  keys.push_back("nonexistent");
+
+  auto results = lsm.get_batch(keys, 0);
+  ASSERT_EQ(results.size(), keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    EXPECT_EQ(results[i].first, keys[i]);
+    EXPECT_EQ(results[i].second, lsm.get(keys[i], 0)) << keys[i];
+  }
+  EXPECT_EQ(results[keys.size() - 2].second->first, "value_mem");
+  EXPECT_FALSE(results.back().second.has_value());
+
+  // 事务 id 为 1 时只能看到第一批写入
+  results = lsm.get_batch({"key0", "key350"}, 1);
+  EXPECT_EQ(results[0].second->first, "value0_0");
+  EXPECT_EQ(results[1].second->first, "value350_0");
+}
+
 // Test iterator functionality
 TEST_F(LSMTest, IteratorOperations) {
   LSM lsm(test_dir);
@@ -335,6 +389,731 @@ TEST_F(LSMTest, Recover) {
     }
   }
 }
+// 事务 id 较小的事务在更大的事务 id 刷盘之后才提交, 崩溃恢复时仍然要重放它的日志
+TEST_F(LSMTest, RecoverTransactionCommittedAfterFlush) {
+  {
+    LSM lsm(test_dir);
+    auto tran_ctx = lsm.begin_tran(IsolationLevel::REPEATABLE_READ);
+    // 普通写入的事务 id 大于 tran_ctx, 刷盘后 sst 中的最大事务 id 超过了 tran_ctx
+    lsm.put("key_flushed", "value");
+    lsm.flush();
+
+    for (int i = 0; i < 10; i++) {
+      tran_ctx->put(make_key(i), "value" + std::to_string(i));
+    }
+    // 只写入 WAL, 模拟写入 memtable 之前的崩溃
+    EXPECT_TRUE(tran_ctx->commit(true));
+  }
+  {
+    LSM lsm(test_dir);
+    EXPECT_EQ(lsm.get("key_flushed"), "value");
+    for (int i = 0; i < 10; i++) {
+      EXPECT_EQ(lsm.get(make_key(i)), "value" + std::to_string(i));
+    }
+  }
+}
+
+// Test that the SST layout is restored from the MANIFEST, and rebuilt from a
+// directory scan when the MANIFEST is missing
+TEST_F(LSMTest, Manifest) {
+  size_t sst_num;
+  size_t next_sst_id;
+  {
+    LSMEngine engine(test_dir);
+    for (int i = 0; i < 5; ++i) {
+      for (int j = 0; j < 1000; ++j) {
+        std::string key = "key" + std::to_string(i * 1000 + j);
+        engine.put(key, "value" + std::to_string(i * 1000 + j), 0);
+      }
+      engine.flush();
+    }
+    // 第 5 次刷盘前 L0 的 4 个 sst 被 compact 到 L1
+    sst_num = engine.ssts.size();
+    next_sst_id = engine.next_sst_id;
+    EXPECT_EQ(engine.level_sst_ids[0].size(), 1);
+    EXPECT_EQ(engine.level_sst_ids[1].size(), sst_num - 1);
+  }
+  EXPECT_TRUE(std::filesystem::exists(Manifest::get_manifest_path(test_dir)));
+
+  for (int round = 0; round < 2; ++round) {
+    if (round == 1) {
+      std::filesystem::remove(Manifest::get_manifest_path(test_dir));
+    }
+    LSMEngine engine(test_dir);
+    EXPECT_EQ(engine.ssts.size(), sst_num);
+    EXPECT_EQ(engine.next_sst_id, next_sst_id);
+    EXPECT_EQ(engine.level_sst_ids[0].size(), 1);
+    for (int i = 0; i < 5000; i += 7) {
+      std::string key = "key" + std::to_string(i);
+      auto res = engine.get(key, 0);
+      ASSERT_TRUE(res.has_value());
+      EXPECT_EQ(res->first, "value" + std::to_string(i));
+    }
+    EXPECT_TRUE(std::filesystem::exists(Manifest::get_manifest_path(test_dir)));
+  }
+}
+
+// 测试 FileIndexer: 逐层缩小范围的二分与暴力查找的结果一致
+TEST_F(LSMTest, FileIndexer) {
+  std::mt19937 rng(42);
+  // 每层的 sst 覆盖不重叠的随机区间, 越往下的层 sst 越多
+  std::map<size_t, std::deque<size_t>> level_sst_ids;
+  std::unordered_map<size_t, std::shared_ptr<SST>> ssts;
+  size_t sst_id = 0;
+  for (size_t level = 1; level <= 6; ++level) {
+    int pos = 0;
+    for (size_t i = 0; i < level * 8; ++i) {
+      int first = pos + rng() % 200;
+      int last = first + rng() % 200;
+      pos = last + 1;
+      ssts[sst_id] = SST::create_sst_with_meta_only(
+          sst_id, 0, make_key(first, 6), make_key(last, 6), nullptr);
+      level_sst_ids[level].push_back(sst_id++);
+    }
+  }
+  FileIndexer indexer;
+  indexer.build(level_sst_ids, ssts);
+
+  auto check = [&](const std::string &key) {
+    std::vector<std::shared_ptr<SST>> expected;
+    for (auto &[level, sst_ids] : level_sst_ids) {
+      for (auto id : sst_ids) {
+        if (ssts[id]->get_first_key() <= key &&
+            key <= ssts[id]->get_last_key()) {
+          expected.push_back(ssts[id]);
+        }
+      }
+    }
+    std::vector<std::shared_ptr<SST>> res;
+    indexer.find(key, res);
+    EXPECT_EQ(res, expected) << key;
+  };
+
+  // 顺序访问命中上一次的 sst, 随机访问走二分
+  for (int i = 0; i < 20000; i += 3) {
+    check(make_key(i, 6));
+  }
+  for (int i = 0; i < 5000; ++i) {
+    check(make_key(rng() % 20000, 6));
+  }
+  check("a");
+  check("z");
+}
+
+// 测试 Level_Iterator 归并多个 key 重叠的 L0 sst 和 memtable
+TEST_F(LSMTest, LevelIteratorMerge) {
+  LSM lsm(test_dir);
+  std::map<std::string, std::string> reference;
+  // 每一轮写入的 key 与之前的轮次重叠, 新的 sst 覆盖或者删除旧的值
+  for (int round = 0; round < 4; round++) {
+    for (int i = round; i < 400; i += 2) {
+      auto key = make_key(i);
+      if (i % 7 == round) {
+        lsm.remove(key);
+        reference.erase(key);
+      } else {
+        auto value = "value" + std::to_string(i) + "_" + std::to_string(round);
+        lsm.put(key, value);
+        reference[key] = value;
+      }
+    }
+    lsm.flush();
+  }
+  // 只在 memtable 中的 key
+  for (int i = 400; i < 450; i++) {
+    lsm.put(make_key(i), "mem" + std::to_string(i));
+    reference[make_key(i)] = "mem" + std::to_string(i);
+  }
+  // 只在 memtable 中的删除标记需要屏蔽 sst 中的旧值
+  for (int i = 1; i < 400; i += 50) {
+    lsm.remove(make_key(i));
+    reference.erase(make_key(i));
+  }
+
+  {
+    auto it = lsm.begin(0);
+    auto ref_it = reference.begin();
+    for (; it != lsm.end() && ref_it != reference.end(); ++it, ++ref_it) {
+      EXPECT_EQ(it->first, ref_it->first);
+      EXPECT_EQ(it->second, ref_it->second);
+    }
+    EXPECT_TRUE(it == lsm.end());
+    EXPECT_TRUE(ref_it == reference.end());
+  }
+
+  // 只读取开头的几个 key
+  auto it = lsm.begin(0);
+  auto ref_it = reference.begin();
+  for (int i = 0; i < 10; i++, ++it, ++ref_it) {
+    ASSERT_TRUE(it.is_valid());
+    EXPECT_EQ((*it).first, ref_it->first);
+  }
+}
+
+TEST_F(LSMTest, LevelIteratorSeekAndReverse) {
+  LSM lsm(test_dir);
+  std::map<std::string, std::string> reference;
+  // 偶数 key 分两轮写入 sst, 再在 memtable 中覆盖或者删除一部分
+  for (int round = 0; round < 2; round++) {
+    for (int i = round * 2; i < 600; i += 4) {
+      lsm.put(make_key(i), "sst" + std::to_string(i));
+      reference[make_key(i)] = "sst" + std::to_string(i);
+    }
+    lsm.flush();
+  }
+  for (int i = 0; i < 600; i += 6) {
+    if (i % 12 == 0) {
+      lsm.remove(make_key(i));
+      reference.erase(make_key(i));
+    } else {
+      lsm.put(make_key(i), "mem" + std::to_string(i));
+      reference[make_key(i)] = "mem" + std::to_string(i);
+    }
+  }
+
+  // 反向遍历全部数据
+  {
+    auto it = lsm.begin(0);
+    it.seek_for_prev(make_key(9999));
+    for (auto ref_it = reference.rbegin(); ref_it != reference.rend();
+         ++ref_it, --it) {
+      ASSERT_TRUE(it.is_valid());
+      EXPECT_EQ(it->first, ref_it->first);
+      EXPECT_EQ(it->second, ref_it->second);
+    }
+    EXPECT_FALSE(it.is_valid());
+  }
+
+  std::mt19937 rng(43);
+  auto it = lsm.begin(0);
+  for (int round = 0; round < 200; round++) {
+    auto target = make_key(rng() % 620);
+    if (rng() % 2 == 0) {
+      it.seek(target);
+      auto exp = reference.lower_bound(target);
+      if (exp == reference.end()) {
+        EXPECT_FALSE(it.is_valid()) << target;
+        continue;
+      }
+      ASSERT_TRUE(it.is_valid()) << target;
+      EXPECT_EQ(it->first, exp->first) << target;
+    } else {
+      it.seek_for_prev(target);
+      auto exp = reference.upper_bound(target);
+      if (exp == reference.begin()) {
+        EXPECT_FALSE(it.is_valid()) << target;
+        continue;
+      }
+      --exp;
+      ASSERT_TRUE(it.is_valid()) << target;
+      EXPECT_EQ(it->first, exp->first) << target;
+    }
+    // 从定位点出发随机地前后移动, 方向切换时不能重复或者遗漏 key
+    auto exp = reference.find(it->first);
+    for (int step = 0; step < 8; step++) {
+      if (rng() % 2 == 0) {
+        ++it;
+        ++exp;
+        if (exp == reference.end()) {
+          EXPECT_FALSE(it.is_valid());
+          break;
+        }
+      } else {
+        --it;
+        if (exp == reference.begin()) {
+          EXPECT_FALSE(it.is_valid());
+          break;
+        }
+        --exp;
+      }
+      ASSERT_TRUE(it.is_valid());
+      EXPECT_EQ(it->first, exp->first);
+      EXPECT_EQ(it->second, exp->second);
+    }
+  }
+}
+
+TEST_F(LSMTest, TwoMergeIteratorSeekAndReverse) {
+  // a 中的数据比 b 新, key 相同时取 a 的值
+  MemTable newer, older;
+  std::map<std::string, std::string> reference;
+  for (int i = 0; i < 100; i += 2) {
+    older.put("key" + std::to_string(100 + i), "old" + std::to_string(i), 0);
+    reference["key" + std::to_string(100 + i)] = "old" + std::to_string(i);
+  }
+  for (int i = 0; i < 100; i += 3) {
+    newer.put("key" + std::to_string(100 + i), "new" + std::to_string(i), 0);
+    reference["key" + std::to_string(100 + i)] = "new" + std::to_string(i);
+  }
+  auto a = std::make_shared<MemTableIterator>(newer.begin(0));
+  auto b = std::make_shared<MemTableIterator>(older.begin(0));
+  TwoMergeIterator it(a, b, 0);
+
+  auto exp = reference.begin();
+  for (; it.is_valid(); ++it, ++exp) {
+    ASSERT_NE(exp, reference.end());
+    EXPECT_EQ(it->first, exp->first);
+    EXPECT_EQ(it->second, exp->second);
+  }
+  EXPECT_EQ(exp, reference.end());
+
+  it.seek_for_prev("key999");
+  for (auto rexp = reference.rbegin(); rexp != reference.rend(); ++rexp, --it) {
+    ASSERT_TRUE(it.is_valid());
+    EXPECT_EQ(it->first, rexp->first);
+    EXPECT_EQ(it->second, rexp->second);
+  }
+  EXPECT_FALSE(it.is_valid());
+
+  // 在 a 和 b 共有的 key 上切换方向
+  it.seek("key106");
+  ASSERT_TRUE(it.is_valid());
+  EXPECT_EQ(it->second, "new6");
+  --it;
+  ASSERT_TRUE(it.is_valid());
+  EXPECT_EQ(it->first, "key104");
+  ++it;
+  ASSERT_TRUE(it.is_valid());
+  EXPECT_EQ(it->first, "key106");
+  ++it;
+  ASSERT_TRUE(it.is_valid());
+  EXPECT_EQ(it->first, "key108");
+}
+
+TEST_F(LSMTest, RangeIterator) {
+  LSM lsm(test_dir);
+  std::map<std::string, std::string> reference;
+  // 每轮写入一段互相重叠的 key, 形成多个 L0 sst, 最后一轮留在 memtable 中
+  for (int round = 0; round < 5; round++) {
+    for (int i = round * 150; i < round * 150 + 400; i += 3) {
+      if (i % 11 == round) {
+        lsm.remove(make_key(i));
+        reference.erase(make_key(i));
+      } else {
+        auto value = std::to_string(i) + "_" + std::to_string(round);
+        lsm.put(make_key(i), value);
+        reference[make_key(i)] = value;
+      }
+    }
+    if (round < 4) {
+      lsm.flush();
+    }
+  }
+
+  std::mt19937 rng(44);
+  for (int round = 0; round < 100; round++) {
+    int a = rng() % 1100, b = rng() % 1100;
+    auto lower = make_key(std::min(a, b));
+    auto upper = make_key(std::max(a, b));
+    auto exp_begin = reference.lower_bound(lower);
+    auto exp_end = reference.lower_bound(upper);
+
+    auto it = lsm.range(0, lower, upper);
+    auto exp = exp_begin;
+    for (; it != lsm.end() && exp != exp_end; ++it, ++exp) {
+      EXPECT_EQ(it->first, exp->first);
+      EXPECT_EQ(it->second, exp->second);
+    }
+    EXPECT_TRUE(it == lsm.end()) << lower << " " << upper;
+    EXPECT_TRUE(exp == exp_end) << lower << " " << upper;
+
+    // 范围之外的定位目标被限制在范围内
+    it.seek_for_prev(make_key(9999));
+    for (auto rexp = exp_end; rexp != exp_begin;) {
+      --rexp;
+      ASSERT_TRUE(it.is_valid()) << lower << " " << upper;
+      EXPECT_EQ(it->first, rexp->first);
+      --it;
+    }
+    EXPECT_FALSE(it.is_valid());
+    it.seek("a");
+    if (exp_begin == exp_end) {
+      EXPECT_FALSE(it.is_valid());
+    } else {
+      ASSERT_TRUE(it.is_valid());
+      EXPECT_EQ(it->first, exp_begin->first);
+    }
+  }
+}
+
+// 迭代器持有创建时的 Version, 迭代期间可以刷盘和 compact,
+// 被移除的 sst 文件在迭代器释放后才删除
+TEST_F(LSMTest, VersionPinsSsts) {
+  auto engine = std::make_shared<LSMEngine>(test_dir);
+  for (int i = 0; i < 1000; i++) {
+    engine->put("key" + std::to_string(i), "old", 1);
+  }
+  engine->flush();
+  ASSERT_EQ(engine->level_sst_ids[0].size(), 1);
+  size_t old_id = engine->level_sst_ids[0][0];
+  auto old_path = engine->get_sst_path(old_id, 0);
+
+  {
+    auto it = engine->begin(1);
+    // 覆盖所有 key 并刷盘, L0 超过阈值后 compact, 打开的迭代器不会阻塞它
+    for (int round = 0; round < 5; round++) {
+      for (int i = 0; i < 1000; i++) {
+        engine->put("key" + std::to_string(i), "new" + std::to_string(round),
+                    2 + round);
+      }
+      engine->flush();
+    }
+    EXPECT_FALSE(engine->level_sst_ids[1].empty());
+    EXPECT_EQ(engine->ssts.count(old_id), 0);
+    EXPECT_TRUE(std::filesystem::exists(old_path));
+
+    // compact 只保留了最新的版本, 迭代器依然读取创建时的 sst
+    size_t count = 0;
+    for (; it != engine->end(); ++it) {
+      EXPECT_EQ(it->second, "old");
+      count++;
+    }
+    EXPECT_EQ(count, 1000);
+  }
+  EXPECT_FALSE(std::filesystem::exists(old_path));
+
+  auto res = engine->get("key0", 0);
+  ASSERT_TRUE(res.has_value());
+  EXPECT_EQ(res->first, "new4");
+}
+
+// 快照读取创建时的数据, 释放前 compact 保留它能看到的版本
+TEST_F(LSMTest, Snapshot) {
+  LSM lsm(test_dir);
+  for (int i = 0; i < 1000; i++) {
+    lsm.put("key" + std::to_string(i), "old" + std::to_string(i));
+  }
+  lsm.flush();
+  auto snapshot = lsm.get_snapshot();
+
+  // 普通的读操作不分配事务 id
+  for (int i = 0; i < 100; i++) {
+    lsm.get("key" + std::to_string(i));
+  }
+  lsm.get_batch({"key0", "key1"});
+  {
+    auto snapshot2 = lsm.get_snapshot();
+    EXPECT_EQ(snapshot2.get_tranc_id(), snapshot.get_tranc_id());
+  }
+
+  // 覆盖和删除之后刷盘, L0 超过阈值后 compact
+  for (int round = 0; round < 5; round++) {
+    for (int i = 0; i < 1000; i++) {
+      if (i % 10 == 0) {
+        lsm.remove("key" + std::to_string(i));
+      } else {
+        lsm.put("key" + std::to_string(i), "new" + std::to_string(round));
+      }
+    }
+    lsm.flush();
+  }
+
+  for (int i = 0; i < 1000; i += 7) {
+    auto key = "key" + std::to_string(i);
+    auto res = lsm.get(key, snapshot);
+    ASSERT_TRUE(res.has_value()) << key;
+    EXPECT_EQ(*res, "old" + std::to_string(i));
+    res = lsm.get(key);
+    if (i % 10 == 0) {
+      EXPECT_FALSE(res.has_value()) << key;
+    } else {
+      ASSERT_TRUE(res.has_value()) << key;
+      EXPECT_EQ(*res, "new4");
+    }
+  }
+  auto batch = lsm.get_batch({"key0", "key1"}, snapshot);
+  EXPECT_EQ(batch[0].second, "old0");
+  EXPECT_EQ(batch[1].second, "old1");
+
+  size_t count = 0;
+  for (auto it = lsm.begin(snapshot); it != lsm.end(); ++it) {
+    EXPECT_EQ(it->second, "old" + it->first.substr(3));
+    count++;
+  }
+  EXPECT_EQ(count, 1000);
+}
+
+// 快照读取还在 memtable 中的覆盖和删除, 只能看到创建快照时已经结束的事务
+TEST_F(LSMTest, SnapshotMemtable) {
+  LSM lsm(test_dir);
+  lsm.put("key1", "v1");
+  lsm.put("key2", "v1");
+  lsm.put("key3", "v1");
+  auto snapshot = lsm.get_snapshot();
+
+  // 不刷盘, 新旧版本都在 memtable 中
+  lsm.put("key1", "v2");
+  lsm.remove("key2");
+  lsm.put("key4", "v2");
+  EXPECT_EQ(lsm.get("key1", snapshot), "v1");
+  EXPECT_EQ(lsm.get("key2", snapshot), "v1");
+  EXPECT_FALSE(lsm.get("key4", snapshot).has_value());
+  EXPECT_EQ(lsm.get("key1"), "v2");
+  EXPECT_FALSE(lsm.get("key2").has_value());
+
+  auto batch = lsm.get_batch({"key1", "key2", "key4"}, snapshot);
+  EXPECT_EQ(batch[0].second, "v1");
+  EXPECT_EQ(batch[1].second, "v1");
+  EXPECT_FALSE(batch[2].second.has_value());
+
+  std::vector<std::pair<std::string, std::string>> result;
+  for (auto it = lsm.begin(snapshot); it != lsm.end(); ++it) {
+    result.push_back(*it);
+  }
+  std::vector<std::pair<std::string, std::string>> answer{
+      {"key1", "v1"}, {"key2", "v1"}, {"key3", "v1"}};
+  EXPECT_EQ(result, answer);
+
+  // 还在进行中的事务之后结束的写入同样不可见, 直到这个事务结束
+  auto tran = lsm.begin_tran(IsolationLevel::READ_UNCOMMITTED);
+  tran->put("key3", "dirty");
+  lsm.put("key5", "v3");
+  auto snapshot2 = lsm.get_snapshot();
+  EXPECT_EQ(lsm.get("key3", snapshot2), "v1");
+  EXPECT_FALSE(lsm.get("key5", snapshot2).has_value());
+  EXPECT_EQ(lsm.get("key1", snapshot2), "v2");
+  EXPECT_TRUE(tran->commit());
+  auto snapshot3 = lsm.get_snapshot();
+  EXPECT_EQ(lsm.get("key3", snapshot3), "dirty");
+  EXPECT_EQ(lsm.get("key5", snapshot3), "v3");
+  EXPECT_EQ(lsm.get("key1", snapshot), "v1");
+
+  // 关闭事务的写入同样有事务 id, 不会被旧的版本遮住
+  lsm.put("key1", "v4", true);
+  EXPECT_EQ(lsm.get("key1"), "v4");
+}
+
+// 快照只能移动, 析构或者 release 时释放
+// 谓词查询合并 memtable 和多个 sst, 结果与快照上的遍历一致
+TEST_F(LSMTest, MonotonyPredicateSnapshot) {
+  LSM lsm(test_dir);
+  for (int i = 0; i < 200; i++) {
+    lsm.put(make_key(i), "v1");
+    if (i % 50 == 49) {
+      lsm.flush();
+    }
+  }
+  auto snapshot = lsm.get_snapshot();
+  for (int i = 50; i < 60; i++) {
+    lsm.remove(make_key(i));
+  }
+  lsm.flush();
+  for (int i = 60; i < 70; i++) {
+    lsm.put(make_key(i), "v2");
+  }
+
+  auto range_predicate = [](int lo, int hi) {
+    return [lo_key = make_key(lo), hi_key = make_key(hi)](const std::string &key) {
+      if (key < lo_key) {
+        return 1;
+      }
+      if (key > hi_key) {
+        return -1;
+      }
+      return 0;
+    };
+  };
+  auto collect = [](auto result) {
+    std::map<std::string, std::string> kvs;
+    if (!result.has_value()) {
+      return kvs;
+    }
+    for (auto it = result->first; it != result->second; ++it) {
+      kvs.insert(*it);
+    }
+    return kvs;
+  };
+
+  // 快照上看不到之后的删除和覆盖
+  std::map<std::string, std::string> expected;
+  for (int i = 40; i <= 79; i++) {
+    expected[make_key(i)] = "v1";
+  }
+  EXPECT_EQ(collect(lsm.lsm_iters_monotony_predicate(snapshot,
+                                                     range_predicate(40, 79))),
+            expected);
+
+  for (int i = 50; i < 60; i++) {
+    expected.erase(make_key(i));
+  }
+  for (int i = 60; i < 70; i++) {
+    expected[make_key(i)] = "v2";
+  }
+  EXPECT_EQ(collect(lsm.lsm_iters_monotony_predicate(0, range_predicate(40, 79))),
+            expected);
+
+  // 满足谓词的 key 都已删除, 或者不存在满足谓词的 key
+  EXPECT_FALSE(
+      lsm.lsm_iters_monotony_predicate(0, range_predicate(50, 59)).has_value());
+  EXPECT_TRUE(lsm.lsm_iters_monotony_predicate(snapshot, range_predicate(50, 59))
+                  .has_value());
+  EXPECT_FALSE(
+      lsm.lsm_iters_monotony_predicate(0, range_predicate(300, 400)).has_value());
+}
+
+TEST(SnapshotListTest, Release) {
+  static_assert(!std::is_copy_constructible_v<Snapshot>);
+  static_assert(std::is_nothrow_move_constructible_v<Snapshot>);
+  SnapshotList list;
+  {
+    auto snapshot = list.create(5);
+    EXPECT_EQ(list.size(), 1);
+    auto moved = std::move(snapshot);
+    EXPECT_EQ(list.size(), 1);
+    EXPECT_EQ(moved.get_tranc_id(), 5);
+    auto other = list.create(3);
+    EXPECT_EQ(list.tranc_ids(), (std::vector<uint64_t>{3, 5}));
+    // 移动赋值释放原来的快照
+    other = std::move(moved);
+    EXPECT_EQ(list.tranc_ids(), std::vector<uint64_t>{5});
+    other.release();
+    other.release();
+    EXPECT_EQ(list.size(), 0);
+    auto last = list.create(7);
+  }
+  EXPECT_EQ(list.size(), 0);
+}
+
+// 可串行化事务在提交时校验读集合, 读取的 key 被其他事务修改后提交失败
+TEST_F(LSMTest, SerializableReadValidation) {
+  LSM lsm(test_dir);
+  lsm.put("x", "1");
+  lsm.put("y", "1");
+
+  // 写偏斜: 两个事务各自读取一个 key 并修改另一个 key
+  for (auto level :
+       {IsolationLevel::REPEATABLE_READ, IsolationLevel::SERIALIZABLE}) {
+    auto tran1 = lsm.begin_tran(level);
+    auto tran2 = lsm.begin_tran(level);
+    EXPECT_EQ(tran1->get("x"), "1");
+    EXPECT_EQ(tran2->get("y"), "1");
+    tran1->put("y", "0");
+    tran2->put("x", "0");
+    EXPECT_TRUE(tran1->commit());
+    // 可重复读只检测写冲突, 允许写偏斜; 可串行化发现 y 已被修改
+    EXPECT_EQ(tran2->commit(), level == IsolationLevel::REPEATABLE_READ);
+    lsm.put("x", "1");
+    lsm.put("y", "1");
+  }
+
+  // 读取时不存在的 key 之后被插入, 同样视为冲突
+  auto tran = lsm.begin_tran(IsolationLevel::SERIALIZABLE);
+  EXPECT_FALSE(tran->get("z").has_value());
+  tran->put("x", "2");
+  lsm.put("z", "1");
+  EXPECT_FALSE(tran->commit());
+}
+
+// 写冲突按事务开始时已结束事务的水位判断: id 更小但在本事务开始后才提交的事务
+// 同样是并发的写入
+TEST_F(LSMTest, RepeatableReadWriteConflict) {
+  LSM lsm(test_dir);
+  lsm.put("k", "0");
+
+  for (auto level :
+       {IsolationLevel::REPEATABLE_READ, IsolationLevel::SERIALIZABLE}) {
+    auto tran1 = lsm.begin_tran(level);
+    auto tran2 = lsm.begin_tran(level);
+    tran1->put("k", "1");
+    EXPECT_TRUE(tran1->commit());
+    // tran1 开始于 tran2 之前, 但是在 tran2 开始之后才提交, 对 tran2 不可见
+    EXPECT_EQ(tran2->get("k"), "0");
+    tran2->put("k", "2");
+    EXPECT_FALSE(tran2->commit());
+    EXPECT_EQ(lsm.get("k"), "1");
+
+    // 普通写入与事务在同一个冲突域中
+    auto tran3 = lsm.begin_tran(level);
+    lsm.put("k", "3");
+    tran3->put("k", "4");
+    EXPECT_FALSE(tran3->commit());
+    EXPECT_EQ(lsm.get("k"), "3");
+
+    // 开始之前已经结束的写入不是冲突
+    auto tran4 = lsm.begin_tran(level);
+    tran4->put("k", "0");
+    EXPECT_TRUE(tran4->commit());
+    EXPECT_EQ(lsm.get("k"), "0");
+  }
+}
+
+// 多个线程并发地用可串行化事务递增计数器, 冲突的事务重试, 不会丢失更新
+TEST_F(LSMTest, SerializableConcurrentIncrement) {
+  LSM lsm(test_dir);
+  lsm.put("counter", "0");
+  const int thread_num = 4;
+  const int increments = 50;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; t++) {
+    threads.emplace_back([&, t]() {
+      for (int done = 0; done < increments;) {
+        auto tran = lsm.begin_tran(IsolationLevel::SERIALIZABLE);
+        auto value = tran->get("counter");
+        ASSERT_TRUE(value.has_value());
+        tran->put("counter", std::to_string(std::stoi(*value) + 1));
+        // 每个线程还修改自己的 key, 与其他线程的写集合不相交
+        tran->put("thread" + std::to_string(t), std::to_string(done));
+        if (tran->commit()) {
+          done++;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(lsm.get("counter"), std::to_string(thread_num * increments));
+  for (int t = 0; t < thread_num; t++) {
+    EXPECT_EQ(lsm.get("thread" + std::to_string(t)),
+              std::to_string(increments - 1));
+  }
+}
+
+// WriteBatch 的修改作为一个事务写入, 重启后从 WAL 恢复
+TEST_F(LSMTest, WriteBatch) {
+  {
+    LSM lsm(test_dir);
+    lsm.put("a", "0");
+    lsm.put("b", "0");
+
+    WriteBatch batch;
+    for (int i = 0; i < 100; i++) {
+      batch.put("key" + std::to_string(i), "value" + std::to_string(i));
+    }
+    batch.put("a", "1");
+    batch.remove("b");
+    batch.remove("key0");
+    lsm.write(batch);
+
+    EXPECT_EQ(lsm.get("a"), "1");
+    EXPECT_FALSE(lsm.get("b").has_value());
+    EXPECT_FALSE(lsm.get("key0").has_value());
+    EXPECT_EQ(lsm.get("key99"), "value99");
+
+    // 事务提交同样通过 WriteBatch 写入
+    auto tran = lsm.begin_tran(IsolationLevel::REPEATABLE_READ);
+    tran->put("c", "1");
+    tran->remove("a");
+    tran->put("c", "2");
+    EXPECT_TRUE(tran->commit());
+    EXPECT_EQ(lsm.get("c"), "2");
+    EXPECT_FALSE(lsm.get("a").has_value());
+  }
+  {
+    LSM lsm(test_dir);
+    EXPECT_FALSE(lsm.get("a").has_value());
+    EXPECT_FALSE(lsm.get("b").has_value());
+    EXPECT_EQ(lsm.get("c"), "2");
+    EXPECT_FALSE(lsm.get("key0").has_value());
+    for (int i = 1; i < 100; i++) {
+      EXPECT_EQ(lsm.get("key" + std::to_string(i)),
+                "value" + std::to_string(i));
+    }
+  }
+}
+
 int main(int argc, char **argv) {
   testing::InitGoogleTest(&argc, argv);
   init_spdlog_file();
@@ -1,6 +1,11 @@
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <iomanip>
+#include <map>
+#include <random>
+#include <sstream>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 #include "../include/consts.h"
@@ -438,6 +443,41 @@ TEST(MemTableTest, IteratorPreffix) {
   EXPECT_TRUE(memtable.iters_preffix("not exist", 0).is_end());
 }
 
+TEST(MemTableTest, RangeIter) {
+  MemTable memtable;
+  memtable.put("apple", "0", 0);
+  memtable.put("banana", "1", 0);
+  memtable.put("cherry", "2", 0);
+  memtable.frozen_cur_table();
+  memtable.put("apricot", "3", 0);
+  memtable.put("banana", "4", 0);
+  memtable.remove("cherry", 0);
+  memtable.put("date", "5", 0);
+
+  // [lower, upper) 左闭右开, 冻结表中的旧值被活跃表覆盖
+  std::vector<std::pair<std::string, std::string>> result;
+  for (auto it = memtable.range("apricot", "date", 0); it != memtable.end(); ++it) {
+    result.push_back(*it);
+  }
+  std::vector<std::pair<std::string, std::string>> expected = {{"apricot", "3"}, {"banana", "4"}};
+  EXPECT_EQ(result, expected);
+
+  // 保留删除标记, 且反向迭代不会越过 lower
+  auto it = memtable.range("b", "z", 0, true);
+  it.seek_for_prev("zz");
+  EXPECT_EQ(it->first, "date");
+  --it;
+  EXPECT_EQ(it->first, "cherry");
+  EXPECT_EQ(it->second, "");
+  --it;
+  EXPECT_EQ(it->first, "banana");
+  --it;
+  EXPECT_TRUE(it.is_end());
+
+  EXPECT_TRUE(memtable.range("c", "c", 0).is_end());
+  EXPECT_TRUE(memtable.range("e", "z", 0).is_end());
+}
+
 TEST(MemTableTest, ItersPredicate_Base) {
   MemTable memtable;
   memtable.put("prefix1", "value1", 0);
@@ -538,6 +578,315 @@ TEST(MemTableTest, ItersPredicate_Large) {
   EXPECT_TRUE(range_begin_iter.is_end());
 }
 
+// 测试批量加载有序数据
+TEST(MemTableTest, LoadSorted) {
+  MemTable memtable;
+  memtable.put("key00010", "old", 1);
+  memtable.put("other", "old", 1);
+
+  // 数据量超过单表大小限制, 会被切分到多个跳表
+  std::vector<std::tuple<std::string, std::string, uint64_t>> entries;
+  std::string value(512, 'v');
+  for (int i = 0; i < 10000; i++) {
+    std::ostringstream oss;
+    oss << "key" << std::setw(5) << std::setfill('0') << i;
+    entries.emplace_back(oss.str(), i % 10 == 0 ? "" : value + std::to_string(i), 2);
+  }
+  memtable.load_sorted(entries);
+  EXPECT_GT(memtable.get_frozen_size(), 0);
+
+  // 加载的数据覆盖旧数据, 空值表示删除
+  EXPECT_EQ(memtable.get("key00010", 0).get_value(), "");
+  EXPECT_EQ(memtable.get("key00011", 0).get_value(), value + "11");
+  EXPECT_EQ(memtable.get("key09999", 0).get_value(), value + "9999");
+  EXPECT_EQ(memtable.get("other", 0).get_value(), "old");
+
+  // 遍历结果有序且不重复, 删除的 key 被跳过
+  std::string prev_key;
+  size_t count = 0;
+  for (auto it = memtable.begin(0); it != memtable.end(); ++it) {
+    EXPECT_GT(it->first, prev_key);
+    prev_key = it->first;
+    count++;
+  }
+  EXPECT_EQ(count, 9000 + 1);
+}
+
+// 测试多个跳表按游标归并: 新表覆盖旧表, 删除标记屏蔽旧版本
+TEST(MemTableTest, MergeIteratorCursor) {
+  MemTable memtable;
+  std::map<std::string, std::string> expected;
+  std::mt19937 rng(7);
+  for (int round = 0; round < 5; round++) {
+    for (int i = 0; i < 500; i++) {
+      std::ostringstream oss;
+      oss << "key" << std::setw(4) << std::setfill('0') << rng() % 800;
+      std::string key = oss.str();
+      if (rng() % 4 == 0) {
+        memtable.remove(key, 0);
+        expected.erase(key);
+      } else {
+        std::string value = "value" + std::to_string(round) + "_" + std::to_string(i);
+        memtable.put(key, value, 0);
+        expected[key] = value;
+      }
+    }
+    if (round != 4) {
+      memtable.frozen_cur_table();
+    }
+  }
+
+  auto exp_it = expected.begin();
+  for (auto it = memtable.begin(0); it != memtable.end(); ++it) {
+    ASSERT_NE(exp_it, expected.end());
+    EXPECT_EQ(it->first, exp_it->first);
+    EXPECT_EQ(it->second, exp_it->second);
+    ++exp_it;
+  }
+  EXPECT_EQ(exp_it, expected.end());
+
+  // 保留删除标记时, 每个 key 只输出最新的版本
+  size_t count = 0;
+  std::string prev_key;
+  for (auto it = memtable.begin(0, true); it != memtable.end(); ++it) {
+    EXPECT_GT(it->first, prev_key);
+    prev_key = it->first;
+    auto exp = expected.find(it->first);
+    if (exp == expected.end()) {
+      EXPECT_EQ(it->second, "");
+    } else {
+      EXPECT_EQ(it->second, exp->second);
+    }
+    count++;
+  }
+  EXPECT_GE(count, expected.size());
+
+  // 前缀迭代器
+  auto exp_prefix = expected.lower_bound("key05");
+  for (auto it = memtable.iters_preffix("key05", 0); !it.is_end(); ++it) {
+    ASSERT_NE(exp_prefix, expected.end());
+    EXPECT_EQ(it->first, exp_prefix->first);
+    EXPECT_EQ(it->second, exp_prefix->second);
+    ++exp_prefix;
+  }
+  EXPECT_TRUE(exp_prefix == expected.end() || exp_prefix->first.compare(0, 5, "key05") != 0);
+}
+
+// 测试归并迭代器只输出事务可见的版本
+TEST(MemTableTest, MergeIteratorTrancId) {
+  MemTable memtable;
+  memtable.put("a", "a1", 1);
+  memtable.put("b", "b1", 1);
+  memtable.frozen_cur_table();
+  memtable.put("a", "a3", 3);
+  memtable.remove("b", 3);
+  memtable.put("c", "c4", 4);
+
+  std::vector<std::pair<std::string, std::string>> result;
+  for (auto it = memtable.begin(2); !it.is_end(); ++it) {
+    result.push_back(*it);
+  }
+  std::vector<std::pair<std::string, std::string>> answer{{"a", "a1"}, {"b", "b1"}};
+  EXPECT_EQ(result, answer);
+
+  result.clear();
+  for (auto it = memtable.begin(4); !it.is_end(); ++it) {
+    result.push_back(*it);
+  }
+  answer = {{"a", "a3"}, {"c", "c4"}};
+  EXPECT_EQ(result, answer);
+}
+
+// 测试归并迭代器的 seek / seek_for_prev 以及反向遍历
+TEST(MemTableTest, SeekAndReverse) {
+  MemTable memtable;
+  std::map<std::string, std::string> expected;
+  std::mt19937 rng(11);
+  auto make_key = [](int i) {
+    std::ostringstream oss;
+    oss << "key" << std::setw(4) << std::setfill('0') << i;
+    return oss.str();
+  };
+  auto kv = [](const auto &entry) { return std::make_pair(entry.first, entry.second); };
+  for (int round = 0; round < 4; round++) {
+    for (int i = 0; i < 400; i++) {
+      std::string key = make_key(rng() % 600);
+      if (rng() % 4 == 0) {
+        memtable.remove(key, 0);
+        expected.erase(key);
+      } else {
+        std::string value = "value" + std::to_string(round) + "_" + std::to_string(i);
+        memtable.put(key, value, 0);
+        expected[key] = value;
+      }
+    }
+    if (round != 3) {
+      memtable.frozen_cur_table();
+    }
+  }
+
+  auto it = memtable.begin(0);
+  for (int round = 0; round < 300; round++) {
+    std::string target = make_key(rng() % 620);
+    auto lower = expected.lower_bound(target);
+    it.seek(target);
+    if (lower == expected.end()) {
+      EXPECT_TRUE(it.is_end()) << target;
+    } else {
+      ASSERT_TRUE(it.is_valid()) << target;
+      EXPECT_EQ(*it, kv(*lower)) << target;
+    }
+
+    auto upper = expected.upper_bound(target);
+    it.seek_for_prev(target);
+    if (upper == expected.begin()) {
+      EXPECT_TRUE(it.is_end()) << target;
+    } else {
+      ASSERT_TRUE(it.is_valid()) << target;
+      auto prev = std::prev(upper);
+      EXPECT_EQ(*it, kv(*prev)) << target;
+      // 反向之后再正向
+      ++it;
+      if (upper == expected.end()) {
+        EXPECT_TRUE(it.is_end());
+      } else {
+        ASSERT_TRUE(it.is_valid());
+        EXPECT_EQ(*it, kv(*upper));
+        --it;
+        ASSERT_TRUE(it.is_valid());
+        EXPECT_EQ(*it, kv(*prev));
+      }
+    }
+  }
+
+  // 完整的反向遍历
+  it.seek_for_prev("key9999");
+  for (auto exp = expected.rbegin(); exp != expected.rend(); ++exp, --it) {
+    ASSERT_TRUE(it.is_valid());
+    EXPECT_EQ(*it, kv(*exp));
+  }
+  EXPECT_TRUE(it.is_end());
+
+  // 前缀迭代器只在前缀范围内定位
+  auto preffix_it = memtable.iters_preffix("key01", 0);
+  preffix_it.seek_for_prev("key9999");
+  auto last = std::prev(expected.lower_bound("key02"));
+  ASSERT_TRUE(preffix_it.is_valid());
+  EXPECT_EQ(*preffix_it, kv(*last));
+  preffix_it.seek("key0");
+  EXPECT_EQ(*preffix_it, kv(*expected.lower_bound("key01")));
+  --preffix_it;
+  EXPECT_TRUE(preffix_it.is_end());
+}
+
+// 测试多版本: 覆盖和删除都不会丢弃旧版本, 按事务 id 读取历史版本
+TEST(MemTableTest, MultiVersion) {
+  MemTable memtable;
+  memtable.put("key1", "v1", 1);
+  memtable.put("key2", "v1", 1);
+  memtable.frozen_cur_table();
+  memtable.put("key1", "v2", 2);
+  memtable.remove("key2", 3);
+  memtable.put("key1", "v4", 4);
+
+  EXPECT_EQ(memtable.get("key1", 0).get_value(), "v4");
+  EXPECT_EQ(memtable.get("key1", 3).get_value(), "v2");
+  EXPECT_EQ(memtable.get("key1", 1).get_value(), "v1");
+  EXPECT_TRUE(memtable.get("key2", 0).get_value().empty());
+  EXPECT_EQ(memtable.get("key2", 2).get_value(), "v1");
+
+  auto batch = memtable.get_batch({"key1", "key2"}, 2);
+  EXPECT_EQ(batch[0].second->first, "v2");
+  EXPECT_EQ(batch[1].second->first, "v1");
+}
+
+// 测试同一个快照下归并迭代器与点查的结果一致, 较新的版本都还没有刷盘
+TEST(MemTableTest, SnapshotIteratorMatchesGet) {
+  MemTable memtable;
+  std::mt19937 rng(7);
+  auto make_key = [](int i) { return "key" + std::to_string(100 + i); };
+  uint64_t tranc_id = 0;
+  for (int round = 0; round < 4; round++) {
+    for (int i = 0; i < 200; i++) {
+      std::string key = make_key(rng() % 50);
+      ++tranc_id;
+      if (rng() % 3 == 0) {
+        memtable.remove(key, tranc_id);
+      } else {
+        memtable.put(key, "v" + std::to_string(tranc_id), tranc_id);
+      }
+    }
+    if (round != 3) {
+      memtable.frozen_cur_table();
+    }
+  }
+
+  for (uint64_t snapshot = 1; snapshot <= tranc_id; snapshot += 37) {
+    std::vector<std::pair<std::string, std::string>> expected;
+    for (int i = 0; i < 50; i++) {
+      auto res = memtable.get(make_key(i), snapshot);
+      if (res.is_valid() && !res.get_value().empty()) {
+        expected.emplace_back(make_key(i), res.get_value());
+      }
+    }
+
+    std::vector<std::pair<std::string, std::string>> result;
+    for (auto it = memtable.begin(snapshot); !it.is_end(); ++it) {
+      result.push_back(*it);
+    }
+    EXPECT_EQ(result, expected) << snapshot;
+
+    result.clear();
+    auto it = memtable.begin(snapshot);
+    for (it.seek_for_prev("key999"); it.is_valid(); --it) {
+      result.push_back(*it);
+    }
+    std::reverse(result.begin(), result.end());
+    EXPECT_EQ(result, expected) << snapshot;
+
+    auto range_it = memtable.range(make_key(10), make_key(20), snapshot);
+    for (auto &[key, value] : expected) {
+      if (key < make_key(10) || key >= make_key(20)) {
+        continue;
+      }
+      ASSERT_TRUE(range_it.is_valid()) << key;
+      EXPECT_EQ(*range_it, std::make_pair(key, value));
+      ++range_it;
+    }
+    EXPECT_TRUE(range_it.is_end());
+  }
+}
+
+// 测试 WriteBatch: 所有操作使用同一个事务 id, 同一个 key 后写入的操作生效
+TEST(MemTableTest, WriteBatch) {
+  MemTable memtable;
+  memtable.put("key1", "old1", 1);
+  memtable.put("key2", "old2", 1);
+
+  WriteBatch batch;
+  batch.put("key1", "value1");
+  batch.remove("key2");
+  batch.put("key3", "value3");
+  batch.put("key3", "value3_new");
+  batch.remove("key4");
+  EXPECT_EQ(batch.count(), 5);
+  memtable.write(batch, 2);
+
+  auto it = memtable.get("key1", 0);
+  EXPECT_EQ(it.get_value(), "value1");
+  EXPECT_EQ(it.get_tranc_id(), 2);
+  EXPECT_TRUE(memtable.get("key2", 0).get_value().empty());
+  EXPECT_EQ(memtable.get("key3", 0).get_value(), "value3_new");
+  EXPECT_TRUE(memtable.get("key4", 0).get_value().empty());
+
+  EXPECT_EQ(memtable.get("key2", 0).get_tranc_id(), 2);
+  EXPECT_EQ(memtable.get("key3", 0).get_tranc_id(), 2);
+
+  batch.clear();
+  EXPECT_TRUE(batch.empty());
+  EXPECT_EQ(batch.data_size(), 0);
+}
+
 int main(int argc, char **argv) {
   testing::InitGoogleTest(&argc, argv);
   init_spdlog_file();
@@ -3,6 +3,7 @@
 #include <cstdlib>
 #include <iomanip>
 #include <iostream>
+#include <random>
 #include <sstream>
 #include <string>
 #include <unordered_set>
@@ -12,7 +13,7 @@
 #include "../include/logger/logger.h"
 #include "../include/skiplist/skiplist.h"
 
-#define CURRENT_LAB 1.3
+#define CURRENT_LAB 5.1
 
 using namespace ::tiny_lsm;
 
@@ -335,6 +336,66 @@ TEST(SkipListTest, TransactionId) {
   EXPECT_EQ((skipList.get("key1", 1).get_value()), "value1");
   // 指定 2 表示只能查找事务 id 小于等于 2 的值
   EXPECT_EQ((skipList.get("key1", 2).get_value()), "value2");
+
+  // 删除标记同样是一个新版本, 不会覆盖旧版本
+  skipList.put("key1", "", 4);
+  EXPECT_TRUE(skipList.get("key1", 0).get_value().empty());
+  EXPECT_EQ((skipList.get("key1", 3).get_value()), "value2");
+  EXPECT_EQ((skipList.get("key1", 3).get_tranc_id()), 2);
+  // 比所有版本都旧的事务看不到这个 key
+  skipList.put("key0", "value0", 5);
+  EXPECT_FALSE(skipList.get("key0", 4).is_valid());
+  EXPECT_FALSE(skipList.get("key2", 4).is_valid());
+
+  // 同一个事务重复写入时原地更新
+  skipList.put("key1", "value3", 2);
+  EXPECT_EQ((skipList.get("key1", 2).get_value()), "value3");
+  size_t versions = 0;
+  for (auto it = skipList.begin(); it != skipList.end(); ++it) {
+    versions += it.get_key() == "key1" ? 1 : 0;
+  }
+  EXPECT_EQ(versions, 3);
+}
+
+// 测试 seek / seek_for_prev 以及反向遍历
+TEST(SkipListTest, SeekAndReverse) {
+  SkipList skipList;
+  auto make_key = [](int i) {
+    std::ostringstream oss;
+    oss << "key" << std::setw(4) << std::setfill('0') << i;
+    return oss.str();
+  };
+  for (int i = 0; i < 1000; i += 2) {
+    skipList.put(make_key(i), "value" + std::to_string(i), 0);
+  }
+
+  // 从头节点查找
+  EXPECT_EQ(skipList.seek(make_key(101)).get_key(), make_key(102));
+  EXPECT_EQ(skipList.seek(make_key(100)).get_key(), make_key(100));
+  EXPECT_TRUE(skipList.seek("key9999").is_end());
+  EXPECT_EQ(skipList.seek_for_prev(make_key(101)).get_key(), make_key(100));
+  EXPECT_EQ(skipList.seek_for_prev("key9999").get_key(), make_key(998));
+  EXPECT_TRUE(skipList.seek_for_prev("a").is_end());
+
+  // 从任意节点出发向两侧查找, 结果与从头查找一致
+  std::mt19937 rng(1);
+  for (int round = 0; round < 200; round++) {
+    auto target = make_key(rng() % 1010);
+    auto it = skipList.seek(make_key(rng() % 999));
+    it.seek(target);
+    EXPECT_TRUE(it == skipList.seek(target)) << target;
+    it = skipList.seek(make_key(rng() % 999));
+    it.seek_for_prev(target);
+    EXPECT_TRUE(it == skipList.seek_for_prev(target)) << target;
+  }
+
+  // 反向遍历
+  int expected = 998;
+  for (auto it = skipList.seek_for_prev("key9999"); !it.is_end(); --it) {
+    EXPECT_EQ(it.get_key(), make_key(expected));
+    expected -= 2;
+  }
+  EXPECT_EQ(expected, -2);
 }
 
 // ! 现在的实现, 并发的锁由 SkipList 的上层 MemTable 实现, 因此不需要测试
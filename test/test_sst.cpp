@@ -1,10 +1,17 @@
 #include "../include/config/config.h"
 #include "../include/consts.h"
 #include "../include/logger/logger.h"
+#include "../include/sst/concact_iterator.h"
+#include "../include/sst/learned_index.h"
 #include "../include/sst/sst.h"
 #include "../include/sst/sst_iterator.h"
+#include "../include/sst/table_cache.h"
+#include <algorithm>
 #include <filesystem>
 #include <gtest/gtest.h>
+#include <iterator>
+#include <random>
+#include <set>
 
 using namespace ::tiny_lsm;
 
@@ -22,6 +29,19 @@ protected:
     std::filesystem::remove_all("test_data");
   }
 
+  // 辅助函数：使用配置中的容量创建 BlockCache
+  static std::shared_ptr<BlockCache> make_block_cache() {
+    return std::make_shared<BlockCache>(
+        TomlConfig::getInstance().getLsmBlockCacheCapacity(),
+        TomlConfig::getInstance().getLsmBlockCacheK());
+  }
+
+  // 辅助函数：生成按数字顺序排列的 key, 数字补零到 width 位
+  static std::string make_key(int i, size_t width = 5) {
+    auto str = std::to_string(i);
+    return "key" + std::string(width - str.length(), '0') + str;
+  }
+
   // 辅助函数：创建一个包含有序数据的SST
   std::shared_ptr<SST> create_test_sst(size_t block_size, size_t num_entries) {
     SSTBuilder builder(block_size, true);
@@ -151,6 +171,32 @@ TEST_F(SSTTest, ReopenSST) {
   EXPECT_EQ(sst->num_blocks(), reopened_sst->num_blocks());
 }
 
+// 测试以只读 mmap 的方式重新打开SST
+TEST_F(SSTTest, ReopenSSTWithMmap) {
+  auto sst = create_test_sst(256, 100);
+
+  // 不使用缓存, 确保每次都从映射区域解码
+  FileObj file = FileObj::open("test_data/test.sst", false, FileIOMode::Mmap);
+  auto reopened_sst = SST::open(1, std::move(file), nullptr);
+  EXPECT_EQ(sst->num_blocks(), reopened_sst->num_blocks());
+
+  size_t cnt = 0;
+  for (auto it = reopened_sst->begin(0); it != reopened_sst->end(); ++it) {
+    EXPECT_EQ(it.key(), "key" + std::to_string(cnt));
+    EXPECT_EQ(it.value(), "value" + std::to_string(cnt));
+    cnt++;
+  }
+  EXPECT_EQ(cnt, 100);
+
+  // 映射区域的 Block 在 SST 释放后依然有效
+  size_t idx = reopened_sst->find_block_idx("key50");
+  auto block = reopened_sst->read_block(idx);
+  reopened_sst.reset();
+  auto value = block->get_value_binary("key50", 0);
+  EXPECT_TRUE(value.has_value());
+  EXPECT_EQ(*value, "value50");
+}
+
 // 测试大文件
 TEST_F(SSTTest, LargeSST) {
   SSTBuilder builder(4096, true); // 4KB blocks
@@ -240,6 +286,453 @@ TEST_F(SSTTest, LargeSSTPredicate) {
   EXPECT_EQ(iter_end.key(), "key501");
 }
 
+// 测试两级索引: 小 block 产生多个索引分区, 索引中只保存分隔 key
+TEST_F(SSTTest, PartitionedIndex) {
+  EXPECT_EQ(SstIndex::shortest_separator("apple", "cherry"), "b");
+  EXPECT_EQ(SstIndex::shortest_separator("key0129", "key0130"), "key013");
+  EXPECT_EQ(SstIndex::shortest_separator("key0129", "key0129a"), "key0129");
+  EXPECT_EQ(SstIndex::shortest_separator("key01", "key0100"), "key01");
+
+  // block 和索引分区都只有 64 字节
+  SSTBuilder builder(64, true);
+  auto block_cache = make_block_cache();
+  // 只写入偶数, 奇数的 key 落在 block 之间或者 block 内部的空隙中
+  for (int i = 0; i < 2000; i += 2) {
+    builder.add(make_key(i, 4), "value" + std::to_string(i), 0);
+  }
+  auto sst = builder.build(1, "test_data/partitioned.sst", block_cache);
+  EXPECT_GT(sst->num_blocks(), 100);
+  EXPECT_EQ(sst->get_first_key(), "key0000");
+  EXPECT_EQ(sst->get_last_key(), "key1998");
+
+  FileObj file = FileObj::open("test_data/partitioned.sst", false);
+  auto reopened = SST::open(1, std::move(file), block_cache);
+  EXPECT_EQ(reopened->num_blocks(), sst->num_blocks());
+  EXPECT_EQ(reopened->get_first_key(), "key0000");
+  EXPECT_EQ(reopened->get_last_key(), "key1998");
+
+  for (int i = 0; i < 2000; i++) {
+    auto it = reopened->get(make_key(i, 4), 0);
+    if (i % 2 == 0) {
+      ASSERT_TRUE(it.is_valid()) << make_key(i, 4);
+      EXPECT_EQ(it.value(), "value" + std::to_string(i));
+    } else {
+      EXPECT_FALSE(it.is_valid()) << make_key(i, 4);
+    }
+  }
+  EXPECT_EQ(reopened->find_block_idx("key9999"), -1);
+  EXPECT_EQ(reopened->find_block_idx("a"), -1);
+
+  // 谓词查询依赖分隔 key 划分 block 的范围
+  auto result = sst_iters_monotony_predicate(
+      reopened, 0, [&](const std::string &key) {
+        if (key < make_key(501, 4)) {
+          return 1;
+        }
+        if (key > make_key(1499, 4)) {
+          return -1;
+        }
+        return 0;
+      });
+  ASSERT_TRUE(result.has_value());
+  auto [it_begin, it_end] = result.value();
+  EXPECT_EQ(it_begin.key(), make_key(502, 4));
+  EXPECT_EQ(it_end.key(), make_key(1500, 4));
+  size_t cnt = 0;
+  for (; it_begin != it_end; ++it_begin) {
+    cnt++;
+  }
+  EXPECT_EQ(cnt, 499);
+}
+
+// 测试读取旧格式的 sst: Meta Section 是 BlockMeta 数组, 没有索引分区
+TEST_F(SSTTest, LegacyIndexFormat) {
+  std::vector<uint8_t> data;
+  std::vector<BlockMeta> metas;
+  for (int b = 0; b < 3; b++) {
+    Block block(4096);
+    for (int i = 0; i < 10; i++) {
+      block.add_entry("key" + std::to_string(b) + std::to_string(i),
+                      "value" + std::to_string(b * 10 + i), 0, false);
+    }
+    metas.emplace_back(data.size(), "key" + std::to_string(b) + "0",
+                       "key" + std::to_string(b) + "9");
+    auto encoded = block.encode(true);
+    data.insert(data.end(), encoded.begin(), encoded.end());
+  }
+  std::vector<uint8_t> meta_section;
+  BlockMeta::encode_meta_to_slice(metas, meta_section);
+  uint32_t meta_offset = data.size();
+  data.insert(data.end(), meta_section.begin(), meta_section.end());
+  // 没有布隆过滤器
+  uint32_t bloom_offset = data.size();
+  uint64_t min_tranc_id = 0, max_tranc_id = 0;
+  for (auto [ptr, len] : std::vector<std::pair<const void *, size_t>>{
+           {&meta_offset, 4}, {&bloom_offset, 4},
+           {&min_tranc_id, 8}, {&max_tranc_id, 8}}) {
+    auto bytes = static_cast<const uint8_t *>(ptr);
+    data.insert(data.end(), bytes, bytes + len);
+  }
+  FileObj::create_and_write("test_data/legacy.sst", data);
+
+  auto sst = SST::open(1, FileObj::open("test_data/legacy.sst", false),
+                       nullptr);
+  EXPECT_EQ(sst->num_blocks(), 3);
+  EXPECT_EQ(sst->get_first_key(), "key00");
+  EXPECT_EQ(sst->get_last_key(), "key29");
+  EXPECT_EQ(sst->find_block_idx("key15"), 1);
+  auto it = sst->get("key27", 0);
+  ASSERT_TRUE(it.is_valid());
+  EXPECT_EQ(it.value(), "value27");
+}
+
+// 测试表缓存: 超出容量时卸载冷的 sst, 再次访问时重新加载
+TEST_F(SSTTest, TableCache) {
+  auto table_cache = std::make_shared<TableCache>(2);
+  std::vector<std::shared_ptr<SST>> ssts;
+  for (size_t id = 0; id < 4; id++) {
+    SSTBuilder builder(256, true);
+    for (size_t i = 0; i < 50; i++) {
+      builder.add("key" + std::to_string(1000 + id * 100 + i),
+                  "value" + std::to_string(1000 + id * 100 + i), 0);
+    }
+    std::string path = "test_data/table_cache_" + std::to_string(id) + ".sst";
+    auto built = builder.build(id, path, nullptr);
+    // 通过元数据延迟打开, 第一次访问时才加载
+    auto sst = SST::open_lazy(id, path, built->sst_size(),
+                              built->get_first_key(), built->get_last_key(),
+                              built->get_tranc_id_range(), nullptr);
+    sst->set_table_cache(table_cache);
+    EXPECT_FALSE(sst->is_loaded());
+    ssts.push_back(sst);
+  }
+
+  for (int round = 0; round < 2; round++) {
+    for (size_t id = 0; id < 4; id++) {
+      std::string key = "key" + std::to_string(1000 + id * 100 + 10);
+      auto it = ssts[id]->get(key, 0);
+      ASSERT_TRUE(it.is_valid());
+      EXPECT_EQ(it.key(), key);
+      EXPECT_EQ(it.value(), "value" + std::to_string(1000 + id * 100 + 10));
+      EXPECT_LE(table_cache->size(), 2);
+    }
+  }
+
+  size_t loaded = 0;
+  for (auto &sst : ssts) {
+    loaded += sst->is_loaded() ? 1 : 0;
+  }
+  EXPECT_LE(loaded, 2);
+
+  // 遍历中途被卸载, 迭代器读取下一个 block 时重新加载
+  auto it = ssts[0]->begin(0);
+  EXPECT_TRUE(ssts[0]->unload());
+  size_t cnt = 0;
+  for (; it != ssts[0]->end(); ++it) {
+    cnt++;
+  }
+  EXPECT_EQ(cnt, 50);
+}
+
+TEST_F(SSTTest, LearnedIndex) {
+  auto make_score_key = [](uint64_t score) {
+    auto str = std::to_string(score);
+    return "zset_" + std::string(12 - str.length(), '0') + str;
+  };
+  // 分数的间隔逐渐变大, 模型需要多个分段
+  std::vector<std::string> keys;
+  for (uint64_t i = 0; i < 3000; i++) {
+    keys.push_back(make_score_key(i * i * 7));
+  }
+
+  auto model = LearnedIndex::train(keys, 4);
+  ASSERT_TRUE(model.has_value());
+  EXPECT_GT(model->num_segments(), 1);
+  std::vector<uint8_t> encoded;
+  model->encode(encoded);
+  auto decoded = LearnedIndex::decode(encoded.data(), encoded.size());
+  EXPECT_EQ(decoded.num_segments(), model->num_segments());
+  for (uint64_t score = 0; score < 3000 * 3000 * 7; score += 997) {
+    auto key = make_score_key(score);
+    size_t expected =
+        std::lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+    auto [lo, hi] = decoded.predict(key);
+    ASSERT_LE(lo, expected) << key;
+    ASSERT_TRUE(expected < hi || expected == keys.size()) << key;
+  }
+  auto [lo, hi] = decoded.predict("a");
+  EXPECT_EQ(lo, 0);
+  encoded[encoded.size() / 2] ^= 0xff;
+  EXPECT_THROW(LearnedIndex::decode(encoded.data(), encoded.size()),
+               std::runtime_error);
+
+  // 有模型和没有模型的 sst 查找结果一致
+  SSTBuilder builder(64, true);
+  SSTBuilder plain_builder(64, true);
+  plain_builder.set_learned_index_error(0);
+  for (uint64_t i = 0; i < 3000; i++) {
+    builder.add(make_score_key(i * i * 7), std::to_string(i), 0);
+    plain_builder.add(make_score_key(i * i * 7), std::to_string(i), 0);
+  }
+  builder.build(1, "test_data/learned.sst", nullptr);
+  auto plain = plain_builder.build(2, "test_data/plain.sst", nullptr);
+  FileObj file = FileObj::open("test_data/learned.sst", false);
+  auto sst = SST::open(1, std::move(file), nullptr);
+  EXPECT_LT(plain->sst_size(), sst->sst_size());
+
+  for (uint64_t i = 0; i < 3000; i++) {
+    auto key = make_score_key(i * i * 7);
+    EXPECT_EQ(sst->find_block_idx(key), plain->find_block_idx(key)) << key;
+    auto it = sst->get(key, 0);
+    ASSERT_TRUE(it.is_valid()) << key;
+    EXPECT_EQ(it.value(), std::to_string(i));
+    auto missing = make_score_key(i * i * 7 + 1);
+    EXPECT_EQ(sst->find_block_idx(missing), plain->find_block_idx(missing))
+        << missing;
+    EXPECT_FALSE(sst->get(missing, 0).is_valid()) << missing;
+  }
+  EXPECT_EQ(sst->find_block_idx("zset_999999999999"), -1);
+  EXPECT_EQ(sst->find_block_idx("a"), -1);
+}
+
+// 测试 seek / seek_for_prev 以及跨 block 和跨 sst 的反向遍历
+TEST_F(SSTTest, SeekAndReverse) {
+  auto block_cache = make_block_cache();
+  // 3 个 key 范围不重叠的 sst, 只包含偶数 key
+  std::set<std::string> keys;
+  std::vector<std::shared_ptr<SST>> ssts;
+  for (int id = 0; id < 3; id++) {
+    SSTBuilder builder(256, true);
+    for (int i = id * 1000; i < (id + 1) * 1000; i += 2) {
+      builder.add(make_key(i), "value" + std::to_string(i), 0);
+      keys.insert(make_key(i));
+    }
+    ssts.push_back(builder.build(
+        id, "test_data/seek_" + std::to_string(id) + ".sst", block_cache));
+  }
+  ASSERT_GT(ssts[0]->num_blocks(), 1);
+
+  std::mt19937 rng(3);
+  SstIterator sst_it(ssts[1], 0);
+  ConcactIterator concat_it(ssts, 0);
+  for (int round = 0; round < 300; round++) {
+    auto target = make_key(rng() % 3100);
+    // 单个 sst 中的期望结果
+    auto lower = keys.lower_bound(target);
+    sst_it.seek(target);
+    if (lower == keys.end() || *lower >= make_key(2000)) {
+      EXPECT_FALSE(sst_it.is_valid()) << target;
+    } else {
+      ASSERT_TRUE(sst_it.is_valid()) << target;
+      EXPECT_EQ(sst_it.key(), std::max(*lower, make_key(1000))) << target;
+    }
+    concat_it.seek(target);
+    if (lower == keys.end()) {
+      EXPECT_FALSE(concat_it.is_valid()) << target;
+    } else {
+      ASSERT_TRUE(concat_it.is_valid()) << target;
+      EXPECT_EQ(concat_it.key(), *lower) << target;
+    }
+
+    auto upper = keys.upper_bound(target);
+    concat_it.seek_for_prev(target);
+    if (upper == keys.begin()) {
+      EXPECT_FALSE(concat_it.is_valid()) << target;
+    } else {
+      ASSERT_TRUE(concat_it.is_valid()) << target;
+      EXPECT_EQ(concat_it.key(), *std::prev(upper)) << target;
+    }
+  }
+
+  // 反向遍历整个 sst
+  sst_it.seek_to_last();
+  int expected = 1998;
+  for (; sst_it.is_valid(); --sst_it) {
+    EXPECT_EQ(sst_it.key(), make_key(expected));
+    expected -= 2;
+  }
+  EXPECT_EQ(expected, 998);
+
+  // 反向遍历所有 sst, 再从中间换向
+  concat_it.seek_for_prev("key99999");
+  expected = 2998;
+  for (; concat_it.is_valid(); --concat_it) {
+    EXPECT_EQ(concat_it.key(), make_key(expected));
+    expected -= 2;
+  }
+  EXPECT_EQ(expected, -2);
+  concat_it.seek(make_key(1001));
+  --concat_it;
+  EXPECT_EQ(concat_it.key(), make_key(1000));
+  --concat_it;
+  EXPECT_EQ(concat_it.key(), make_key(998));
+  ++concat_it;
+  EXPECT_EQ(concat_it.key(), make_key(1000));
+}
+
+TEST_F(SSTTest, RangeBounds) {
+  auto block_cache = make_block_cache();
+  std::vector<std::shared_ptr<SST>> ssts;
+  for (int id = 0; id < 4; id++) {
+    SSTBuilder builder(256, true);
+    for (int i = id * 1000; i < (id + 1) * 1000; i += 2) {
+      builder.add(make_key(i), "value" + std::to_string(i), 0);
+    }
+    ssts.push_back(builder.build(
+        id, "test_data/range_" + std::to_string(id) + ".sst", block_cache));
+  }
+
+  std::mt19937 rng(44);
+  for (int round = 0; round < 100; round++) {
+    int a = rng() % 4200, b = rng() % 4200;
+    auto lower = make_key(std::min(a, b));
+    auto upper = make_key(std::max(a, b));
+    std::vector<std::string> expected;
+    for (int i = 0; i < 4000; i += 2) {
+      if (make_key(i) >= lower && make_key(i) < upper) {
+        expected.push_back(make_key(i));
+      }
+    }
+
+    // 连接迭代器输出范围内的所有 key, 只会多出边界 block 中的 key
+    ConcactIterator concat_it(ssts, 0, lower, upper);
+    std::vector<std::string> result;
+    for (; concat_it.is_valid(); ++concat_it) {
+      result.push_back(concat_it.key());
+    }
+    ASSERT_TRUE(std::is_sorted(result.begin(), result.end()));
+    std::vector<std::string> in_range;
+    std::copy_if(
+        result.begin(), result.end(), std::back_inserter(in_range),
+        [&](const std::string &key) { return key >= lower && key < upper; });
+    EXPECT_EQ(in_range, expected) << lower << " " << upper;
+    if (!result.empty()) {
+      // 最后输出的 key 与 upper 位于同一个 block, 没有读取之后的 block
+      auto &sst = ssts[std::stoi(result.back().substr(3)) / 1000];
+      if (upper <= sst->get_last_key()) {
+        EXPECT_EQ(sst->lower_bound_block(result.back()),
+                  sst->lower_bound_block(upper))
+            << lower << " " << upper;
+      }
+      EXPECT_GE(result.front(), lower);
+    }
+
+    // 单个 sst 上反向遍历同样停在边界 block 内
+    auto &sst = ssts[1];
+    SstIterator sst_it(sst, lower, upper, 0);
+    sst_it.seek_for_prev(upper);
+    std::vector<std::string> reversed;
+    for (; sst_it.is_valid(); --sst_it) {
+      reversed.push_back(sst_it.key());
+    }
+    for (auto &key : expected) {
+      if (key >= sst->get_first_key() && key <= sst->get_last_key()) {
+        EXPECT_NE(std::find(reversed.begin(), reversed.end(), key),
+                  reversed.end())
+            << key;
+      }
+    }
+    if (!reversed.empty() && lower >= sst->get_first_key()) {
+      EXPECT_EQ(sst->lower_bound_block(reversed.back()),
+                sst->lower_bound_block(lower));
+    }
+  }
+}
+
+// 顺序扫描时的预读: 结果不受影响, 并且提前读入游标之后的 block
+TEST_F(SSTTest, Readahead) {
+  SSTBuilder builder(128, true);
+  for (int i = 0; i < 2000; i++) {
+    builder.add(make_key(i), "value" + std::to_string(i), 0);
+  }
+  auto sst = builder.build(1, "test_data/readahead.sst", nullptr);
+  ASSERT_GT(sst->num_blocks(), 64);
+
+  for (auto mode : {FileIOMode::Std, FileIOMode::Mmap}) {
+    auto block_cache = make_block_cache();
+    auto reopened_sst =
+        SST::open(1, FileObj::open("test_data/readahead.sst", false, mode),
+                  block_cache);
+    // 自适应预读, 中途随机定位后重新检测顺序访问
+    std::vector<std::string> keys;
+    SstIterator it(reopened_sst, 0);
+    for (int i = 0; i < 300; ++it, ++i) {
+      keys.push_back(it.key());
+    }
+    for (it.seek(make_key(1500)); it.is_valid(); ++it) {
+      keys.push_back(it.key());
+    }
+    ASSERT_EQ(keys.size(), 800);
+    EXPECT_EQ(keys[299], make_key(299));
+    EXPECT_EQ(keys[300], make_key(1500));
+    EXPECT_EQ(keys.back(), make_key(1999));
+
+    // 固定的预读窗口
+    it.seek_first();
+    it.set_readahead(32);
+    int cnt = 0;
+    for (; it.is_valid(); ++it, ++cnt) {
+      EXPECT_EQ(it.key(), make_key(cnt));
+    }
+    EXPECT_EQ(cnt, 2000);
+  }
+
+  // Direct 模式下预读的 block 直接进入 BlockCache, 可以观察到预读的范围
+  // 缓存容量足够放下所有 block 和索引分区, 预读的 block 不会被淘汰
+  size_t num_blocks = sst->num_blocks();
+  size_t max_window = TomlConfig::getInstance().getLsmSstReadaheadMaxBlocks();
+  ASSERT_GE(max_window, 2);
+  {
+    auto block_cache = std::make_shared<BlockCache>(2 * num_blocks, 2);
+    auto direct_sst = SST::open(
+        1, FileObj::open("test_data/readahead.sst", false, FileIOMode::Direct),
+        block_cache);
+    SstIterator it(direct_sst, 0);
+    // 开始遍历时只预读最初的 2 个 block
+    EXPECT_NE(block_cache->get(1, 1), nullptr);
+    EXPECT_EQ(block_cache->get(1, 2), nullptr);
+
+    size_t cur_block = 0;
+    for (; it.is_valid(); ++it) {
+      size_t block_idx = direct_sst->find_block_idx(it.key());
+      if (block_idx == cur_block) {
+        continue;
+      }
+      cur_block = block_idx;
+      // 游标进入新的 block 时, 下一个 block 已经被预读
+      if (block_idx + 1 < num_blocks) {
+        EXPECT_NE(block_cache->get(1, block_idx + 1), nullptr) << block_idx;
+      }
+      // 窗口加倍到上限之后, 预读的范围超过游标半个窗口
+      if (block_idx >= 2 * max_window && block_idx + max_window / 2 < num_blocks) {
+        EXPECT_NE(block_cache->get(1, block_idx + max_window / 2), nullptr)
+            << block_idx;
+      }
+    }
+    EXPECT_EQ(cur_block, num_blocks - 1);
+  }
+  {
+    // 固定的预读窗口一次提交整个窗口
+    auto block_cache = std::make_shared<BlockCache>(2 * num_blocks, 2);
+    auto direct_sst = SST::open(
+        1, FileObj::open("test_data/readahead.sst", false, FileIOMode::Direct),
+        block_cache);
+    SstIterator it(direct_sst, 0);
+    it.set_readahead(32);
+    EXPECT_NE(block_cache->get(1, 31), nullptr);
+    EXPECT_EQ(block_cache->get(1, 32), nullptr);
+  }
+
+  std::vector<std::shared_ptr<SST>> ssts = {sst};
+  ConcactIterator concat_it(ssts, 0);
+  concat_it.set_readahead(8);
+  int cnt = 0;
+  for (; concat_it.is_valid(); ++concat_it) {
+    cnt++;
+  }
+  EXPECT_EQ(cnt, 2000);
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   init_spdlog_file();
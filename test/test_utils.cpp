@@ -1,9 +1,13 @@
 #include "../include/logger/logger.h"
 #include "../include/utils/bloom_filter.h"
+#include "../include/utils/crc32c.h"
 #include "../include/utils/files.h"
+#include "../include/utils/io_uring.h"
+#include <fcntl.h>
 #include <filesystem>
 #include <gtest/gtest.h>
 #include <random>
+#include <unistd.h>
 
 using namespace ::tiny_lsm;
 
@@ -134,6 +138,126 @@ protected:
 //   EXPECT_EQ(read_data, data);
 // }
 
+// 测试 Direct 模式下的读取和批量读取
+TEST_F(FileTest, DirectReadBatch) {
+  const std::string path = "test_data/direct.dat";
+  const size_t size = 3 * 4096 + 123; // 故意不按 4K 对齐
+  auto data = generate_random_data(size);
+
+  {
+    auto file = FileObj::create_and_write(path, data, FileIOMode::Direct);
+    EXPECT_EQ(file.size(), size);
+  }
+
+  auto file = FileObj::open(path, false, FileIOMode::Direct);
+  EXPECT_EQ(file.size(), size);
+
+  // 非对齐的单次读取
+  auto slice = file.read_to_slice(4000, 200);
+  EXPECT_EQ(slice, std::vector<uint8_t>(data.begin() + 4000,
+                                        data.begin() + 4200));
+
+  // 批量读取, 包括跨页和文件尾部的区间
+  std::vector<std::pair<size_t, size_t>> ranges = {
+      {0, 10}, {4090, 20}, {8192, 4096}, {size - 7, 7}};
+  auto results = file.read_batch(ranges);
+  ASSERT_EQ(results.size(), ranges.size());
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    auto [offset, length] = ranges[i];
+    EXPECT_EQ(results[i], std::vector<uint8_t>(data.begin() + offset,
+                                               data.begin() + offset + length));
+  }
+
+  EXPECT_THROW(file.read_batch({{size - 1, 2}}), std::out_of_range);
+}
+
+// 请求数超过提交队列容量时分批提交, 返回时所有读都已完成
+TEST_F(FileTest, IoUringReadBatch) {
+  IoUring ring(4);
+  if (!ring.valid()) {
+    GTEST_SKIP() << "io_uring is not available";
+  }
+  const std::string path = "test_data/io_uring.dat";
+  auto data = generate_random_data(64 * 1024);
+  { FileObj::create_and_write(path, data); }
+
+  int fd = ::open(path.c_str(), O_RDONLY);
+  ASSERT_GE(fd, 0);
+  const size_t n = 37;
+  const size_t length = 1000;
+  std::vector<std::vector<uint8_t>> buffers(n, std::vector<uint8_t>(length));
+  std::vector<IoReadRequest> reqs;
+  for (size_t i = 0; i < n; ++i) {
+    reqs.push_back({fd, buffers[i].data(), length, i * 1700});
+  }
+  auto res = ring.read_batch(reqs);
+  ::close(fd);
+
+  ASSERT_EQ(res.size(), n);
+  for (size_t i = 0; i < n; ++i) {
+    ASSERT_EQ(res[i], static_cast<int>(length)) << i;
+    EXPECT_EQ(buffers[i], std::vector<uint8_t>(data.begin() + i * 1700,
+                                               data.begin() + i * 1700 + length));
+  }
+  EXPECT_TRUE(ring.valid());
+}
+
+// 测试可写 mmap 的追加写: 预分配扩展映射, 关闭时截断到逻辑大小
+TEST_F(FileTest, MmapAppend) {
+  const std::string path = "test_data/mmap_append.dat";
+  std::vector<uint8_t> expected;
+
+  {
+    auto file = FileObj::open(path, true, FileIOMode::MmapAppend);
+    EXPECT_EQ(file.size(), 0);
+
+    // 写入量超过最小预分配大小, 触发多次扩展
+    for (int i = 0; i < 600; ++i) {
+      auto chunk = generate_random_data(4000 + i);
+      EXPECT_TRUE(file.append(chunk));
+      expected.insert(expected.end(), chunk.begin(), chunk.end());
+      if (i % 100 == 0) {
+        EXPECT_TRUE(file.sync_range(0, file.size(), true));
+      }
+    }
+    EXPECT_EQ(file.size(), expected.size());
+    EXPECT_EQ(file.read_to_slice(0, 100),
+              std::vector<uint8_t>(expected.begin(), expected.begin() + 100));
+    EXPECT_TRUE(file.sync());
+
+    // 预分配的空间大于逻辑大小
+    EXPECT_GT(std::filesystem::file_size(path), expected.size());
+  }
+
+  // 关闭后文件大小等于逻辑大小
+  EXPECT_EQ(std::filesystem::file_size(path), expected.size());
+
+  // 重新打开后继续追加
+  auto file = FileObj::open(path, false, FileIOMode::MmapAppend);
+  EXPECT_EQ(file.size(), expected.size());
+  std::vector<uint8_t> tail = {1, 2, 3};
+  EXPECT_TRUE(file.append(tail));
+  expected.insert(expected.end(), tail.begin(), tail.end());
+  EXPECT_EQ(file.read_to_slice(0, expected.size()), expected);
+}
+
+// 测试 CRC32C 的标准测试向量以及分段计算
+TEST(Crc32cTest, KnownValues) {
+  const std::string data = "123456789";
+  EXPECT_EQ(crc32c(data.data(), data.size()), 0xE3069283u);
+  EXPECT_EQ(crc32c(data.data(), 0), 0u);
+
+  // 分段计算的结果与整体计算一致, 覆盖非 8 字节对齐的长度
+  std::string large(1000, 'x');
+  for (size_t i = 0; i < large.size(); ++i) {
+    large[i] = static_cast<char>(i * 31);
+  }
+  uint32_t whole = crc32c(large.data(), large.size());
+  uint32_t part = crc32c(large.data(), 333);
+  part = crc32c(large.data() + 333, large.size() - 333, part);
+  EXPECT_EQ(whole, part);
+}
+
 // 综合测试布隆过滤器的功能
 TEST(BloomFilterTest, ComprehensiveTest) {
   // 创建布隆过滤器，预期插入1000个元素，假阳性率为0.01
@@ -4,6 +4,7 @@
 #include <filesystem>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <thread>
 
 using namespace testing;
 using namespace ::tiny_lsm;
@@ -157,6 +158,139 @@ TEST_F(WALTest, RecoverTest) {
   }
 }
 
+// 多个线程并发提交, 组提交合并写入后所有记录都能恢复
+TEST_F(WALTest, GroupCommit) {
+  const int thread_num = 8;
+  const int tranc_per_thread = 50;
+
+  {
+    MockWAL wal(test_dir, 16, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_num; t++) {
+      threads.emplace_back([&wal, t]() {
+        for (int i = 0; i < tranc_per_thread; i++) {
+          uint64_t tranc_id = t * tranc_per_thread + i + 1;
+          std::vector<Record> records = {
+              Record::createRecord(tranc_id),
+              Record::putRecord(tranc_id, "key" + std::to_string(tranc_id),
+                                "value" + std::to_string(tranc_id)),
+              Record::commitRecord(tranc_id)};
+          // 返回时记录已经落盘
+          EXPECT_TRUE(wal.log_async(records, WalSyncMode::Always).get());
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+
+  auto tranc_records = WAL::recover(test_dir, 0);
+  ASSERT_EQ(tranc_records.size(), thread_num * tranc_per_thread);
+  for (auto &[tranc_id, records] : tranc_records) {
+    ASSERT_EQ(records.size(), 3);
+    EXPECT_EQ(records[0], Record::createRecord(tranc_id));
+    EXPECT_EQ(records[1],
+              Record::putRecord(tranc_id, "key" + std::to_string(tranc_id),
+                                "value" + std::to_string(tranc_id)));
+    EXPECT_EQ(records[2], Record::commitRecord(tranc_id));
+  }
+}
+
+// 帧校验失败时, 恢复只保留之前完整的帧
+TEST_F(WALTest, TornWrite) {
+  std::vector<uint8_t> data;
+  for (uint64_t tranc_id = 1; tranc_id <= 3; tranc_id++) {
+    Record::encode_frame({Record::createRecord(tranc_id),
+                          Record::putRecord(tranc_id, "key",
+                                            std::string(300, 'v')),
+                          Record::commitRecord(tranc_id)},
+                         data);
+  }
+  EXPECT_EQ(Record::decode_frames(data).size(), 9);
+
+  // 最后一帧只写入了一部分, 之后是预分配的 0
+  auto torn = std::vector<uint8_t>(data.begin(), data.end() - 100);
+  torn.resize(torn.size() + 4096, 0);
+  EXPECT_EQ(Record::decode_frames(torn).size(), 6);
+
+  // 中间一帧的内容损坏, 之后的帧都不再可信
+  auto corrupted = data;
+  corrupted[data.size() / 2] ^= 0xFF;
+  EXPECT_EQ(Record::decode_frames(corrupted).size(), 3);
+}
+
+// 不刷盘的模式下, 提交返回时记录已经写入文件
+TEST_F(WALTest, SyncModes) {
+  for (auto mode : {WalSyncMode::Periodic, WalSyncMode::None}) {
+    std::filesystem::remove_all(test_dir);
+    WAL wal(test_dir, 1024, 0, 1, 4096, mode, 10);
+
+    for (uint64_t tranc_id = 1; tranc_id <= 10; tranc_id++) {
+      // 单次调用可以覆盖配置的策略
+      auto call_mode = tranc_id % 2 == 0 ? WalSyncMode::Always
+                                         : WalSyncMode::Default;
+      std::vector<Record> records = {
+          Record::putRecord(tranc_id, "key", std::to_string(tranc_id)),
+          Record::commitRecord(tranc_id)};
+      EXPECT_TRUE(wal.log_async(records, call_mode).get());
+    }
+
+    // WAL 还没有关闭, 记录已经可以被读取
+    auto tranc_records = WAL::recover(test_dir, 0);
+    EXPECT_EQ(tranc_records.size(), 10);
+  }
+}
+
+// 清理的日志文件被回收复用, 复用文件中的旧数据不会被恢复
+TEST_F(WALTest, Recycle) {
+  auto count_recycled = [this]() {
+    size_t count = 0;
+    for (const auto &entry : std::filesystem::directory_iterator(test_dir)) {
+      count += entry.path().filename().string().rfind("recycle.", 0) == 0;
+    }
+    return count;
+  };
+  auto log_tranc = [](WAL &wal, uint64_t tranc_id) {
+    std::vector<Record> records = {
+        Record::createRecord(tranc_id),
+        Record::putRecord(tranc_id, "key" + std::to_string(tranc_id),
+                          std::string(300, 'a' + tranc_id % 26)),
+        Record::commitRecord(tranc_id)};
+    EXPECT_TRUE(wal.log_async(records).get());
+  };
+
+  {
+    WAL wal(test_dir, 1024, 0, 1, 4096, WalSyncMode::Always, 1000, 2);
+    for (uint64_t tranc_id = 1; tranc_id <= 50; tranc_id++) {
+      log_tranc(wal, tranc_id);
+    }
+
+    // 前 50 个事务已经刷入 sst, 等待清理线程回收
+    wal.set_max_finished_tranc_id(50);
+    for (int i = 0; i < 50 && count_recycled() < 2; i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    ASSERT_EQ(count_recycled(), 2);
+
+    // 切换文件时优先复用回收的文件
+    for (uint64_t tranc_id = 51; tranc_id <= 100; tranc_id++) {
+      log_tranc(wal, tranc_id);
+    }
+    EXPECT_EQ(count_recycled(), 0);
+  }
+
+  auto tranc_records = WAL::recover(test_dir, 50);
+  ASSERT_EQ(tranc_records.size(), 50);
+  for (auto &[tranc_id, records] : tranc_records) {
+    EXPECT_GT(tranc_id, 50);
+    ASSERT_EQ(records.size(), 3);
+    EXPECT_EQ(records[1],
+              Record::putRecord(tranc_id, "key" + std::to_string(tranc_id),
+                                std::string(300, 'a' + tranc_id % 26)));
+  }
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   init_spdlog_file();
@@ -71,7 +71,7 @@ target("memtable")
 
 target("block")
     set_kind("static")  -- 生成静态库
-    add_deps("config")
+    add_deps("config", "utils")
     add_files("src/block/*.cpp")
     add_packages("toml11", "spdlog")
     add_includedirs("include", {public = true})
@@ -269,6 +269,48 @@ target("benchmark_skiplist")
         set_strip("none")    -- <-- 即使在 release 模式下也必须设置为 none
     end
 
+target("benchmark_wal")
+    set_kind("binary")
+    set_group("benchmark")
+    add_files("benchmark/benchmark_wal.cpp")
+    add_deps("logger", "wal")
+    add_packages("toml11", "spdlog")
+    add_includedirs("include")
+    set_my_target_dir("$(buildir)/benchmark")  -- 设置输出目录
+    if is_mode("release") then
+        set_symbols("debug")
+        set_optimize("fast")
+        set_strip("none")
+    end
+
+target("benchmark_sst_index")
+    set_kind("binary")
+    set_group("benchmark")
+    add_files("benchmark/benchmark_sst_index.cpp")
+    add_deps("logger", "sst")
+    add_packages("toml11", "spdlog")
+    add_includedirs("include")
+    set_my_target_dir("$(buildir)/benchmark")  -- 设置输出目录
+    if is_mode("release") then
+        set_symbols("debug")
+        set_optimize("fast")
+        set_strip("none")
+    end
+
+target("benchmark_compaction")
+    set_kind("binary")
+    set_group("benchmark")
+    add_files("benchmark/benchmark_compaction.cpp")
+    add_deps("logger", "lsm")
+    add_packages("toml11", "spdlog")
+    add_includedirs("include")
+    set_my_target_dir("$(buildir)/benchmark")  -- 设置输出目录
+    if is_mode("release") then
+        set_symbols("debug")
+        set_optimize("fast")
+        set_strip("none")
+    end
+
 -- 定义 示例
 target("example")
     set_kind("binary")